@@ -21,6 +21,36 @@ namespace g2d
 			// Engine will prefix this path to all relative resource-loading paths
 			// using in the engine, turning them to absolute paths.
 			const char* resourceFolderPath;
+
+			// Pack archives mounted at startup, paths are relative to resourceFolderPath.
+			// Resources are searched in packs first, later packs take precedence,
+			// and loose files under resourceFolderPath are used as fallback.
+			const char** resourcePacks = nullptr;
+
+			uint32_t resourcePackCount = 0;
+
+			// Loose resource files are read in batches by io_uring on linux,
+			// and by a pool of fileReadingThreads threads on other platforms.
+			uint32_t fileReadingThreads = 4;
+
+			// Maximum number of reads in flight when io_uring is used.
+			uint32_t fileReadingQueueDepth = 128;
+
+			// Number of background threads decoding textures, textures
+			// will be loaded synchronously when first used if it is 0.
+			uint32_t textureLoadingThreads = 2;
+
+			// Maximum bytes of decoded textures uploaded each frame.
+			uint32_t textureUploadBudget = 4 * 1024 * 1024;
+
+			// Maximum bytes of video memory used by textures, 0 means no limitation.
+			// See RenderSystem::SetTextureMemoryBudget.
+			uint64_t textureMemoryBudget = 0;
+
+			// Number of background threads running jobs of the engine, besides the
+			// main thread. 0xFFFFFFFF means one less than the number of CPU cores,
+			// all jobs run on the main thread if it is 0.
+			uint32_t jobThreads = 0xFFFFFFFF;
 		};
 
 		// CAUSTION, this must be the first Engine function
@@ -15,6 +15,19 @@ namespace g2d
 		Normal,		// src*src_a + dst*(1-src_a)
 
 		Additve,	// src*1 + dst*1
+
+		Premultiplied,	// src*1 + dst*(1-src_a), for textures baked with premultiplied alpha.
+	};
+
+	// Slots of per-draw parameters in a Pass.
+	// Built-in shaders use Tint to multiply the output color,
+	// and TexcoordTransform to offset(xy) and scale(zw) texcoords.
+	class G2DAPI DrawParam
+	{
+	public:
+		constexpr static uint32_t Tint = 0;
+		constexpr static uint32_t TexcoordTransform = 1;
+		constexpr static uint32_t Count = 2;
 	};
 
 	// Memory layout of Mesh.
@@ -84,9 +97,21 @@ namespace g2d
 	public:
 		// Read and parse colors from a image file, it support 
 		// BMP/PNG/TGA files, with or without alpha channel.
+		// DDS and baked .g2dtex files are uploaded as they are,
+		// use BlendMode::Premultiplied for premultiplied ones.
+		// Path is relative to resource folder, and searched in
+		// mounted resource packs before loose files.
 		// Return nullptr if meets an unsupport file format,
 		// or an error occured when loading.
 		static Texture* LoadFromFile(const char* path);
+
+		// Invoked in rendering thread when preloading finished.
+		typedef void(*PreloadCallback)(void* userData);
+
+		// Load textures in background before using them, e.g. in loading screens.
+		// The callback will be invoked during BeginRender when every texture 
+		// in the list has been uploaded or failed to load.
+		static void Preload(const char** paths, uint32_t count, PreloadCallback callback, void* userData);
 		
 		// Call this manually when the texture no longer
 		// being referenced, to decrease reference count.
@@ -122,6 +147,7 @@ namespace g2d
 
 		// Return true if two passes using same VS/PS, and
 		// the datas including in passes is same. otherwise return false.
+		// Per-draw parameters are not taken into account.
 		virtual bool IsSame(Pass* other) const = 0;
 
 		virtual void SetBlendMode(BlendMode mode) = 0;
@@ -136,6 +162,12 @@ namespace g2d
 		// or it will raise a out-of-memory exception.
 		virtual void SetPSConstant(uint32_t index, float* data, uint32_t size, uint32_t count) = 0;
 
+		// Fill a per-draw parameter, see DrawParam for the slots.
+		// Unlike constants, render system writes these values into
+		// the vertex stream when batching, so passes that differ only
+		// in per-draw parameters still merge into one drawcall.
+		virtual void SetDrawParam(uint32_t index, const gml::vec4& param) = 0;
+
 		// Set a texture to a pass.
 		// if texture index is exceed the max texture index,
 		// it will automatic expand the max texture. count of Texture
@@ -164,6 +196,9 @@ namespace g2d
 		// memory size of pixel constant buffer.
 		virtual uint32_t GetPSConstantLength() const = 0;
 
+		// Retrieve a per-draw parameter, see DrawParam for the slots.
+		virtual const gml::vec4& GetDrawParam(uint32_t index) const = 0;
+
 		virtual BlendMode GetBlendMode() const = 0;
 	};
 
@@ -216,6 +251,25 @@ namespace g2d
 		constexpr static uint32_t Overlay = 0x8000;
 	};
 
+	// Statistics of textures maintained by render system.
+	struct TextureStatistics
+	{
+		// Video memory used by resident textures, in bytes.
+		uint64_t residentBytes = 0;
+
+		uint32_t residentCount = 0;
+
+		// Times of textures being evicted due to exceeding memory budget.
+		uint32_t evictionCount = 0;
+
+		// Times of evicted textures being loaded again.
+		uint32_t reloadCount = 0;
+
+		// Times of loaded textures sharing video memory with
+		// a resident texture of identical content.
+		uint32_t dedupCount = 0;
+	};
+
 	class G2DAPI RenderSystem : public GObject
 	{
 	public:
@@ -243,5 +297,13 @@ namespace g2d
 
 		// Convert camera-space coordinate to screen-space coordinate.
 		virtual gml::coord ViewToScreen(const gml::vec2 & view) const = 0;
+
+		// Limit video memory used by textures, 0 means no limitation.
+		// Least recently used textures no longer referenced by any
+		// Texture will be evicted when exceeding the budget, and 
+		// will be loaded again when being used next time.
+		virtual void SetTextureMemoryBudget(uint64_t bytes) = 0;
+
+		virtual const TextureStatistics& GetTextureStatistics() const = 0;
 	};
 }
@@ -1,4 +1,7 @@
 #pragma once
+#include <new>
+#include <type_traits>
+#include <utility>
 #include <gml/gmlvector.h>
 #include <gml/gmlmatrix.h>
 #include <gml/gmlaabb.h>
@@ -10,6 +13,36 @@ namespace g2d
 	constexpr uint32_t DEF_VISIBLE_MASK = 0xFFFFFFFF;
 	constexpr int DEF_COMPONENT_ORDER = 0x5000;
 
+	// Bits of local transform changes, passed to
+	// Component::OnTransformChanged.
+	class G2DAPI TransformChange
+	{
+	public:
+		constexpr static uint32_t Position = 0x1;
+		constexpr static uint32_t Rotation = 0x2;
+		constexpr static uint32_t Scale = 0x4;
+		constexpr static uint32_t Pivot = 0x8;
+	};
+
+	// Bits of events handled by a component, returned by
+	// Component::GetEventMask. Handlers of events not in
+	// the mask are never invoked.
+	class G2DAPI EventMask
+	{
+	public:
+		constexpr static uint32_t Update = 0x1;
+		constexpr static uint32_t TransformChanged = 0x2;
+		constexpr static uint32_t UpdateMatrixChanged = 0x4;
+		constexpr static uint32_t Message = 0x8;
+		constexpr static uint32_t Cursor = 0x10;		// enter, hovering and leave.
+		constexpr static uint32_t Click = 0x20;
+		constexpr static uint32_t DoubleClick = 0x40;
+		constexpr static uint32_t Drag = 0x80;		// begin, dragging and end.
+		constexpr static uint32_t Drop = 0x100;		// dropping and drop to.
+		constexpr static uint32_t Key = 0x200;		// press, pressing begin, pressing and end.
+		constexpr static uint32_t All = 0xFFFFFFFF;
+	};
+
 	class Component;
 	class Camera;
 	class SceneNode;
@@ -49,6 +82,12 @@ namespace g2d
 		// The mask will collaborate with the camera's visible mask
 		uint32_t GetVisibleMask() const;
 
+		// Implement this function to declare handled events, a combination
+		// of EventMask bits, it must not change while the component is added
+		// to a node. Components made by CreateComponent detect it from the
+		// overridden handlers, others receive all events by default.
+		virtual uint32_t GetEventMask() const { return m_eventMask; }
+
 	public:
 		// Trigger when SceneNode being created or the
 		// component being added to the node successfully.
@@ -61,17 +100,15 @@ namespace g2d
 		// User need to commit a render request to render system.
 		virtual void OnRender() { }
 
-		// Trigger when local Roll rotation changes by calling SetRotation().
-		virtual void OnRotate(gml::radian r) { }
-
-		// Trigger when local scale changes by calling SetScale().
-		virtual void OnScale(const gml::vec2& newScaler) { }
-
-		// Trigger when local position changes by calling SetPosition().
-		virtual void OnMove(const gml::vec2& newPos) { }
+		// Trigger at most once a frame during update, after OnUpdate, when
+		// local transform has been changed by setters since last time.
+		// Changes is a combination of TransformChange bits, new values
+		// can be read from the node.
+		virtual void OnTransformChanged(uint32_t changes) { }
 
 		// Trigger when raw messages comes. 
 		// Some messages will be converted to special events list below.
+		// Nodes receive messages and key events in no particular order.
 		virtual void OnMessage(const g2d::Message& message) { }
 
 		// First update event after local tranform changes.
@@ -141,15 +178,98 @@ namespace g2d
 	public:// internal use
 		void SetSceneNode(g2d::SceneNode* node);
 
-		void SetRenderingOrder(uint32_t& order);
+		// rendering order of its node, components of
+		// the same node are sorted by their ranks.
+		void SetRenderingOrder(uint64_t order) { m_renderingOrder = order; }
 
-		uint32_t GetRenderingOrder() { return m_renderingOrder; }
+		uint64_t GetRenderingOrder() const { return m_renderingOrder; }
+
+		void SetRenderingRank(uint64_t rank) { m_renderingRank = rank; }
+
+		uint64_t GetRenderingRank() const { return m_renderingRank; }
+
+		constexpr static uint32_t INVALID_REGISTRY_INDEX = 0xFFFFFFFF;
+
+		void SetRegistryIndex(uint32_t index) { m_registryIndex = index; }
+
+		uint32_t GetRegistryIndex() const { return m_registryIndex; }
+
+		void SetEventMask(uint32_t mask) { m_eventMask = mask; }
 
 	private:
 		SceneNode* m_sceneNode = nullptr;
-		uint32_t m_renderingOrder = 0xFFFFFFFF;
+		uint64_t m_renderingOrder = 0xFFFFFFFFFFFFFFFF;
+		uint64_t m_renderingRank = 0;
+		uint32_t m_registryIndex = INVALID_REGISTRY_INDEX;
+		uint32_t m_eventMask = EventMask::All;
 	};
 
+	// Events handled by class T, found by the handlers it overrides.
+	// Overridden handlers must be public.
+#define G2D_OVERRIDES(handler) (!std::is_same<decltype(&T::handler), decltype(&Component::handler)>::value)
+	template<typename T> uint32_t DetectEventMask()
+	{
+		uint32_t mask = 0;
+		if (G2D_OVERRIDES(OnUpdate)) mask |= EventMask::Update;
+		if (G2D_OVERRIDES(OnTransformChanged)) mask |= EventMask::TransformChanged;
+		if (G2D_OVERRIDES(OnUpdateMatrixChanged)) mask |= EventMask::UpdateMatrixChanged;
+		if (G2D_OVERRIDES(OnMessage)) mask |= EventMask::Message;
+		if (G2D_OVERRIDES(OnCursorEnterFrom) || G2D_OVERRIDES(OnCursorHovering) || G2D_OVERRIDES(OnCursorLeaveTo))
+			mask |= EventMask::Cursor;
+		if (G2D_OVERRIDES(OnLClick) || G2D_OVERRIDES(OnRClick) || G2D_OVERRIDES(OnMClick))
+			mask |= EventMask::Click;
+		if (G2D_OVERRIDES(OnLDoubleClick) || G2D_OVERRIDES(OnRDoubleClick) || G2D_OVERRIDES(OnMDoubleClick))
+			mask |= EventMask::DoubleClick;
+		if (G2D_OVERRIDES(OnLDragBegin) || G2D_OVERRIDES(OnRDragBegin) || G2D_OVERRIDES(OnMDragBegin) ||
+			G2D_OVERRIDES(OnLDragging) || G2D_OVERRIDES(OnRDragging) || G2D_OVERRIDES(OnMDragging) ||
+			G2D_OVERRIDES(OnLDragEnd) || G2D_OVERRIDES(OnRDragEnd) || G2D_OVERRIDES(OnMDragEnd))
+			mask |= EventMask::Drag;
+		if (G2D_OVERRIDES(OnLDropping) || G2D_OVERRIDES(OnRDropping) || G2D_OVERRIDES(OnMDropping) ||
+			G2D_OVERRIDES(OnLDropTo) || G2D_OVERRIDES(OnRDropTo) || G2D_OVERRIDES(OnMDropTo))
+			mask |= EventMask::Drop;
+		if (G2D_OVERRIDES(OnKeyPress) || G2D_OVERRIDES(OnKeyPressingBegin) ||
+			G2D_OVERRIDES(OnKeyPressing) || G2D_OVERRIDES(OnKeyPressingEnd))
+			mask |= EventMask::Key;
+		return mask;
+	}
+#undef G2D_OVERRIDES
+
+	// Memory of components is allocated from pools of their
+	// class, so that components of a class stay close together.
+	void* G2DAPI AllocateComponentMemory(uint32_t classID, uint32_t size);
+
+	void G2DAPI FreeComponentMemory(uint32_t classID, void* memory);
+
+	// Create a component from pools, instead of new. The class must
+	// implement Release by calling DestroyComponent(this).
+	template<typename T, typename... ARGS> T* CreateComponent(ARGS&&... args)
+	{
+		void* memory = AllocateComponentMemory(T::GetStaticClassID(), sizeof(T));
+		T* component = new (memory) T(std::forward<ARGS>(args)...);
+		component->SetEventMask(DetectEventMask<T>());
+		return component;
+	}
+
+	template<typename T> void DestroyComponent(T* component)
+	{
+		component->~T();
+		FreeComponentMemory(T::GetStaticClassID(), component);
+	}
+
+	// Components are written to scene snapshots by serializers of their
+	// class, registered at startup by a name which stays the same between
+	// runs, unlike class ids. Save writes data of the component, and returns
+	// its size, it's called again if capacity is not enough. Load creates a
+	// component from the data. Quad is registered by the engine, components
+	// of classes not registered are not written. Loaded components are
+	// owned by their nodes and always auto-released, no matter how saved
+	// ones were added, since nothing else refers to them.
+	typedef uint32_t(*SaveComponentFunc)(const Component& component, void* data, uint32_t capacity);
+
+	typedef Component*(*LoadComponentFunc)(const void* data, uint32_t size);
+
+	void G2DAPI RegisterSnapshotClass(uint32_t classID, const char* name, SaveComponentFunc save, LoadComponentFunc load);
+
 	// Image Quad
 	class G2DAPI Quad : public Component
 	{
@@ -216,7 +336,19 @@ namespace g2d
 		virtual gml::coord WorldToScreen(const gml::vec2& pos) const = 0;
 	};
 
-	// Node in Scene Tree
+	// Identifies a node of a scene, unlike pointers, handle of a released
+	// node never refers to nodes created later. See Scene::GetNodeByHandle.
+	struct SceneNodeHandle
+	{
+		uint32_t index;
+		uint32_t generation;	// 0 for invalid handle.
+	};
+
+	// Node in Scene Tree. Creating, releasing and moving nodes, adding and
+	// removing components in events of the scene are deferred, and applied
+	// at once after the event is dispatched: nodes created meanwhile are
+	// not updated in the frame, their world matrices ignore parents, and
+	// deferred AddComponent and RemoveComponent always succeed.
 	class G2DAPI SceneNode : public GObject
 	{
 	public:
@@ -226,6 +358,9 @@ namespace g2d
 		// Which scene the node belongs to.
 		virtual Scene* GetScene() const = 0;
 
+		// Handle of the node, it stays unique after the node is released.
+		virtual SceneNodeHandle GetHandle() const = 0;
+
 		// Return nullptr if the parent is Scene.
 		virtual SceneNode* GetParentNode() const = 0;
 
@@ -313,6 +448,10 @@ namespace g2d
 		// Setting local Roll rotation.
 		virtual SceneNode* SetRotation(gml::radian r) = 0;
 
+		// Setting all local transform at once, it's cheaper than
+		// calling setters separately, e.g. for animations.
+		virtual SceneNode* SetTransform(const gml::vec2& position, gml::radian r, const gml::vec2& scale, const gml::vec2& pivot) = 0;
+
 		// Manually setting visibility.
 		// None-seen node will not be rendered.
 		virtual void SetVisible(bool) = 0;
@@ -368,7 +507,7 @@ namespace g2d
 		virtual gml::vec2 WorldToParent(const gml::vec2& pos) = 0;
 	};
 
-	// Query the first component by a certain type.
+	// Query the first component by a certain type, in constant time.
 	template<typename T> T* FindComponent(SceneNode* node);
 
 	class G2DAPI Scene : public GObject
@@ -395,6 +534,21 @@ namespace g2d
 		// Create a child node, and add it to the node.
 		virtual SceneNode* CreateChild() = 0;
 
+		// Return nullptr if the node is released, or handle is invalid.
+		virtual SceneNode* GetNodeByHandle(const SceneNodeHandle& handle) const = 0;
+
+		// Number of components of the class attached to nodes of the scene.
+		virtual uint32_t GetComponentCount(uint32_t classID) const = 0;
+
+		// Components of the class attached to nodes of the scene, stored
+		// contiguously in no particular order, so that systems can update
+		// all of them in one pass. It becomes invalid after components are
+		// added or removed. Return nullptr if there is no such component.
+		virtual Component* const* GetComponents(uint32_t classID) const = 0;
+
+		// First component of the class on the node, in constant time.
+		virtual Component* FindComponent(SceneNode* node, uint32_t classID) const = 0;
+
 		// Create a child node, with a camera component, 
 		// and add it the scene.
 		virtual Camera* CreateCameraNode() = 0;
@@ -409,6 +563,26 @@ namespace g2d
 
 		// Number of exist cameras.
 		virtual uint32_t GetCameraCount() const = 0;
+
+		// Update top-level nodes and their subtrees concurrently on
+		// job threads, it is disabled by default. Components must only
+		// access nodes of their own subtree in updating events, changes
+		// are deferred until every subtree is updated, as in other events.
+		virtual void SetParallelUpdate(bool enabled) = 0;
+
+		virtual bool IsParallelUpdate() const = 0;
+
+		// Write the scene tree to a binary snapshot: nodes, local transforms,
+		// visibility, visible masks, static flags and components of snapshot
+		// classes. Camera nodes and their children are not written. Path is
+		// relative to the resource root, unless it's absolute.
+		virtual bool SaveSnapshot(const char* path) = 0;
+
+		// Append nodes of a snapshot as top-level nodes, return false if it's
+		// not a valid snapshot. The file is mapped instead of read, nodes are
+		// ordered in one pass, and added to the spatial graph together, so
+		// that large levels load quickly. It can not be called in events.
+		virtual bool LoadSnapshot(const char* path) = 0;
 		
 		// Call it manually each frame, to send OnRender event
 		// to scene tree, so that each node can notify its components.
@@ -417,12 +591,6 @@ namespace g2d
 
 	template<typename T> T* FindComponent(SceneNode* node)
 	{
-		auto count = node->GetComponentCount();
-		for (uint32_t i = 0; i < count; i++)
-		{
-			auto component = node->GetComponentByIndex(i);
-			if (Is<T>(component)) return reinterpret_cast<T*>(component);
-		}
-		return nullptr;
+		return static_cast<T*>(node->GetScene()->FindComponent(node, T::GetStaticClassID()));
 	}
 }
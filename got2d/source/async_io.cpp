@@ -0,0 +1,426 @@
+#include <algorithm>
+#include <cstring>
+#include "async_io.h"
+
+#ifdef _WIN32
+#include <Windows.h>
+#else
+#include <cerrno>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+#ifdef G2D_HAS_IO_URING
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <sys/uio.h>
+#include <linux/io_uring.h>
+#endif
+
+namespace
+{
+	// a single read call never exceeds 1GB.
+	constexpr uint64_t MAX_READ_BYTES = 1u << 30;
+}
+
+bool ReadFileRange(const std::string& path, uint64_t offset, uint64_t size, uint8_t* buffer)
+{
+#ifdef _WIN32
+	HANDLE file = ::CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr,
+		OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+	if (file == INVALID_HANDLE_VALUE)
+		return false;
+
+	uint64_t finished = 0;
+	while (finished < size)
+	{
+		OVERLAPPED overlapped;
+		::ZeroMemory(&overlapped, sizeof(overlapped));
+		overlapped.Offset = static_cast<DWORD>(offset + finished);
+		overlapped.OffsetHigh = static_cast<DWORD>((offset + finished) >> 32);
+		DWORD readBytes = 0;
+		DWORD length = static_cast<DWORD>(std::min(size - finished, MAX_READ_BYTES));
+		if (!::ReadFile(file, buffer + finished, length, &readBytes, &overlapped) || readBytes == 0)
+			break;
+		finished += readBytes;
+	}
+	::CloseHandle(file);
+	return finished == size;
+#else
+	int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+	if (fd < 0)
+		return false;
+
+	uint64_t finished = 0;
+	while (finished < size)
+	{
+		size_t length = static_cast<size_t>(std::min(size - finished, MAX_READ_BYTES));
+		ssize_t readBytes = ::pread(fd, buffer + finished, length, static_cast<off_t>(offset + finished));
+		if (readBytes < 0 && errno == EINTR)
+			continue;
+		if (readBytes <= 0)
+			break;
+		finished += readBytes;
+	}
+	::close(fd);
+	return finished == size;
+#endif
+}
+
+#ifdef G2D_HAS_IO_URING
+// raw syscalls, so that liburing is not required.
+struct AsyncIO::Ring
+{
+	int fd = -1;
+	void* sqRing = nullptr;
+	size_t sqRingSize = 0;
+	void* cqRing = nullptr;
+	size_t cqRingSize = 0;
+	io_uring_sqe* sqes = nullptr;
+	size_t sqesSize = 0;
+	uint32_t* sqTail = nullptr;
+	uint32_t* sqMask = nullptr;
+	uint32_t* sqArray = nullptr;
+	uint32_t* cqHead = nullptr;
+	uint32_t* cqTail = nullptr;
+	uint32_t* cqMask = nullptr;
+	io_uring_cqe* cqes = nullptr;
+};
+
+bool AsyncIO::SetupRing(uint32_t queueDepth)
+{
+	io_uring_params params;
+	memset(&params, 0, sizeof(params));
+	int fd = static_cast<int>(::syscall(__NR_io_uring_setup, queueDepth, &params));
+	if (fd < 0)
+		return false;
+
+	m_ring = new Ring();
+	m_ring->fd = fd;
+	m_ring->sqRingSize = params.sq_off.array + params.sq_entries * sizeof(uint32_t);
+	m_ring->cqRingSize = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+	bool singleMap = (params.features & IORING_FEAT_SINGLE_MMAP) != 0;
+	if (singleMap)
+	{
+		m_ring->sqRingSize = std::max(m_ring->sqRingSize, m_ring->cqRingSize);
+	}
+
+	void* sqRing = ::mmap(nullptr, m_ring->sqRingSize, PROT_READ | PROT_WRITE,
+		MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQ_RING);
+	if (sqRing == MAP_FAILED)
+	{
+		DestroyRing();
+		return false;
+	}
+	m_ring->sqRing = sqRing;
+
+	void* cqRing = sqRing;
+	if (!singleMap)
+	{
+		cqRing = ::mmap(nullptr, m_ring->cqRingSize, PROT_READ | PROT_WRITE,
+			MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_CQ_RING);
+		if (cqRing == MAP_FAILED)
+		{
+			DestroyRing();
+			return false;
+		}
+		m_ring->cqRing = cqRing;
+	}
+
+	m_ring->sqesSize = params.sq_entries * sizeof(io_uring_sqe);
+	void* sqes = ::mmap(nullptr, m_ring->sqesSize, PROT_READ | PROT_WRITE,
+		MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQES);
+	if (sqes == MAP_FAILED)
+	{
+		DestroyRing();
+		return false;
+	}
+	m_ring->sqes = static_cast<io_uring_sqe*>(sqes);
+
+	auto sqBase = static_cast<uint8_t*>(sqRing);
+	auto cqBase = static_cast<uint8_t*>(cqRing);
+	m_ring->sqTail = reinterpret_cast<uint32_t*>(sqBase + params.sq_off.tail);
+	m_ring->sqMask = reinterpret_cast<uint32_t*>(sqBase + params.sq_off.ring_mask);
+	m_ring->sqArray = reinterpret_cast<uint32_t*>(sqBase + params.sq_off.array);
+	m_ring->cqHead = reinterpret_cast<uint32_t*>(cqBase + params.cq_off.head);
+	m_ring->cqTail = reinterpret_cast<uint32_t*>(cqBase + params.cq_off.tail);
+	m_ring->cqMask = reinterpret_cast<uint32_t*>(cqBase + params.cq_off.ring_mask);
+	m_ring->cqes = reinterpret_cast<io_uring_cqe*>(cqBase + params.cq_off.cqes);
+
+	// completion queue is larger than submission queue, so
+	// it never overflows while reads in flight are limited.
+	m_queueDepth = params.sq_entries;
+	return true;
+}
+
+void AsyncIO::DestroyRing()
+{
+	if (m_ring == nullptr)
+		return;
+
+	if (m_ring->sqes != nullptr)
+		::munmap(m_ring->sqes, m_ring->sqesSize);
+	if (m_ring->cqRing != nullptr)
+		::munmap(m_ring->cqRing, m_ring->cqRingSize);
+	if (m_ring->sqRing != nullptr)
+		::munmap(m_ring->sqRing, m_ring->sqRingSize);
+	::close(m_ring->fd);
+	delete m_ring;
+	m_ring = nullptr;
+}
+
+void AsyncIO::RingLoop()
+{
+	struct RingRead
+	{
+		IORequest request;
+		int fd;
+		uint64_t finished;
+		iovec vector;
+	};
+
+	std::vector<IORequest> incoming;
+	std::vector<RingRead*> submitting;
+	uint32_t inflightCount = 0;
+	uint32_t unsubmittedCount = 0;
+
+	auto finish = [this](RingRead* read, bool succeeded)
+	{
+		::close(read->fd);
+		Complete(read->request, succeeded);
+		delete read;
+	};
+
+	while (true)
+	{
+		// block for new requests only when the ring is empty.
+		incoming.clear();
+		bool idle = inflightCount == 0 && submitting.empty();
+		uint32_t capacity = m_queueDepth - inflightCount - static_cast<uint32_t>(submitting.size());
+		if (!PopRequests(incoming, capacity, idle))
+			break;
+
+		for (auto& request : incoming)
+		{
+			int fd = ::open(request.path.c_str(), O_RDONLY | O_CLOEXEC);
+			if (fd < 0)
+			{
+				Complete(request, false);
+			}
+			else if (request.size == 0)
+			{
+				::close(fd);
+				Complete(request, true);
+			}
+			else
+			{
+				submitting.push_back(new RingRead{ std::move(request), fd, 0, iovec() });
+			}
+		}
+
+		for (auto read : submitting)
+		{
+			uint32_t tail = *m_ring->sqTail;
+			uint32_t index = tail & *m_ring->sqMask;
+			io_uring_sqe* sqe = &m_ring->sqes[index];
+			memset(sqe, 0, sizeof(io_uring_sqe));
+			read->vector.iov_base = read->request.buffer + read->finished;
+			read->vector.iov_len = static_cast<size_t>(std::min(read->request.size - read->finished, MAX_READ_BYTES));
+			sqe->opcode = IORING_OP_READV;
+			sqe->fd = read->fd;
+			sqe->addr = reinterpret_cast<uint64_t>(&read->vector);
+			sqe->len = 1;
+			sqe->off = read->request.offset + read->finished;
+			sqe->user_data = reinterpret_cast<uint64_t>(read);
+			m_ring->sqArray[index] = index;
+			__atomic_store_n(m_ring->sqTail, tail + 1, __ATOMIC_RELEASE);
+			unsubmittedCount++;
+			inflightCount++;
+		}
+		submitting.clear();
+
+		if (inflightCount == 0)
+			continue;
+
+		// submit the whole batch and wait for at least one completion in one syscall.
+		int submitted = static_cast<int>(::syscall(__NR_io_uring_enter, m_ring->fd,
+			unsubmittedCount, 1, IORING_ENTER_GETEVENTS, nullptr, 0));
+		if (submitted > 0)
+		{
+			unsubmittedCount -= std::min<uint32_t>(unsubmittedCount, submitted);
+		}
+
+		uint32_t head = *m_ring->cqHead;
+		while (head != __atomic_load_n(m_ring->cqTail, __ATOMIC_ACQUIRE))
+		{
+			const io_uring_cqe& cqe = m_ring->cqes[head & *m_ring->cqMask];
+			auto read = reinterpret_cast<RingRead*>(cqe.user_data);
+			int result = cqe.res;
+			head++;
+			inflightCount--;
+
+			if (result == -EAGAIN || result == -EINTR)
+			{
+				submitting.push_back(read);
+			}
+			else if (result <= 0)
+			{
+				finish(read, false);
+			}
+			else
+			{
+				// short reads are continued from where they stopped.
+				read->finished += result;
+				if (read->finished < read->request.size)
+					submitting.push_back(read);
+				else
+					finish(read, true);
+			}
+		}
+		__atomic_store_n(m_ring->cqHead, head, __ATOMIC_RELEASE);
+	}
+}
+#endif
+
+bool AsyncIO::Start(uint32_t threadCount, uint32_t queueDepth, bool allowIoUring)
+{
+	Stop();
+	m_quit = false;
+	m_queueDepth = std::max(1u, queueDepth);
+
+#ifdef G2D_HAS_IO_URING
+	// io_uring may be disabled by kernel or sandbox, fallback silently.
+	if (allowIoUring && SetupRing(m_queueDepth))
+	{
+		m_threads.push_back(std::thread([this] { RingLoop(); }));
+		return true;
+	}
+#else
+	(void)allowIoUring;
+#endif
+
+	threadCount = std::max(1u, threadCount);
+	for (uint32_t i = 0; i < threadCount; i++)
+	{
+		m_threads.push_back(std::thread([this] { WorkerLoop(); }));
+	}
+	return true;
+}
+
+void AsyncIO::Stop()
+{
+	WaitIdle();
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_quit = true;
+	}
+	m_requestCondition.notify_all();
+	for (auto& thread : m_threads)
+	{
+		thread.join();
+	}
+	m_threads.clear();
+
+#ifdef G2D_HAS_IO_URING
+	DestroyRing();
+#endif
+}
+
+void AsyncIO::Submit(std::vector<IORequest>& requests)
+{
+	if (requests.empty())
+		return;
+
+	// no background thread, read in calling thread.
+	if (m_threads.empty())
+	{
+		for (auto& request : requests)
+		{
+			bool succeeded = ReadFileRange(request.path, request.offset, request.size, request.buffer);
+			if (request.callback)
+			{
+				request.callback(request.userData, succeeded);
+			}
+		}
+		requests.clear();
+		return;
+	}
+
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_unfinishedCount += static_cast<uint32_t>(requests.size());
+		for (auto& request : requests)
+		{
+			m_requests.push_back(std::move(request));
+		}
+	}
+	requests.clear();
+	m_requestCondition.notify_all();
+}
+
+void AsyncIO::WaitIdle()
+{
+	std::unique_lock<std::mutex> lock(m_mutex);
+	m_idleCondition.wait(lock, [this] { return m_unfinishedCount == 0; });
+}
+
+const char* AsyncIO::GetBackendName() const
+{
+	if (m_threads.empty())
+		return "none";
+
+#ifdef G2D_HAS_IO_URING
+	if (m_ring != nullptr)
+		return "io_uring";
+#endif
+	return "thread pool";
+}
+
+void AsyncIO::Complete(const IORequest& request, bool succeeded)
+{
+	if (request.callback)
+	{
+		request.callback(request.userData, succeeded);
+	}
+
+	std::lock_guard<std::mutex> lock(m_mutex);
+	if (--m_unfinishedCount == 0)
+	{
+		m_idleCondition.notify_all();
+	}
+}
+
+bool AsyncIO::PopRequests(std::vector<IORequest>& requests, uint32_t maxCount, bool wait)
+{
+	std::unique_lock<std::mutex> lock(m_mutex);
+	if (wait)
+	{
+		m_requestCondition.wait(lock, [this] { return m_quit || !m_requests.empty(); });
+		if (m_requests.empty())
+			return false;
+	}
+
+	while (maxCount > 0 && !m_requests.empty())
+	{
+		requests.push_back(std::move(m_requests.front()));
+		m_requests.pop_front();
+		maxCount--;
+	}
+	return true;
+}
+
+void AsyncIO::WorkerLoop()
+{
+	std::vector<IORequest> requests;
+	while (true)
+	{
+		requests.clear();
+		if (!PopRequests(requests, 1, true))
+			break;
+
+		for (auto& request : requests)
+		{
+			Complete(request, ReadFileRange(request.path, request.offset, request.size, request.buffer));
+		}
+	}
+}
@@ -0,0 +1,91 @@
+#pragma once
+#include <cinttypes>
+#include <string>
+#include <vector>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+
+// Asynchronous file reading service.
+// Requests are submitted in batches and read into caller-provided
+// buffers. On linux it uses io_uring when kernel supports it, and
+// fallback to a thread pool calling pread (ReadFile on windows).
+
+#if defined(__linux__)
+#define G2D_HAS_IO_URING 1
+#endif
+
+// Invoked in I/O thread when the request finished, succeeded is
+// false if file can not be opened or has less bytes than required.
+typedef void(*IOCallback)(void* userData, bool succeeded);
+
+struct IORequest
+{
+	std::string path;
+	uint64_t offset = 0;
+	uint64_t size = 0;
+	uint8_t* buffer = nullptr;
+	IOCallback callback = nullptr;
+	void* userData = nullptr;
+};
+
+class AsyncIO
+{
+public:
+	AsyncIO() = default;
+
+	AsyncIO(const AsyncIO&) = delete;
+
+	AsyncIO& operator=(const AsyncIO&) = delete;
+
+	~AsyncIO() { Stop(); }
+
+	// threadCount is used by thread pool backend, queueDepth is the
+	// maximum number of reads in flight of io_uring backend.
+	bool Start(uint32_t threadCount, uint32_t queueDepth, bool allowIoUring = true);
+
+	// Wait for all submitted requests, and stop I/O threads.
+	void Stop();
+
+	// Requests are moved out, buffers must stay alive until callbacks are invoked.
+	void Submit(std::vector<IORequest>& requests);
+
+	// Block until all submitted requests have finished.
+	void WaitIdle();
+
+	bool IsStarted() const { return !m_threads.empty(); }
+
+	// "io_uring", "thread pool" or "none".
+	const char* GetBackendName() const;
+
+private:
+	void Complete(const IORequest& request, bool succeeded);
+
+	bool PopRequests(std::vector<IORequest>& requests, uint32_t maxCount, bool wait);
+
+	void WorkerLoop();
+
+#ifdef G2D_HAS_IO_URING
+	bool SetupRing(uint32_t queueDepth);
+
+	void DestroyRing();
+
+	void RingLoop();
+
+	struct Ring;
+	Ring* m_ring = nullptr;
+#endif
+
+	std::vector<std::thread> m_threads;
+	std::deque<IORequest> m_requests;
+	std::mutex m_mutex;
+	std::condition_variable m_requestCondition;
+	std::condition_variable m_idleCondition;
+	uint32_t m_unfinishedCount = 0;
+	uint32_t m_queueDepth = 0;
+	bool m_quit = false;
+};
+
+// Read a whole range synchronously, used by thread pool backend.
+bool ReadFileRange(const std::string& path, uint64_t offset, uint64_t size, uint8_t* buffer);
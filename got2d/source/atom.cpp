@@ -0,0 +1,88 @@
+#include <atomic>
+#include <mutex>
+#include <stdexcept>
+#include <unordered_map>
+#include "atom.h"
+
+namespace
+{
+	// names live in fixed-size chunks which never move, readers
+	// index them directly while new names are appended under lock.
+	constexpr uint32_t ATOM_CHUNK_BITS = 10;
+	constexpr uint32_t ATOM_CHUNK_SIZE = 1 << ATOM_CHUNK_BITS;
+	constexpr uint32_t ATOM_MAX_CHUNKS = 4096;
+
+	class AtomTable
+	{
+	public:
+		AtomTable()
+		{
+			for (auto& chunk : m_chunks)
+			{
+				chunk = nullptr;
+			}
+			Intern(std::string());
+		}
+
+		uint32_t Intern(const std::string& name)
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			auto itFound = m_ids.find(name);
+			if (itFound != m_ids.end())
+				return itFound->second;
+
+			uint32_t id = m_count;
+			uint32_t chunkIndex = id >> ATOM_CHUNK_BITS;
+			if (chunkIndex >= ATOM_MAX_CHUNKS)
+				throw std::length_error("too many atoms.");
+
+			std::string* chunk = m_chunks[chunkIndex].load(std::memory_order_relaxed);
+			if (chunk == nullptr)
+			{
+				chunk = new std::string[ATOM_CHUNK_SIZE];
+				m_chunks[chunkIndex].store(chunk, std::memory_order_release);
+			}
+			chunk[id & (ATOM_CHUNK_SIZE - 1)] = name;
+			m_ids.insert(std::make_pair(name, id));
+			m_count++;
+			return id;
+		}
+
+		// id is obtained from Intern, which has finished writing the name.
+		const std::string& GetName(uint32_t id) const
+		{
+			std::string* chunk = m_chunks[id >> ATOM_CHUNK_BITS].load(std::memory_order_acquire);
+			return chunk[id & (ATOM_CHUNK_SIZE - 1)];
+		}
+
+	private:
+		std::mutex m_mutex;
+		std::unordered_map<std::string, uint32_t> m_ids;
+		std::atomic<std::string*> m_chunks[ATOM_MAX_CHUNKS];
+		uint32_t m_count = 0;
+	};
+
+	// never destroyed, atoms may be used by other static objects on exit.
+	AtomTable& GetAtomTable()
+	{
+		static AtomTable* table = new AtomTable();
+		return *table;
+	}
+}
+
+Atom::Atom(const char* name)
+	: m_id(GetAtomTable().Intern(name))
+{
+
+}
+
+Atom::Atom(const std::string& name)
+	: m_id(GetAtomTable().Intern(name))
+{
+
+}
+
+const std::string& Atom::GetString() const
+{
+	return GetAtomTable().GetName(m_id);
+}
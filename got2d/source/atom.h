@@ -0,0 +1,45 @@
+#pragma once
+#include <cinttypes>
+#include <string>
+#include <functional>
+
+// Interned string, every distinct name is stored once in a global
+// table and identified by a 32-bit id, so that comparing and looking
+// up names are integer operations. Interning is thread-safe, and
+// names of atoms can be read in any thread without locking.
+// Atoms are never freed, default constructed atom is the empty string.
+class Atom
+{
+public:
+	Atom() = default;
+
+	explicit Atom(const char* name);
+
+	explicit Atom(const std::string& name);
+
+	uint32_t GetID() const { return m_id; }
+
+	bool IsEmpty() const { return m_id == 0; }
+
+	const std::string& GetString() const;
+
+	const char* GetCString() const { return GetString().c_str(); }
+
+	bool operator==(const Atom& other) const { return m_id == other.m_id; }
+
+	bool operator!=(const Atom& other) const { return m_id != other.m_id; }
+
+	// Ordered by id rather than by name, only for keying containers.
+	bool operator<(const Atom& other) const { return m_id < other.m_id; }
+
+private:
+	uint32_t m_id = 0;
+};
+
+namespace std
+{
+	template<> struct hash<Atom>
+	{
+		size_t operator()(const Atom& atom) const { return atom.GetID(); }
+	};
+}
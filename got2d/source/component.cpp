@@ -5,7 +5,17 @@
 
 g2d::Quad* g2d::Quad::Create()
 {
-	return new ::Quad();
+	return g2d::CreateComponent<::Quad>();
+}
+
+void* g2d::AllocateComponentMemory(uint32_t classID, uint32_t size)
+{
+	return ComponentPools::GetInstance().Allocate(classID, size);
+}
+
+void g2d::FreeComponentMemory(uint32_t classID, void* memory)
+{
+	ComponentPools::GetInstance().Free(classID, memory);
 }
 
 gml::aabb2d g2d::Component::GetWorldAABB() const
@@ -23,11 +33,6 @@ void g2d::Component::SetSceneNode(g2d::SceneNode* node)
 	m_sceneNode = node;
 }
 
-void g2d::Component::SetRenderingOrder(uint32_t& order)
-{
-	m_renderingOrder = order++;
-}
-
 uint32_t g2d::Component::GetVisibleMask() const
 {
 	return GetSceneNode()->GetVisibleMask();
@@ -16,7 +16,7 @@ public:
 	Quad();
 
 public:	//g2d::Entity
-	virtual void Release() override { delete this; }
+	virtual void Release() override { g2d::DestroyComponent(this); }
 
 	virtual const gml::aabb2d& GetLocalAABB() const override { return m_aabb; }
 
@@ -48,7 +48,7 @@ public:
 	std::vector<Component*> visibleComponents;
 
 public:	//g2d::Component
-	virtual void Release() override { delete this; }
+	virtual void Release() override { g2d::DestroyComponent(this); }
 
 	virtual const gml::aabb2d& GetLocalAABB() const override { return m_aabb; }
 
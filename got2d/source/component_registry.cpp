@@ -0,0 +1,107 @@
+#include "component_registry.h"
+#include "inner_utility.h"
+
+ComponentPools& ComponentPools::GetInstance()
+{
+	static ComponentPools* s_instance = new ComponentPools();
+	return *s_instance;
+}
+
+void* ComponentPools::Allocate(uint32_t classID, uint32_t size)
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+	if (classID >= m_pools.size())
+	{
+		m_pools.resize(classID + 1);
+	}
+
+	auto& pool = m_pools[classID];
+	if (pool == nullptr)
+	{
+		pool.reset(new BlockPool(size));
+	}
+	ENSURE(pool->GetBlockSize() == BlockPool::AlignSize(size));
+	return pool->Allocate();
+}
+
+void ComponentPools::Free(uint32_t classID, void* memory)
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+	ENSURE(classID < m_pools.size() && m_pools[classID] != nullptr);
+	m_pools[classID]->Free(memory);
+}
+
+uint32_t ComponentPools::GetCount(uint32_t classID) const
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+	if (classID >= m_pools.size() || m_pools[classID] == nullptr)
+		return 0;
+
+	return m_pools[classID]->GetCount();
+}
+
+ComponentRegistry::ClassComponents& ComponentRegistry::GetClassComponents(uint32_t classID)
+{
+	if (classID >= m_classes.size())
+	{
+		m_classes.resize(classID + 1);
+	}
+	return m_classes[classID];
+}
+
+void ComponentRegistry::Add(g2d::Component& component)
+{
+	ENSURE(component.GetRegistryIndex() == g2d::Component::INVALID_REGISTRY_INDEX);
+	auto& components = GetClassComponents(component.GetClassID()).components;
+	component.SetRegistryIndex(static_cast<uint32_t>(components.size()));
+	components.push_back(&component);
+}
+
+void ComponentRegistry::Remove(g2d::Component& component)
+{
+	uint32_t index = component.GetRegistryIndex();
+	ENSURE(index != g2d::Component::INVALID_REGISTRY_INDEX);
+
+	// the last one fills the hole, order of components is not kept.
+	auto& components = m_classes[component.GetClassID()].components;
+	g2d::Component* last = components.back();
+	components[index] = last;
+	last->SetRegistryIndex(index);
+	components.pop_back();
+	component.SetRegistryIndex(g2d::Component::INVALID_REGISTRY_INDEX);
+}
+
+void ComponentRegistry::SetFirst(uint32_t classID, uint32_t nodeIndex, g2d::Component* component)
+{
+	auto& firstByNode = GetClassComponents(classID).firstByNode;
+	if (nodeIndex >= firstByNode.size())
+	{
+		if (component == nullptr)
+			return;
+
+		firstByNode.resize(nodeIndex + 1, nullptr);
+	}
+	firstByNode[nodeIndex] = component;
+}
+
+g2d::Component* ComponentRegistry::FindFirst(uint32_t classID, uint32_t nodeIndex) const
+{
+	if (classID >= m_classes.size())
+		return nullptr;
+
+	auto& firstByNode = m_classes[classID].firstByNode;
+	return (nodeIndex < firstByNode.size()) ? firstByNode[nodeIndex] : nullptr;
+}
+
+uint32_t ComponentRegistry::GetCount(uint32_t classID) const
+{
+	return (classID < m_classes.size()) ? static_cast<uint32_t>(m_classes[classID].components.size()) : 0;
+}
+
+g2d::Component* const* ComponentRegistry::GetComponents(uint32_t classID) const
+{
+	if (GetCount(classID) == 0)
+		return nullptr;
+
+	return m_classes[classID].components.data();
+}
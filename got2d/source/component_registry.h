@@ -0,0 +1,63 @@
+#pragma once
+#include <memory>
+#include <mutex>
+#include <vector>
+#include "../include/g2dscene.h"
+#include "object_pool.h"
+
+// Memory of components created by g2d::CreateComponent, every class id
+// has its own pool, so that components of a class are close to each
+// other. Components may be created by jobs, pools are locked.
+class ComponentPools
+{
+public:
+	// never destroyed, components may be released after static destruction.
+	static ComponentPools& GetInstance();
+
+	void* Allocate(uint32_t classID, uint32_t size);
+
+	void Free(uint32_t classID, void* memory);
+
+	// number of allocated components of the class.
+	uint32_t GetCount(uint32_t classID) const;
+
+private:
+	ComponentPools() = default;
+
+	std::vector<std::unique_ptr<BlockPool>> m_pools;	// by class id.
+	mutable std::mutex m_mutex;
+};
+
+// Components attached to nodes of a scene, grouped by class id.
+// Components of a class are kept in a dense list for iterating, the
+// first component of a class on a node is indexed by the pool index of
+// the node. It's only modified on the main thread, parallel updating
+// defers adding and removing components.
+class ComponentRegistry
+{
+public:
+	void Add(g2d::Component& component);
+
+	void Remove(g2d::Component& component);
+
+	// component can be nullptr if the node has no component of the class.
+	void SetFirst(uint32_t classID, uint32_t nodeIndex, g2d::Component* component);
+
+	g2d::Component* FindFirst(uint32_t classID, uint32_t nodeIndex) const;
+
+	uint32_t GetCount(uint32_t classID) const;
+
+	// nullptr if no component of the class.
+	g2d::Component* const* GetComponents(uint32_t classID) const;
+
+private:
+	struct ClassComponents
+	{
+		std::vector<g2d::Component*> components;
+		std::vector<g2d::Component*> firstByNode;	// by pool index of node.
+	};
+
+	ClassComponents& GetClassComponents(uint32_t classID);
+
+	std::vector<ClassComponents> m_classes;	// by class id.
+};
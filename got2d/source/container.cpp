@@ -3,708 +3,416 @@
 
 ComponentContainer::~ComponentContainer()
 {
-	for (auto& c : m_components)
+	m_components.Clear([&](const NodeComponent& c)
 	{
 		if (c.AutoRelease)
 		{
 			c.ComponentPtr->Release();
 		}
-	}
-	m_components.clear();
-	DelayRemove();
-}
-
-void ComponentContainer::Collect()
-{
-	if (m_collectionChanged)
-	{
-		DelayRemove();
-		Recollect();
-		m_collectionChanged = false;
-	}
+	});
 }
 
 bool ComponentContainer::Add(g2d::SceneNode* parent, g2d::Component* component, bool autoRelease)
 {
-	if (m_components.empty())
+	if (m_components.Find([component](const NodeComponent& c) { return component == c.ComponentPtr; }) != nullptr)
 	{
-		m_components.push_back({ component , autoRelease });
-		component->SetSceneNode(parent);
-		component->OnInitial();
-		m_collectionChanged = true;
-		return true;
+		return false;
 	}
-	else
-	{
-		auto itEndReleased = m_released.end();
-		auto itFoundReleased = std::find_if(m_released.begin(), itEndReleased,
-			[component](const NodeComponent& c) { return component == c.ComponentPtr; });
-		if (itFoundReleased != itEndReleased)
-		{
-			m_released.erase(itFoundReleased);
-			return true;
-		}
 
-		auto itEnd = m_components.end();
-		auto itFound = std::find_if(m_components.begin(), itEnd,
-			[component](const NodeComponent& c) { return component == c.ComponentPtr; });
-		if (itFound != itEnd)
-		{
-			return false;
-		}
-
-		int cOrder = component->GetExecuteOrder();
-		int lastOrder = m_components.back().ComponentPtr->GetExecuteOrder();
-		if (cOrder < lastOrder)
-		{
-			m_components.push_back({ component, autoRelease });
-		}
-		else //try insert
-		{
-			auto itCur = m_components.begin();
-			for (; itCur != itEnd; itCur++)
-			{
-				if (itCur->ComponentPtr->GetExecuteOrder() > cOrder)
-					break;
-			}
-			m_components.insert(itCur, { component, autoRelease });
-		}
-		component->SetSceneNode(parent);
-		component->OnInitial();
-		m_collectionChanged = true;
-		return true;
-	}
+	m_components.Add({ component, autoRelease });
+	component->SetSceneNode(parent);
+	UpdateEventMask();
+	component->OnInitial();
+	return true;
 }
 
-bool ComponentContainer::Remove(g2d::Component* component, bool forceNotReleased)
+bool ComponentContainer::Remove(g2d::Component* component, bool& autoRelease)
 {
-	auto itEndReleased = m_released.end();
-	if (itEndReleased != std::find_if(m_released.begin(), itEndReleased,
-		[component](const NodeComponent& c) { return component == c.ComponentPtr; }))
+	NodeComponent removed(component, false);
+	if (!m_components.Remove([component](const NodeComponent& c) { return component == c.ComponentPtr; }, removed))
 	{
 		return false;
 	}
 
-	auto itEnd = m_components.end();
-	auto itFound = std::find_if(m_components.begin(), itEnd,
-		[component](NodeComponent& c) {return c.ComponentPtr == component; });
-
-	if (itFound != itEnd)
-	{
-		m_released.push_back({ component, !forceNotReleased && itFound->AutoRelease });
-		m_components.erase(itFound);
-		m_collectionChanged = true;
-		return true;
-	}
-	else
-	{
-		return false;
-	}
+	autoRelease = removed.AutoRelease;
+	UpdateEventMask();
+	return true;
 }
 
 bool ComponentContainer::IsAutoRelease(g2d::Component* component) const
 {
-	bool forcedNotReleased = false;
-	auto itEndReleased = m_released.end();
-	auto itFoundReleased = std::find_if(m_released.begin(), itEndReleased,
-		[component](const NodeComponent& c) { return component == c.ComponentPtr; });
-	if (itFoundReleased != itEndReleased)
-	{
-		forcedNotReleased = itFoundReleased->AutoRelease;
-	}
+	auto found = m_components.Find([component](const NodeComponent& c) { return component == c.ComponentPtr; });
+	return found == nullptr || found->AutoRelease;
+}
 
-	auto itEnd = m_components.end();
-	auto itFound = std::find_if(m_components.begin(), itEnd,
-		[component](const NodeComponent& c) { return component == c.ComponentPtr; });
+g2d::Component* ComponentContainer::At(uint32_t index) const
+{
+	ENSURE(index < GetCount());
+	return m_components.At(index).ComponentPtr;
+}
 
-	if (itFound == itEnd)
-	{
-		return !forcedNotReleased;
-	}
-	else
+void ComponentContainer::UpdateEventMask()
+{
+	m_eventMask = 0;
+	m_components.Traversal([&](const NodeComponent& c)
 	{
-		return !forcedNotReleased && itFound->AutoRelease;
-	}
+		m_eventMask |= c.EventMask;
+	});
 }
 
-g2d::Component* ComponentContainer::At(uint32_t index) const
+g2d::Component* ComponentContainer::Find(uint32_t classID) const
 {
-	return m_components.at(index).ComponentPtr;
+	auto found = m_components.Find([classID](const NodeComponent& c) { return c.ComponentPtr->GetClassID() == classID; });
+	return found == nullptr ? nullptr : found->ComponentPtr;
 }
 
-void ComponentContainer::DelayRemove()
+void NodeSubscribers::Add(::SceneNode& node, uint32_t nodeIndex)
 {
-	if (m_released.size() != 0)
+	if (nodeIndex >= m_positions.size())
 	{
-		for (auto& rcomponent : m_released)
-		{
-			if (rcomponent.AutoRelease)
-			{
-				rcomponent.ComponentPtr->Release();
-			}
-		}
-		m_released.clear();
+		m_positions.resize(nodeIndex + 1, INVALID_POSITION);
 	}
-}
 
-void ComponentContainer::Recollect()
-{
-	m_collection.clear();
-	for (auto& c : m_components)
+	if (m_positions[nodeIndex] == INVALID_POSITION)
 	{
-		m_collection.push_back(c);
+		m_positions[nodeIndex] = static_cast<uint32_t>(m_nodes.size());
+		m_nodes.push_back(&node);
+		m_nodeIndices.push_back(nodeIndex);
 	}
 }
 
-SceneNodeContainer::~SceneNodeContainer()
+void NodeSubscribers::Remove(uint32_t nodeIndex)
 {
-	ClearChildren();
+	if (nodeIndex >= m_positions.size() || m_positions[nodeIndex] == INVALID_POSITION)
+		return;
+
+	// the last one fills the hole.
+	uint32_t position = m_positions[nodeIndex];
+	uint32_t lastIndex = m_nodeIndices.back();
+	m_nodes[position] = m_nodes.back();
+	m_nodeIndices[position] = lastIndex;
+	m_positions[lastIndex] = position;
+	m_nodes.pop_back();
+	m_nodeIndices.pop_back();
+	m_positions[nodeIndex] = INVALID_POSITION;
 }
 
+const uint32_t NodeSubscribers::INVALID_POSITION;
 
-void SceneNodeContainer::ClearChildren()
+SceneNodeContainer::~SceneNodeContainer()
 {
-	for (auto& child : m_children)
-	{
-		delete child;
-	}
-	m_children.clear();
-	DelayRemove();
+	ClearChildren();
 }
 
-void SceneNodeContainer::Collect()
+
+void SceneNodeContainer::ClearChildren()
 {
-	if (m_collectionChanged)
+	for (::SceneNode* child = First(); child != nullptr;)
 	{
-		DelayRemove();
-		Recollect();
-		m_collectionChanged = false;
+		::SceneNode* next = child->GetNextSibling();
+		child->Destroy();
+		child = next;
 	}
+	m_list.Clear();
 }
 
 ::SceneNode* SceneNodeContainer::CreateChild(::Scene& scene, ::SceneNode& parent)
 {
 	uint32_t childID = GetCount();
-	auto rst = new ::SceneNode(scene, &parent, childID);
-	m_children.push_back(rst);
-	m_collectionChanged = true;
+	auto rst = scene.CreateSceneNode(&parent, childID);
+	m_list.Append(rst);
 	return rst;
 }
 
 ::SceneNode* SceneNodeContainer::CreateChild(::Scene& scene, SceneNodeContainer& parent)
 {
 	uint32_t childID = GetCount();
-	auto rst = new ::SceneNode(scene, parent, childID);
-	m_children.push_back(rst);
-	m_collectionChanged = true;
+	auto rst = scene.CreateSceneNode(parent, childID);
+	m_list.Append(rst);
 	return rst;
 }
 
 
-::SceneNode* SceneNodeContainer::At(uint32_t index) const
+void SceneNodeContainer::Attach(::SceneNode& child)
 {
-	ENSURE(index < m_children.size());
-	return m_children[index];
+	child.SetChildIndex(GetCount());
+	m_list.Append(&child);
 }
 
-::SceneNode * SceneNodeContainer::First() const
+::SceneNode* SceneNodeContainer::At(uint32_t index) const
 {
-	return m_children.empty() ? nullptr : *m_children.begin();
+	return m_list.At(index);
 }
 
-::SceneNode * SceneNodeContainer::Last() const
+uint32_t SceneNodeContainer::IndexOf(const ::SceneNode& child) const
 {
-	return m_children.empty() ? nullptr : m_children.back();
+	return m_list.IndexOf(&child);
 }
 
-void SceneNodeContainer::Remove(::SceneNode& child)
+bool SceneNodeContainer::Remove(::SceneNode& child)
 {
-	::SceneNode* releasedChild = &child;
-
-	auto itEndReleased = m_released.end();
-	if (itEndReleased == std::find(m_released.begin(), itEndReleased, releasedChild))
-	{
-		auto itEnd = m_children.end();
-		auto itFound = std::find(m_children.begin(), itEnd, releasedChild);
-		if (itFound != itEnd)
-		{
-			uint32_t index = releasedChild->GetChildIndex();
-			m_released.push_back(releasedChild);
-			itFound = m_children.erase(itFound);
-			itEnd = m_children.end();
-			for (; itFound != itEnd; itFound++)
-			{
-				(*itFound)->SetChildIndex(index++);
-			}
-			m_collectionChanged = true;
-		}
-	}
-}
-
-bool SceneNodeContainer::Move(uint32_t from, uint32_t to)
-{
-	ENSURE(to < m_children.size() && from < m_children.size());
-	if (from == to)
-		return false;
-
-	auto& siblings = m_children;
-	auto fromNode = siblings[from];
-	auto formOrder = siblings[from]->GetRenderingOrder();
-	auto toOrder = siblings[to]->GetRenderingOrder();
-
-	// for actual dirty flag: RenderingOrderDirtyNode
-	fromNode->SetRenderingOrderOnly(toOrder);
-	siblings[to]->SetRenderingOrderOnly(formOrder);
-
-	if (from > to)
-	{
-		for (auto itID = to; itID < from; itID++)
-		{
-			siblings[itID + 1] = siblings[itID];
-			siblings[itID + 1]->SetChildIndex(itID + 1);
-		}
-	}
-	else
-	{
-		for (auto itID = from; itID < to; itID++)
-		{
-			siblings[itID] = siblings[itID + 1];
-			siblings[itID]->SetChildIndex(itID);
-		}
-	}
-	siblings[to] = fromNode;
-	fromNode->SetChildIndex(to);
-	return true;
-}
-
-void SceneNodeContainer::DelayRemove()
-{
-	if (m_released.size() != 0)
-	{
-		for (auto& rnode : m_released)
-		{
-			delete rnode;
-		}
-		m_released.clear();
-	}
+	return m_list.Remove(&child);
 }
 
-
-void SceneNodeContainer::Recollect()
+bool SceneNodeContainer::Move(::SceneNode& child, ::SceneNode* before)
 {
-	m_collection.clear();
-	for (auto& c : m_children)
-	{
-		m_collection.push_back(c);
-	}
+	return m_list.Move(&child, before);
 }
 
-
-
 // Event Dispatcher 
-void ComponentContainer::OnRotate(gml::radian r)
-{
-	for (auto& c : m_components)
-	{
-		c.ComponentPtr->OnRotate(r);
-	}
-}
-
-void ComponentContainer::OnScale(const gml::vec2 & s)
-{
-	for (auto& c : m_components)
-	{
-		c.ComponentPtr->OnScale(s);
-	}
-}
-
-void ComponentContainer::OnMove(const gml::vec2 & p)
+void ComponentContainer::OnTransformChanged(uint32_t changes)
 {
-	for (auto& c : m_components)
+	Dispatch(g2d::EventMask::TransformChanged, [&](g2d::Component* component)
 	{
-		c.ComponentPtr->OnMove(p);
-	}
+		component->OnTransformChanged(changes);
+	});
 }
 
 void ComponentContainer::OnMessage(const g2d::Message & message)
 {
-	Collect();
-	for (auto& c : m_collection)
+	Dispatch(g2d::EventMask::Message, [&](g2d::Component* component)
 	{
-		c.ComponentPtr->OnMessage(message);
-	}
-	DelayRemove();
+		component->OnMessage(message);
+	});
 }
 
 void ComponentContainer::OnUpdate(uint32_t deltaTime)
 {
-	Collect();
-	for (auto& c : m_collection)
+	Dispatch(g2d::EventMask::Update, [&](g2d::Component* component)
 	{
-		c.ComponentPtr->OnUpdate(deltaTime);
-	}
-	DelayRemove();
+		component->OnUpdate(deltaTime);
+	});
 }
 
 void ComponentContainer::OnUpdateMatrixChanged()
 {
-	Collect();
-	for (auto& c : m_collection)
+	Dispatch(g2d::EventMask::UpdateMatrixChanged, [&](g2d::Component* component)
 	{
-		c.ComponentPtr->OnUpdateMatrixChanged();
-	}
-	DelayRemove();
+		component->OnUpdateMatrixChanged();
+	});
 }
 
 void ComponentContainer::OnCursorEnterFrom(::SceneNode * adjacency)
 {
-	Collect();
-	for (auto& c : m_collection)
+	Dispatch(g2d::EventMask::Cursor, [&](g2d::Component* component)
 	{
-		c.ComponentPtr->OnCursorEnterFrom(adjacency, GetMouse(), GetKeyboard());
-	}
-	DelayRemove();
+		component->OnCursorEnterFrom(adjacency, GetMouse(), GetKeyboard());
+	});
 }
 
 void ComponentContainer::OnCursorHovering()
 {
-	Collect();
-	for (auto& c : m_collection)
+	Dispatch(g2d::EventMask::Cursor, [&](g2d::Component* component)
 	{
-		c.ComponentPtr->OnCursorHovering(GetMouse(), GetKeyboard());
-	}
-	DelayRemove();
+		component->OnCursorHovering(GetMouse(), GetKeyboard());
+	});
 }
 
 void ComponentContainer::OnCursorLeaveTo(::SceneNode * adjacency)
 {
-	Collect();
-	for (auto& c : m_collection)
+	Dispatch(g2d::EventMask::Cursor, [&](g2d::Component* component)
 	{
-		c.ComponentPtr->OnCursorLeaveTo(adjacency, GetMouse(), GetKeyboard());
-	}
-	DelayRemove();
+		component->OnCursorLeaveTo(adjacency, GetMouse(), GetKeyboard());
+	});
 }
 
 void ComponentContainer::OnLClick()
 {
-	Collect();
-	for (auto& c : m_collection)
+	Dispatch(g2d::EventMask::Click, [&](g2d::Component* component)
 	{
-		c.ComponentPtr->OnLClick(GetMouse(), GetKeyboard());
-	}
-	DelayRemove();
+		component->OnLClick(GetMouse(), GetKeyboard());
+	});
 }
 
 void ComponentContainer::OnRClick()
 {
-	Collect();
-	for (auto& c : m_collection)
+	Dispatch(g2d::EventMask::Click, [&](g2d::Component* component)
 	{
-		c.ComponentPtr->OnRClick(GetMouse(), GetKeyboard());
-	}
-	DelayRemove();
+		component->OnRClick(GetMouse(), GetKeyboard());
+	});
 }
 
 void ComponentContainer::OnMClick()
 {
-	Collect();
-	for (auto& c : m_collection)
+	Dispatch(g2d::EventMask::Click, [&](g2d::Component* component)
 	{
-		c.ComponentPtr->OnMClick(GetMouse(), GetKeyboard());
-	}
-	DelayRemove();
+		component->OnMClick(GetMouse(), GetKeyboard());
+	});
 }
 
 void ComponentContainer::OnLDoubleClick()
 {
-	Collect();
-	for (auto& c : m_collection)
+	Dispatch(g2d::EventMask::DoubleClick, [&](g2d::Component* component)
 	{
-		c.ComponentPtr->OnLDoubleClick(GetMouse(), GetKeyboard());
-	}
-	DelayRemove();
+		component->OnLDoubleClick(GetMouse(), GetKeyboard());
+	});
 }
 
 void ComponentContainer::OnRDoubleClick()
 {
-	Collect();
-	for (auto& c : m_collection)
+	Dispatch(g2d::EventMask::DoubleClick, [&](g2d::Component* component)
 	{
-		c.ComponentPtr->OnRDoubleClick(GetMouse(), GetKeyboard());
-	}
-	DelayRemove();
+		component->OnRDoubleClick(GetMouse(), GetKeyboard());
+	});
 }
 
 void ComponentContainer::OnMDoubleClick()
 {
-	Collect();
-	for (auto& c : m_collection)
+	Dispatch(g2d::EventMask::DoubleClick, [&](g2d::Component* component)
 	{
-		c.ComponentPtr->OnMDoubleClick(GetMouse(), GetKeyboard());
-	}
-	DelayRemove();
+		component->OnMDoubleClick(GetMouse(), GetKeyboard());
+	});
 }
 
 void ComponentContainer::OnLDragBegin()
 {
-	Collect();
-	for (auto& c : m_collection)
+	Dispatch(g2d::EventMask::Drag, [&](g2d::Component* component)
 	{
-		c.ComponentPtr->OnLDragBegin(GetMouse(), GetKeyboard());
-	}
-	DelayRemove();
+		component->OnLDragBegin(GetMouse(), GetKeyboard());
+	});
 }
 
 void ComponentContainer::OnRDragBegin()
 {
-	Collect();
-	for (auto& c : m_collection)
+	Dispatch(g2d::EventMask::Drag, [&](g2d::Component* component)
 	{
-		c.ComponentPtr->OnRDragBegin(GetMouse(), GetKeyboard());
-	}
-	DelayRemove();
+		component->OnRDragBegin(GetMouse(), GetKeyboard());
+	});
 }
 
 void ComponentContainer::OnMDragBegin()
 {
-	Collect();
-	for (auto& c : m_collection)
+	Dispatch(g2d::EventMask::Drag, [&](g2d::Component* component)
 	{
-		c.ComponentPtr->OnMDragBegin(GetMouse(), GetKeyboard());
-	}
-	DelayRemove();
+		component->OnMDragBegin(GetMouse(), GetKeyboard());
+	});
 }
 
 void ComponentContainer::OnLDragging()
 {
-	Collect();
-	for (auto& c : m_collection)
+	Dispatch(g2d::EventMask::Drag, [&](g2d::Component* component)
 	{
-		c.ComponentPtr->OnLDragging(GetMouse(), GetKeyboard());
-	}
-	DelayRemove();
+		component->OnLDragging(GetMouse(), GetKeyboard());
+	});
 }
 
 void ComponentContainer::OnRDragging()
 {
-	Collect();
-	for (auto& c : m_collection)
+	Dispatch(g2d::EventMask::Drag, [&](g2d::Component* component)
 	{
-		c.ComponentPtr->OnRDragging(GetMouse(), GetKeyboard());
-	}
-	DelayRemove();
+		component->OnRDragging(GetMouse(), GetKeyboard());
+	});
 }
 
 void ComponentContainer::OnMDragging()
 {
-	Collect();
-	for (auto& c : m_collection)
+	Dispatch(g2d::EventMask::Drag, [&](g2d::Component* component)
 	{
-		c.ComponentPtr->OnMDragging(GetMouse(), GetKeyboard());
-	}
-	DelayRemove();
+		component->OnMDragging(GetMouse(), GetKeyboard());
+	});
 }
 
 void ComponentContainer::OnLDragEnd()
 {
-	Collect();
-	for (auto& c : m_collection)
+	Dispatch(g2d::EventMask::Drag, [&](g2d::Component* component)
 	{
-		c.ComponentPtr->OnLDragEnd(GetMouse(), GetKeyboard());
-	}
-	DelayRemove();
+		component->OnLDragEnd(GetMouse(), GetKeyboard());
+	});
 }
 
 void ComponentContainer::OnRDragEnd()
 {
-	Collect();
-	for (auto& c : m_collection)
+	Dispatch(g2d::EventMask::Drag, [&](g2d::Component* component)
 	{
-		c.ComponentPtr->OnRDragEnd(GetMouse(), GetKeyboard());
-	}
-	DelayRemove();
+		component->OnRDragEnd(GetMouse(), GetKeyboard());
+	});
 }
 
 void ComponentContainer::OnMDragEnd()
 {
-	Collect();
-	for (auto& c : m_collection)
+	Dispatch(g2d::EventMask::Drag, [&](g2d::Component* component)
 	{
-		c.ComponentPtr->OnMDragEnd(GetMouse(), GetKeyboard());
-	}
-	DelayRemove();
+		component->OnMDragEnd(GetMouse(), GetKeyboard());
+	});
 }
 
 void ComponentContainer::OnLDropping(::SceneNode * dropped)
 {
-	Collect();
-	for (auto& c : m_collection)
+	Dispatch(g2d::EventMask::Drop, [&](g2d::Component* component)
 	{
-		c.ComponentPtr->OnLDropping(dropped, GetMouse(), GetKeyboard());
-	}
-	DelayRemove();
+		component->OnLDropping(dropped, GetMouse(), GetKeyboard());
+	});
 }
 
 void ComponentContainer::OnRDropping(::SceneNode * dropped)
 {
-	Collect();
-	for (auto& c : m_collection)
+	Dispatch(g2d::EventMask::Drop, [&](g2d::Component* component)
 	{
-		c.ComponentPtr->OnRDropping(dropped, GetMouse(), GetKeyboard());
-	}
-	DelayRemove();
+		component->OnRDropping(dropped, GetMouse(), GetKeyboard());
+	});
 }
 
 void ComponentContainer::OnMDropping(::SceneNode * dropped)
 {
-	Collect();
-	for (auto& c : m_collection)
+	Dispatch(g2d::EventMask::Drop, [&](g2d::Component* component)
 	{
-		c.ComponentPtr->OnMDropping(dropped, GetMouse(), GetKeyboard());
-	}
-	DelayRemove();
+		component->OnMDropping(dropped, GetMouse(), GetKeyboard());
+	});
 }
 
 void ComponentContainer::OnLDropTo(::SceneNode * dropped)
 {
-	Collect();
-	for (auto& c : m_collection)
+	Dispatch(g2d::EventMask::Drop, [&](g2d::Component* component)
 	{
-		c.ComponentPtr->OnLDropTo(dropped, GetMouse(), GetKeyboard());
-	}
-	DelayRemove();
+		component->OnLDropTo(dropped, GetMouse(), GetKeyboard());
+	});
 }
 
 void ComponentContainer::OnRDropTo(::SceneNode * dropped)
 {
-	Collect();
-	for (auto& c : m_collection)
+	Dispatch(g2d::EventMask::Drop, [&](g2d::Component* component)
 	{
-		c.ComponentPtr->OnRDropTo(dropped, GetMouse(), GetKeyboard());
-	}
-	DelayRemove();
+		component->OnRDropTo(dropped, GetMouse(), GetKeyboard());
+	});
 }
 
 void ComponentContainer::OnMDropTo(::SceneNode * dropped)
 {
-	Collect();
-	for (auto& c : m_collection)
+	Dispatch(g2d::EventMask::Drop, [&](g2d::Component* component)
 	{
-		c.ComponentPtr->OnMDropTo(dropped, GetMouse(), GetKeyboard());
-	}
-	DelayRemove();
+		component->OnMDropTo(dropped, GetMouse(), GetKeyboard());
+	});
 }
 
 void ComponentContainer::OnKeyPress(g2d::KeyCode key)
 {
-	Collect();
-	for (auto& c : m_collection)
+	Dispatch(g2d::EventMask::Key, [&](g2d::Component* component)
 	{
-		c.ComponentPtr->OnKeyPress(key, GetMouse(), GetKeyboard());
-	}
-	DelayRemove();
+		component->OnKeyPress(key, GetMouse(), GetKeyboard());
+	});
 }
 
 void ComponentContainer::OnKeyPressingBegin(g2d::KeyCode key)
 {
-	Collect();
-	for (auto& c : m_collection)
+	Dispatch(g2d::EventMask::Key, [&](g2d::Component* component)
 	{
-		c.ComponentPtr->OnKeyPressingBegin(key, GetMouse(), GetKeyboard());
-	}
-	DelayRemove();
+		component->OnKeyPressingBegin(key, GetMouse(), GetKeyboard());
+	});
 }
 
 void ComponentContainer::OnKeyPressing(g2d::KeyCode key)
 {
-	Collect();
-	for (auto& c : m_collection)
+	Dispatch(g2d::EventMask::Key, [&](g2d::Component* component)
 	{
-		c.ComponentPtr->OnKeyPressing(key, GetMouse(), GetKeyboard());
-	}
-	DelayRemove();
+		component->OnKeyPressing(key, GetMouse(), GetKeyboard());
+	});
 }
 
 void ComponentContainer::OnKeyPressingEnd(g2d::KeyCode key)
 {
-	Collect();
-	for (auto& c : m_collection)
-	{
-		c.ComponentPtr->OnKeyPressingEnd(key, GetMouse(), GetKeyboard());
-	}
-	DelayRemove();
-}
-
-
-void SceneNodeContainer::OnMessage(const g2d::Message & message)
-{
-	// Collecting  must not be process before
-	// dispatching, or will cause potential 
-	// recursive dispatching
-	for (auto& child : m_collection)
-	{
-		child->OnMessage(message);
-	}
-	Collect();
-}
-
-void SceneNodeContainer::OnUpdate(uint32_t deltaTime)
-{
-	// Collecting  must not be process before
-	// dispatching, or will cause potential 
-	// recursive dispatching
-	for (auto& child : m_collection)
+	Dispatch(g2d::EventMask::Key, [&](g2d::Component* component)
 	{
-		child->OnUpdate(deltaTime);
-	}
-	Collect();
+		component->OnKeyPressingEnd(key, GetMouse(), GetKeyboard());
+	});
 }
 
-void SceneNodeContainer::OnKeyPress(g2d::KeyCode key)
-{
-	// Collecting  must not be process before
-	// dispatching, or will cause potential 
-	// recursive dispatching
-	for (auto& child : m_collection)
-	{
-		child->OnKeyPress(key);
-	}
-	Collect();
-}
-
-void SceneNodeContainer::OnKeyPressingBegin(g2d::KeyCode key)
-{
-	// Collecting  must not be process before
-	// dispatching, or will cause potential 
-	// recursive dispatching
-	for (auto& child : m_collection)
-	{
-		child->OnKeyPressingBegin(key);
-	}
-	Collect();
-}
-
-void SceneNodeContainer::OnKeyPressing(g2d::KeyCode key)
-{
-	// Collecting  must not be process before
-	// dispatching, or will cause potential 
-	// recursive dispatching
-	for (auto& child : m_collection)
-	{
-		child->OnKeyPressing(key);
-	}
-	Collect();
-}
-
-void SceneNodeContainer::OnKeyPressingEnd(g2d::KeyCode key)
-{
-	// Collecting  must not be process before
-	// dispatching, or will cause potential 
-	// recursive dispatching
-	for (auto& child : m_collection)
-	{
-		child->OnKeyPressingEnd(key);
-	}
-	Collect();
-}
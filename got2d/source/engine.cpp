@@ -1,5 +1,6 @@
 #include <algorithm>
 #include "engine.h"
+#include "pixel_format.h"
 
 uint32_t G2DAPI NextClassID()
 {
@@ -31,7 +32,15 @@ bool g2d::Engine::Initialize(const Config& config)
 
 
 	instance->SetResourceRoot(config.resourceFolderPath);
-	if (!instance->CreateRenderSystem(config.nativeWindow))
+	for (uint32_t i = 0; i < config.resourcePackCount; i++)
+	{
+		if (!instance->GetFileSystem().MountArchive(config.resourcePacks[i]))
+		{
+			return false;
+		}
+	}
+
+	if (!instance->CreateRenderSystem(config))
 	{
 		return false;
 	}
@@ -55,6 +64,8 @@ g2d::Engine* g2d::Engine::Instance()
 
 Engine::~Engine()
 {
+	SetPixelJobSystem(nullptr);
+	m_jobSystem.Stop();
 	m_renderSystem.Destroy();
 }
 
@@ -74,6 +85,8 @@ g2d::Scene* Engine::CreateNewScene(float boundSize)
 
 void Engine::Update(uint32_t deltaTime)
 {
+	// nothing runs between frames, frame memory of last one can be reused.
+	m_jobSystem.ResetFrameMemory();
 	m_elapsedTime += deltaTime;
 
 	GetKeyboard().Update(m_elapsedTime);
@@ -112,25 +125,32 @@ bool Engine::OnResize(uint32_t width, uint32_t height)
 	}
 }
 
-bool Engine::CreateRenderSystem(void* nativeWindow)
+bool Engine::CreateRenderSystem(const Config& config)
 {
-	nativeWindow = nativeWindow;
-	if (!m_renderSystem.Create(nativeWindow))
+	nativeWindow = config.nativeWindow;
+	if (!m_renderSystem.Create(config.nativeWindow))
 	{
 		return false;
 	}
+	uint32_t jobThreads = config.jobThreads;
+	if (jobThreads == 0xFFFFFFFF)
+	{
+		uint32_t cores = std::thread::hardware_concurrency();
+		jobThreads = (cores > 1) ? cores - 1 : 0;
+	}
+	m_jobSystem.Start(jobThreads);
+	SetPixelJobSystem(&m_jobSystem);
+	m_asyncIO.Start(config.fileReadingThreads, config.fileReadingQueueDepth);
+	m_renderSystem.GetTexturePool().StartStreaming(config.textureLoadingThreads, config.textureUploadBudget);
+	m_renderSystem.SetTextureMemoryBudget(config.textureMemoryBudget);
 	return true;
 }
 
 void Engine::SetResourceRoot(const std::string& resPath)
 {
+	// '/' works on every platform, including windows.
 	if (!resPath.empty())
 	{
-		m_resourceRoot = resPath;
-		std::replace(m_resourceRoot.begin(), m_resourceRoot.end(), '/', '\\');
-		if (m_resourceRoot.back() != '\\')
-		{
-			m_resourceRoot.push_back('\\');
-		}
+		m_fileSystem.SetRoot(resPath);
 	}
 }
@@ -2,6 +2,8 @@
 #include <vector>
 #include <string>
 #include "../include/g2dengine.h"
+#include "file_system.h"
+#include "job_system.h"
 #include "render_system.h"
 #include "scene.h"
 
@@ -13,11 +15,17 @@ public:
 
 	~Engine();
 
-	bool CreateRenderSystem(void* nativeWindow);
+	bool CreateRenderSystem(const Config& config);
 
 	void SetResourceRoot(const std::string& resPath);
 
-	const std::string& GetResourceRoot() const { return m_resourceRoot; }
+	const std::string& GetResourceRoot() const { return m_fileSystem.GetRoot(); }
+
+	FileSystem& GetFileSystem() { return m_fileSystem; }
+
+	AsyncIO& GetAsyncIO() { return m_asyncIO; }
+
+	JobSystem& GetJobSystem() { return m_jobSystem; }
 
 	void RemoveScene(::Scene& scene);
 
@@ -36,8 +44,10 @@ private:
 	uint32_t m_elapsedTime = 0;
 
 	void* nativeWindow = nullptr;
+	FileSystem m_fileSystem;
+	AsyncIO m_asyncIO;
+	JobSystem m_jobSystem;
 	RenderSystem m_renderSystem;
-	std::string m_resourceRoot;
 	std::vector<::Scene*> m_scenes;
 };
 
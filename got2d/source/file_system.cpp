@@ -0,0 +1,448 @@
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include "file_system.h"
+
+#ifdef _WIN32
+#include <Windows.h>
+#else
+#include <sys/types.h>
+#include <dirent.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+
+bool MappedFile::Open(const std::string& path)
+{
+	Close();
+#ifdef _WIN32
+	HANDLE file = ::CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr,
+		OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL | FILE_FLAG_RANDOM_ACCESS, nullptr);
+	if (file == INVALID_HANDLE_VALUE)
+		return false;
+
+	LARGE_INTEGER size;
+	if (!::GetFileSizeEx(file, &size) || size.QuadPart == 0)
+	{
+		::CloseHandle(file);
+		return false;
+	}
+
+	HANDLE mapping = ::CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+	if (mapping == nullptr)
+	{
+		::CloseHandle(file);
+		return false;
+	}
+
+	void* data = ::MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+	if (data == nullptr)
+	{
+		::CloseHandle(mapping);
+		::CloseHandle(file);
+		return false;
+	}
+
+	m_file = file;
+	m_mapping = mapping;
+	m_data = static_cast<const uint8_t*>(data);
+	m_size = static_cast<uint64_t>(size.QuadPart);
+#else
+	int fd = ::open(path.c_str(), O_RDONLY);
+	if (fd < 0)
+		return false;
+
+	struct stat st;
+	if (::fstat(fd, &st) != 0 || st.st_size == 0)
+	{
+		::close(fd);
+		return false;
+	}
+
+	// mapping keeps the file alive, descriptor is not needed anymore.
+	void* data = ::mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+	::close(fd);
+	if (data == MAP_FAILED)
+		return false;
+
+	m_data = static_cast<const uint8_t*>(data);
+	m_size = static_cast<uint64_t>(st.st_size);
+#endif
+	return true;
+}
+
+void MappedFile::Close()
+{
+#ifdef _WIN32
+	if (m_data != nullptr)
+		::UnmapViewOfFile(m_data);
+	if (m_mapping != nullptr)
+		::CloseHandle(m_mapping);
+	if (m_file != nullptr)
+		::CloseHandle(m_file);
+	m_file = nullptr;
+	m_mapping = nullptr;
+#else
+	if (m_data != nullptr)
+		::munmap(const_cast<uint8_t*>(m_data), m_size);
+#endif
+	m_data = nullptr;
+	m_size = 0;
+}
+
+bool PackArchive::Open(const std::string& path)
+{
+	m_header = nullptr;
+	m_entries = nullptr;
+	m_names = nullptr;
+	if (!m_file.Open(path))
+		return false;
+
+	const uint8_t* data = m_file.GetData();
+	uint64_t size = m_file.GetSize();
+	auto header = reinterpret_cast<const PackHeader*>(data);
+	if (size < sizeof(PackHeader) ||
+		header->magic != PACK_MAGIC ||
+		header->version != PACK_VERSION ||
+		sizeof(PackHeader) + static_cast<uint64_t>(header->entryCount) * sizeof(PackEntry) > header->namesOffset ||
+		header->namesOffset > size ||
+		header->namesSize > size - header->namesOffset)
+	{
+		m_file.Close();
+		return false;
+	}
+
+	// validate once, so that lookups need no bounds checking.
+	auto entries = reinterpret_cast<const PackEntry*>(data + sizeof(PackHeader));
+	auto names = reinterpret_cast<const char*>(data + header->namesOffset);
+	for (uint32_t i = 0; i < header->entryCount; i++)
+	{
+		const PackEntry& entry = entries[i];
+		bool valid = entry.dataOffset <= size && entry.dataSize <= size - entry.dataOffset &&
+			static_cast<uint64_t>(entry.nameOffset) + entry.nameLength <= header->namesSize;
+		if (valid && i > 0)
+		{
+			// unsigned, the same as std::string order of g2dpack and Find.
+			const PackEntry& prev = entries[i - 1];
+			size_t compareLength = std::min(prev.nameLength, entry.nameLength);
+			int result = memcmp(names + prev.nameOffset, names + entry.nameOffset, compareLength);
+			valid = result < 0 || (result == 0 && prev.nameLength < entry.nameLength);
+		}
+
+		if (!valid)
+		{
+			m_file.Close();
+			return false;
+		}
+	}
+
+	m_header = header;
+	m_entries = entries;
+	m_names = names;
+	return true;
+}
+
+std::string PackArchive::GetEntryName(uint32_t index) const
+{
+	return std::string(m_names + m_entries[index].nameOffset, m_entries[index].nameLength);
+}
+
+bool PackArchive::Find(const std::string& name, uint32_t& index) const
+{
+	uint32_t lower = 0;
+	uint32_t upper = GetEntryCount();
+	while (lower < upper)
+	{
+		uint32_t middle = lower + (upper - lower) / 2;
+		const PackEntry& entry = m_entries[middle];
+		size_t compareLength = std::min<size_t>(entry.nameLength, name.size());
+		int result = memcmp(m_names + entry.nameOffset, name.data(), compareLength);
+		if (result == 0)
+		{
+			if (entry.nameLength == name.size())
+			{
+				index = middle;
+				return true;
+			}
+			result = entry.nameLength < name.size() ? -1 : 1;
+		}
+
+		if (result < 0)
+			lower = middle + 1;
+		else
+			upper = middle;
+	}
+	return false;
+}
+
+void FileView::Reference(const uint8_t* data, uint64_t size)
+{
+	m_buffer.clear();
+	m_data = data;
+	m_size = size;
+}
+
+std::vector<uint8_t>& FileView::AllocateBuffer(uint64_t size)
+{
+	m_buffer.resize(static_cast<size_t>(size));
+	m_data = m_buffer.data();
+	m_size = size;
+	return m_buffer;
+}
+
+void FileView::Release()
+{
+	std::vector<uint8_t>().swap(m_buffer);
+	m_data = nullptr;
+	m_size = 0;
+}
+
+FILE* OpenForReading(const std::string& path)
+{
+	FILE* file = nullptr;
+#ifdef _MSC_VER
+	if (fopen_s(&file, path.c_str(), "rb") != 0)
+		return nullptr;
+#else
+	file = fopen(path.c_str(), "rb");
+#endif
+	return file;
+}
+
+bool ReadLooseFile(const std::string& path, FileView& view)
+{
+	FILE* file = OpenForReading(path);
+	if (file == nullptr)
+		return false;
+
+	bool result = false;
+	if (fseek(file, 0, SEEK_END) == 0)
+	{
+		long size = ftell(file);
+		if (size >= 0 && fseek(file, 0, SEEK_SET) == 0)
+		{
+			auto& buffer = view.AllocateBuffer(size);
+			result = fread(buffer.data(), 1, size, file) == static_cast<size_t>(size);
+		}
+	}
+	fclose(file);
+	return result;
+}
+
+bool WriteLooseFile(const std::string& path, const void* data, uint64_t size)
+{
+	FILE* file = nullptr;
+#ifdef _MSC_VER
+	if (fopen_s(&file, path.c_str(), "wb") != 0)
+		return false;
+#else
+	file = fopen(path.c_str(), "wb");
+	if (file == nullptr)
+		return false;
+#endif
+
+	bool result = fwrite(data, 1, static_cast<size_t>(size), file) == size;
+	return fclose(file) == 0 && result;
+}
+
+bool GetLooseFileSize(const std::string& path, uint64_t& size)
+{
+#ifdef _WIN32
+	WIN32_FILE_ATTRIBUTE_DATA attributes;
+	if (!::GetFileAttributesExA(path.c_str(), GetFileExInfoStandard, &attributes) ||
+		(attributes.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY))
+	{
+		return false;
+	}
+	size = (static_cast<uint64_t>(attributes.nFileSizeHigh) << 32) | attributes.nFileSizeLow;
+#else
+	struct stat st;
+	if (::stat(path.c_str(), &st) != 0 || !S_ISREG(st.st_mode))
+		return false;
+	size = static_cast<uint64_t>(st.st_size);
+#endif
+	return true;
+}
+
+void CollectLooseFiles(const std::string& folder, const std::string& prefix, std::vector<std::string>& names)
+{
+#ifdef _WIN32
+	WIN32_FIND_DATAA findData;
+	HANDLE find = ::FindFirstFileA((folder + prefix + "*").c_str(), &findData);
+	if (find == INVALID_HANDLE_VALUE)
+		return;
+
+	do
+	{
+		std::string name = findData.cFileName;
+		if (name == "." || name == "..")
+			continue;
+
+		if (findData.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY)
+			CollectLooseFiles(folder, prefix + name + "/", names);
+		else
+			names.push_back(prefix + name);
+	} while (::FindNextFileA(find, &findData));
+	::FindClose(find);
+#else
+	DIR* dir = ::opendir((folder + prefix).c_str());
+	if (dir == nullptr)
+		return;
+
+	while (dirent* entry = ::readdir(dir))
+	{
+		std::string name = entry->d_name;
+		if (name == "." || name == "..")
+			continue;
+
+		struct stat st;
+		if (::stat((folder + prefix + name).c_str(), &st) != 0)
+			continue;
+
+		if (S_ISDIR(st.st_mode))
+			CollectLooseFiles(folder, prefix + name + "/", names);
+		else if (S_ISREG(st.st_mode))
+			names.push_back(prefix + name);
+	}
+	::closedir(dir);
+#endif
+}
+
+void ListLooseFiles(const std::string& folder, std::vector<std::string>& names)
+{
+	std::string root = folder;
+	std::replace(root.begin(), root.end(), '\\', '/');
+	if (!root.empty() && root.back() != '/')
+		root.push_back('/');
+
+	names.clear();
+	CollectLooseFiles(root, "", names);
+	std::sort(names.begin(), names.end());
+}
+
+bool IsAbsolutePath(const std::string& path)
+{
+	return (!path.empty() && path[0] == '/') || (path.size() > 1 && path[1] == ':');
+}
+
+void FileSystem::SetRoot(const std::string& root)
+{
+	m_root = root;
+	std::replace(m_root.begin(), m_root.end(), '\\', '/');
+	if (!m_root.empty() && m_root.back() != '/')
+	{
+		m_root.push_back('/');
+	}
+}
+
+bool FileSystem::MountArchive(const std::string& path)
+{
+	std::string fullPath = IsAbsolutePath(path) ? path : m_root + NormalizePath(path);
+	std::unique_ptr<PackArchive> archive(new PackArchive());
+	if (!archive->Open(fullPath))
+		return false;
+
+	m_archives.push_back(std::move(archive));
+	return true;
+}
+
+void FileSystem::UnmountAll()
+{
+	m_archives.clear();
+}
+
+std::string FileSystem::NormalizePath(const std::string& path)
+{
+	std::string normalized;
+	normalized.reserve(path.size());
+	for (size_t i = 0; i < path.size(); i++)
+	{
+		char c = (path[i] == '\\') ? '/' : path[i];
+		if (c == '/' && !normalized.empty() && normalized.back() == '/')
+			continue;
+
+		// skip "./" at the beginning or after a separator.
+		if (c == '.' && (normalized.empty() || normalized.back() == '/') &&
+			i + 1 < path.size() && (path[i + 1] == '/' || path[i + 1] == '\\'))
+		{
+			i++;
+			continue;
+		}
+		normalized.push_back(c);
+	}
+	return normalized;
+}
+
+bool FileSystem::ReadFile(const std::string& name, FileView& view) const
+{
+	for (auto itCur = m_archives.rbegin(); itCur != m_archives.rend(); itCur++)
+	{
+		uint32_t index;
+		if ((*itCur)->Find(name, index))
+		{
+			view.Reference((*itCur)->GetEntryData(index), (*itCur)->GetEntry(index).dataSize);
+			return true;
+		}
+	}
+	return ReadLooseFile(IsAbsolutePath(name) ? name : m_root + name, view);
+}
+
+bool FileSystem::MapFile(const std::string& name, FileView& view, MappedFile& mapping) const
+{
+	for (auto itCur = m_archives.rbegin(); itCur != m_archives.rend(); itCur++)
+	{
+		uint32_t index;
+		if ((*itCur)->Find(name, index))
+		{
+			view.Reference((*itCur)->GetEntryData(index), (*itCur)->GetEntry(index).dataSize);
+			return true;
+		}
+	}
+
+	if (!mapping.Open(IsAbsolutePath(name) ? name : m_root + name))
+		return false;
+
+	view.Reference(mapping.GetData(), mapping.GetSize());
+	return true;
+}
+
+bool FileSystem::WriteFile(const std::string& name, const void* data, uint64_t size) const
+{
+	return WriteLooseFile(IsAbsolutePath(name) ? name : m_root + name, data, size);
+}
+
+bool FileSystem::Exists(const std::string& name) const
+{
+	uint32_t index;
+	for (auto& archive : m_archives)
+	{
+		if (archive->Find(name, index))
+			return true;
+	}
+
+	uint64_t size;
+	return GetLooseFileSize(IsAbsolutePath(name) ? name : m_root + name, size);
+}
+
+FileLocation FileSystem::PrepareRead(const std::string& name, FileView& view, IORequest& request) const
+{
+	for (auto itCur = m_archives.rbegin(); itCur != m_archives.rend(); itCur++)
+	{
+		uint32_t index;
+		if ((*itCur)->Find(name, index))
+		{
+			view.Reference((*itCur)->GetEntryData(index), (*itCur)->GetEntry(index).dataSize);
+			return FileLocation::Packed;
+		}
+	}
+
+	request.path = IsAbsolutePath(name) ? name : m_root + name;
+	if (!GetLooseFileSize(request.path, request.size))
+		return FileLocation::Missing;
+
+	request.offset = 0;
+	request.buffer = view.AllocateBuffer(request.size).data();
+	return FileLocation::Loose;
+}
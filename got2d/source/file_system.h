@@ -0,0 +1,170 @@
+#pragma once
+#include <cinttypes>
+#include <string>
+#include <vector>
+#include <memory>
+#include "async_io.h"
+
+// Virtual file system of resources.
+// Resource names are relative to the resource root and use '/'
+// as separator on every platform. Files in mounted pack archives
+// are accessed without copying, others are read from loose files.
+
+// Pack archive layout, all fields are little-endian:
+//   PackHeader
+//   PackEntry[entryCount], sorted by name
+//   names, not null-terminated
+//   file data, each one aligned to header.alignment
+constexpr uint32_t PACK_MAGIC = 0x50443247; // "G2DP"
+constexpr uint32_t PACK_VERSION = 1;
+constexpr uint32_t PACK_DEFAULT_ALIGNMENT = 64;
+
+struct PackHeader
+{
+	uint32_t magic;
+	uint32_t version;
+	uint32_t entryCount;
+	uint32_t alignment;
+	uint64_t namesOffset;
+	uint64_t namesSize;
+};
+
+struct PackEntry
+{
+	uint64_t dataOffset;
+	uint64_t dataSize;
+	uint32_t nameOffset;
+	uint32_t nameLength;
+};
+
+static_assert(sizeof(PackHeader) == 32 && sizeof(PackEntry) == 24, "pack layout must be packed.");
+
+// Read-only memory mapping of a whole file.
+class MappedFile
+{
+public:
+	MappedFile() = default;
+
+	MappedFile(const MappedFile&) = delete;
+
+	MappedFile& operator=(const MappedFile&) = delete;
+
+	~MappedFile() { Close(); }
+
+	bool Open(const std::string& path);
+
+	void Close();
+
+	const uint8_t* GetData() const { return m_data; }
+
+	uint64_t GetSize() const { return m_size; }
+
+private:
+	const uint8_t* m_data = nullptr;
+	uint64_t m_size = 0;
+#ifdef _WIN32
+	void* m_file = nullptr;
+	void* m_mapping = nullptr;
+#endif
+};
+
+class PackArchive
+{
+public:
+	// Map the archive and validate its index.
+	bool Open(const std::string& path);
+
+	uint32_t GetEntryCount() const { return m_header == nullptr ? 0 : m_header->entryCount; }
+
+	std::string GetEntryName(uint32_t index) const;
+
+	const PackEntry& GetEntry(uint32_t index) const { return m_entries[index]; }
+
+	const uint8_t* GetEntryData(uint32_t index) const { return m_file.GetData() + m_entries[index].dataOffset; }
+
+	// Binary search in sorted index, return false if not found.
+	bool Find(const std::string& name, uint32_t& index) const;
+
+private:
+	MappedFile m_file;
+	const PackHeader* m_header = nullptr;
+	const PackEntry* m_entries = nullptr;
+	const char* m_names = nullptr;
+};
+
+// Content of a file, points into a mapped archive,
+// or owns the buffer when it's read from a loose file.
+class FileView
+{
+public:
+	const uint8_t* GetData() const { return m_data; }
+
+	uint64_t GetSize() const { return m_size; }
+
+	void Reference(const uint8_t* data, uint64_t size);
+
+	std::vector<uint8_t>& AllocateBuffer(uint64_t size);
+
+	void Release();
+
+private:
+	const uint8_t* m_data = nullptr;
+	uint64_t m_size = 0;
+	std::vector<uint8_t> m_buffer;
+};
+
+bool ReadLooseFile(const std::string& path, FileView& view);
+
+// create or truncate the file.
+bool WriteLooseFile(const std::string& path, const void* data, uint64_t size);
+
+bool GetLooseFileSize(const std::string& path, uint64_t& size);
+
+// Names of all files under folder, relative to folder and sorted.
+void ListLooseFiles(const std::string& folder, std::vector<std::string>& names);
+
+enum class FileLocation : int
+{
+	Packed,
+	Loose,
+	Missing,
+};
+
+class FileSystem
+{
+public:
+	// Loose files are searched under root, it's normalized to '/' with a trailing '/'.
+	void SetRoot(const std::string& root);
+
+	const std::string& GetRoot() const { return m_root; }
+
+	// Archive path is relative to root. Archives mounted later take precedence.
+	// Mounting is NOT thread-safe, do it before loading any resources.
+	bool MountArchive(const std::string& path);
+
+	void UnmountAll();
+
+	// Convert '\\' to '/', remove "./" and duplicated separators.
+	static std::string NormalizePath(const std::string& path);
+
+	// Read resource by normalized name, search archives first, and
+	// fallback to loose file under root. It can be called in any thread.
+	bool ReadFile(const std::string& name, FileView& view) const;
+
+	// Same as ReadFile, but loose files are mapped by mapping instead of
+	// read, for large files which are parsed in place.
+	bool MapFile(const std::string& name, FileView& view, MappedFile& mapping) const;
+
+	// Write loose file under root, unless name is absolute.
+	bool WriteFile(const std::string& name, const void* data, uint64_t size) const;
+
+	bool Exists(const std::string& name) const;
+
+	// Prepare reading resource with AsyncIO: packed resources are referenced by
+	// view at once, loose files get a buffer in view and a request to submit.
+	FileLocation PrepareRead(const std::string& name, FileView& view, IORequest& request) const;
+
+private:
+	std::string m_root;
+	std::vector<std::unique_ptr<PackArchive>> m_archives;
+};
@@ -0,0 +1,346 @@
+#pragma once
+#include <cinttypes>
+#include <cstddef>
+#include <functional>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+#include <vector>
+#include <algorithm>
+
+// Cache-friendly replacements of std::map for small keys on hot paths.
+// Interfaces follow std::map, except that keys and values must be
+// default constructible, and any insertion or erasure invalidates
+// iterators and references of elements.
+
+// Finalizer of MurmurHash3, spreads integer keys and pointers,
+// whose low bits are often zero, to all bits.
+inline uint64_t mix_hash(uint64_t h)
+{
+	h ^= h >> 33;
+	h *= 0xff51afd7ed558ccdULL;
+	h ^= h >> 33;
+	h *= 0xc4ceb9fe1a85ec53ULL;
+	h ^= h >> 33;
+	return h;
+}
+
+template<typename K, typename = void>
+struct flat_hash
+{
+	size_t operator()(const K& key) const { return static_cast<size_t>(mix_hash(std::hash<K>()(key))); }
+};
+
+template<typename K>
+struct flat_hash<K, typename std::enable_if<std::is_integral<K>::value || std::is_enum<K>::value>::type>
+{
+	size_t operator()(K key) const { return static_cast<size_t>(mix_hash(static_cast<uint64_t>(key))); }
+};
+
+template<typename K>
+struct flat_hash<K*, void>
+{
+	size_t operator()(K* key) const { return static_cast<size_t>(mix_hash(reinterpret_cast<uintptr_t>(key))); }
+};
+
+// Open addressing with linear probing, elements are stored inline in
+// one array, and erasing shifts following elements back instead of
+// leaving tombstones, so probing sequences stay short.
+template<typename K, typename V, typename HASH = flat_hash<K>>
+class flat_hash_map
+{
+	struct slot
+	{
+		std::pair<K, V> element;
+		bool used = false;
+	};
+
+public:
+	typedef std::pair<K, V> value_type;
+
+	template<typename SLOT, typename VALUE>
+	class iterator_base
+	{
+	public:
+		iterator_base(SLOT* slot, SLOT* end) : m_slot(slot), m_end(end) { skip(); }
+
+		VALUE& operator*() const { return m_slot->element; }
+
+		VALUE* operator->() const { return &(m_slot->element); }
+
+		iterator_base& operator++() { m_slot++; skip(); return *this; }
+
+		bool operator==(const iterator_base& other) const { return m_slot == other.m_slot; }
+
+		bool operator!=(const iterator_base& other) const { return m_slot != other.m_slot; }
+
+	private:
+		friend class flat_hash_map;
+
+		void skip() { while (m_slot != m_end && !m_slot->used) m_slot++; }
+
+		SLOT* m_slot;
+		SLOT* m_end;
+	};
+
+	typedef iterator_base<slot, value_type> iterator;
+	typedef iterator_base<const slot, const value_type> const_iterator;
+
+	iterator begin() { return iterator(m_slots.data(), m_slots.data() + m_slots.size()); }
+
+	iterator end() { return iterator(m_slots.data() + m_slots.size(), m_slots.data() + m_slots.size()); }
+
+	const_iterator begin() const { return const_iterator(m_slots.data(), m_slots.data() + m_slots.size()); }
+
+	const_iterator end() const { return const_iterator(m_slots.data() + m_slots.size(), m_slots.data() + m_slots.size()); }
+
+	size_t size() const { return m_size; }
+
+	bool empty() const { return m_size == 0; }
+
+	void clear()
+	{
+		m_slots.clear();
+		m_size = 0;
+	}
+
+	// Make room for count elements without rehashing.
+	void reserve(size_t count)
+	{
+		size_t capacity = 8;
+		while (capacity * 3 < count * 4)
+			capacity *= 2;
+
+		if (capacity > m_slots.size())
+			rehash(capacity);
+	}
+
+	iterator find(const K& key)
+	{
+		size_t index = find_index(key);
+		return index == npos ? end() : iterator(m_slots.data() + index, m_slots.data() + m_slots.size());
+	}
+
+	const_iterator find(const K& key) const
+	{
+		size_t index = find_index(key);
+		return index == npos ? end() : const_iterator(m_slots.data() + index, m_slots.data() + m_slots.size());
+	}
+
+	size_t count(const K& key) const { return find_index(key) == npos ? 0 : 1; }
+
+	V& at(const K& key)
+	{
+		size_t index = find_index(key);
+		if (index == npos)
+			throw std::out_of_range("key not found.");
+		return m_slots[index].element.second;
+	}
+
+	const V& at(const K& key) const
+	{
+		size_t index = find_index(key);
+		if (index == npos)
+			throw std::out_of_range("key not found.");
+		return m_slots[index].element.second;
+	}
+
+	V& operator[](const K& key) { return insert(value_type(key, V())).first->second; }
+
+	std::pair<iterator, bool> insert(const value_type& element)
+	{
+		// keep load factor below 3/4.
+		if ((m_size + 1) * 4 > m_slots.size() * 3)
+			rehash(m_slots.empty() ? 8 : m_slots.size() * 2);
+
+		size_t mask = m_slots.size() - 1;
+		size_t index = HASH()(element.first) & mask;
+		while (m_slots[index].used)
+		{
+			if (m_slots[index].element.first == element.first)
+				return{ iterator(m_slots.data() + index, m_slots.data() + m_slots.size()), false };
+			index = (index + 1) & mask;
+		}
+
+		m_slots[index].element = element;
+		m_slots[index].used = true;
+		m_size++;
+		return{ iterator(m_slots.data() + index, m_slots.data() + m_slots.size()), true };
+	}
+
+	size_t erase(const K& key)
+	{
+		size_t index = find_index(key);
+		if (index == npos)
+			return 0;
+
+		erase_index(index);
+		return 1;
+	}
+
+	void erase(iterator it) { erase_index(static_cast<size_t>(it.m_slot - m_slots.data())); }
+
+private:
+	static const size_t npos = static_cast<size_t>(-1);
+
+	size_t find_index(const K& key) const
+	{
+		if (m_size == 0)
+			return npos;
+
+		size_t mask = m_slots.size() - 1;
+		size_t index = HASH()(key) & mask;
+		while (m_slots[index].used)
+		{
+			if (m_slots[index].element.first == key)
+				return index;
+			index = (index + 1) & mask;
+		}
+		return npos;
+	}
+
+	// backward shift deletion: move later elements of the same
+	// probing run into the hole, unless it's before their home slot.
+	void erase_index(size_t hole)
+	{
+		size_t mask = m_slots.size() - 1;
+		size_t index = (hole + 1) & mask;
+		while (m_slots[index].used)
+		{
+			size_t home = HASH()(m_slots[index].element.first) & mask;
+			if (((index - home) & mask) >= ((index - hole) & mask))
+			{
+				m_slots[hole].element = std::move(m_slots[index].element);
+				hole = index;
+			}
+			index = (index + 1) & mask;
+		}
+		m_slots[hole].element = value_type();
+		m_slots[hole].used = false;
+		m_size--;
+	}
+
+	void rehash(size_t capacity)
+	{
+		std::vector<slot> oldSlots(capacity);
+		oldSlots.swap(m_slots);
+		size_t mask = capacity - 1;
+		for (auto& s : oldSlots)
+		{
+			if (!s.used)
+				continue;
+
+			size_t index = HASH()(s.element.first) & mask;
+			while (m_slots[index].used)
+				index = (index + 1) & mask;
+
+			m_slots[index].element = std::move(s.element);
+			m_slots[index].used = true;
+		}
+	}
+
+	std::vector<slot> m_slots;
+	size_t m_size = 0;
+};
+
+// Sorted array of elements, for a few keys that are mostly looked up,
+// or when elements must be visited in order of keys.
+template<typename K, typename V>
+class vector_map
+{
+public:
+	typedef std::pair<K, V> value_type;
+	typedef typename std::vector<value_type>::iterator iterator;
+	typedef typename std::vector<value_type>::const_iterator const_iterator;
+
+	iterator begin() { return m_elements.begin(); }
+
+	iterator end() { return m_elements.end(); }
+
+	const_iterator begin() const { return m_elements.begin(); }
+
+	const_iterator end() const { return m_elements.end(); }
+
+	size_t size() const { return m_elements.size(); }
+
+	bool empty() const { return m_elements.empty(); }
+
+	void clear() { m_elements.clear(); }
+
+	void reserve(size_t count) { m_elements.reserve(count); }
+
+	iterator find(const K& key)
+	{
+		auto it = lower_bound(m_elements, key);
+		return (it != m_elements.end() && !(key < it->first)) ? it : m_elements.end();
+	}
+
+	const_iterator find(const K& key) const
+	{
+		auto it = lower_bound(m_elements, key);
+		return (it != m_elements.end() && !(key < it->first)) ? it : m_elements.end();
+	}
+
+	size_t count(const K& key) const { return find(key) == end() ? 0 : 1; }
+
+	V& at(const K& key)
+	{
+		auto it = find(key);
+		if (it == end())
+			throw std::out_of_range("key not found.");
+		return it->second;
+	}
+
+	const V& at(const K& key) const
+	{
+		auto it = find(key);
+		if (it == end())
+			throw std::out_of_range("key not found.");
+		return it->second;
+	}
+
+	V& operator[](const K& key) { return insert(value_type(key, V())).first->second; }
+
+	std::pair<iterator, bool> insert(const value_type& element)
+	{
+		auto it = lower_bound(m_elements, element.first);
+		if (it != m_elements.end() && !(element.first < it->first))
+			return{ it, false };
+
+		return{ m_elements.insert(it, element), true };
+	}
+
+	size_t erase(const K& key)
+	{
+		auto it = find(key);
+		if (it == end())
+			return 0;
+
+		m_elements.erase(it);
+		return 1;
+	}
+
+	void erase(iterator it) { m_elements.erase(it); }
+
+private:
+	// branchless binary search, comparisons of random keys
+	// are not predictable, conditional moves are cheaper.
+	template<typename ELEMENTS>
+	static auto lower_bound(ELEMENTS& elements, const K& key) -> decltype(elements.begin())
+	{
+		size_t count = elements.size();
+		if (count == 0)
+			return elements.begin();
+
+		size_t base = 0;
+		while (count > 1)
+		{
+			size_t half = count / 2;
+			base = (elements[base + half].first < key) ? base + half : base;
+			count -= half;
+		}
+		return elements.begin() + (base + (elements[base].first < key ? 1 : 0));
+	}
+
+	std::vector<value_type> m_elements;
+};
@@ -0,0 +1,87 @@
+#pragma once
+#include <cinttypes>
+#include <cstring>
+
+// Non-cryptographic 64-bit hash (MurmurHash64A), for identifying
+// contents in memory, it must NOT be persisted in files since
+// results differ between little-endian and big-endian machines.
+inline uint64_t HashBytes(const void* data, size_t size, uint64_t seed = 0)
+{
+	const uint64_t m = 0xc6a4a7935bd1e995ULL;
+	const int r = 47;
+	uint64_t h = seed ^ (size * m);
+
+	const uint8_t* bytes = static_cast<const uint8_t*>(data);
+	const uint8_t* end = bytes + (size & ~static_cast<size_t>(7));
+	for (; bytes != end; bytes += 8)
+	{
+		uint64_t k;
+		memcpy(&k, bytes, 8);
+		k *= m;
+		k ^= k >> r;
+		k *= m;
+		h ^= k;
+		h *= m;
+	}
+
+	uint64_t tail = 0;
+	switch (size & 7)
+	{
+	case 7: tail ^= static_cast<uint64_t>(bytes[6]) << 48; // fall through
+	case 6: tail ^= static_cast<uint64_t>(bytes[5]) << 40; // fall through
+	case 5: tail ^= static_cast<uint64_t>(bytes[4]) << 32; // fall through
+	case 4: tail ^= static_cast<uint64_t>(bytes[3]) << 24; // fall through
+	case 3: tail ^= static_cast<uint64_t>(bytes[2]) << 16; // fall through
+	case 2: tail ^= static_cast<uint64_t>(bytes[1]) << 8; // fall through
+	case 1: tail ^= static_cast<uint64_t>(bytes[0]);
+		h ^= tail;
+		h *= m;
+	}
+
+	h ^= h >> r;
+	h *= m;
+	h ^= h >> r;
+	return h;
+}
+
+inline uint64_t RotateLeft64(uint64_t x, int r)
+{
+	return (x << r) | (x >> (64 - r));
+}
+
+// Another 64-bit hash with different mixing (rounds of xxHash64), for
+// confirming that contents of the same HashBytes are really equal.
+inline uint64_t CheckHashBytes(const void* data, size_t size, uint64_t seed = 0)
+{
+	const uint64_t p1 = 0x9E3779B185EBCA87ULL;
+	const uint64_t p2 = 0xC2B2AE3D27D4EB4FULL;
+	const uint64_t p3 = 0x165667B19E3779F9ULL;
+	const uint64_t p5 = 0x27D4EB2F165667C5ULL;
+	uint64_t h = seed + p5 + static_cast<uint64_t>(size);
+
+	const uint8_t* bytes = static_cast<const uint8_t*>(data);
+	const uint8_t* end = bytes + (size & ~static_cast<size_t>(7));
+	for (; bytes != end; bytes += 8)
+	{
+		uint64_t k;
+		memcpy(&k, bytes, 8);
+		k *= p2;
+		k = RotateLeft64(k, 31);
+		k *= p1;
+		h ^= k;
+		h = RotateLeft64(h, 27) * p1 + p3;
+	}
+
+	for (end = bytes + (size & 7); bytes != end; bytes++)
+	{
+		h ^= *bytes * p5;
+		h = RotateLeft64(h, 11) * p1;
+	}
+
+	h ^= h >> 33;
+	h *= p2;
+	h ^= h >> 29;
+	h *= p3;
+	h ^= h >> 32;
+	return h;
+}
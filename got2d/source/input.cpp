@@ -44,11 +44,12 @@ void MouseEvent::NotifyAll(g2d::MouseButton button)
 
 Keyboard::~Keyboard()
 {
-	for (auto& keyState : m_states)
+	for (auto keyState : m_stateList)
 	{
-		delete keyState.second;
+		delete keyState;
 	}
 	m_states.clear();
+	m_stateList.clear();
 }
 
 g2d::SwitchState Keyboard::GetPressState(g2d::KeyCode key) const
@@ -63,9 +64,9 @@ uint32_t Keyboard::GetRepeatingCount(g2d::KeyCode key) const
 
 bool Keyboard::IsFree() const
 {
-	for (auto& key : m_states)
+	for (auto keyState : m_stateList)
 	{
-		if (key.second->State() != g2d::SwitchState::Releasing)
+		if (keyState->State() != g2d::SwitchState::Releasing)
 			return false;
 	}
 	return true;
@@ -73,21 +74,25 @@ bool Keyboard::IsFree() const
 
 void Keyboard::CreateKeyState(g2d::KeyCode key)
 {
-	m_states.insert({ key, new KeyState(key) });
-	m_states[key]->OnPress = [this](KeyState& state) { this->OnPress.NotifyAll(state.Key); };
-	m_states[key]->OnPressingBegin = [this](KeyState& state) { this->OnPressingBegin.NotifyAll(state.Key); };
-	m_states[key]->OnPressing = [this](KeyState& state) { this->OnPressing.NotifyAll(state.Key); };
-	m_states[key]->OnPressingEnd = [this](KeyState& state) { this->OnPressingEnd.NotifyAll(state.Key); };
+	auto keyState = new KeyState(key);
+	keyState->OnPress = [this](KeyState& state) { this->OnPress.NotifyAll(state.Key); };
+	keyState->OnPressingBegin = [this](KeyState& state) { this->OnPressingBegin.NotifyAll(state.Key); };
+	keyState->OnPressing = [this](KeyState& state) { this->OnPressing.NotifyAll(state.Key); };
+	keyState->OnPressingEnd = [this](KeyState& state) { this->OnPressingEnd.NotifyAll(state.Key); };
+	m_states.insert({ key, keyState });
+	m_stateList.push_back(keyState);
 
 }
 
 Keyboard::KeyState& Keyboard::GetState(g2d::KeyCode key) const
 {
-	if (m_states.count(key) == 0)
+	auto itFound = m_states.find(key);
+	if (itFound != m_states.end())
 	{
-		const_cast<Keyboard*>(this)->CreateKeyState(key);
+		return *(itFound->second);
 	}
-	return *(m_states.at(key));
+	const_cast<Keyboard*>(this)->CreateKeyState(key);
+	return *(m_stateList.back());
 }
 
 void Keyboard::OnMessage(const g2d::Message& message, uint32_t currentTimeStamp)
@@ -98,9 +103,9 @@ void Keyboard::OnMessage(const g2d::Message& message, uint32_t currentTimeStamp)
 	}
 	else if (message.Event == g2d::MessageEvent::LostFocus)
 	{
-		for (auto& keyState : m_states)
+		for (size_t i = 0; i < m_stateList.size(); i++)
 		{
-			keyState.second->ForceRelease();
+			m_stateList[i]->ForceRelease();
 		}
 	}
 }
@@ -119,9 +124,9 @@ void Keyboard::Update(uint32_t currentTimeStamp)
 	{
 		ALTState.OnMessage(g2d::Message(g2d::MessageEvent::KeyUp, ALTKey), currentTimeStamp);
 	}
-	for (auto& keyState : m_states)
+	for (size_t i = 0; i < m_stateList.size(); i++)
 	{
-		keyState.second->Update(currentTimeStamp);
+		m_stateList[i]->Update(currentTimeStamp);
 	}
 }
 
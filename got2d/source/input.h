@@ -4,6 +4,7 @@
 #include <map>
 #include <gml/gmlrect.h>
 #include "../include/g2dinput.h"
+#include "flat_map.h"
 
 constexpr uint32_t PRESSING_INTERVAL = 500u;
 
@@ -105,7 +106,10 @@ private:
 	};
 	KeyState& GetState(g2d::KeyCode key) const;
 	void CreateKeyState(g2d::KeyCode key);
-	std::map<g2d::KeyCode, KeyState*> m_states;
+	flat_hash_map<g2d::KeyCode, KeyState*> m_states;
+
+	// states are visited by index, since callbacks may create new states.
+	std::vector<KeyState*> m_stateList;
 };
 
 class Mouse : public g2d::Mouse
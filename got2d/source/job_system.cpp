@@ -0,0 +1,618 @@
+#include <algorithm>
+#include "job_system.h"
+
+namespace
+{
+	// jobs in flight spawned by one worker, job pool and deque share it.
+	constexpr uint32_t JOB_CAPACITY = 4096;
+
+	// times an idle worker looks for jobs before sleeping.
+	constexpr uint32_t IDLE_SPIN_COUNT = 64;
+}
+
+struct Job
+{
+	JobFunction function = nullptr;
+	RangeJobFunction rangeFunction = nullptr;
+	void* userData = nullptr;
+	uint32_t begin = 0;
+	uint32_t end = 0;
+	uint32_t grainSize = 0;
+	JobCounter* counter = nullptr;
+	Job* nextWaiting = nullptr;
+	std::atomic<bool> inUse{ false };
+	bool heapAllocated = false;
+};
+
+// Chase-Lev deque of fixed capacity, the owner pushes and pops at the
+// bottom, thieves take from the top.
+class JobDeque
+{
+public:
+	bool Push(Job* job)
+	{
+		int64_t bottom = m_bottom.load(std::memory_order_relaxed);
+		int64_t top = m_top.load(std::memory_order_acquire);
+		if (bottom - top >= static_cast<int64_t>(JOB_CAPACITY))
+			return false;
+
+		m_jobs[bottom & (JOB_CAPACITY - 1)].store(job, std::memory_order_relaxed);
+		m_bottom.store(bottom + 1, std::memory_order_release);
+		return true;
+	}
+
+	Job* Pop()
+	{
+		int64_t bottom = m_bottom.load(std::memory_order_relaxed) - 1;
+		m_bottom.store(bottom, std::memory_order_relaxed);
+		std::atomic_thread_fence(std::memory_order_seq_cst);
+		int64_t top = m_top.load(std::memory_order_relaxed);
+		if (top > bottom)
+		{
+			m_bottom.store(bottom + 1, std::memory_order_relaxed);
+			return nullptr;
+		}
+
+		Job* job = m_jobs[bottom & (JOB_CAPACITY - 1)].load(std::memory_order_relaxed);
+		if (top == bottom)
+		{
+			// the last one, race with thieves.
+			if (!m_top.compare_exchange_strong(top, top + 1, std::memory_order_seq_cst, std::memory_order_relaxed))
+				job = nullptr;
+			m_bottom.store(bottom + 1, std::memory_order_relaxed);
+		}
+		return job;
+	}
+
+	Job* Steal()
+	{
+		int64_t top = m_top.load(std::memory_order_acquire);
+		std::atomic_thread_fence(std::memory_order_seq_cst);
+		int64_t bottom = m_bottom.load(std::memory_order_acquire);
+		if (top >= bottom)
+			return nullptr;
+
+		Job* job = m_jobs[top & (JOB_CAPACITY - 1)].load(std::memory_order_relaxed);
+		if (!m_top.compare_exchange_strong(top, top + 1, std::memory_order_seq_cst, std::memory_order_relaxed))
+			return nullptr;
+		return job;
+	}
+
+	bool IsEmpty() const
+	{
+		return m_top.load(std::memory_order_relaxed) >= m_bottom.load(std::memory_order_relaxed);
+	}
+
+private:
+	// owner and thieves modify different ends, keep them
+	// in different cache lines.
+	std::atomic<int64_t> m_top{ 0 };
+	uint8_t m_padding[64];
+	std::atomic<int64_t> m_bottom{ 0 };
+	std::atomic<Job*> m_jobs[JOB_CAPACITY];
+};
+
+class JobWorker
+{
+public:
+	JobWorker(JobSystem& system, uint32_t index)
+		: system(system)
+		, index(index)
+		, randomState(index * 0x9E3779B9u + 1)
+		, jobs(new Job[JOB_CAPACITY])
+	{
+
+	}
+
+	// xorshift, picks victims to steal from.
+	uint32_t NextRandom()
+	{
+		randomState ^= randomState << 13;
+		randomState ^= randomState >> 17;
+		randomState ^= randomState << 5;
+		return randomState;
+	}
+
+	JobSystem& system;
+	uint32_t index;
+	uint32_t randomState;
+	JobDeque deque;
+	std::unique_ptr<Job[]> jobs;
+	uint32_t nextJob = 0;
+	FrameArena arena;
+	std::atomic<uint64_t> executedCount{ 0 };
+	std::atomic<uint64_t> stolenCount{ 0 };
+	std::atomic<uint64_t> stealAttempts{ 0 };
+	std::atomic<uint64_t> sleepCount{ 0 };
+};
+
+namespace
+{
+	thread_local JobWorker* t_currentWorker = nullptr;
+
+	void AddStatistic(std::atomic<uint64_t>& statistic, uint64_t value)
+	{
+		// only the owner writes it.
+		statistic.store(statistic.load(std::memory_order_relaxed) + value, std::memory_order_relaxed);
+	}
+}
+
+void* FrameArena::Allocate(size_t size, size_t alignment)
+{
+	while (m_blockIndex < m_blocks.size())
+	{
+		Block& block = m_blocks[m_blockIndex];
+		uintptr_t base = reinterpret_cast<uintptr_t>(block.memory.get());
+		uintptr_t address = (base + m_offset + alignment - 1) & ~static_cast<uintptr_t>(alignment - 1);
+		if (address + size <= base + block.size)
+		{
+			m_usedBytes += address + size - (base + m_offset);
+			m_offset = address + size - base;
+			return reinterpret_cast<void*>(address);
+		}
+		m_blockIndex++;
+		m_offset = 0;
+	}
+
+	Block block;
+	block.size = std::max(m_blockSize, size + alignment);
+	block.memory.reset(new uint8_t[block.size]);
+	m_blocks.push_back(std::move(block));
+	m_blockIndex = m_blocks.size() - 1;
+	m_offset = 0;
+	return Allocate(size, alignment);
+}
+
+void FrameArena::Reset()
+{
+	m_blockIndex = 0;
+	m_offset = 0;
+	m_usedBytes = 0;
+}
+
+JobSystem::JobSystem()
+{
+
+}
+
+JobSystem::~JobSystem()
+{
+	Stop();
+}
+
+void JobSystem::Start(uint32_t threadCount)
+{
+	if (IsStarted())
+		return;
+
+	m_quit = false;
+	for (uint32_t i = 0; i <= threadCount; i++)
+	{
+		m_workers.push_back(std::unique_ptr<JobWorker>(new JobWorker(*this, i)));
+	}
+
+	t_currentWorker = m_workers[0].get();
+	for (uint32_t i = 1; i <= threadCount; i++)
+	{
+		JobWorker* worker = m_workers[i].get();
+		m_threads.push_back(std::thread([this, worker] { WorkerLoop(worker); }));
+	}
+}
+
+void JobSystem::Stop()
+{
+	if (!IsStarted())
+		return;
+
+	JobWorker* worker = GetCurrentWorker();
+	while (m_unfinishedCount.load(std::memory_order_acquire) != 0)
+	{
+		Job* job = FindJob(worker);
+		if (job != nullptr)
+			Execute(job, worker);
+		else
+			std::this_thread::yield();
+	}
+
+	{
+		std::lock_guard<std::mutex> lock(m_sleepMutex);
+		m_quit = true;
+		m_wakeVersion++;
+	}
+	m_wakeCondition.notify_all();
+	for (auto& thread : m_threads)
+	{
+		thread.join();
+	}
+	m_threads.clear();
+
+	if (t_currentWorker != nullptr && &(t_currentWorker->system) == this)
+	{
+		t_currentWorker = nullptr;
+	}
+	m_workers.clear();
+}
+
+void JobSystem::Run(JobFunction function, void* userData, JobCounter* counter, JobCounter* dependency)
+{
+	JobWorker* worker = GetCurrentWorker();
+	Job* job = AllocateJob(worker);
+	job->function = function;
+	job->rangeFunction = nullptr;
+	job->userData = userData;
+	job->counter = counter;
+	if (counter != nullptr)
+	{
+		counter->m_count.fetch_add(1, std::memory_order_relaxed);
+	}
+	m_unfinishedCount.fetch_add(1, std::memory_order_relaxed);
+
+	if (!IsStarted())
+	{
+		Execute(job, nullptr);
+		return;
+	}
+	ScheduleAfter(job, dependency, worker);
+}
+
+void JobSystem::Wait(JobCounter& counter)
+{
+	JobWorker* worker = GetCurrentWorker();
+	while (counter.m_count.load(std::memory_order_acquire) != 0)
+	{
+		Job* job = FindJob(worker);
+		if (job != nullptr)
+			Execute(job, worker);
+		else
+			std::this_thread::yield();
+	}
+
+	// the last finishing thread may still hold the lock,
+	// counter can be destroyed only after it released.
+	std::lock_guard<std::mutex> lock(counter.m_mutex);
+}
+
+void JobSystem::ParallelFor(uint32_t begin, uint32_t end, uint32_t grainSize, RangeJobFunction function, void* userData)
+{
+	grainSize = std::max(1u, grainSize);
+	if (begin >= end)
+		return;
+
+	if (end - begin <= grainSize || GetWorkerCount() <= 1)
+	{
+		function(userData, begin, end);
+		return;
+	}
+
+	JobCounter counter;
+	JobWorker* worker = GetCurrentWorker();
+	Job* job = AllocateJob(worker);
+	job->function = nullptr;
+	job->rangeFunction = function;
+	job->userData = userData;
+	job->begin = begin;
+	job->end = end;
+	job->grainSize = grainSize;
+	job->counter = &counter;
+	counter.m_count.fetch_add(1, std::memory_order_relaxed);
+	m_unfinishedCount.fetch_add(1, std::memory_order_relaxed);
+
+	// the whole range starts on the calling thread, which
+	// splits it and leaves halves for thieves.
+	Execute(job, worker);
+	Wait(counter);
+}
+
+void* JobSystem::AllocateFrameMemory(size_t size, size_t alignment)
+{
+	JobWorker* worker = GetCurrentWorker();
+	if (worker != nullptr)
+	{
+		return worker->arena.Allocate(size, alignment);
+	}
+
+	std::lock_guard<std::mutex> lock(m_sharedArenaMutex);
+	return m_sharedArena.Allocate(size, alignment);
+}
+
+void JobSystem::ResetFrameMemory()
+{
+	for (auto& worker : m_workers)
+	{
+		worker->arena.Reset();
+	}
+
+	std::lock_guard<std::mutex> lock(m_sharedArenaMutex);
+	m_sharedArena.Reset();
+}
+
+int JobSystem::GetCurrentWorkerIndex() const
+{
+	JobWorker* worker = GetCurrentWorker();
+	return worker == nullptr ? -1 : static_cast<int>(worker->index);
+}
+
+JobStatistics JobSystem::GetStatistics() const
+{
+	JobStatistics statistics;
+	for (auto& worker : m_workers)
+	{
+		statistics.executedCount += worker->executedCount.load(std::memory_order_relaxed);
+		statistics.stolenCount += worker->stolenCount.load(std::memory_order_relaxed);
+		statistics.stealAttempts += worker->stealAttempts.load(std::memory_order_relaxed);
+		statistics.sleepCount += worker->sleepCount.load(std::memory_order_relaxed);
+	}
+	return statistics;
+}
+
+void JobSystem::ResetStatistics()
+{
+	for (auto& worker : m_workers)
+	{
+		worker->executedCount.store(0, std::memory_order_relaxed);
+		worker->stolenCount.store(0, std::memory_order_relaxed);
+		worker->stealAttempts.store(0, std::memory_order_relaxed);
+		worker->sleepCount.store(0, std::memory_order_relaxed);
+	}
+}
+
+JobWorker* JobSystem::GetCurrentWorker() const
+{
+	JobWorker* worker = t_currentWorker;
+	return (worker != nullptr && &(worker->system) == this) ? worker : nullptr;
+}
+
+Job* JobSystem::AllocateJob(JobWorker* worker)
+{
+	// pool entries are reused round robin, an entry still in flight
+	// means too many jobs are spawned, fall back to heap.
+	if (worker != nullptr)
+	{
+		Job& job = worker->jobs[worker->nextJob++ & (JOB_CAPACITY - 1)];
+		if (!job.inUse.load(std::memory_order_acquire))
+		{
+			job.inUse.store(true, std::memory_order_relaxed);
+			job.heapAllocated = false;
+			return &job;
+		}
+	}
+
+	Job* job = new Job();
+	job->heapAllocated = true;
+	return job;
+}
+
+void JobSystem::FreeJob(Job* job)
+{
+	if (job->heapAllocated)
+	{
+		delete job;
+	}
+	else
+	{
+		job->inUse.store(false, std::memory_order_release);
+	}
+}
+
+void JobSystem::Schedule(Job* job, JobWorker* worker)
+{
+	if (worker != nullptr)
+	{
+		if (!worker->deque.Push(job))
+		{
+			// deque is full, run it now rather than blocking.
+			Execute(job, worker);
+			return;
+		}
+	}
+	else
+	{
+		std::lock_guard<std::mutex> lock(m_sharedMutex);
+		m_sharedJobs.push_back(job);
+		m_sharedCount.fetch_add(1, std::memory_order_relaxed);
+	}
+	WakeWorker();
+}
+
+void JobSystem::ScheduleAfter(Job* job, JobCounter* dependency, JobWorker* worker)
+{
+	if (dependency != nullptr)
+	{
+		std::lock_guard<std::mutex> lock(dependency->m_mutex);
+		if (dependency->m_count.load(std::memory_order_acquire) != 0)
+		{
+			job->nextWaiting = dependency->m_waitingJobs;
+			dependency->m_waitingJobs = job;
+			return;
+		}
+	}
+	Schedule(job, worker);
+}
+
+Job* JobSystem::FindJob(JobWorker* worker)
+{
+	if (worker != nullptr)
+	{
+		Job* job = worker->deque.Pop();
+		if (job != nullptr)
+			return job;
+	}
+
+	if (m_sharedCount.load(std::memory_order_relaxed) > 0)
+	{
+		std::lock_guard<std::mutex> lock(m_sharedMutex);
+		if (!m_sharedJobs.empty())
+		{
+			Job* job = m_sharedJobs.front();
+			m_sharedJobs.pop_front();
+			m_sharedCount.fetch_sub(1, std::memory_order_relaxed);
+			return job;
+		}
+	}
+
+	// visit other workers from a random one.
+	uint32_t workerCount = GetWorkerCount();
+	uint32_t first = (worker != nullptr) ? worker->NextRandom() : static_cast<uint32_t>(m_unfinishedCount.load(std::memory_order_relaxed));
+	for (uint32_t i = 0; i < workerCount; i++)
+	{
+		JobWorker* victim = m_workers[(first + i) % workerCount].get();
+		if (victim == worker || victim->deque.IsEmpty())
+			continue;
+
+		if (worker != nullptr)
+			AddStatistic(worker->stealAttempts, 1);
+
+		Job* job = victim->deque.Steal();
+		if (job != nullptr)
+		{
+			if (worker != nullptr)
+				AddStatistic(worker->stolenCount, 1);
+			return job;
+		}
+	}
+	return nullptr;
+}
+
+void JobSystem::Execute(Job* job, JobWorker* worker)
+{
+	if (job->rangeFunction != nullptr)
+	{
+		// keep the first half, and leave the second half for thieves.
+		uint32_t begin = job->begin;
+		uint32_t end = job->end;
+		while (end - begin > job->grainSize)
+		{
+			uint32_t middle = begin + (end - begin) / 2;
+			Job* half = AllocateJob(worker);
+			half->function = nullptr;
+			half->rangeFunction = job->rangeFunction;
+			half->userData = job->userData;
+			half->begin = middle;
+			half->end = end;
+			half->grainSize = job->grainSize;
+			half->counter = job->counter;
+			job->counter->m_count.fetch_add(1, std::memory_order_relaxed);
+			m_unfinishedCount.fetch_add(1, std::memory_order_relaxed);
+			Schedule(half, worker);
+			end = middle;
+		}
+		job->rangeFunction(job->userData, begin, end);
+	}
+	else
+	{
+		job->function(job->userData);
+	}
+
+	JobCounter* counter = job->counter;
+	FreeJob(job);
+	if (counter != nullptr)
+	{
+		Finish(*counter, worker);
+	}
+	m_unfinishedCount.fetch_sub(1, std::memory_order_release);
+
+	if (worker != nullptr)
+		AddStatistic(worker->executedCount, 1);
+}
+
+void JobSystem::Finish(JobCounter& counter, JobWorker* worker)
+{
+	uint32_t count = counter.m_count.load(std::memory_order_relaxed);
+	while (count > 1)
+	{
+		if (counter.m_count.compare_exchange_weak(count, count - 1, std::memory_order_acq_rel, std::memory_order_relaxed))
+			return;
+	}
+
+	// may be the last one, waiting jobs are released under lock,
+	// so that none is added after the list is taken.
+	Job* waitingJobs = nullptr;
+	{
+		std::lock_guard<std::mutex> lock(counter.m_mutex);
+		if (counter.m_count.fetch_sub(1, std::memory_order_acq_rel) == 1)
+		{
+			waitingJobs = counter.m_waitingJobs;
+			counter.m_waitingJobs = nullptr;
+		}
+	}
+
+	// counter may have been destroyed here.
+	while (waitingJobs != nullptr)
+	{
+		Job* job = waitingJobs;
+		waitingJobs = job->nextWaiting;
+		job->nextWaiting = nullptr;
+		Schedule(job, worker);
+	}
+}
+
+bool JobSystem::HasQueuedJobs() const
+{
+	if (m_sharedCount.load(std::memory_order_relaxed) > 0)
+		return true;
+
+	for (auto& worker : m_workers)
+	{
+		if (!worker->deque.IsEmpty())
+			return true;
+	}
+	return false;
+}
+
+void JobSystem::WakeWorker()
+{
+	// pairs with the fence in Sleep, either the sleeper
+	// sees the job, or we see the sleeper.
+	std::atomic_thread_fence(std::memory_order_seq_cst);
+	if (m_sleepingCount.load(std::memory_order_relaxed) == 0)
+		return;
+
+	{
+		std::lock_guard<std::mutex> lock(m_sleepMutex);
+		m_wakeVersion++;
+	}
+	m_wakeCondition.notify_one();
+}
+
+void JobSystem::Sleep(JobWorker& worker)
+{
+	std::unique_lock<std::mutex> lock(m_sleepMutex);
+	m_sleepingCount.fetch_add(1, std::memory_order_relaxed);
+	std::atomic_thread_fence(std::memory_order_seq_cst);
+	uint64_t version = m_wakeVersion;
+	if (!m_quit && !HasQueuedJobs())
+	{
+		AddStatistic(worker.sleepCount, 1);
+		m_wakeCondition.wait(lock, [&] { return m_quit || m_wakeVersion != version; });
+	}
+	m_sleepingCount.fetch_sub(1, std::memory_order_relaxed);
+}
+
+void JobSystem::WorkerLoop(JobWorker* worker)
+{
+	t_currentWorker = worker;
+	uint32_t idleCount = 0;
+	for (;;)
+	{
+		Job* job = FindJob(worker);
+		if (job != nullptr)
+		{
+			Execute(job, worker);
+			idleCount = 0;
+			continue;
+		}
+
+		if (++idleCount < IDLE_SPIN_COUNT)
+		{
+			std::this_thread::yield();
+			continue;
+		}
+
+		idleCount = 0;
+		Sleep(*worker);
+		std::lock_guard<std::mutex> lock(m_sleepMutex);
+		if (m_quit)
+			break;
+	}
+	t_currentWorker = nullptr;
+}
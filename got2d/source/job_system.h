@@ -0,0 +1,186 @@
+#pragma once
+#include <cinttypes>
+#include <cstddef>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Work-stealing job scheduler.
+// Every worker thread owns a deque, new jobs are pushed to the deque of
+// the spawning thread and popped in LIFO order, idle workers steal the
+// oldest jobs of others. The thread calling Start becomes worker 0, it
+// runs jobs only while it is waiting for a counter. Other threads can
+// spawn and wait jobs as well, their jobs go to a shared queue.
+
+typedef void(*JobFunction)(void* userData);
+
+// Invoked with a sub-range [begin, end) of ParallelFor.
+typedef void(*RangeJobFunction)(void* userData, uint32_t begin, uint32_t end);
+
+struct Job;
+class JobWorker;
+
+// Number of unfinished jobs added with it. A counter can be waited by
+// Wait, or be the dependency of jobs which start after it reaches zero.
+// It must be waited before destroyed if any job is added.
+class JobCounter
+{
+public:
+	JobCounter() = default;
+
+	JobCounter(const JobCounter&) = delete;
+
+	JobCounter& operator=(const JobCounter&) = delete;
+
+	bool IsDone() const { return m_count.load(std::memory_order_acquire) == 0; }
+
+private:
+	friend class JobSystem;
+	std::atomic<uint32_t> m_count{ 0 };
+	std::mutex m_mutex;
+	Job* m_waitingJobs = nullptr;
+};
+
+// Linear allocator reset every frame, memory is never freed one by
+// one, and blocks are kept for the following frames.
+class FrameArena
+{
+public:
+	explicit FrameArena(size_t blockSize = 64 * 1024) : m_blockSize(blockSize) { }
+
+	// alignment must be power of two.
+	void* Allocate(size_t size, size_t alignment = 16);
+
+	void Reset();
+
+	size_t GetUsedBytes() const { return m_usedBytes; }
+
+private:
+	struct Block
+	{
+		std::unique_ptr<uint8_t[]> memory;
+		size_t size;
+	};
+
+	std::vector<Block> m_blocks;
+	size_t m_blockSize;
+	size_t m_blockIndex = 0;
+	size_t m_offset = 0;
+	size_t m_usedBytes = 0;
+};
+
+struct JobStatistics
+{
+	uint64_t executedCount = 0;
+	uint64_t stolenCount = 0;		// executed jobs taken from other workers.
+	uint64_t stealAttempts = 0;		// include failed ones.
+	uint64_t sleepCount = 0;
+};
+
+class JobSystem
+{
+public:
+	JobSystem();
+
+	JobSystem(const JobSystem&) = delete;
+
+	JobSystem& operator=(const JobSystem&) = delete;
+
+	~JobSystem();
+
+	// Start threadCount background workers, the calling thread becomes
+	// the first worker. All jobs run on the calling thread if it is 0.
+	void Start(uint32_t threadCount);
+
+	// Finish all jobs, including those waiting for dependencies, and stop workers.
+	void Stop();
+
+	bool IsStarted() const { return !m_workers.empty(); }
+
+	// background workers and the thread calling Start.
+	uint32_t GetWorkerCount() const { return static_cast<uint32_t>(m_workers.size()); }
+
+	// Run function(userData) on any worker. counter is increased now and
+	// decreased when the job finished, the job does not start until the
+	// dependency reaches zero. Both of them can be nullptr.
+	void Run(JobFunction function, void* userData, JobCounter* counter = nullptr, JobCounter* dependency = nullptr);
+
+	// Block until counter reaches zero, executing other jobs meanwhile.
+	void Wait(JobCounter& counter);
+
+	// Invoke function(userData, b, e) for sub-ranges of [begin, end) no
+	// larger than grainSize, ranges are split in halves on demand so that
+	// idle workers steal large ones. Return after all ranges finished.
+	void ParallelFor(uint32_t begin, uint32_t end, uint32_t grainSize, RangeJobFunction function, void* userData);
+
+	// func(b, e) is invoked concurrently.
+	template<typename FUNC> void ParallelFor(uint32_t begin, uint32_t end, uint32_t grainSize, FUNC func)
+	{
+		ParallelFor(begin, end, grainSize, [](void* userData, uint32_t b, uint32_t e)
+		{
+			(*static_cast<FUNC*>(userData))(b, e);
+		}, &func);
+	}
+
+	// Memory from the frame arena of the calling worker, it is valid until
+	// ResetFrameMemory. Threads which are not workers share one arena.
+	void* AllocateFrameMemory(size_t size, size_t alignment = 16);
+
+	// Must be called when no job is running, e.g. at the beginning of a frame.
+	void ResetFrameMemory();
+
+	// Index of the calling worker, or -1 if it's not a worker.
+	int GetCurrentWorkerIndex() const;
+
+	JobStatistics GetStatistics() const;
+
+	void ResetStatistics();
+
+private:
+	JobWorker* GetCurrentWorker() const;
+
+	Job* AllocateJob(JobWorker* worker);
+
+	void FreeJob(Job* job);
+
+	void Schedule(Job* job, JobWorker* worker);
+
+	void ScheduleAfter(Job* job, JobCounter* dependency, JobWorker* worker);
+
+	Job* FindJob(JobWorker* worker);
+
+	void Execute(Job* job, JobWorker* worker);
+
+	void Finish(JobCounter& counter, JobWorker* worker);
+
+	bool HasQueuedJobs() const;
+
+	void WakeWorker();
+
+	void Sleep(JobWorker& worker);
+
+	void WorkerLoop(JobWorker* worker);
+
+	std::vector<std::unique_ptr<JobWorker>> m_workers;
+	std::vector<std::thread> m_threads;
+
+	// jobs spawned by threads which are not workers.
+	std::deque<Job*> m_sharedJobs;
+	std::mutex m_sharedMutex;
+	std::atomic<uint32_t> m_sharedCount{ 0 };
+	FrameArena m_sharedArena;
+	std::mutex m_sharedArenaMutex;
+
+	// all spawned and unfinished jobs.
+	std::atomic<uint32_t> m_unfinishedCount{ 0 };
+
+	std::mutex m_sleepMutex;
+	std::condition_variable m_wakeCondition;
+	std::atomic<uint32_t> m_sleepingCount{ 0 };
+	uint64_t m_wakeVersion = 0;
+	bool m_quit = false;
+};
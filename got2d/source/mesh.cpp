@@ -169,6 +169,33 @@ bool Geometry::MakeEnoughIndexArray(uint32_t numIndices)
 	return true;
 }
 
+bool Geometry::MakeEnoughParamArray(uint32_t numVertices)
+{
+	if (m_numParams >= numVertices)
+	{
+		return true;
+	}
+
+	D3D11_BUFFER_DESC bufferDesc =
+	{
+		sizeof(DrawParamVertex) * numVertices,	//UINT ByteWidth;
+		D3D11_USAGE_DYNAMIC,					//D3D11_USAGE Usage;
+		D3D11_BIND_VERTEX_BUFFER,				//UINT BindFlags;
+		D3D11_CPU_ACCESS_WRITE,					//UINT CPUAccessFlags;
+		0,										//UINT MiscFlags;
+		0										//UINT StructureByteStride;
+	};
+
+	ID3D11Buffer* paramBuffer;
+	if (S_OK != GetRenderSystem()->GetDevice()->CreateBuffer(&bufferDesc, NULL, &paramBuffer))
+	{
+		return false;
+	}
+	m_numParams = numVertices;
+	m_paramBuffer = paramBuffer;
+	return true;
+}
+
 void Geometry::UploadVertices(uint32_t offset, g2d::GeometryVertex* vertices, uint32_t count)
 {
 	ENSURE(vertices != nullptr && m_vertexBuffer != nullptr);
@@ -197,10 +224,26 @@ void Geometry::UploadIndices(uint32_t offset, uint32_t* indices, uint32_t count)
 	}
 }
 
+void Geometry::UploadParams(uint32_t offset, DrawParamVertex* params, uint32_t count)
+{
+	ENSURE(params != nullptr && m_paramBuffer != nullptr);
+
+	D3D11_MAPPED_SUBRESOURCE mappedResource;
+	if (S_OK == GetRenderSystem()->GetContext()->Map(m_paramBuffer, 0, D3D11_MAP_WRITE_DISCARD, 0, &mappedResource))
+	{
+		count = __min(m_numParams - offset, count);
+		DrawParamVertex* data = reinterpret_cast<DrawParamVertex*>(mappedResource.pData);
+		memcpy(data + offset, params, sizeof(DrawParamVertex) * count);
+		GetRenderSystem()->GetContext()->Unmap(m_paramBuffer, 0);
+	}
+}
+
 void Geometry::Destroy()
 {
 	m_vertexBuffer.release();
 	m_indexBuffer.release();
+	m_paramBuffer.release();
 	m_numVertices = 0;
 	m_numIndices = 0;
+	m_numParams = 0;
 }
@@ -0,0 +1,187 @@
+#pragma once
+#include <cinttypes>
+#include <algorithm>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+// Objects of one type allocated from fixed-size slabs.
+// Objects never move, freed slots are reused first, so that creating
+// and destroying does not allocate once enough slabs exist. Every slot
+// carries a generation, odd while alive, bumped on creating and on
+// destroying, a handle of (index, generation) tells whether the object
+// it was taken from is still alive, even after the slot is reused.
+template<typename T, uint32_t SLAB_SIZE = 256>
+class ObjectPool
+{
+public:
+	struct Handle
+	{
+		uint32_t index;
+		uint32_t generation;	// 0 is never used by living objects.
+	};
+
+	ObjectPool() = default;
+
+	ObjectPool(const ObjectPool&) = delete;
+
+	ObjectPool& operator=(const ObjectPool&) = delete;
+
+	// objects must be destroyed before.
+	~ObjectPool() = default;
+
+	template<typename... ARGS> T* Create(ARGS&&... args)
+	{
+		uint32_t index = m_freeHead;
+		if (index == INVALID_INDEX)
+		{
+			index = static_cast<uint32_t>(m_slabs.size()) * SLAB_SIZE;
+			m_slabs.emplace_back(new Slot[SLAB_SIZE]);
+			// chain new slots in order, the first one is taken now.
+			for (uint32_t i = 0; i < SLAB_SIZE; i++)
+			{
+				Slot& slot = m_slabs.back()[i];
+				slot.generation = 0;
+				slot.index = index + i;
+				slot.nextFree = (i + 1 < SLAB_SIZE) ? index + i + 1 : INVALID_INDEX;
+			}
+		}
+
+		// constructor may create other objects of the pool.
+		Slot& slot = GetSlot(index);
+		m_freeHead = slot.nextFree;
+		slot.generation++;
+		m_count++;
+		return new (&slot.storage) T(std::forward<ARGS>(args)...);
+	}
+
+	void Destroy(T* object)
+	{
+		// destructor may destroy other objects of the pool.
+		Slot* slot = reinterpret_cast<Slot*>(object);
+		object->~T();
+		slot->generation++;
+		slot->nextFree = m_freeHead;
+		m_freeHead = slot->index;
+		m_count--;
+	}
+
+	static Handle GetHandle(const T* object)
+	{
+		const Slot* slot = reinterpret_cast<const Slot*>(object);
+		return{ slot->index, slot->generation };
+	}
+
+	// nullptr if the object is destroyed.
+	T* Get(const Handle& handle) const
+	{
+		if (handle.index >= m_slabs.size() * SLAB_SIZE)
+			return nullptr;
+
+		Slot& slot = GetSlot(handle.index);
+		if (slot.generation != handle.generation || (slot.generation & 1) == 0)
+			return nullptr;
+
+		return reinterpret_cast<T*>(&slot.storage);
+	}
+
+	// number of living objects.
+	uint32_t GetCount() const { return m_count; }
+
+	uint32_t GetCapacity() const { return static_cast<uint32_t>(m_slabs.size()) * SLAB_SIZE; }
+
+private:
+	static const uint32_t INVALID_INDEX = 0xFFFFFFFF;
+
+	// storage must be the first member, objects and
+	// their slots share the same address.
+	struct Slot
+	{
+		typename std::aligned_storage<sizeof(T), alignof(T)>::type storage;
+		uint32_t generation;
+		uint32_t index;
+		uint32_t nextFree;
+	};
+
+	static_assert(std::is_standard_layout<Slot>::value, "slot must be standard layout.");
+
+	Slot& GetSlot(uint32_t index) const
+	{
+		return m_slabs[index / SLAB_SIZE][index % SLAB_SIZE];
+	}
+
+	std::vector<std::unique_ptr<Slot[]>> m_slabs;
+	uint32_t m_freeHead = INVALID_INDEX;
+	uint32_t m_count = 0;
+};
+
+template<typename T, uint32_t SLAB_SIZE>
+const uint32_t ObjectPool<T, SLAB_SIZE>::INVALID_INDEX;
+
+// Untyped blocks of one size, for objects whose types are only known
+// at runtime, e.g. by class id. Blocks are aligned as operator new,
+// slabs are never freed until the pool is destroyed.
+class BlockPool
+{
+public:
+	explicit BlockPool(uint32_t blockSize, uint32_t slabSize = 64)
+		: m_blockSize(AlignSize(blockSize))
+		, m_slabSize(slabSize)
+	{
+	}
+
+	BlockPool(const BlockPool&) = delete;
+
+	BlockPool& operator=(const BlockPool&) = delete;
+
+	void* Allocate()
+	{
+		if (m_freeHead == nullptr)
+		{
+			m_slabs.emplace_back(new uint8_t[static_cast<size_t>(m_blockSize) * m_slabSize]);
+			// chain new blocks in order, a free block stores the next one.
+			uint8_t* slab = m_slabs.back().get();
+			for (uint32_t i = m_slabSize; i > 0; i--)
+			{
+				void* block = slab + static_cast<size_t>(m_blockSize) * (i - 1);
+				*static_cast<void**>(block) = m_freeHead;
+				m_freeHead = block;
+			}
+		}
+
+		void* block = m_freeHead;
+		m_freeHead = *static_cast<void**>(block);
+		m_count++;
+		return block;
+	}
+
+	void Free(void* block)
+	{
+		*static_cast<void**>(block) = m_freeHead;
+		m_freeHead = block;
+		m_count--;
+	}
+
+	uint32_t GetBlockSize() const { return m_blockSize; }
+
+	// number of allocated blocks.
+	uint32_t GetCount() const { return m_count; }
+
+	uint32_t GetCapacity() const { return static_cast<uint32_t>(m_slabs.size()) * m_slabSize; }
+
+	// size of blocks allocated for objects of size.
+	static uint32_t AlignSize(uint32_t size)
+	{
+		const uint32_t alignment = 16;
+		return (std::max(size, static_cast<uint32_t>(sizeof(void*))) + alignment - 1) & ~(alignment - 1);
+	}
+
+private:
+	std::vector<std::unique_ptr<uint8_t[]>> m_slabs;
+	void* m_freeHead = nullptr;
+	uint32_t m_blockSize;
+	uint32_t m_slabSize;
+	uint32_t m_count = 0;
+};
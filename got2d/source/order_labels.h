@@ -0,0 +1,126 @@
+#pragma once
+#include <cinttypes>
+#include <vector>
+
+// Sparse keys keeping items of a sequence in order, it does NOT depend
+// on any engine type, so that tools can share it. Items inserted between
+// two neighbours take keys in the gap between theirs. When the gap is too
+// small, keys in the smallest aligned range around it which is sparse
+// enough are spread evenly, so that inserting costs O(log^2 n) amortized,
+// instead of renumbering all following items.
+// ACCESS provides these for ITEM* item, nullptr is the end of sequence:
+//   uint64_t GetKey(item), void SetKey(item, key), ITEM* Prev(item), ITEM* Next(item)
+//   bool IsDirty(item), true for items placed in the sequence but not
+//   inserted yet, their keys are stale and skipped when relabeling.
+template<typename ITEM, typename ACCESS> class OrderLabels
+{
+public:
+	// appended items are this far apart.
+	constexpr static uint64_t APPEND_GAP = 1ull << 24;
+
+	explicit OrderLabels(ACCESS access = ACCESS()) : m_access(access) { }
+
+	// give keys to items, placed between prev and next in order, prev and
+	// next are nullptr at the ends, they must not be dirty. Keys of other
+	// items may be changed, it returns the number of keys set.
+	uint32_t Insert(ITEM* prev, ITEM* next, const std::vector<ITEM*>& items)
+	{
+		uint64_t count = items.size();
+		if (count == 0)
+			return 0;
+
+		uint64_t low = (prev == nullptr) ? 0 : m_access.GetKey(prev);
+		uint64_t step = 0;
+		if (next == nullptr)
+		{
+			if ((UINT64_MAX - low) / APPEND_GAP > count)
+				step = APPEND_GAP;
+		}
+		else
+		{
+			step = (m_access.GetKey(next) - low) / (count + 1);
+		}
+
+		if (step == 0)
+		{
+			return Relabel(prev, next, items);
+		}
+
+		for (uint64_t i = 0; i < count; i++)
+		{
+			m_access.SetKey(items[i], low + (i + 1) * step);
+		}
+		return static_cast<uint32_t>(count);
+	}
+
+private:
+	// the range of 2^bits keys is sparse enough if it holds
+	// no more than (4/3)^bits items, after inserting.
+	uint32_t Relabel(ITEM* prev, ITEM* next, const std::vector<ITEM*>& items)
+	{
+		m_before.clear();
+		m_after.clear();
+		uint64_t low = (prev == nullptr) ? 0 : m_access.GetKey(prev);
+		uint64_t first = 0;
+		uint64_t last = UINT64_MAX;
+		double limit = 1.0;
+		for (uint32_t bits = 1; bits < 64; bits++)
+		{
+			limit *= 4.0 / 3.0;
+			uint64_t rangeFirst = (low >> bits) << bits;
+			uint64_t rangeLast = rangeFirst + ((1ull << bits) - 1);
+			Extend(prev, next, rangeFirst, rangeLast);
+			uint64_t total = m_before.size() + items.size() + m_after.size();
+			if (total <= limit && total < rangeLast - rangeFirst)
+			{
+				first = rangeFirst;
+				last = rangeLast;
+				break;
+			}
+		}
+		Extend(prev, next, first, last);
+
+		// m_before is collected backward.
+		uint64_t total = m_before.size() + items.size() + m_after.size();
+		uint64_t step = (last - first) / (total + 1);
+		uint64_t key = first;
+		for (auto it = m_before.rbegin(); it != m_before.rend(); it++)
+		{
+			m_access.SetKey(*it, key += step);
+		}
+		for (auto item : items)
+		{
+			m_access.SetKey(item, key += step);
+		}
+		for (auto item : m_after)
+		{
+			m_access.SetKey(item, key += step);
+		}
+		return static_cast<uint32_t>(total);
+	}
+
+	// collect items around, whose keys are in [first, last]. Dirty items
+	// are walked over, they get keys when they are inserted later.
+	void Extend(ITEM* prev, ITEM* next, uint64_t first, uint64_t last)
+	{
+		ITEM* before = m_before.empty() ? prev : m_access.Prev(m_before.back());
+		while (before != nullptr && (m_access.IsDirty(before) || m_access.GetKey(before) >= first))
+		{
+			if (!m_access.IsDirty(before))
+				m_before.push_back(before);
+			before = m_access.Prev(before);
+		}
+
+		ITEM* after = m_after.empty() ? next : m_access.Next(m_after.back());
+		while (after != nullptr && (m_access.IsDirty(after) || m_access.GetKey(after) <= last))
+		{
+			if (!m_access.IsDirty(after))
+				m_after.push_back(after);
+			after = m_access.Next(after);
+		}
+	}
+
+	ACCESS m_access;
+	std::vector<ITEM*> m_before;
+	std::vector<ITEM*> m_after;
+};
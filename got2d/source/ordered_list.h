@@ -0,0 +1,86 @@
+#pragma once
+#include <cinttypes>
+#include <algorithm>
+#include "inner_utility.h"
+#include "small_vector.h"
+
+// Ordered items, they are never changed while they are traversed,
+// changes made during dispatching are recorded by the command buffer of
+// the scene and applied afterwards, so that traversing never copies.
+// LESS orders items, equal ones keep the order they are added. Up to N
+// items are stored without heap block.
+template<typename T, typename LESS, uint32_t N = 1> class OrderedList
+{
+public:
+	uint32_t GetCount() const { return static_cast<uint32_t>(m_items.size()); }
+
+	// items the heap block can hold.
+	uint32_t GetCapacity() const { return static_cast<uint32_t>(m_items.capacity()); }
+
+	T& At(uint32_t index)
+	{
+		ENSURE(index < GetCount());
+		return m_items[index];
+	}
+
+	const T& At(uint32_t index) const
+	{
+		ENSURE(index < GetCount());
+		return m_items[index];
+	}
+
+	// placed after items of equal order.
+	void Add(const T& item)
+	{
+		auto itPos = std::find_if(m_items.begin(), m_items.end(), [&](const T& other) { return LESS()(item, other); });
+		uint32_t index = static_cast<uint32_t>(itPos - m_items.begin());
+		m_items.push_back(item);
+		std::rotate(m_items.begin() + index, m_items.end() - 1, m_items.end());
+	}
+
+	// false if not found, the removed item is copied to removed.
+	template<typename PRED> bool Remove(PRED pred, T& removed)
+	{
+		auto itFound = std::find_if(m_items.begin(), m_items.end(), pred);
+		if (itFound == m_items.end())
+			return false;
+
+		removed = *itFound;
+		m_items.erase(itFound);
+		return true;
+	}
+
+	// nullptr if not found, it's valid until adding or removing.
+	template<typename PRED> T* Find(PRED pred)
+	{
+		auto itFound = std::find_if(m_items.begin(), m_items.end(), pred);
+		return itFound == m_items.end() ? nullptr : &*itFound;
+	}
+
+	template<typename PRED> const T* Find(PRED pred) const
+	{
+		return const_cast<OrderedList*>(this)->Find(pred);
+	}
+
+	// func must not add or remove items.
+	template<typename FUNC> void Traversal(FUNC func)
+	{
+		for (auto& item : m_items)
+		{
+			func(item);
+		}
+	}
+
+	// release is passed a copy, since releasing may add items.
+	template<typename FUNC> void Clear(FUNC release)
+	{
+		for (uint32_t i = 0; i < m_items.size(); i++)
+		{
+			release(T(m_items[i]));
+		}
+		m_items.clear();
+	}
+
+private:
+	small_vector<T, N> m_items;
+};
@@ -0,0 +1,342 @@
+#include <atomic>
+#include <cstring>
+#include "pixel_format.h"
+
+#if defined(_M_IX86) || defined(_M_X64) || defined(__i386__) || defined(__x86_64__)
+#define G2D_PIXEL_SIMD 1
+#include <immintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#define G2D_TARGET(x)
+#else
+#define G2D_TARGET(x) __attribute__((target(x)))
+#endif
+#else
+#define G2D_PIXEL_SIMD 0
+#endif
+
+namespace
+{
+	// 0.5 rounded x / 255, exact for x in [0, 255*255].
+	inline uint8_t Div255(uint32_t x)
+	{
+		x += 128;
+		return static_cast<uint8_t>((x + (x >> 8)) >> 8);
+	}
+
+	void ExpandRGBToRGBAScalar(const uint8_t* src, uint8_t* dst, uint32_t pixelCount, bool swapRB)
+	{
+		const int r = swapRB ? 2 : 0;
+		const int b = swapRB ? 0 : 2;
+		for (uint32_t i = 0; i < pixelCount; i++, src += 3, dst += 4)
+		{
+			dst[0] = src[r];
+			dst[1] = src[1];
+			dst[2] = src[b];
+			dst[3] = 255;
+		}
+	}
+
+	void SwizzleRGBScalar(const uint8_t* src, uint8_t* dst, uint32_t pixelCount)
+	{
+		for (uint32_t i = 0; i < pixelCount; i++, src += 3, dst += 3)
+		{
+			uint8_t r = src[0];
+			dst[0] = src[2];
+			dst[1] = src[1];
+			dst[2] = r;
+		}
+	}
+
+	void SwizzleRGBAScalar(const uint8_t* src, uint8_t* dst, uint32_t pixelCount)
+	{
+		for (uint32_t i = 0; i < pixelCount; i++, src += 4, dst += 4)
+		{
+			uint8_t r = src[0];
+			dst[0] = src[2];
+			dst[1] = src[1];
+			dst[2] = r;
+			dst[3] = src[3];
+		}
+	}
+
+	void PremultiplyAlphaScalar(const uint8_t* src, uint8_t* dst, uint32_t pixelCount)
+	{
+		for (uint32_t i = 0; i < pixelCount; i++, src += 4, dst += 4)
+		{
+			uint32_t a = src[3];
+			dst[0] = Div255(src[0] * a);
+			dst[1] = Div255(src[1] * a);
+			dst[2] = Div255(src[2] * a);
+			dst[3] = static_cast<uint8_t>(a);
+		}
+	}
+
+#if G2D_PIXEL_SIMD
+	bool CPUSupportSSSE3()
+	{
+#ifdef _MSC_VER
+		int info[4];
+		__cpuid(info, 1);
+		return (info[2] & (1 << 9)) != 0;
+#else
+		return __builtin_cpu_supports("ssse3") != 0;
+#endif
+	}
+
+	bool CPUSupportAVX2()
+	{
+#ifdef _MSC_VER
+		int info[4];
+		__cpuid(info, 0);
+		if (info[0] < 7)
+			return false;
+
+		// OS must save YMM registers.
+		__cpuid(info, 1);
+		bool osxsave = (info[2] & (1 << 27)) != 0;
+		if (!osxsave || (_xgetbv(0) & 6) != 6)
+			return false;
+
+		__cpuidex(info, 7, 0);
+		return (info[1] & (1 << 5)) != 0;
+#else
+		return __builtin_cpu_supports("avx2") != 0;
+#endif
+	}
+
+	G2D_TARGET("ssse3")
+	void ExpandRGBToRGBASSSE3(const uint8_t* src, uint8_t* dst, uint32_t pixelCount, bool swapRB)
+	{
+		const __m128i mask = swapRB
+			? _mm_setr_epi8(2, 1, 0, -1, 5, 4, 3, -1, 8, 7, 6, -1, 11, 10, 9, -1)
+			: _mm_setr_epi8(0, 1, 2, -1, 3, 4, 5, -1, 6, 7, 8, -1, 9, 10, 11, -1);
+		const __m128i alpha = _mm_set1_epi32(static_cast<int>(0xFF000000));
+
+		// 16 pixels: 48 bytes in, 64 bytes out.
+		uint32_t i = 0;
+		for (; i + 16 <= pixelCount; i += 16, src += 48, dst += 64)
+		{
+			__m128i in0 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src));
+			__m128i in1 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + 16));
+			__m128i in2 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + 32));
+			__m128i out0 = _mm_shuffle_epi8(in0, mask);
+			__m128i out1 = _mm_shuffle_epi8(_mm_alignr_epi8(in1, in0, 12), mask);
+			__m128i out2 = _mm_shuffle_epi8(_mm_alignr_epi8(in2, in1, 8), mask);
+			__m128i out3 = _mm_shuffle_epi8(_mm_srli_si128(in2, 4), mask);
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(dst), _mm_or_si128(out0, alpha));
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(dst + 16), _mm_or_si128(out1, alpha));
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(dst + 32), _mm_or_si128(out2, alpha));
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(dst + 48), _mm_or_si128(out3, alpha));
+		}
+		ExpandRGBToRGBAScalar(src, dst, pixelCount - i, swapRB);
+	}
+
+	G2D_TARGET("ssse3")
+	void SwizzleRGBSSSE3(const uint8_t* src, uint8_t* dst, uint32_t pixelCount)
+	{
+		// 5 pixels(15 bytes) each step, the 16th byte is kept
+		// and will be rewritten by next step.
+		const __m128i mask = _mm_setr_epi8(2, 1, 0, 5, 4, 3, 8, 7, 6, 11, 10, 9, 14, 13, 12, 15);
+		uint32_t i = 0;
+		for (; i + 6 <= pixelCount; i += 5, src += 15, dst += 15)
+		{
+			__m128i in = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src));
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(dst), _mm_shuffle_epi8(in, mask));
+		}
+		SwizzleRGBScalar(src, dst, pixelCount - i);
+	}
+
+	G2D_TARGET("ssse3")
+	void SwizzleRGBASSSE3(const uint8_t* src, uint8_t* dst, uint32_t pixelCount)
+	{
+		const __m128i mask = _mm_setr_epi8(2, 1, 0, 3, 6, 5, 4, 7, 10, 9, 8, 11, 14, 13, 12, 15);
+		uint32_t i = 0;
+		for (; i + 4 <= pixelCount; i += 4, src += 16, dst += 16)
+		{
+			__m128i in = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src));
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(dst), _mm_shuffle_epi8(in, mask));
+		}
+		SwizzleRGBAScalar(src, dst, pixelCount - i);
+	}
+
+	G2D_TARGET("ssse3")
+	inline __m128i PremultiplyHalfSSSE3(__m128i color, __m128i alpha)
+	{
+		// exact rounding of x/255: (t + (t >> 8)) >> 8, t = x + 128.
+		__m128i t = _mm_add_epi16(_mm_mullo_epi16(color, alpha), _mm_set1_epi16(128));
+		return _mm_srli_epi16(_mm_add_epi16(t, _mm_srli_epi16(t, 8)), 8);
+	}
+
+	G2D_TARGET("ssse3")
+	void PremultiplyAlphaSSSE3(const uint8_t* src, uint8_t* dst, uint32_t pixelCount)
+	{
+		// broadcast alpha to RGB channels, multiply alpha by 255 to keep it.
+		const __m128i alphaMask = _mm_setr_epi8(3, 3, 3, -1, 7, 7, 7, -1, 11, 11, 11, -1, 15, 15, 15, -1);
+		const __m128i alphaKeep = _mm_set1_epi32(static_cast<int>(0xFF000000));
+		const __m128i zero = _mm_setzero_si128();
+		uint32_t i = 0;
+		for (; i + 4 <= pixelCount; i += 4, src += 16, dst += 16)
+		{
+			__m128i in = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src));
+			__m128i alpha = _mm_or_si128(_mm_shuffle_epi8(in, alphaMask), alphaKeep);
+			__m128i lo = PremultiplyHalfSSSE3(_mm_unpacklo_epi8(in, zero), _mm_unpacklo_epi8(alpha, zero));
+			__m128i hi = PremultiplyHalfSSSE3(_mm_unpackhi_epi8(in, zero), _mm_unpackhi_epi8(alpha, zero));
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(dst), _mm_packus_epi16(lo, hi));
+		}
+		PremultiplyAlphaScalar(src, dst, pixelCount - i);
+	}
+
+	G2D_TARGET("avx2")
+	void ExpandRGBToRGBAAVX2(const uint8_t* src, uint8_t* dst, uint32_t pixelCount, bool swapRB)
+	{
+		// each 128-bit lane takes 4 pixels(12 bytes) after dword permutation.
+		const __m256i mask = swapRB
+			? _mm256_setr_epi8(2, 1, 0, -1, 5, 4, 3, -1, 8, 7, 6, -1, 11, 10, 9, -1,
+				2, 1, 0, -1, 5, 4, 3, -1, 8, 7, 6, -1, 11, 10, 9, -1)
+			: _mm256_setr_epi8(0, 1, 2, -1, 3, 4, 5, -1, 6, 7, 8, -1, 9, 10, 11, -1,
+				0, 1, 2, -1, 3, 4, 5, -1, 6, 7, 8, -1, 9, 10, 11, -1);
+		const __m256i permute = _mm256_setr_epi32(0, 1, 2, 0, 3, 4, 5, 0);
+		const __m256i alpha = _mm256_set1_epi32(static_cast<int>(0xFF000000));
+
+		// 16 pixels each step, loads read 8 bytes beyond
+		// the 48 bytes, so keep away from the tail.
+		uint32_t i = 0;
+		for (; i + 19 <= pixelCount; i += 16, src += 48, dst += 64)
+		{
+			__m256i in0 = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src));
+			__m256i in1 = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src + 24));
+			__m256i out0 = _mm256_shuffle_epi8(_mm256_permutevar8x32_epi32(in0, permute), mask);
+			__m256i out1 = _mm256_shuffle_epi8(_mm256_permutevar8x32_epi32(in1, permute), mask);
+			_mm256_storeu_si256(reinterpret_cast<__m256i*>(dst), _mm256_or_si256(out0, alpha));
+			_mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + 32), _mm256_or_si256(out1, alpha));
+		}
+		ExpandRGBToRGBASSSE3(src, dst, pixelCount - i, swapRB);
+	}
+
+	G2D_TARGET("avx2")
+	void SwizzleRGBAAVX2(const uint8_t* src, uint8_t* dst, uint32_t pixelCount)
+	{
+		const __m256i mask = _mm256_setr_epi8(2, 1, 0, 3, 6, 5, 4, 7, 10, 9, 8, 11, 14, 13, 12, 15,
+			2, 1, 0, 3, 6, 5, 4, 7, 10, 9, 8, 11, 14, 13, 12, 15);
+		uint32_t i = 0;
+		for (; i + 8 <= pixelCount; i += 8, src += 32, dst += 32)
+		{
+			__m256i in = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src));
+			_mm256_storeu_si256(reinterpret_cast<__m256i*>(dst), _mm256_shuffle_epi8(in, mask));
+		}
+		SwizzleRGBASSSE3(src, dst, pixelCount - i);
+	}
+
+	G2D_TARGET("avx2")
+	inline __m256i PremultiplyHalfAVX2(__m256i color, __m256i alpha)
+	{
+		__m256i t = _mm256_add_epi16(_mm256_mullo_epi16(color, alpha), _mm256_set1_epi16(128));
+		return _mm256_srli_epi16(_mm256_add_epi16(t, _mm256_srli_epi16(t, 8)), 8);
+	}
+
+	G2D_TARGET("avx2")
+	void PremultiplyAlphaAVX2(const uint8_t* src, uint8_t* dst, uint32_t pixelCount)
+	{
+		const __m256i alphaMask = _mm256_setr_epi8(3, 3, 3, -1, 7, 7, 7, -1, 11, 11, 11, -1, 15, 15, 15, -1,
+			3, 3, 3, -1, 7, 7, 7, -1, 11, 11, 11, -1, 15, 15, 15, -1);
+		const __m256i alphaKeep = _mm256_set1_epi32(static_cast<int>(0xFF000000));
+		const __m256i zero = _mm256_setzero_si256();
+		uint32_t i = 0;
+		for (; i + 8 <= pixelCount; i += 8, src += 32, dst += 32)
+		{
+			// unpack/pack work in lanes, so pixel order is kept.
+			__m256i in = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src));
+			__m256i alpha = _mm256_or_si256(_mm256_shuffle_epi8(in, alphaMask), alphaKeep);
+			__m256i lo = PremultiplyHalfAVX2(_mm256_unpacklo_epi8(in, zero), _mm256_unpacklo_epi8(alpha, zero));
+			__m256i hi = PremultiplyHalfAVX2(_mm256_unpackhi_epi8(in, zero), _mm256_unpackhi_epi8(alpha, zero));
+			_mm256_storeu_si256(reinterpret_cast<__m256i*>(dst), _mm256_packus_epi16(lo, hi));
+		}
+		PremultiplyAlphaSSSE3(src, dst, pixelCount - i);
+	}
+#endif
+
+	struct PixelKernels
+	{
+		const char* name;
+		void(*expandRGBToRGBA)(const uint8_t*, uint8_t*, uint32_t, bool);
+		void(*swizzleRGB)(const uint8_t*, uint8_t*, uint32_t);
+		void(*swizzleRGBA)(const uint8_t*, uint8_t*, uint32_t);
+		void(*premultiplyAlpha)(const uint8_t*, uint8_t*, uint32_t);
+	};
+
+	// the fastest one supported if name is nullptr, false if the
+	// named one is not supported.
+	bool SelectKernels(const char* name, PixelKernels& kernels)
+	{
+		auto named = [name](const char* n) { return name == nullptr || strcmp(name, n) == 0; };
+#if G2D_PIXEL_SIMD
+		if (named("avx2") && CPUSupportAVX2())
+		{
+			kernels = { "avx2", ExpandRGBToRGBAAVX2, SwizzleRGBSSSE3, SwizzleRGBAAVX2, PremultiplyAlphaAVX2 };
+			return true;
+		}
+		if (named("ssse3") && CPUSupportSSSE3())
+		{
+			kernels = { "ssse3", ExpandRGBToRGBASSSE3, SwizzleRGBSSSE3, SwizzleRGBASSSE3, PremultiplyAlphaSSSE3 };
+			return true;
+		}
+#endif
+		if (named("scalar"))
+		{
+			kernels = { "scalar", ExpandRGBToRGBAScalar, SwizzleRGBScalar, SwizzleRGBAScalar, PremultiplyAlphaScalar };
+			return true;
+		}
+		return false;
+	}
+
+	PixelKernels& GetKernels()
+	{
+		static PixelKernels s_kernels;
+		static bool s_selected = SelectKernels(nullptr, s_kernels);
+		(void)s_selected;
+		return s_kernels;
+	}
+
+	std::atomic<JobSystem*> g_pixelJobSystem{ nullptr };
+}
+
+void ExpandRGBToRGBA(const uint8_t* src, uint8_t* dst, uint32_t pixelCount, bool swapRB)
+{
+	GetKernels().expandRGBToRGBA(src, dst, pixelCount, swapRB);
+}
+
+void SwizzleRGB(const uint8_t* src, uint8_t* dst, uint32_t pixelCount)
+{
+	GetKernels().swizzleRGB(src, dst, pixelCount);
+}
+
+void SwizzleRGBA(const uint8_t* src, uint8_t* dst, uint32_t pixelCount)
+{
+	GetKernels().swizzleRGBA(src, dst, pixelCount);
+}
+
+void PremultiplyAlpha(const uint8_t* src, uint8_t* dst, uint32_t pixelCount)
+{
+	GetKernels().premultiplyAlpha(src, dst, pixelCount);
+}
+
+const char* GetPixelKernelName()
+{
+	return GetKernels().name;
+}
+
+bool SelectPixelKernels(const char* name)
+{
+	return SelectKernels(name, GetKernels());
+}
+
+void SetPixelJobSystem(JobSystem* jobs)
+{
+	g_pixelJobSystem.store(jobs, std::memory_order_release);
+}
+
+JobSystem* GetPixelJobSystem()
+{
+	return g_pixelJobSystem.load(std::memory_order_acquire);
+}
@@ -0,0 +1,62 @@
+#pragma once
+#include <cinttypes>
+#include <algorithm>
+#include "job_system.h"
+
+// Pixel format conversion kernels. SSSE3/AVX2 versions are
+// selected at runtime, and fallback to scalar versions on
+// other CPUs.
+
+// Expand RGB8 to RGBA8, alpha channel is filled with 255.
+// If swapRB is true, RGB8 is treated as BGR8 and will be
+// swizzled to RGBA8 at the same time.
+void ExpandRGBToRGBA(const uint8_t* src, uint8_t* dst, uint32_t pixelCount, bool swapRB = false);
+
+// Swap R/B channels of 24-bit pixels, RGB8 <-> BGR8.
+// src and dst can be the same memory.
+void SwizzleRGB(const uint8_t* src, uint8_t* dst, uint32_t pixelCount);
+
+// Swap R/B channels of 32-bit pixels, RGBA8 <-> BGRA8.
+// src and dst can be the same memory.
+void SwizzleRGBA(const uint8_t* src, uint8_t* dst, uint32_t pixelCount);
+
+// Multiply RGB channels of RGBA8 pixels by alpha channel.
+// src and dst can be the same memory.
+void PremultiplyAlpha(const uint8_t* src, uint8_t* dst, uint32_t pixelCount);
+
+// Name of the kernel set selected for current CPU: "avx2", "ssse3" or "scalar".
+const char* GetPixelKernelName();
+
+// Use the named kernel set instead, or the fastest one if it's nullptr,
+// false if current CPU does not support it. It's for testing, call it
+// when nothing is being converted.
+bool SelectPixelKernels(const char* name);
+
+// Job system ParallelRows runs on, rows are converted in calling thread
+// if it's nullptr or not started. The engine sets its own one, tools
+// may start one.
+void SetPixelJobSystem(JobSystem* jobs);
+
+JobSystem* GetPixelJobSystem();
+
+// Images smaller than this will be converted in calling thread.
+constexpr uint32_t PARALLEL_CONVERTING_BYTES = 256 * 1024;
+
+// Rows of a job, thieves take halves of larger ranges.
+constexpr uint32_t PARALLEL_CONVERTING_GRAIN_BYTES = 64 * 1024;
+
+// Split rows into blocks and invoke func(rowBegin, rowEnd)
+// on job workers, when image is large enough.
+template<typename FUNC> void ParallelRows(uint32_t rowCount, uint32_t rowBytes, FUNC func)
+{
+	JobSystem* jobs = GetPixelJobSystem();
+	if (jobs == nullptr || jobs->GetWorkerCount() <= 1 ||
+		static_cast<uint64_t>(rowCount) * rowBytes < PARALLEL_CONVERTING_BYTES)
+	{
+		func(0u, rowCount);
+		return;
+	}
+
+	uint32_t grainSize = std::max(1u, PARALLEL_CONVERTING_GRAIN_BYTES / std::max(1u, rowBytes));
+	jobs->ParallelFor(0, rowCount, grainSize, func);
+}
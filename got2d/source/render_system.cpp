@@ -128,6 +128,23 @@ bool RenderSystem::CreateBlendModes()
 		return false;
 	m_blendModes[g2d::BlendMode::Additve] = blendState;
 
+	for (int i = 0; i < D3D11_SIMULTANEOUS_RENDER_TARGET_COUNT; i++)
+	{
+		blendDesc.RenderTarget[i].BlendEnable = TRUE;
+		blendDesc.RenderTarget[i].SrcBlend = D3D11_BLEND_ONE;
+		blendDesc.RenderTarget[i].DestBlend = D3D11_BLEND_INV_SRC_ALPHA;
+		blendDesc.RenderTarget[i].BlendOp = D3D11_BLEND_OP_ADD;
+		blendDesc.RenderTarget[i].SrcBlendAlpha = D3D11_BLEND_ONE;
+		blendDesc.RenderTarget[i].DestBlendAlpha = D3D11_BLEND_ZERO;
+		blendDesc.RenderTarget[i].BlendOpAlpha = D3D11_BLEND_OP_ADD;
+		blendDesc.RenderTarget[i].RenderTargetWriteMask = D3D11_COLOR_WRITE_ENABLE_ALL;
+	}
+
+	hr = m_d3dDevice->CreateBlendState(&blendDesc, &blendState);
+	if (hr != S_OK)
+		return false;
+	m_blendModes[g2d::BlendMode::Premultiplied] = blendState;
+
 	for (int i = 0; i < D3D11_SIMULTANEOUS_RENDER_TARGET_COUNT; i++)
 	{
 		blendDesc.RenderTarget[i].BlendEnable = TRUE;
@@ -268,6 +285,7 @@ void RenderSystem::Destroy()
 		delete list.second;
 	}
 	m_renderRequests.clear();
+	m_batchParams.clear();
 
 	for (auto& blendMode : m_blendModes)
 	{
@@ -327,16 +345,16 @@ void RenderSystem::Present()
 
 void RenderSystem::SetBlendMode(g2d::BlendMode blendMode)
 {
-	if (m_blendModes.count(blendMode) == 0)
+	auto itFound = m_blendModes.find(blendMode);
+	if (itFound == m_blendModes.end())
 		return;
 
-	ID3D11BlendState* blendState = m_blendModes[blendMode];
-	m_d3dContext->OMSetBlendState(blendState, nullptr, 0xffffffff);
+	m_d3dContext->OMSetBlendState(itFound->second, nullptr, 0xffffffff);
 }
 
 Texture* RenderSystem::CreateTextureFromFile(const char* resPath)
 {
-	return new Texture(resPath);
+	return new Texture(Atom(resPath));
 }
 
 void RenderSystem::UpdateConstBuffer(ID3D11Buffer* cbuffer, const void* data, uint32_t length)
@@ -379,13 +397,18 @@ void RenderSystem::FlushBatch(Mesh& mesh, g2d::Material& material)
 
 	for (uint32_t i = 0; i < material.GetPassCount(); i++)
 	{
-		auto pass = material.GetPassByIndex(i);
-		auto shader = m_shaderlib->GetShaderByName(pass->GetVertexShaderName(), pass->GetPixelShaderName());
-		if (shader)
+		auto pass = reinterpret_cast<::Pass*>(material.GetPassByIndex(i));
+		auto shader = m_shaderlib->GetShaderByName(pass->GetVertexShader(), pass->GetPixelShader());
+		auto& params = m_batchParams[i];
+		// without parameters of every vertex, the pass can not be drawn.
+		if (shader && m_geometry.MakeEnoughParamArray(static_cast<uint32_t>(params.size())))
 		{
-			uint32_t stride = sizeof(g2d::GeometryVertex);
-			uint32_t offset = 0;
-			m_d3dContext->IASetVertexBuffers(0, 1, &(m_geometry.m_vertexBuffer.pointer), &stride, &offset);
+			m_geometry.UploadParams(0, &(params[0]), static_cast<uint32_t>(params.size()));
+
+			ID3D11Buffer* buffers[] = { m_geometry.m_vertexBuffer, m_geometry.m_paramBuffer };
+			uint32_t strides[] = { sizeof(g2d::GeometryVertex), sizeof(DrawParamVertex) };
+			uint32_t offsets[] = { 0, 0 };
+			m_d3dContext->IASetVertexBuffers(0, 2, buffers, strides, offsets);
 			m_d3dContext->IASetIndexBuffer(m_geometry.m_indexBuffer, DXGI_FORMAT_R32_UINT, 0);
 			m_d3dContext->IASetPrimitiveTopology(D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
 			m_d3dContext->IASetInputLayout(shader->GetInputLayout());
@@ -429,8 +452,7 @@ void RenderSystem::FlushBatch(Mesh& mesh, g2d::Material& material)
 				for (uint32_t t = 0; t < pass->GetTextureCount(); t++)
 				{
 					::Texture* timpl = reinterpret_cast<::Texture*>(pass->GetTextureByIndex(t));
-					std::string textureName = (timpl == nullptr) ? "" : timpl->GetResourceName();
-					auto texture = m_texPool.GetTexture(textureName);
+					auto texture = m_texPool.GetTexture((timpl == nullptr) ? Atom() : timpl->GetResource());
 					if (texture)
 					{
 						views[t] = texture->m_shaderView;
@@ -451,6 +473,29 @@ void RenderSystem::FlushBatch(Mesh& mesh, g2d::Material& material)
 	}
 
 	mesh.Clear();
+	for (auto& params : m_batchParams)
+	{
+		params.clear();
+	}
+}
+
+void RenderSystem::AppendDrawParams(g2d::Material& material, uint32_t vertexCount)
+{
+	if (m_batchParams.size() < material.GetPassCount())
+	{
+		m_batchParams.resize(material.GetPassCount());
+	}
+
+	for (uint32_t i = 0; i < material.GetPassCount(); i++)
+	{
+		auto pass = material.GetPassByIndex(i);
+		DrawParamVertex drawParams;
+		for (uint32_t p = 0; p < g2d::DrawParam::Count; p++)
+		{
+			drawParams.params[p] = pass->GetDrawParam(p);
+		}
+		m_batchParams[i].insert(m_batchParams[i].end(), vertexCount, drawParams);
+	}
 }
 
 void RenderSystem::FlushRequests()
@@ -482,8 +527,11 @@ void RenderSystem::FlushRequests()
 			{
 				FlushBatch(batchMesh, *material);
 				//de factor, no need to Merge when there is only ONE MESH each drawcall.
-				batchMesh.Merge(request.mesh, request.worldMatrix);
+				//a mesh too large for a batch is not drawn, nor are its parameters added.
+				if (!batchMesh.Merge(request.mesh, request.worldMatrix))
+					continue;
 			}
+			AppendDrawParams(request.material, request.mesh.GetVertexCount());
 		}
 		list.clear();
 	}
@@ -495,11 +543,11 @@ void RenderSystem::FlushRequests()
 
 void RenderSystem::RenderMesh(uint32_t layer, g2d::Mesh* mesh, g2d::Material* material, const gml::mat32& worldMatrix)
 {
-	if (m_renderRequests.count(layer) == 0)
+	ReqList*& list = m_renderRequests[layer];
+	if (list == nullptr)
 	{
-		m_renderRequests[layer] = new ReqList();
+		list = new ReqList();
 	}
-	ReqList* list = m_renderRequests[layer];
 	list->push_back({ *mesh, *material, worldMatrix });
 }
 
@@ -522,6 +570,7 @@ gml::coord RenderSystem::ViewToScreen(const gml::vec2 & view) const
 
 void RenderSystem::BeginRender()
 {
+	m_texPool.Update();
 	Clear();
 }
 
@@ -1,8 +1,19 @@
 #pragma once
 #include <Windows.h>
+#include <cstring>
 #include <map>
+#include <set>
+#include <deque>
 #include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
 #include <d3d11.h>
+#include "img_data.h"
+#include "texture_codec.h"
+#include "file_system.h"
+#include "atom.h"
+#include "flat_map.h"
 #include <gml/gmlcolor.h>
 #include "../include/g2drender.h"
 #include "inner_utility.h"
@@ -10,6 +21,13 @@
 #pragma comment(lib, "d3d11.lib")
 #pragma comment(lib, "dxgi.lib")
 
+// Per-vertex layout of the second vertex stream,
+// filled with per-draw parameters of a pass when batching.
+struct DrawParamVertex
+{
+	gml::vec4 params[g2d::DrawParam::Count];
+};
+
 class Geometry
 {
 public:
@@ -19,16 +37,22 @@ public:
 
 	bool MakeEnoughIndexArray(uint32_t numIndices);
 
+	bool MakeEnoughParamArray(uint32_t numVertices);
+
 	void UploadVertices(uint32_t offset, g2d::GeometryVertex*, uint32_t count);
 
 	void UploadIndices(uint32_t offset, uint32_t* indices, uint32_t count);
 
+	void UploadParams(uint32_t offset, DrawParamVertex* params, uint32_t count);
+
 	void Destroy();
 
 	autor<ID3D11Buffer> m_vertexBuffer = nullptr;
 	autor<ID3D11Buffer> m_indexBuffer = nullptr;
+	autor<ID3D11Buffer> m_paramBuffer = nullptr;
 	uint32_t m_numVertices = 0;
 	uint32_t m_numIndices = 0;
+	uint32_t m_numParams = 0;
 };
 
 class Mesh : public g2d::Mesh
@@ -71,16 +95,18 @@ class Texture : public g2d::Texture
 {
 	RTTI_IMPL;
 public:
-	static Texture& Default() { static Texture t(""); return t; }
+	static Texture& Default() { static Texture t{ Atom() }; return t; }
+
+	Texture(Atom resource);
 
-	Texture(std::string resPath);
+	~Texture();
 
-	const std::string& GetResourceName() const { return m_resPath; }
+	Atom GetResource() const { return m_resource; }
 
 public: // g2d::Texture
 	virtual void Release() override;
 
-	virtual const char* Identifier() const override { return m_resPath.c_str(); }
+	virtual const char* Identifier() const override { return m_resource.GetCString(); }
 
 	virtual bool IsSame(g2d::Texture* other) const override;
 
@@ -88,7 +114,27 @@ public: // g2d::Texture
 
 private:
 	int m_refCount = 1;
-	std::string m_resPath;
+	Atom m_resource;
+};
+
+// Decoded content of a texture. The hash only picks the bucket, a
+// texture is shared when the layout and a second hash match as well.
+struct TextureContent
+{
+	uint32_t layout[5] = { 0, 0, 0, 0, 0 };	// container or not, format or channels, width, height, mips.
+	uint64_t hash = 0;
+	uint64_t check = 0;
+
+	bool operator==(const TextureContent& other) const
+	{
+		return hash == other.hash && check == other.check &&
+			memcmp(layout, other.layout, sizeof(layout)) == 0;
+	}
+};
+
+struct TextureContentHash
+{
+	size_t operator()(const TextureContent& content) const { return static_cast<size_t>(content.hash); }
 };
 
 class Texture2D
@@ -96,32 +142,156 @@ class Texture2D
 public:
 	bool Create(uint32_t width, uint32_t height);
 
+	// Create immutable texture with all mips of container,
+	// block-compressed data is uploaded without decoding.
+	bool Create(const TextureContainer& container);
+
+	// Only textures created by Create(width, height) can be uploaded.
 	void UploadImage(uint8_t* data, bool hasAlpha);
 
 	void Destroy();
 
+	uint64_t GetMemoryBytes() const { return m_memoryBytes; }
+
 	autor<ID3D11Texture2D> m_texture = nullptr;
 	autor<ID3D11ShaderResourceView> m_shaderView = nullptr;
 	uint32_t m_width = 0;
 	uint32_t m_height = 0;
+	uint64_t m_memoryBytes = 0;
+	TextureContent m_content;
+	uint32_t m_lastUsedFrame = 0;
 };
 
+// CPU side data of a texture, either a decoded image or
+// a container file which mips point into file view.
+struct TextureData
+{
+	img_data image;
+	FileView file;
+	TextureContainer container;
+	bool isContainer = false;
+
+	// decoded pixels or container mips, identical images
+	// under different names share one Texture2D.
+	TextureContent content;
+
+	uint64_t GetUploadBytes() const;
+};
+
+// Parse container or decode image from data.file, and hash the content.
+bool DecodeTextureData(const std::string& resourcePath, TextureData& data);
+
+bool DecodeTextureFromFile(const std::string& resourcePath, TextureData& data);
+
+void DestroyTextureData(TextureData& data);
+
 class TexturePool
 {
 public:
 	bool CreateDefaultTexture();
 
+	// Start background decoding workers, textures missed in GetTexture
+	// will be decoded by workers and uploaded in Update, no more than
+	// uploadBudget bytes per frame. Loading synchronously if workerCount is 0.
+	void StartStreaming(uint32_t workerCount, uint32_t uploadBudget);
+
 	void Destroy();
 
-	Texture2D* GetTexture(const std::string& resource);
+	// Upload decoded images and notify finished preloading requests,
+	// it should be called once per frame in rendering thread.
+	void Update();
+
+	// Return default texture when the texture is still loading,
+	// return nullptr when the texture failed to load.
+	Texture2D* GetTexture(Atom resource);
 
 	Texture2D& GetDefaultTexture() { return m_defaultTexture; }
 
+	void Preload(std::vector<Atom> resources, g2d::Texture::PreloadCallback callback, void* userData);
+
+	// Reference counting of Texture objects,
+	// only unreferenced textures can be evicted.
+	void AddReference(Atom resource);
+
+	void RemoveReference(Atom resource);
+
+	void SetMemoryBudget(uint64_t bytes) { m_memoryBudget = bytes; }
+
+	const g2d::TextureStatistics& GetStatistics() const { return m_statistics; }
+
+	// Resident textures of different names may share the same content.
+	bool IsSameTexture(Atom resource, Atom otherResource) const;
+
 private:
-	bool LoadTextureFromFile(std::string resourcePath);
+	struct DecodedImage
+	{
+		Atom resource;
+		TextureData data;
+		bool fileLoaded = false;
+		bool succeeded = false;
+	};
+
+	// loose file read by AsyncIO, it must not move until reading finished.
+	struct ReadingJob
+	{
+		TexturePool* pool;
+		DecodedImage image;
+	};
+
+	struct PreloadRequest
+	{
+		std::vector<Atom> resources;
+		g2d::Texture::PreloadCallback callback;
+		void* userData;
+	};
+
+	bool LoadTextureFromFile(Atom resource);
+
+	bool CreateTexture(Atom resource, TextureData& data);
+
+	// Files are read by AsyncIO in batches submitted by FlushReads,
+	// and decoded by workers after reading finished.
+	void RequestLoading(Atom resource);
+
+	void FlushReads();
+
+	static void OnFileRead(void* userData, bool succeeded);
+
+	void EnqueueDecoding(DecodedImage&& image);
+
+	void DecodeLoop();
 
-	std::map<std::string, Texture2D*> m_textures;
+	void StopStreaming();
+
+	void CheckPreloads();
+
+	void EvictTextures();
+
+	// names of textures with identical content map to the same Texture2D.
+	flat_hash_map<Atom, Texture2D*> m_textures;
+	flat_hash_map<TextureContent, Texture2D*, TextureContentHash> m_contents;
+	std::set<Atom> m_failed;
 	Texture2D m_defaultTexture;
+
+	// memory budget
+	std::map<Atom, uint32_t> m_references;
+	std::set<Atom> m_evicted;
+	uint64_t m_memoryBudget = 0;
+	uint32_t m_frame = 0;
+	g2d::TextureStatistics m_statistics;
+
+	// streaming, m_pending and m_preloads are touched in rendering thread only.
+	std::set<Atom> m_pending;
+	std::vector<PreloadRequest> m_preloads;
+	std::vector<std::thread> m_workers;
+	std::vector<IORequest> m_readBatch;
+	std::deque<DecodedImage> m_jobs;
+	std::mutex m_jobMutex;
+	std::condition_variable m_jobCondition;
+	std::deque<DecodedImage> m_decoded;
+	std::mutex m_decodedMutex;
+	uint32_t m_uploadBudget = 0;
+	bool m_quit = false;
 };
 
 class VSData
@@ -187,26 +357,24 @@ public:
 
 	~ShaderLib();
 
-	Shader* GetShaderByName(const std::string& vsName, const std::string& psName);
+	Shader* GetShaderByName(Atom vsName, Atom psName);
 
 private:
-	bool BuildShader(const std::string& effectName, const std::string& vsName, const std::string& psName);
+	bool BuildShader(uint64_t effect, Atom vsName, Atom psName);
 
-	std::string GetEffectName(const std::string& vsName, const std::string& psName);
+	// effect is identified by ids of both shader names.
+	uint64_t GetEffect(Atom vsName, Atom psName);
 
-	std::map<std::string, VSData*> m_vsSources;
-	std::map<std::string, PSData*>  m_psSources;
-	std::map<std::string, Shader*> m_shaders;
+	vector_map<Atom, VSData*> m_vsSources;
+	vector_map<Atom, PSData*>  m_psSources;
+	flat_hash_map<uint64_t, Shader*> m_shaders;
 };
 
 class Pass : public g2d::Pass
 {
 	RTTI_IMPL;
 public:
-	Pass(std::string vsName, std::string psName)
-		: m_vsName(std::move(vsName))
-		, m_psName(std::move(psName))
-		, m_blendMode(g2d::BlendMode::None) {}
+	Pass(const char* vsName, const char* psName);
 
 	Pass(const Pass& other);
 
@@ -216,10 +384,14 @@ public:
 
 	void Release() { delete this; }
 
+	Atom GetVertexShader() const { return m_vsName; }
+
+	Atom GetPixelShader() const { return m_psName; }
+
 public:
-	virtual const char* GetVertexShaderName() const override { return m_vsName.c_str(); }
+	virtual const char* GetVertexShaderName() const override { return m_vsName.GetCString(); }
 
-	virtual const char* GetPixelShaderName() const override { return m_psName.c_str(); }
+	virtual const char* GetPixelShaderName() const override { return m_psName.GetCString(); }
 
 	virtual bool IsSame(g2d::Pass* other) const override;
 
@@ -229,6 +401,8 @@ public:
 
 	virtual void SetPSConstant(uint32_t index, float* data, uint32_t size, uint32_t count) override;
 
+	virtual void SetDrawParam(uint32_t index, const gml::vec4& param) override;
+
 	virtual void SetBlendMode(g2d::BlendMode blendMode) override { m_blendMode = blendMode; }
 
 	virtual g2d::Texture* GetTextureByIndex(uint32_t index) const override { return m_textures[index]; }
@@ -243,14 +417,17 @@ public:
 
 	virtual uint32_t GetPSConstantLength() const override { return static_cast<uint32_t>(m_psConstants.size()) * 4 * sizeof(float); }
 
+	virtual const gml::vec4& GetDrawParam(uint32_t index) const override;
+
 	virtual g2d::BlendMode GetBlendMode() const override { return m_blendMode; }
 
 private:
-	std::string m_vsName = "";
-	std::string m_psName = "";
+	Atom m_vsName;
+	Atom m_psName;
 	std::vector<g2d::Texture*> m_textures;
 	std::vector<gml::vec4> m_vsConstants;
 	std::vector<gml::vec4> m_psConstants;
+	DrawParamVertex m_drawParams;
 	g2d::BlendMode m_blendMode = g2d::BlendMode::None;
 };
 
@@ -306,6 +483,8 @@ public:
 
 	Texture* CreateTextureFromFile(const char* resPath);
 
+	TexturePool& GetTexturePool() { return m_texPool; }
+
 	ID3D11Device* GetDevice() { return m_d3dDevice; }
 
 	ID3D11DeviceContext* GetContext() { return m_d3dContext; }
@@ -327,11 +506,17 @@ public:
 
 	virtual gml::coord ViewToScreen(const gml::vec2 & view) const override;
 
+	virtual void SetTextureMemoryBudget(uint64_t bytes) override { m_texPool.SetMemoryBudget(bytes); }
+
+	virtual const g2d::TextureStatistics& GetTextureStatistics() const override { return m_texPool.GetStatistics(); }
+
 private:
 	bool CreateBlendModes();
 
 	void FlushBatch(Mesh& mesh, g2d::Material&);
 
+	void AppendDrawParams(g2d::Material& material, uint32_t vertexCount);
+
 	void UpdateConstBuffer(ID3D11Buffer* cbuffer, const void* data, uint32_t length);
 
 	void UpdateSceneConstBuffer();
@@ -344,7 +529,7 @@ private:
 	autor<ID3D11RenderTargetView> m_bbView = nullptr;
 	autor<ID3D11Buffer> m_sceneConstBuffer = nullptr;
 	D3D11_VIEWPORT m_viewport;
-	std::map<g2d::BlendMode, ID3D11BlendState*> m_blendModes;
+	vector_map<g2d::BlendMode, ID3D11BlendState*> m_blendModes;
 
 	gml::color4 m_bkColor = gml::color4::blue();
 
@@ -359,7 +544,11 @@ private:
 	};
 
 	typedef std::vector<RenderRequest> ReqList;
-	std::map<uint32_t, ReqList*> m_renderRequests;
+	// few layers, visited in order of layer.
+	vector_map<uint32_t, ReqList*> m_renderRequests;
+
+	// per-draw parameters of batching mesh, one list per pass.
+	std::vector<std::vector<DrawParamVertex>> m_batchParams;
 
 	Geometry m_geometry;
 	TexturePool m_texPool;
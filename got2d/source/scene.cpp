@@ -3,8 +3,9 @@
 #include "engine.h"
 
 Scene::Scene(float boundSize)
-	: m_spatial(boundSize)
-	, m_mouseButtonState{ 0, 1, 2 }
+	: m_mouseButtonState{ 0, 1, 2 }
+	, m_spatial(boundSize)
+	, m_commandBuffer(false)
 {
 	//for main camera
 	CreateCameraNode();
@@ -13,6 +14,20 @@ Scene::Scene(float boundSize)
 	RegisterMouseEventReceiver();
 }
 
+template<typename FUNC> void Scene::Batch(FUNC func)
+{
+	if (SceneCommandBuffer::GetCurrent() != nullptr)
+	{
+		func();
+		return;
+	}
+
+	SceneCommandBuffer::SetCurrent(&m_commandBuffer);
+	func();
+	SceneCommandBuffer::SetCurrent(nullptr);
+	ApplyCommands();
+}
+
 void Scene::RegisterKeyEventReceiver()
 {
 	m_keyPressReceiver.UserData
@@ -24,25 +39,25 @@ void Scene::RegisterKeyEventReceiver()
 	m_keyPressReceiver.Functor = [](void* userData, g2d::KeyCode key)
 	{
 		::Scene* scene = reinterpret_cast<::Scene*>(userData);
-		scene->OnKeyPress(key);
+		scene->Batch([&] { scene->OnKeyPress(key); });
 	};
 
 	m_keyPressingBeginReceiver.Functor = [](void* userData, g2d::KeyCode key)
 	{
 		::Scene* scene = reinterpret_cast<::Scene*>(userData);
-		scene->OnKeyPressingBegin(key);
+		scene->Batch([&] { scene->OnKeyPressingBegin(key); });
 	};
 
 	m_keyPressingReceiver.Functor = [](void* userData, g2d::KeyCode key)
 	{
 		::Scene* scene = reinterpret_cast<::Scene*>(userData);
-		scene->OnKeyPressing(key);
+		scene->Batch([&] { scene->OnKeyPressing(key); });
 	};
 
 	m_keyPressingEndReceiver.Functor = [](void* userData, g2d::KeyCode key)
 	{
 		::Scene* scene = reinterpret_cast<::Scene*>(userData);
-		scene->OnKeyPressingEnd(key);
+		scene->Batch([&] { scene->OnKeyPressingEnd(key); });
 	};
 
 	GetKeyboard().OnPress += m_keyPressReceiver;
@@ -64,37 +79,37 @@ void Scene::RegisterMouseEventReceiver()
 	m_mousePressReceiver.Functor = [](void* userData, g2d::MouseButton button)
 	{
 		::Scene* scene = reinterpret_cast<::Scene*>(userData);
-		scene->OnMousePress(button);
+		scene->Batch([&] { scene->OnMousePress(button); });
 	};
 
 	m_mousePressingBeginReceiver.Functor = [](void* userData, g2d::MouseButton button)
 	{
 		::Scene* scene = reinterpret_cast<::Scene*>(userData);
-		scene->OnMousePressingBegin(button);
+		scene->Batch([&] { scene->OnMousePressingBegin(button); });
 	};
 
 	m_mousePressingReceiver.Functor = [](void* userData, g2d::MouseButton button)
 	{
 		::Scene* scene = reinterpret_cast<::Scene*>(userData);
-		scene->OnMousePressing(button);
+		scene->Batch([&] { scene->OnMousePressing(button); });
 	};
 
 	m_mousePressingEndReceiver.Functor = [](void* userData, g2d::MouseButton button)
 	{
 		::Scene* scene = reinterpret_cast<::Scene*>(userData);
-		scene->OnMousePressingEnd(button);
+		scene->Batch([&] { scene->OnMousePressingEnd(button); });
 	};
 
 	m_mouseMovingReceiver.Functor = [](void* userData, g2d::MouseButton button)
 	{
 		::Scene* scene = reinterpret_cast<::Scene*>(userData);
-		scene->OnMouseMoving();
+		scene->Batch([&] { scene->OnMouseMoving(); });
 	};
 
 	m_mouseDoubleClickReceiver.Functor = [](void* userData, g2d::MouseButton button)
 	{
 		::Scene* scene = reinterpret_cast<::Scene*>(userData);
-		scene->OnMouseDoubleClick(button);
+		scene->Batch([&] { scene->OnMouseDoubleClick(button); });
 	};
 
 	GetMouse().OnPress += m_mousePressReceiver;
@@ -129,23 +144,33 @@ void Scene::ResortCameraOrder()
 	}
 }
 
-void Scene::ResetRenderingOrder()
+void Scene::UpdateRenderingOrder(::SceneNode& node)
 {
-	if (m_renderingOrderDirtyNode != nullptr)
+	if (m_applyingCommands)
 	{
-		m_renderingOrderDirtyNode->AdjustRenderingOrder();
-		m_renderingOrderDirtyNode = nullptr;
+		if (!node.IsRenderingOrderDirty())
+		{
+			m_orderDirtyNodes.push_back(node.GetHandle());
+		}
+		node.MarkRenderingOrderDirty();
+		return;
 	}
+
+	m_orderingNodes.clear();
+	node.CollectSubtree(m_orderingNodes);
+	m_renderingOrder.Insert(node.GetPrevInRenderingOrder(), node.GetNextAfterSubtree(), m_orderingNodes);
 }
 
 void Scene::Release()
 {
+	ENSURE(SceneCommandBuffer::GetCurrent() == nullptr);
 	UnRegisterKeyEventReceiver();
 	UnRegisterMouseEventReceiver();
 	::GetEngineImpl()->RemoveScene(*this);
 	// clean the children first, so that
 	// child nodes can access SpatialGraph
 	// in the scene
+	DeleteReleasedNodes();
 	m_children.ClearChildren();
 	delete this;
 }
@@ -170,35 +195,278 @@ void Scene::UnRegisterMouseEventReceiver()
 
 void Scene::Update(uint32_t elapsedTime, uint32_t deltaTime)
 {
-	if (m_hoverNode != nullptr && m_canTickHovering && GetMouse().IsFree())
+	Batch([&]
 	{
-		m_hoverNode->OnCursorHovering();
-		m_canTickHovering = false;
-	}
+		if (m_hoverNode != nullptr && m_canTickHovering && GetMouse().IsFree())
+		{
+			m_hoverNode->OnCursorHovering();
+			m_canTickHovering = false;
+		}
 
-	m_children.OnUpdate(deltaTime);
+		// changes made since last frame, and those made by updating.
+		m_transforms.Update(&m_movedTransforms);
+		JobSystem& jobs = GetEngineImpl()->GetJobSystem();
+		if (m_parallelUpdate && jobs.GetWorkerCount() > 1)
+		{
+			UpdateParallel(deltaTime, jobs);
+		}
+		else
+		{
+			DispatchToSubscribers(m_updateSubscribers, [&](::SceneNode* node)
+			{
+				node->OnUpdate(deltaTime);
+			});
+		}
+		m_transforms.Update(&m_movedTransforms);
+		NotifyMovedNodes();
+	});
 
 	//TODO: checking whether m_Hovering is deleted
 	m_canTickHovering = true;
 }
 
-void Scene::OnMessage(const g2d::Message& message, uint32_t currentTimeStamp)
+void Scene::UpdateParallel(uint32_t deltaTime, JobSystem& jobs)
 {
-	m_children.OnMessage(message);
+	// one more for the calling thread, if it's not a worker.
+	while (m_commandBuffers.size() < jobs.GetWorkerCount() + 1)
+	{
+		m_commandBuffers.emplace_back(new SceneCommandBuffer(true));
+	}
+
+	// subscribers of a top-level subtree are updated by the same job,
+	// since they may access each other.
+	m_updateGroups.clear();
+	m_updateGroupStarts.clear();
+	DispatchToSubscribers(m_updateSubscribers, [&](::SceneNode* node)
+	{
+		m_updateGroups.push_back({ node->GetTopLevel()->GetHandle().index, node });
+	});
+	std::stable_sort(m_updateGroups.begin(), m_updateGroups.end(),
+		[](const std::pair<uint32_t, ::SceneNode*>& a, const std::pair<uint32_t, ::SceneNode*>& b) { return a.first < b.first; });
+	for (uint32_t i = 0; i < m_updateGroups.size(); i++)
+	{
+		if (i == 0 || m_updateGroups[i].first != m_updateGroups[i - 1].first)
+			m_updateGroupStarts.push_back(i);
+	}
+	uint32_t groupCount = static_cast<uint32_t>(m_updateGroupStarts.size());
+	m_updateGroupStarts.push_back(static_cast<uint32_t>(m_updateGroups.size()));
+
+	// a few ranges per worker, so that idle workers can steal
+	// from those who own large subtrees.
+	uint32_t grainSize = std::max(1u, groupCount / (jobs.GetWorkerCount() * 16));
+	m_transforms.BeginConcurrent();
+	jobs.ParallelFor(0, groupCount, grainSize, [&](uint32_t begin, uint32_t end)
+	{
+		// a worker may update other subtrees while waiting in a job.
+		auto previous = SceneCommandBuffer::GetCurrent();
+		int workerIndex = jobs.GetCurrentWorkerIndex();
+		SceneCommandBuffer::SetCurrent(m_commandBuffers[workerIndex < 0 ? jobs.GetWorkerCount() : workerIndex].get());
+		for (uint32_t i = m_updateGroupStarts[begin]; i < m_updateGroupStarts[end]; i++)
+		{
+			m_updateGroups[i].second->OnUpdate(deltaTime);
+		}
+		SceneCommandBuffer::SetCurrent(previous);
+	});
+	m_transforms.EndConcurrent();
 }
 
-void Scene::SetRenderingOrderDirty(::SceneNode* parent)
+void Scene::NotifyMovedNodes()
 {
-	if (m_renderingOrderDirtyNode == nullptr)
+	// parents come before children in each Update, moving of ancestors
+	// is found by the transform pass instead of walking the tree.
+	for (auto handle : m_movedTransforms)
 	{
-		m_renderingOrderDirtyNode = parent;
+		::SceneNode* node = m_transformNodes[handle];
+		if (node != nullptr && !node->IsRemoved())
+		{
+			node->OnWorldChanged();
+		}
 	}
-	else if (m_renderingOrderDirtyNode->GetRenderingOrder() > parent->GetRenderingOrder())
+	m_movedTransforms.clear();
+}
+
+void Scene::ApplyCommands()
+{
+	// commands applied change the scene directly, with fixing deferred.
+	m_applyingCommands = true;
+	ApplyCommands(m_commandBuffer);
+	for (auto& buffer : m_commandBuffers)
 	{
-		m_renderingOrderDirtyNode = parent;
+		ApplyCommands(*buffer);
+	}
+	m_applyingCommands = false;
+
+	UpdateDirtyRenderingOrder();
+	AdjustDirtySpatial();
+	DeleteReleasedNodes();
+}
+
+void Scene::ApplyCommands(SceneCommandBuffer& buffer)
+{
+	for (auto& command : buffer.GetCommands())
+	{
+		::SceneNode* node = command.node;
+		switch (command.type)
+		{
+		case SceneCommandBuffer::Type::CreateChild:
+			node->Attach();
+			UpdateRenderingOrder(*node);
+			break;
+		case SceneCommandBuffer::Type::Release:
+			node->Release();
+			break;
+		case SceneCommandBuffer::Type::Delete:
+			DeleteSceneNode(*node);
+			break;
+		case SceneCommandBuffer::Type::AddComponent:
+			node->AddComponent(command.component, command.autoRelease);
+			break;
+		case SceneCommandBuffer::Type::RemoveComponent:
+			node->RemoveComponent(command.component);
+			break;
+		case SceneCommandBuffer::Type::RemoveComponentWithoutRelease:
+			node->RemoveComponentWithoutRelease(command.component);
+			break;
+		case SceneCommandBuffer::Type::AdjustSpatial:
+			if (!node->IsSpatialDirty())
+			{
+				node->SetSpatialDirty(true);
+				m_spatialDirtyNodes.push_back(node->GetHandle());
+			}
+			break;
+		case SceneCommandBuffer::Type::MoveToFront:
+			node->MoveToFront();
+			break;
+		case SceneCommandBuffer::Type::MoveToBack:
+			node->MoveToBack();
+			break;
+		case SceneCommandBuffer::Type::MovePrev:
+			node->MovePrev();
+			break;
+		case SceneCommandBuffer::Type::MoveNext:
+			node->MoveNext();
+			break;
+		case SceneCommandBuffer::Type::SortCameras:
+			m_cameraOrderDirty = true;
+			break;
+		}
+	}
+	buffer.Clear();
+}
+
+void Scene::UpdateDirtyRenderingOrder()
+{
+	for (auto& handle : m_orderDirtyNodes)
+	{
+		::SceneNode* node = m_nodes.Get({ handle.index, handle.generation });
+		if (node == nullptr || !node->IsRenderingOrderDirty())
+			continue;
+
+		// released subtrees are out of order.
+		bool inScene = true;
+		for (::SceneNode* current = node; current != nullptr && inScene; current = current->GetParent())
+		{
+			inScene = !current->IsRemoved();
+		}
+		if (!inScene)
+			continue;
+
+		// dirty nodes next to each other are ordered at once,
+		// between the clean ones around them.
+		::SceneNode* prev = node->GetPrevInRenderingOrder();
+		::SceneNode* first = node;
+		while (prev != nullptr && prev->IsRenderingOrderDirty())
+		{
+			first = prev;
+			prev = prev->GetPrevInRenderingOrder();
+		}
+
+		m_orderingNodes.clear();
+		::SceneNode* next = first;
+		while (next != nullptr && next->IsRenderingOrderDirty())
+		{
+			next->SetRenderingOrderDirty(false);
+			m_orderingNodes.push_back(next);
+			next = next->GetNextInRenderingOrder();
+		}
+		m_renderingOrder.Insert(prev, next, m_orderingNodes);
+	}
+	m_orderDirtyNodes.clear();
+}
+
+void Scene::AdjustDirtySpatial()
+{
+	for (auto& handle : m_spatialDirtyNodes)
+	{
+		::SceneNode* node = m_nodes.Get({ handle.index, handle.generation });
+		if (node != nullptr)
+		{
+			node->SetSpatialDirty(false);
+			node->AdjustSpatial();
+		}
+	}
+	m_spatialDirtyNodes.clear();
+}
+
+void Scene::UpdateSubscription(::SceneNode& node, uint32_t previousEvents, uint32_t events)
+{
+	uint32_t changedEvents = previousEvents ^ events;
+	uint32_t nodeIndex = node.GetHandle().index;
+	if ((changedEvents & g2d::EventMask::Update) != 0)
+	{
+		if ((events & g2d::EventMask::Update) != 0)
+			m_updateSubscribers.Add(node, nodeIndex);
+		else
+			m_updateSubscribers.Remove(nodeIndex);
+	}
+
+	if ((changedEvents & g2d::EventMask::Key) != 0)
+	{
+		if ((events & g2d::EventMask::Key) != 0)
+			m_keySubscribers.Add(node, nodeIndex);
+		else
+			m_keySubscribers.Remove(nodeIndex);
+	}
+
+	if ((changedEvents & g2d::EventMask::Message) != 0)
+	{
+		if ((events & g2d::EventMask::Message) != 0)
+			m_messageSubscribers.Add(node, nodeIndex);
+		else
+			m_messageSubscribers.Remove(nodeIndex);
 	}
 }
 
+void Scene::SetTransformNode(TransformStore::Handle handle, ::SceneNode* node)
+{
+	if (handle >= m_transformNodes.size())
+	{
+		m_transformNodes.resize(handle + 1, nullptr);
+	}
+	m_transformNodes[handle] = node;
+}
+
+template<typename FUNC> void Scene::DispatchToSubscribers(const NodeSubscribers& subscribers, FUNC func)
+{
+	// subscribing and releasing by handlers are recorded, subscribers
+	// never change here. Released ones are skipped.
+	for (auto node : subscribers.GetNodes())
+	{
+		if (node->ReceivesEvents() && !node->IsRemoved()) func(node);
+	}
+}
+
+void Scene::OnMessage(const g2d::Message& message, uint32_t currentTimeStamp)
+{
+	Batch([&]
+	{
+		DispatchToSubscribers(m_messageSubscribers, [&](::SceneNode* node)
+		{
+			node->OnMessage(message);
+		});
+	});
+}
+
 void Scene::OnResize()
 {
 	for (auto& camera : m_cameras)
@@ -207,13 +475,14 @@ void Scene::OnResize()
 	}
 }
 
-void Scene::AdjustRenderingOrder()
+void Scene::DeleteReleasedNodes()
 {
-	m_renderingOrderEnd = 1;
-	m_children.Traversal([&](::SceneNode* child)
+	// deleting nodes may release more nodes.
+	for (size_t i = 0; i < m_releasedNodes.size(); i++)
 	{
-		child->SetRenderingOrder(m_renderingOrderEnd);
-	});
+		m_releasedNodes[i]->Destroy();
+	}
+	m_releasedNodes.clear();
 }
 
 void Scene::OnRemoveSceneNode(::SceneNode& node)
@@ -236,29 +505,67 @@ void Scene::OnRemoveSceneNode(::SceneNode& node)
 
 g2d::SceneNode * Scene::CreateChild()
 {
+	auto buffer = SceneCommandBuffer::GetCurrent();
+	if (buffer != nullptr)
+	{
+		return buffer->CreateChild(*this, nullptr, m_children);
+	}
+
 	auto child = m_children.CreateChild(*this, m_children);
-	child->SetRenderingOrder(m_renderingOrderEnd);
+	UpdateRenderingOrder(*child);
 	return child;
 }
 
+g2d::SceneNode* Scene::GetNodeByHandle(const g2d::SceneNodeHandle& handle) const
+{
+	// slabs may be added by other jobs during parallel updating.
+	std::unique_lock<std::mutex> lock(m_nodesMutex, std::defer_lock);
+	if (SceneCommandBuffer::IsConcurrent())
+	{
+		lock.lock();
+	}
+
+	::SceneNode* node = m_nodes.Get({ handle.index, handle.generation });
+	return (node == nullptr || node->IsRemoved()) ? nullptr : node;
+}
+
+g2d::Component* Scene::FindComponent(g2d::SceneNode* node, uint32_t classID) const
+{
+	ENSURE(node != nullptr && node->GetScene() == this);
+	auto handle = node->GetHandle();
+	return m_componentRegistry.FindFirst(classID, handle.index);
+}
+
 void Scene::OnKeyPress(g2d::KeyCode key)
 {
-	m_children.OnKeyPress(key);
+	DispatchToSubscribers(m_keySubscribers, [&](::SceneNode* node)
+	{
+		node->OnKeyPress(key);
+	});
 }
 
 void Scene::OnKeyPressingBegin(g2d::KeyCode key)
 {
-	m_children.OnKeyPressingBegin(key);
+	DispatchToSubscribers(m_keySubscribers, [&](::SceneNode* node)
+	{
+		node->OnKeyPressingBegin(key);
+	});
 }
 
 void Scene::OnKeyPressing(g2d::KeyCode key)
 {
-	m_children.OnKeyPressing(key);
+	DispatchToSubscribers(m_keySubscribers, [&](::SceneNode* node)
+	{
+		node->OnKeyPressing(key);
+	});
 }
 
 void Scene::OnKeyPressingEnd(g2d::KeyCode key)
 {
-	m_children.OnKeyPressingEnd(key);
+	DispatchToSubscribers(m_keySubscribers, [&](::SceneNode* node)
+	{
+		node->OnKeyPressingEnd(key);
+	});
 }
 
 void Scene::OnMousePress(g2d::MouseButton button)
@@ -412,14 +719,20 @@ void Scene::OnMouseMoving()
 
 bool RenderingOrderSorter(g2d::Component* a, g2d::Component* b)
 {
-	return a->GetRenderingOrder() < b->GetRenderingOrder();
+	// components of a node share its order.
+	if (a->GetRenderingOrder() != b->GetRenderingOrder())
+	{
+		return a->GetRenderingOrder() < b->GetRenderingOrder();
+	}
+	return a->GetRenderingRank() < b->GetRenderingRank();
 }
 
 void Scene::Render()
 {
+	// nodes moved by callbacks of updating, they are notified next frame.
+	m_transforms.Update(&m_movedTransforms);
 	GetRenderSystem()->FlushRequests();
 	ResortCameraOrder();
-	ResetRenderingOrder();
 	for (auto camera : m_cameraOrder)
 	{
 		if (!camera->IsActivity())
@@ -444,9 +757,23 @@ void Scene::Render()
 	}
 }
 
+void Scene::SetCameraOrderDirty()
+{
+	if (SceneCommandBuffer::IsConcurrent())
+	{
+		SceneCommandBuffer::GetCurrent()->Record(SceneCommandBuffer::Type::SortCameras, nullptr);
+	}
+	else
+	{
+		m_cameraOrderDirty = true;
+	}
+}
+
 g2d::Camera* Scene::CreateCameraNode()
 {
-	Camera* camera = new ::Camera(*this, static_cast<uint32_t>(m_cameras.size()));
+	// cameras are shared by all subtrees.
+	ENSURE(!SceneCommandBuffer::IsConcurrent());
+	Camera* camera = g2d::CreateComponent<::Camera>(*this, static_cast<uint32_t>(m_cameras.size()));
 	m_cameras.push_back(camera);
 	m_cameraOrderDirty = true;
 
@@ -464,3 +791,74 @@ uint32_t Scene::GetCameraCount() const
 {
 	return static_cast<uint32_t>(m_cameras.size());
 }
+
+namespace
+{
+	thread_local SceneCommandBuffer* t_currentCommandBuffer = nullptr;
+}
+
+SceneCommandBuffer* SceneCommandBuffer::GetCurrent()
+{
+	return t_currentCommandBuffer;
+}
+
+void SceneCommandBuffer::SetCurrent(SceneCommandBuffer* buffer)
+{
+	t_currentCommandBuffer = buffer;
+}
+
+bool SceneCommandBuffer::IsConcurrent()
+{
+	return t_currentCommandBuffer != nullptr && t_currentCommandBuffer->m_concurrent;
+}
+
+::SceneNode* SceneCommandBuffer::CreateChild(::Scene& scene, ::SceneNode* parent, SceneNodeContainer& parentContainer)
+{
+	// parent can be created by this buffer as well, other pending
+	// parents belong to other subtrees.
+	TransformStore::Handle parentTransform = TransformStore::INVALID_HANDLE;
+	if (parent != nullptr && parent->IsPending())
+	{
+		ENSURE(&parent->GetTransforms() == &m_transforms);
+		parentTransform = parent->GetTransformHandle();
+	}
+
+	auto child = scene.CreateSceneNode(parent, parentContainer, m_transforms, parentTransform, 0u);
+	Record(Type::CreateChild, child);
+	return child;
+}
+
+bool SceneCommandBuffer::IsStaging(const ::SceneNode& node) const
+{
+	return &node.GetTransforms() == &m_transforms;
+}
+
+const TransformMatrix& SceneCommandBuffer::GetWorldMatrix(::SceneNode& node)
+{
+	// pending ancestors are composed by the staging store already.
+	::SceneNode* ancestor = node.GetParent();
+	while (ancestor != nullptr && ancestor->IsPending())
+	{
+		ancestor = ancestor->GetParent();
+	}
+
+	TransformStore::Handle handle = node.GetTransformHandle();
+	const TransformMatrix& staging = m_transforms.GetWorldMatrix(handle);
+	if (ancestor == nullptr)
+		return staging;
+
+	if (m_worldMatrices.size() <= handle)
+	{
+		m_worldMatrices.resize(handle + 1);
+	}
+	TransformStore& transforms = ancestor->GetTransforms();
+	TransformStore::Multiply(transforms.GetWorldMatrix(ancestor->GetTransformHandle()), staging, m_worldMatrices[handle]);
+	return m_worldMatrices[handle];
+}
+
+void SceneCommandBuffer::Clear()
+{
+	m_commands.clear();
+	m_transforms.Clear();
+	m_worldMatrices.clear();
+}
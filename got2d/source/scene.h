@@ -1,49 +1,71 @@
 #pragma once
+#include <deque>
+#include <memory>
+#include <mutex>
 #include <vector>
 #include <gml/gmlmatrix.h>
 #include "../include/g2dscene.h"
 #include "component.h"
+#include "component_registry.h"
 #include "spatial_graph.h"
 #include "input.h"
+#include "transform_store.h"
+#include "job_system.h"
+#include "object_pool.h"
+#include "ordered_list.h"
+#include "sibling_list.h"
+#include "small_vector.h"
+#include "order_labels.h"
 
 class SceneNode;
 class Scene;
 
 struct NodeComponent
 {
-	NodeComponent(g2d::Component* c, bool ar) : ComponentPtr(c), AutoRelease(ar) { }
+	NodeComponent(g2d::Component* c, bool ar) : ComponentPtr(c), EventMask(c->GetEventMask()), AutoRelease(ar) { }
 	g2d::Component* ComponentPtr = nullptr;
+	uint32_t EventMask = g2d::EventMask::All;	// cached, so that skipping costs no virtual call.
 	bool AutoRelease = false;
 };
 
+struct ExecuteOrderLess
+{
+	bool operator()(const NodeComponent& a, const NodeComponent& b) const
+	{
+		return a.ComponentPtr->GetExecuteOrder() < b.ComponentPtr->GetExecuteOrder();
+	}
+};
+
 class ComponentContainer
 {
 public:
 	~ComponentContainer();
 
-	void Collect();
-
 	bool Add(g2d::SceneNode* parent, g2d::Component* component, bool autoRelease);
 
-	bool Remove(g2d::Component* component, bool forceNotReleased);
+	// the component is released by the caller if autoRelease is set,
+	// after it's unregistered.
+	bool Remove(g2d::Component* component, bool& autoRelease);
 
 	bool IsAutoRelease(g2d::Component* component) const;
 
 	g2d::Component* At(uint32_t index) const;
 
-	uint32_t GetCount() const { return static_cast<uint32_t>(m_components.size()); }
+	// first component of the class, in execution order.
+	g2d::Component* Find(uint32_t classID) const;
+
+	// events handled by any of the components.
+	uint32_t GetEventMask() const { return m_eventMask; }
+
+	uint32_t GetCount() const { return m_components.GetCount(); }
 
 	template<typename FUNC> void Traversal(FUNC f)
 	{
-		for (auto& c : m_components) f(c.ComponentPtr);
+		m_components.Traversal([&](NodeComponent& c) { f(c.ComponentPtr); });
 	}
 
 public:
-	void OnRotate(gml::radian r);
-
-	void OnScale(const gml::vec2& s);
-
-	void OnMove(const gml::vec2& p);
+	void OnTransformChanged(uint32_t changes);
 
 	void OnMessage(const g2d::Message& message);
 
@@ -108,169 +130,283 @@ public:
 	void OnKeyPressingEnd(g2d::KeyCode key);
 
 private:
-	void Recollect();
+	void UpdateEventMask();
+
+	// invoke func for components handling any of the events. Adding
+	// and removing components by func are recorded by the command buffer
+	// of the scene, so that the list never changes here.
+	template<typename FUNC> void Dispatch(uint32_t events, FUNC func)
+	{
+		if ((m_eventMask & events) == 0)
+			return;
+
+		m_components.Traversal([&](const NodeComponent& c)
+		{
+			if ((c.EventMask & events) != 0) func(c.ComponentPtr);
+		});
+	}
+
+	// most nodes have one or two components.
+	OrderedList<NodeComponent, ExecuteOrderLess, 2> m_components;
+	uint32_t m_eventMask = 0;
+};
+
+// sibling pointers and child index of ::SceneNode, defined after it.
+struct SiblingAccess
+{
+	::SceneNode* Prev(::SceneNode* node) const;
+
+	::SceneNode* Next(::SceneNode* node) const;
+
+	void SetPrev(::SceneNode* node, ::SceneNode* prev) const;
 
-	void DelayRemove();
+	void SetNext(::SceneNode* node, ::SceneNode* next) const;
 
-	std::vector<NodeComponent> m_components;
-	std::vector<NodeComponent> m_released;
-	std::vector<NodeComponent> m_collection;
-	bool m_collectionChanged = true;
+	uint32_t GetIndex(const ::SceneNode* node) const;
+
+	void SetIndex(::SceneNode* node, uint32_t index) const;
 };
 
+// Children of a node or of the scene, kept in a SiblingList.
 class SceneNodeContainer
 {
 public:
 	~SceneNodeContainer();
 
-	void Collect();
-
 	void ClearChildren();
 
 	::SceneNode* CreateChild(::Scene& scene, ::SceneNode& parent);
 
 	::SceneNode* CreateChild(::Scene& scene, SceneNodeContainer& parent);
 
+	// append a node created during parallel updating.
+	void Attach(::SceneNode& child);
+
 	::SceneNode* At(uint32_t index) const;
 
-	::SceneNode* First() const;
+	uint32_t IndexOf(const ::SceneNode& child) const;
 
-	::SceneNode* Last() const;
+	::SceneNode* First() const { return m_list.First(); }
 
-	uint32_t GetCount() const { return static_cast<uint32_t>(m_children.size()); }
+	::SceneNode* Last() const { return m_list.Last(); }
 
-	void Remove(::SceneNode& child);
+	uint32_t GetCount() const { return m_list.GetCount(); }
 
-	bool Move(uint32_t from, uint32_t to);
+	// false if it's not a child, or removed already.
+	bool Remove(::SceneNode& child);
 
-	template<typename FUNC> void Traversal(FUNC func)
-	{
-		for (auto& child : m_children) func(child);
-	}
+	// place the child before another one, or at the end if it's
+	// nullptr, false if it's not moved.
+	bool Move(::SceneNode& child, ::SceneNode* before);
 
-	template<typename FUNC> void InverseTraversal(FUNC func)
-	{
-		auto it = m_children.rbegin();
-		auto end = m_children.rend();
-		for (; it != end; it++) func(*it);
-	}
+	// func must not add or remove children.
+	template<typename FUNC> void Traversal(FUNC func);
 
-public:
-	void OnMessage(const g2d::Message& message);
+	template<typename FUNC> void InverseTraversal(FUNC func);
 
-	void OnUpdate(uint32_t deltaTime);
+	// func is invoked for children concurrently, children
+	// can not be changed until it returns.
+	template<typename FUNC> void ParallelTraversal(JobSystem& jobs, uint32_t grainSize, FUNC func)
+	{
+		m_list.UpdateIndices();
+		jobs.ParallelFor(0, GetCount(), grainSize, [&](uint32_t begin, uint32_t end)
+		{
+			for (uint32_t i = begin; i < end; i++) func(m_list.At(i));
+		});
+	}
 
-	void OnKeyPress(g2d::KeyCode key);
+private:
+	SiblingList<::SceneNode, SiblingAccess> m_list;
+};
 
-	void OnKeyPressingBegin(g2d::KeyCode key);
+// Nodes subscribing an event, in no particular order. Nodes are added
+// and removed in constant time by their pool index.
+class NodeSubscribers
+{
+public:
+	void Add(::SceneNode& node, uint32_t nodeIndex);
 
-	void OnKeyPressing(g2d::KeyCode key);
+	void Remove(uint32_t nodeIndex);
 
-	void OnKeyPressingEnd(g2d::KeyCode key);
+	const std::vector<::SceneNode*>& GetNodes() const { return m_nodes; }
 
 private:
-	void Recollect();
-
-	void DelayRemove();
+	static const uint32_t INVALID_POSITION = 0xFFFFFFFF;
 
-	std::vector<::SceneNode*> m_children;
-	std::vector<::SceneNode*> m_released;
-	std::vector<::SceneNode*> m_collection;
-	bool m_collectionChanged = true;
+	std::vector<::SceneNode*> m_nodes;
+	std::vector<uint32_t> m_nodeIndices;	// pool index of m_nodes.
+	std::vector<uint32_t> m_positions;	// position in m_nodes, by pool index.
 };
 
-class LocalTransform
+// Structural changes made while the scene is updating or dispatching
+// events. They are recorded, so that lists being dispatched never change,
+// and applied in one batch afterwards, rendering orders and the spatial
+// graph are fixed once for the batch. Each worker updating subtrees in
+// parallel records into its own buffer, buffers are applied one by one.
+class SceneCommandBuffer
 {
 public:
-	LocalTransform();
+	explicit SceneCommandBuffer(bool concurrent) : m_concurrent(concurrent) { }
 
-	void SetPosition(const gml::vec2& position);
+	enum class Type : int
+	{
+		CreateChild,
+		Release,
+		Delete,
+		AddComponent,
+		RemoveComponent,
+		RemoveComponentWithoutRelease,
+		AdjustSpatial,
+		MoveToFront,
+		MoveToBack,
+		MovePrev,
+		MoveNext,
+		SortCameras,
+	};
+
+	struct Command
+	{
+		Type type;
+		::SceneNode* node;
+		g2d::Component* component;
+		bool autoRelease;
+	};
 
-	void SetPivot(const gml::vec2& pivot);
+	// buffer of the calling thread, nullptr unless the scene is
+	// dispatching, changes are applied at once then.
+	static SceneCommandBuffer* GetCurrent();
 
-	void SetScale(const gml::vec2& scale);
+	static void SetCurrent(SceneCommandBuffer* buffer);
 
-	void SetRotation(gml::radian r);
+	// the calling thread is updating a subtree in parallel.
+	static bool IsConcurrent();
 
-	const gml::mat32& GetMatrix();
+	// the node is not added to its parent until applied.
+	::SceneNode* CreateChild(::Scene& scene, ::SceneNode* parent, SceneNodeContainer& parentContainer);
 
-	const gml::vec2& GetPosition() const { return m_position; }
+	// the node is created by this buffer, and not applied yet.
+	bool IsStaging(const ::SceneNode& node) const;
 
-	const gml::vec2& GetPivot() const { return m_pivot; }
+	// world matrix of a node created by this buffer, its staging one
+	// composed with the world matrix of its nearest applied ancestor.
+	const TransformMatrix& GetWorldMatrix(::SceneNode& node);
 
-	const gml::vec2& GetScale() const { return m_scale; }
+	void Record(Type type, ::SceneNode* node, g2d::Component* component = nullptr, bool autoRelease = false)
+	{
+		m_commands.push_back({ type, node, component, autoRelease });
+	}
 
-	gml::radian GetRotation() const { return m_rotation; }
+	const std::vector<Command>& GetCommands() const { return m_commands; }
+
+	void Clear();
 
 private:
-	void SetMatrixDirty();
-
-	gml::vec2 m_position = gml::vec2::zero();
-	gml::vec2 m_pivot = gml::vec2::zero();
-	gml::vec2 m_scale = gml::vec2::one();
-	gml::radian m_rotation = gml::radian(0.0f);
-	gml::mat32 m_matrix = gml::mat32::identity();
-	bool m_matrixDirty = true;
+	std::vector<Command> m_commands;
+	bool m_concurrent;
+
+	// transforms of created nodes, moved to the scene when applied.
+	TransformStore m_transforms;
+
+	// composed world matrices by staging handle, a deque so that
+	// returned references stay valid while more nodes are created.
+	std::deque<TransformMatrix> m_worldMatrices;
 };
 
-class WorldTransform
+class SceneNode : public g2d::SceneNode
 {
+	RTTI_IMPL;
 public:
-	WorldTransform(::SceneNode& node, LocalTransform& local);
+	SceneNode(::Scene& scene, ::SceneNode* parent, uint32_t childID);
 
-	const gml::vec2& GetPosition();
+	SceneNode(::Scene& scene, SceneNodeContainer& parentContainer, uint32_t childID);
 
-	const gml::vec2& GetUp();
+	SceneNode(::Scene& scene, ::SceneNode* parent, SceneNodeContainer& parentContainer, TransformStore& transforms, TransformStore::Handle parentTransform, uint32_t childID);
 
-	const gml::vec2& GetRight();
+	~SceneNode();
 
-	const gml::mat32& GetMatrix();
+	TransformStore& GetTransforms() const { return *m_transforms; }
 
-	void SetMatrixDirty();
+	TransformStore::Handle GetTransformHandle() const { return m_transform; }
 
-	void SetRightDirty() { m_rightDirty = true; }
+	// created while the scene is dispatching, and not applied yet.
+	bool IsPending() const;
 
-	void SetUpDirty() { m_upDirty = true; }
+	// add the pending node to its parent, and move its transform to the scene.
+	void Attach();
 
-	void SetPositionDirty() { m_positionDirty = true; }
+	// delete the node, or defer it while the scene is dispatching.
+	void Destroy();
 
-private:
-	::SceneNode& m_sceneNode;
-	LocalTransform& m_localTransform;
-	gml::vec2 m_position = gml::vec2::zero();
-	gml::vec2 m_right = gml::vec2::right();
-	gml::vec2 m_up = gml::vec2::up();
-	gml::mat32 m_matrix = gml::mat32::identity();
-	bool m_matrixDirty = true;
-	bool m_positionDirty = true;
-	bool m_rightDirty = true;
-	bool m_upDirty = true;
-};
-class SceneNode : public g2d::SceneNode
-{
-	RTTI_IMPL;
-public:
-	SceneNode(::Scene& scene, ::SceneNode* parent, uint32_t childID);
+	// updating, key events and messages are dispatched to subscribers of the scene,
+	// it must be called after components are added or removed.
+	void UpdateSubscriptions();
 
-	SceneNode(::Scene& scene, SceneNodeContainer& parentContainer, uint32_t childID);
+	// unsubscribe the released subtree, it no longer receives events.
+	void StopEvents();
 
-	~SceneNode();
+	bool ReceivesEvents() const { return m_receivesEvents; }
+
+	void AdjustSpatial();
+
+	// for creating many nodes at once, e.g. loading snapshots, the caller
+	// orders them and adds their components to the spatial graph.
+	::SceneNode* CreateChildUnordered() { return m_children.CreateChild(m_scene, *this); }
+
+	bool AddComponentWithoutSpatial(g2d::Component* component, bool autoRelease);
 
-	uint32_t GetRenderingOrder() const { return m_renderingOrder; }
+	// the subtree is moved or created by applied commands, it's
+	// ordered after all commands of the batch are applied.
+	bool IsRenderingOrderDirty() const { return m_renderingOrderDirty; }
+
+	void SetRenderingOrderDirty(bool dirty) { m_renderingOrderDirty = dirty; }
+
+	// mark the node and its descendants.
+	void MarkRenderingOrderDirty();
+
+	// adjusting is recorded, it's done once for the batch.
+	bool IsSpatialDirty() const { return m_spatialDirty; }
+
+	void SetSpatialDirty(bool dirty) { m_spatialDirty = dirty; }
+
+	uint64_t GetRenderingOrder() const { return m_renderingOrder; }
+
+	// components of the node take the order too.
+	void SetRenderingOrder(uint64_t order);
+
+	// nodes are rendered after their parents and previous siblings,
+	// and before their children. Neighbours of the node in order,
+	// nullptr at the ends.
+	::SceneNode* GetPrevInRenderingOrder() const;
+
+	::SceneNode* GetNextInRenderingOrder() const;
+
+	::SceneNode* GetNextAfterSubtree() const;
+
+	// the node and its descendants, in rendering order.
+	void CollectSubtree(std::vector<::SceneNode*>& nodes);
 
 	::SceneNode* GetParent() const { return m_parent; }
 
-	void AdjustRenderingOrder();
+	::SceneNode* GetTopLevel();
 
 	void OnUpdate(uint32_t deltaTime);
 
+	// the world matrix is recomputed, by its own changes or ancestors',
+	// notified once even if it's recomputed again in the same frame.
+	void OnWorldChanged();
+
 	void SetChildIndex(uint32_t index) { m_childIndex = index; }
 
-	void SetRenderingOrder(uint32_t& order);
+	uint32_t GetCachedChildIndex() const { return m_childIndex; }
+
+	// siblings are linked by the parent container.
+	::SceneNode* GetPrevSibling() const { return m_prevSibling; }
+
+	::SceneNode* GetNextSibling() const { return m_nextSibling; }
 
-	// provided to Move function for 
-	// temporary setting rendering order
-	void SetRenderingOrderOnly(uint32_t order);
+	void SetPrevSibling(::SceneNode* sibling) { m_prevSibling = sibling; }
+
+	void SetNextSibling(::SceneNode* sibling) { m_nextSibling = sibling; }
 
 	bool ParentIsScene() const { return m_parent == nullptr; }
 
@@ -309,6 +445,8 @@ public:	//g2d::SceneNode
 
 	virtual g2d::Scene* GetScene() const override;
 
+	virtual g2d::SceneNodeHandle GetHandle() const override;
+
 	virtual g2d::SceneNode* GetParentNode() const override { return m_parent; }
 
 	virtual g2d::SceneNode* GetPrevSiblingNode() const override { return GetPrevSibling(); }
@@ -345,7 +483,7 @@ public:	//g2d::SceneNode
 
 	virtual uint32_t GetComponentCount() const override { return m_components.GetCount(); }
 
-	virtual const gml::mat32& GetLocalMatrix() override { return m_localTransform.GetMatrix(); }
+	virtual const gml::mat32& GetLocalMatrix() override;
 
 	virtual const gml::mat32& GetWorldMatrix() override;
 
@@ -363,19 +501,21 @@ public:	//g2d::SceneNode
 
 	virtual g2d::SceneNode* SetRotation(gml::radian r) override;
 
+	virtual g2d::SceneNode* SetTransform(const gml::vec2& position, gml::radian r, const gml::vec2& scale, const gml::vec2& pivot) override;
+
 	virtual void SetVisible(bool visible) override { m_isVisible = visible; }
 
 	virtual void SetStatic(bool s) override;
 
 	virtual void SetVisibleMask(uint32_t mask, bool recursive) override;
 
-	virtual const gml::vec2& GetPosition()  const override { return m_localTransform.GetPosition(); }
+	virtual const gml::vec2& GetPosition()  const override;
 
-	virtual const gml::vec2& GetPivot() const override { return m_localTransform.GetPivot(); }
+	virtual const gml::vec2& GetPivot() const override;
 
-	virtual const gml::vec2& GetScale() const override { return m_localTransform.GetScale(); }
+	virtual const gml::vec2& GetScale() const override;
 
-	virtual gml::radian GetRotation() const override { return m_localTransform.GetRotation(); }
+	virtual gml::radian GetRotation() const override;
 
 	virtual gml::vec2 GetWorldPosition() override;
 
@@ -383,7 +523,7 @@ public:	//g2d::SceneNode
 
 	virtual const gml::vec2& GetUp() override;
 
-	virtual uint32_t GetChildIndex() const override { return m_childIndex; }
+	virtual uint32_t GetChildIndex() const override { return m_parentContainer.IndexOf(*this); }
 
 	virtual bool IsVisible() const override { return m_isVisible; }
 
@@ -398,41 +538,97 @@ public:	//g2d::SceneNode
 	virtual gml::vec2 WorldToParent(const gml::vec2& pos) override;
 
 private:
-	::SceneNode* GetPrevSibling() const;
-
-	::SceneNode* GetNextSibling() const;
+	// keep the component registry of the scene up to date,
+	// after the component is added to or removed from the node.
+	void RegisterComponent(g2d::Component& component);
 
-	void SetWorldMatrixDirty();
+	void UnregisterComponent(g2d::Component& component);
 
-	void AdjustSpatial();
+	// record the change if the scene is dispatching.
+	bool Defer(SceneCommandBuffer::Type type, g2d::Component* component = nullptr, bool autoRelease = false);
 
 private:
 	::Scene& m_scene;
 	::SceneNode* m_parent = nullptr;
 	SceneNodeContainer& m_parentContainer;
+	::SceneNode* m_prevSibling = nullptr;
+	::SceneNode* m_nextSibling = nullptr;
 	SceneNodeContainer m_children;
 	ComponentContainer m_components;
-	LocalTransform m_localTransform;
-	WorldTransform m_worldTransform;
+	TransformStore* m_transforms;	// staging store of a command buffer while pending.
+	TransformStore::Handle m_transform;
+	uint32_t m_worldVersion = 0;	// world version of last update, new node starts from 0.
+	uint32_t m_transformChanges = 0;	// g2d::TransformChange bits not notified yet.
+	gml::vec2 m_right = gml::vec2::right();
+	gml::vec2 m_up = gml::vec2::up();
 	bool m_isVisible = true;
 	bool m_isStatic = false;
-	bool m_matrixDirtyUpdate = true;
 	bool m_isRemoved = false;
-	uint32_t m_childIndex = 0;
-	uint32_t m_renderingOrder = 0xFFFFFFFF;	// make sure the order maxinum(error) at the beginning
+	bool m_receivesEvents = true;
+	bool m_renderingOrderDirty = false;
+	bool m_spatialDirty = false;
+	uint32_t m_subscribedEvents = 0;	// g2d::EventMask bits subscribed in the scene.
+	uint32_t m_childIndex = 0;	// valid after indices of the parent container are updated.
+	uint32_t m_componentSequence = 0;	// components added, ranks equal execute orders by it.
 	uint32_t m_visibleMask = g2d::DEF_VISIBLE_MASK;
+	uint64_t m_renderingOrder = 0;	// given once it's in the tree.
 
 };
 
+inline ::SceneNode* SiblingAccess::Prev(::SceneNode* node) const { return node->GetPrevSibling(); }
+
+inline ::SceneNode* SiblingAccess::Next(::SceneNode* node) const { return node->GetNextSibling(); }
+
+inline void SiblingAccess::SetPrev(::SceneNode* node, ::SceneNode* prev) const { node->SetPrevSibling(prev); }
+
+inline void SiblingAccess::SetNext(::SceneNode* node, ::SceneNode* next) const { node->SetNextSibling(next); }
+
+inline uint32_t SiblingAccess::GetIndex(const ::SceneNode* node) const { return node->GetCachedChildIndex(); }
+
+inline void SiblingAccess::SetIndex(::SceneNode* node, uint32_t index) const { node->SetChildIndex(index); }
+
+template<typename FUNC> void SceneNodeContainer::Traversal(FUNC func)
+{
+	for (::SceneNode* child = First(); child != nullptr;)
+	{
+		::SceneNode* next = child->GetNextSibling();
+		func(child);
+		child = next;
+	}
+}
+
+template<typename FUNC> void SceneNodeContainer::InverseTraversal(FUNC func)
+{
+	for (::SceneNode* child = Last(); child != nullptr; child = child->GetPrevSibling()) func(child);
+}
+
+struct RenderingOrderAccess
+{
+	uint64_t GetKey(::SceneNode* node) const { return node->GetRenderingOrder(); }
+
+	void SetKey(::SceneNode* node, uint64_t key) const { node->SetRenderingOrder(key); }
+
+	::SceneNode* Prev(::SceneNode* node) const { return node->GetPrevInRenderingOrder(); }
+
+	::SceneNode* Next(::SceneNode* node) const { return node->GetNextInRenderingOrder(); }
+
+	bool IsDirty(::SceneNode* node) const { return node->IsRenderingOrderDirty(); }
+};
+
 class Scene : public g2d::Scene
 {
 	RTTI_IMPL;
 public:
 	Scene(float boundSize);
 
-	void SetRenderingOrderDirty(::SceneNode* parent);
+	// the node is created or moved, order its subtree between its
+	// neighbours, without renumbering following nodes. It's deferred
+	// to the end of the batch while commands are applied.
+	void UpdateRenderingOrder(::SceneNode& node);
 
-	void SetCameraOrderDirty() { m_cameraOrderDirty = true; }
+	// cameras are shared by all subtrees, it's recorded while
+	// updating in parallel.
+	void SetCameraOrderDirty();
 
 	void Update(uint32_t elapsedTime, uint32_t deltaTime);
 
@@ -442,7 +638,33 @@ public:
 
 	SpatialGraph& GetSpatialGraph() { return m_spatial; }
 
-	void AdjustRenderingOrder();
+	TransformStore& GetTransforms() { return m_transforms; }
+
+	ComponentRegistry& GetComponentRegistry() { return m_componentRegistry; }
+
+	// node handles events changed from previousEvents to events.
+	void UpdateSubscription(::SceneNode& node, uint32_t previousEvents, uint32_t events);
+
+	// node owning the transform of the scene, nullptr when it's destroyed.
+	void SetTransformNode(TransformStore::Handle handle, ::SceneNode* node);
+
+	// nodes are allocated from the pool of the scene, jobs of
+	// parallel updating may create them concurrently.
+	template<typename... ARGS> ::SceneNode* CreateSceneNode(ARGS&&... args)
+	{
+		if (!SceneCommandBuffer::IsConcurrent())
+			return m_nodes.Create(*this, std::forward<ARGS>(args)...);
+
+		std::lock_guard<std::mutex> lock(m_nodesMutex);
+		return m_nodes.Create(*this, std::forward<ARGS>(args)...);
+	}
+
+	// nodes are never deleted during parallel updating.
+	void DeleteSceneNode(::SceneNode& node) { m_nodes.Destroy(&node); }
+
+	// callbacks on the stack may still use the released node,
+	// it's deleted at the end of updating.
+	void DelayDelete(::SceneNode& node) { m_releasedNodes.push_back(&node); }
 
 	void OnRemoveSceneNode(::SceneNode& node);
 
@@ -460,6 +682,14 @@ public: //g2d::Scene
 
 	virtual g2d::SceneNode* CreateChild() override;
 
+	virtual g2d::SceneNode* GetNodeByHandle(const g2d::SceneNodeHandle& handle) const override;
+
+	virtual uint32_t GetComponentCount(uint32_t classID) const override { return m_componentRegistry.GetCount(classID); }
+
+	virtual g2d::Component* const* GetComponents(uint32_t classID) const override { return m_componentRegistry.GetComponents(classID); }
+
+	virtual g2d::Component* FindComponent(g2d::SceneNode* node, uint32_t classID) const override;
+
 	virtual g2d::Camera* CreateCameraNode() override;
 
 	virtual g2d::Camera* GetMainCamera() const override { return GetCameraByIndex(0); }
@@ -468,12 +698,39 @@ public: //g2d::Scene
 
 	virtual uint32_t GetCameraCount() const override;
 
+	virtual void SetParallelUpdate(bool enabled) override { m_parallelUpdate = enabled; }
+
+	virtual bool IsParallelUpdate() const override { return m_parallelUpdate; }
+
+	virtual bool SaveSnapshot(const char* path) override;
+
+	virtual bool LoadSnapshot(const char* path) override;
+
 	virtual void Render() override;
 
 private:
 	void ResortCameraOrder();
 
-	void ResetRenderingOrder();
+	void UpdateParallel(uint32_t deltaTime, JobSystem& jobs);
+
+	void NotifyMovedNodes();
+
+	// changes made by func are recorded, and applied at once
+	// after it returns, nested ones are applied by the outer.
+	template<typename FUNC> void Batch(FUNC func);
+
+	// commands of all buffers, then fix what they changed.
+	void ApplyCommands();
+
+	void ApplyCommands(SceneCommandBuffer& buffer);
+
+	void UpdateDirtyRenderingOrder();
+
+	void AdjustDirtySpatial();
+
+	void DeleteReleasedNodes();
+
+	template<typename FUNC> void DispatchToSubscribers(const NodeSubscribers& subscribers, FUNC func);
 
 	::SceneNode* FindInteractiveObject(const gml::coord& cursorPos);
 
@@ -530,6 +787,18 @@ private:
 		void OnRemoveSceneNode(::SceneNode& node);
 	} m_mouseButtonState[3];
 
+	// outlive nodes, which release their transforms
+	// and unregister their components on destruction.
+	TransformStore m_transforms;
+	std::vector<::SceneNode*> m_transformNodes;
+	std::vector<TransformStore::Handle> m_movedTransforms;
+	ComponentRegistry m_componentRegistry;
+	NodeSubscribers m_updateSubscribers;
+	NodeSubscribers m_keySubscribers;
+	NodeSubscribers m_messageSubscribers;
+	std::vector<::SceneNode*> m_releasedNodes;
+	ObjectPool<::SceneNode> m_nodes;
+	mutable std::mutex m_nodesMutex;
 	SceneNodeContainer m_children;
 
 	SpatialGraph m_spatial;
@@ -540,6 +809,22 @@ private:
 	::SceneNode* m_hoverNode = nullptr;
 	bool m_canTickHovering = false;
 
-	::SceneNode* m_renderingOrderDirtyNode = nullptr;
-	uint32_t m_renderingOrderEnd = 1;
+	OrderLabels<::SceneNode, RenderingOrderAccess> m_renderingOrder;
+	std::vector<::SceneNode*> m_orderingNodes;
+
+	// commands of the batch, and nodes they changed, by handle,
+	// since recorded deletes may come first.
+	SceneCommandBuffer m_commandBuffer;
+	std::vector<g2d::SceneNodeHandle> m_orderDirtyNodes;
+	std::vector<g2d::SceneNodeHandle> m_spatialDirtyNodes;
+	bool m_applyingCommands = false;
+
+	// one for each worker of the job system.
+	std::vector<std::unique_ptr<SceneCommandBuffer>> m_commandBuffers;
+
+	// update subscribers sorted by pool index of their top-level node,
+	// and where each top-level subtree starts.
+	std::vector<std::pair<uint32_t, ::SceneNode*>> m_updateGroups;
+	std::vector<uint32_t> m_updateGroupStarts;
+	bool m_parallelUpdate = false;
 };
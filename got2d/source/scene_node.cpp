@@ -1,22 +1,52 @@
 #include "scene.h"
 
+// transforms are stored without gml, but laid out the same.
+static_assert(sizeof(gml::vec2) == sizeof(TransformVector), "layout of gml::vec2 changed.");
+static_assert(sizeof(gml::mat32) == sizeof(TransformMatrix), "layout of gml::mat32 changed.");
+
+inline const gml::vec2& ToVec2(const TransformVector& v)
+{
+	return reinterpret_cast<const gml::vec2&>(v);
+}
+
+inline const TransformVector& ToTransformVector(const gml::vec2& v)
+{
+	return reinterpret_cast<const TransformVector&>(v);
+}
+
+inline const gml::mat32& ToMat32(const TransformMatrix& m)
+{
+	return reinterpret_cast<const gml::mat32&>(m);
+}
+
+inline bool IsSameVector(const TransformVector& a, const gml::vec2& b)
+{
+	return a.x == b.x && a.y == b.y;
+}
+
 SceneNode::SceneNode(::Scene& scene, ::SceneNode* parent, uint32_t childID)
-	: m_scene(scene)
-	, m_parent(parent)
-	, m_parentContainer(parent->m_children)
-	, m_worldTransform(*this, m_localTransform)
-	, m_childIndex(childID)
+	: SceneNode(scene, parent, parent->m_children, scene.GetTransforms(), parent->m_transform, childID)
 {
 
 }
 
 SceneNode::SceneNode(::Scene& scene, SceneNodeContainer& parentContainer, uint32_t childID)
+	: SceneNode(scene, nullptr, parentContainer, scene.GetTransforms(), TransformStore::INVALID_HANDLE, childID)
+{
+}
+
+SceneNode::SceneNode(::Scene& scene, ::SceneNode* parent, SceneNodeContainer& parentContainer, TransformStore& transforms, TransformStore::Handle parentTransform, uint32_t childID)
 	: m_scene(scene)
-	, m_parent(nullptr)
+	, m_parent(parent)
 	, m_parentContainer(parentContainer)
-	, m_worldTransform(*this, m_localTransform)
+	, m_transforms(&transforms)
+	, m_transform(transforms.Create(parentTransform))
 	, m_childIndex(childID)
 {
+	if (!IsPending())
+	{
+		m_scene.SetTransformNode(m_transform, this);
+	}
 }
 
 SceneNode::~SceneNode()
@@ -24,34 +54,162 @@ SceneNode::~SceneNode()
 	m_components.Traversal([&](g2d::Component* component)
 	{
 		m_scene.GetSpatialGraph().Remove(*component);
+		m_scene.GetComponentRegistry().Remove(*component);
+		// the pool index is reused by nodes created later.
+		m_scene.GetComponentRegistry().SetFirst(component->GetClassID(), GetHandle().index, nullptr);
 	});
+	m_scene.UpdateSubscription(*this, m_subscribedEvents, 0);
+	if (!IsPending())
+	{
+		m_scene.SetTransformNode(m_transform, nullptr);
+	}
+	m_transforms->Destroy(m_transform);
+}
+
+bool SceneNode::IsPending() const
+{
+	return m_transforms != &m_scene.GetTransforms();
+}
+
+void SceneNode::Attach()
+{
+	TransformStore& staging = *m_transforms;
+	TransformStore& transforms = m_scene.GetTransforms();
+	TransformStore::Handle handle = transforms.Create(ParentIsScene() ? TransformStore::INVALID_HANDLE : m_parent->m_transform);
+	transforms.SetTransform(handle, staging.GetPosition(m_transform), staging.GetRotation(m_transform),
+		staging.GetScale(m_transform), staging.GetPivot(m_transform));
+	m_transforms = &transforms;
+	m_transform = handle;
+	m_scene.SetTransformNode(handle, this);
+	m_parentContainer.Attach(*this);
+}
+
+void SceneNode::Destroy()
+{
+	// destructor accesses the spatial graph and transforms shared by
+	// all subtrees, so that it waits until updating finished.
+	if (!Defer(SceneCommandBuffer::Type::Delete))
+	{
+		m_scene.DeleteSceneNode(*this);
+	}
+}
+
+void SceneNode::RegisterComponent(g2d::Component& component)
+{
+	auto& registry = m_scene.GetComponentRegistry();
+	uint32_t classID = component.GetClassID();
+	registry.Add(component);
+	registry.SetFirst(classID, GetHandle().index, m_components.Find(classID));
+}
+
+void SceneNode::UnregisterComponent(g2d::Component& component)
+{
+	auto& registry = m_scene.GetComponentRegistry();
+	uint32_t classID = component.GetClassID();
+	registry.Remove(component);
+	registry.SetFirst(classID, GetHandle().index, m_components.Find(classID));
+}
+
+void SceneNode::UpdateSubscriptions()
+{
+	const uint32_t sceneEvents = g2d::EventMask::Update | g2d::EventMask::Key | g2d::EventMask::Message;
+	uint32_t events = m_receivesEvents ? (m_components.GetEventMask() & sceneEvents) : 0;
+	if (events != m_subscribedEvents)
+	{
+		m_scene.UpdateSubscription(*this, m_subscribedEvents, events);
+		m_subscribedEvents = events;
+	}
+}
+
+void SceneNode::StopEvents()
+{
+	m_receivesEvents = false;
+	UpdateSubscriptions();
+	m_children.Traversal([](::SceneNode* child)
+	{
+		child->StopEvents();
+	});
+}
+
+bool SceneNode::Defer(SceneCommandBuffer::Type type, g2d::Component* component, bool autoRelease)
+{
+	auto buffer = SceneCommandBuffer::GetCurrent();
+	if (buffer == nullptr)
+		return false;
+
+	buffer->Record(type, this, component, autoRelease);
+	return true;
+}
+
+const gml::mat32& SceneNode::GetLocalMatrix()
+{
+	return ToMat32(GetTransforms().GetLocalMatrix(m_transform));
 }
 
 const gml::mat32& SceneNode::GetWorldMatrix()
 {
-	return m_worldTransform.GetMatrix();
+	if (IsPending())
+	{
+		// staging stores do not know parents in the scene.
+		auto buffer = SceneCommandBuffer::GetCurrent();
+		ENSURE(buffer != nullptr && buffer->IsStaging(*this));
+		return ToMat32(buffer->GetWorldMatrix(*this));
+	}
+	return ToMat32(GetTransforms().GetWorldMatrix(m_transform));
 }
 
+const gml::vec2& SceneNode::GetPosition() const
+{
+	return ToVec2(GetTransforms().GetPosition(m_transform));
+}
+
+const gml::vec2& SceneNode::GetPivot() const
+{
+	return ToVec2(GetTransforms().GetPivot(m_transform));
+}
+
+const gml::vec2& SceneNode::GetScale() const
+{
+	return ToVec2(GetTransforms().GetScale(m_transform));
+}
+
+gml::radian SceneNode::GetRotation() const
+{
+	return gml::radian(GetTransforms().GetRotation(m_transform));
+}
+
+// setters only record what changed, components are notified in
+// OnWorldChanged once, no matter how many times the node is changed.
 g2d::SceneNode* SceneNode::SetPivot(const gml::vec2& pivot)
 {
-	m_localTransform.SetPivot(pivot);
-	SetWorldMatrixDirty();
+	auto& transforms = GetTransforms();
+	if (!IsSameVector(transforms.GetPivot(m_transform), pivot))
+	{
+		transforms.SetPivot(m_transform, ToTransformVector(pivot));
+		m_transformChanges |= g2d::TransformChange::Pivot;
+	}
 	return this;
 }
 
 g2d::SceneNode* SceneNode::SetScale(const gml::vec2& scale)
 {
-	m_components.OnScale(scale);
-	m_localTransform.SetScale(scale);
-	SetWorldMatrixDirty();
+	auto& transforms = GetTransforms();
+	if (!IsSameVector(transforms.GetScale(m_transform), scale))
+	{
+		transforms.SetScale(m_transform, ToTransformVector(scale));
+		m_transformChanges |= g2d::TransformChange::Scale;
+	}
 	return this;
 }
 
 g2d::SceneNode* SceneNode::SetPosition(const gml::vec2& position)
 {
-	m_components.OnMove(position);
-	m_localTransform.SetPosition(position);
-	SetWorldMatrixDirty();
+	auto& transforms = GetTransforms();
+	if (!IsSameVector(transforms.GetPosition(m_transform), position))
+	{
+		transforms.SetPosition(m_transform, ToTransformVector(position));
+		m_transformChanges |= g2d::TransformChange::Position;
+	}
 	return this;
 }
 
@@ -64,19 +222,19 @@ g2d::SceneNode * SceneNode::SetWorldPosition(const gml::vec2 & position)
 
 g2d::SceneNode * SceneNode::SetRight(const gml::vec2 & right)
 {
-	auto& oldRight = m_worldTransform.GetRight();
+	auto oldRight = GetRight();
 	auto cos = dot(right, oldRight);
 	bool ccw = cross(right, oldRight) < 0;
 	if (gml::fequal(cos, -1.0f))
 	{
-		gml::radian r = m_localTransform.GetRotation() + gml::radian(gml::PI);
+		gml::radian r = GetRotation() + gml::radian(gml::PI);
 		SetRotation(gml::limited_rotation(r));
 	}
 	else if (!gml::fequal(cos, 1.0f))
 	{
 		float acosr = acos(cos);
 		gml::radian rdiff = gml::radian(ccw ? acosr : -acosr);
-		gml::radian r = m_localTransform.GetRotation() + rdiff;
+		gml::radian r = GetRotation() + rdiff;
 		SetRotation(gml::limited_rotation(r));
 	}
 	return this;
@@ -84,19 +242,19 @@ g2d::SceneNode * SceneNode::SetRight(const gml::vec2 & right)
 
 g2d::SceneNode * SceneNode::SetUp(const gml::vec2 & up)
 {
-	auto& oldUp = m_worldTransform.GetUp();
+	auto oldUp = GetUp();
 	auto cos = dot(up, oldUp);
 	bool ccw = cross(up, oldUp) < 0;
 	if (gml::fequal(cos, -1.0f))
 	{
-		gml::radian r = m_localTransform.GetRotation() + gml::radian(gml::PI);
+		gml::radian r = GetRotation() + gml::radian(gml::PI);
 		SetRotation(gml::limited_rotation(r));
 	}
 	else if (!gml::fequal(cos, 1.0f))
 	{
 		float acosr = acos(cos);
 		gml::radian rdiff = gml::radian(ccw ? acosr : -acosr);
-		gml::radian r = m_localTransform.GetRotation() + rdiff;
+		gml::radian r = GetRotation() + rdiff;
 		SetRotation(gml::limited_rotation(r));
 	}
 	return this;
@@ -104,102 +262,166 @@ g2d::SceneNode * SceneNode::SetUp(const gml::vec2 & up)
 
 g2d::SceneNode* SceneNode::SetRotation(gml::radian r)
 {
-	m_components.OnRotate(r);
-	m_localTransform.SetRotation(r);
-	SetWorldMatrixDirty();
+	auto& transforms = GetTransforms();
+	if (transforms.GetRotation(m_transform) != r.value)
+	{
+		transforms.SetRotation(m_transform, r.value);
+		m_transformChanges |= g2d::TransformChange::Rotation;
+	}
 	return this;
 }
 
-void SceneNode::AdjustRenderingOrder()
+g2d::SceneNode* SceneNode::SetTransform(const gml::vec2& position, gml::radian r, const gml::vec2& scale, const gml::vec2& pivot)
 {
-	if (ParentIsScene() && m_childIndex == 0)
+	auto& transforms = GetTransforms();
+	uint32_t changes = 0;
+	if (!IsSameVector(transforms.GetPosition(m_transform), position))
+		changes |= g2d::TransformChange::Position;
+	if (transforms.GetRotation(m_transform) != r.value)
+		changes |= g2d::TransformChange::Rotation;
+	if (!IsSameVector(transforms.GetScale(m_transform), scale))
+		changes |= g2d::TransformChange::Scale;
+	if (!IsSameVector(transforms.GetPivot(m_transform), pivot))
+		changes |= g2d::TransformChange::Pivot;
+
+	if (changes != 0)
 	{
-		m_scene.AdjustRenderingOrder();
+		transforms.SetTransform(m_transform, ToTransformVector(position), r.value, ToTransformVector(scale), ToTransformVector(pivot));
+		m_transformChanges |= changes;
 	}
-	else
+	return this;
+}
+
+::SceneNode* SceneNode::GetPrevInRenderingOrder() const
+{
+	auto prev = GetPrevSibling();
+	if (prev == nullptr)
 	{
-		auto index = m_renderingOrder + 1;
-		m_children.Traversal([&](::SceneNode* child)
-		{
-			child->SetRenderingOrder(index);
-		});
+		return m_parent;
+	}
+
+	// the last descendant of the previous sibling.
+	while (prev->m_children.GetCount() > 0)
+	{
+		prev = prev->m_children.Last();
+	}
+	return prev;
+}
+
+::SceneNode* SceneNode::GetNextInRenderingOrder() const
+{
+	auto first = m_children.First();
+	return (first != nullptr) ? first : GetNextAfterSubtree();
+}
 
-		auto current = this;
-		while (current != nullptr)
+::SceneNode* SceneNode::GetNextAfterSubtree() const
+{
+	const ::SceneNode* current = this;
+	while (current != nullptr)
+	{
+		auto next = current->GetNextSibling();
+		if (next != nullptr)
 		{
-			auto next = current->GetNextSibling();
-			while (next != nullptr)
-			{
-				next->SetRenderingOrder(index);
-				next = next->GetNextSibling();
-			}
-			current = current->GetParent();
+			return next;
 		}
+		current = current->m_parent;
 	}
+	return nullptr;
 }
 
-void SceneNode::SetWorldMatrixDirty()
+void SceneNode::MarkRenderingOrderDirty()
 {
-	m_worldTransform.SetMatrixDirty();
+	// descendants of a dirty node are dirty already.
+	if (m_renderingOrderDirty)
+		return;
+
+	m_renderingOrderDirty = true;
 	m_children.Traversal([](::SceneNode* child)
 	{
-		child->SetWorldMatrixDirty();
+		child->MarkRenderingOrderDirty();
+	});
+}
+
+void SceneNode::CollectSubtree(std::vector<::SceneNode*>& nodes)
+{
+	nodes.push_back(this);
+	m_children.Traversal([&](::SceneNode* child)
+	{
+		child->CollectSubtree(nodes);
 	});
-	m_matrixDirtyUpdate = true;
 }
 
 void SceneNode::AdjustSpatial()
 {
+	if (Defer(SceneCommandBuffer::Type::AdjustSpatial))
+		return;
+
 	m_components.Traversal([&](g2d::Component* component)
 	{
 		m_scene.GetSpatialGraph().Add(*component);
 	});
 }
 
+::SceneNode* SceneNode::GetTopLevel()
+{
+	::SceneNode* node = this;
+	while (!node->ParentIsScene())
+	{
+		node = node->m_parent;
+	}
+	return node;
+}
+
 void SceneNode::OnUpdate(uint32_t deltaTime)
 {
 	m_components.OnUpdate(deltaTime);
-	if (m_matrixDirtyUpdate)
+}
+
+void SceneNode::OnWorldChanged()
+{
+	// the node may be listed more than once in a frame.
+	uint32_t worldVersion = GetTransforms().GetWorldVersion(m_transform);
+	if (m_worldVersion == worldVersion)
+		return;
+
+	m_worldVersion = worldVersion;
+	if (m_transformChanges != 0)
 	{
-		// static object need to adjust location in
-		// quad tree, at this time, we may adjust it
-		// before visibility testing process, aka 
-		// rendering process
-		if (IsStatic())
-		{
-			AdjustSpatial();
-		}
-		m_components.OnUpdateMatrixChanged();
-		m_matrixDirtyUpdate = false;
+		// changes made in callbacks are notified next frame.
+		uint32_t changes = m_transformChanges;
+		m_transformChanges = 0;
+		m_components.OnTransformChanged(changes);
 	}
 
-	m_children.OnUpdate(deltaTime);
+	// static object need to adjust location in
+	// quad tree, at this time, we may adjust it
+	// before visibility testing process, aka 
+	// rendering process
+	if (IsStatic())
+	{
+		AdjustSpatial();
+	}
+	m_components.OnUpdateMatrixChanged();
 }
 
 g2d::Scene * SceneNode::GetScene() const { return &m_scene; }
 
-::SceneNode* SceneNode::GetPrevSibling() const
+g2d::SceneNodeHandle SceneNode::GetHandle() const
 {
-	if (m_childIndex == 0)
-	{
-		return nullptr;
-	}
-	return m_parentContainer.At(m_childIndex - 1);
+	auto handle = ObjectPool<::SceneNode>::GetHandle(this);
+	return{ handle.index, handle.generation };
 }
 
-::SceneNode* SceneNode::GetNextSibling() const
+g2d::SceneNode * SceneNode::CreateChild()
 {
-	if (m_childIndex == m_parentContainer.GetCount() - 1)
+	auto buffer = SceneCommandBuffer::GetCurrent();
+	if (buffer != nullptr)
 	{
-		return nullptr;
+		return buffer->CreateChild(m_scene, this, m_children);
 	}
-	return m_parentContainer.At(m_childIndex + 1);
-}
 
-g2d::SceneNode * SceneNode::CreateChild()
-{
 	auto child = m_children.CreateChild(m_scene, *this);
-	m_scene.SetRenderingOrderDirty(this);
+	m_scene.UpdateRenderingOrder(*child);
 	return child;
 }
 
@@ -209,52 +431,72 @@ void SceneNode::Release()
 	// rendering order, but wont change the order,
 	// so we do nothing when deleting nodes
 	m_isRemoved = true;
-	m_parentContainer.Remove(*this);
+	if (Defer(SceneCommandBuffer::Type::Release))
+		return;
+
+	if (!m_parentContainer.Remove(*this))
+		return;
+
+	StopEvents();
 	m_scene.OnRemoveSceneNode(*this);
+	m_scene.DelayDelete(*this);
 }
 
 void SceneNode::MoveToFront()
 {
-	auto oldIndex = m_childIndex;
-	if (m_parentContainer.Move(m_childIndex, m_parentContainer.GetCount() - 1))
+	if (Defer(SceneCommandBuffer::Type::MoveToFront))
+		return;
+
+	if (m_parentContainer.Move(*this, nullptr))
 	{
-		m_scene.SetRenderingOrderDirty(m_parentContainer.At(oldIndex));
+		m_scene.UpdateRenderingOrder(*this);
 	}
 }
 
 void SceneNode::MoveToBack()
 {
-	if (m_parentContainer.Move(m_childIndex, 0))
+	if (Defer(SceneCommandBuffer::Type::MoveToBack))
+		return;
+
+	if (m_parentContainer.Move(*this, m_parentContainer.First()))
 	{
-		m_scene.SetRenderingOrderDirty(this);
+		m_scene.UpdateRenderingOrder(*this);
 	}
 }
 
 void SceneNode::MovePrev()
 {
-	if (m_parentContainer.Move(m_childIndex, m_childIndex - 1))
+	if (Defer(SceneCommandBuffer::Type::MovePrev))
+		return;
+
+	auto prev = GetPrevSibling();
+	if (prev != nullptr && m_parentContainer.Move(*this, prev))
 	{
-		m_scene.SetRenderingOrderDirty(this);
+		m_scene.UpdateRenderingOrder(*this);
 	}
 }
 
 void SceneNode::MoveNext()
 {
-	auto oldIndex = m_childIndex;
-	if (m_parentContainer.Move(m_childIndex, m_childIndex + 1))
+	if (Defer(SceneCommandBuffer::Type::MoveNext))
+		return;
+
+	auto next = GetNextSibling();
+	if (next != nullptr && m_parentContainer.Move(*this, next->GetNextSibling()))
 	{
-		m_scene.SetRenderingOrderDirty(m_parentContainer.At(oldIndex));
+		m_scene.UpdateRenderingOrder(*this);
 	}
 }
 
 bool SceneNode::AddComponent(g2d::Component* component, bool autoRelease)
 {
 	ENSURE(component != nullptr);
-	auto successed = m_components.Add(this, component, autoRelease);
-	if (successed)
+	if (Defer(SceneCommandBuffer::Type::AddComponent, component, autoRelease))
+		return true;
+
+	if (AddComponentWithoutSpatial(component, autoRelease))
 	{
 		m_scene.GetSpatialGraph().Add(*component);
-		m_scene.SetRenderingOrderDirty(this);
 		return true;
 	}
 	else
@@ -263,12 +505,38 @@ bool SceneNode::AddComponent(g2d::Component* component, bool autoRelease)
 	}
 }
 
+bool SceneNode::AddComponentWithoutSpatial(g2d::Component* component, bool autoRelease)
+{
+	auto successed = m_components.Add(this, component, autoRelease);
+	if (successed)
+	{
+		RegisterComponent(*component);
+		UpdateSubscriptions();
+
+		// ranked as components are sorted, by execute order, then by sequence.
+		uint32_t executeOrder = static_cast<uint32_t>(component->GetExecuteOrder()) ^ 0x80000000;
+		component->SetRenderingRank((static_cast<uint64_t>(executeOrder) << 32) | m_componentSequence++);
+		component->SetRenderingOrder(m_renderingOrder);
+	}
+	return successed;
+}
+
 bool SceneNode::RemoveComponent(g2d::Component * component)
 {
 	ENSURE(component != nullptr);
-	if (m_components.Remove(component, false))
+	if (Defer(SceneCommandBuffer::Type::RemoveComponent, component))
+		return true;
+
+	bool autoRelease = false;
+	if (m_components.Remove(component, autoRelease))
 	{
+		UnregisterComponent(*component);
+		UpdateSubscriptions();
 		m_scene.GetSpatialGraph().Remove(*component);
+		if (autoRelease)
+		{
+			component->Release();
+		}
 		return true;
 	}
 	else
@@ -280,7 +548,20 @@ bool SceneNode::RemoveComponent(g2d::Component * component)
 bool SceneNode::RemoveComponentWithoutRelease(g2d::Component * component)
 {
 	ENSURE(component != nullptr);
-	return m_components.Remove(component, true);
+	if (Defer(SceneCommandBuffer::Type::RemoveComponentWithoutRelease, component))
+		return true;
+
+	bool autoRelease = false;
+	if (m_components.Remove(component, autoRelease))
+	{
+		UnregisterComponent(*component);
+		UpdateSubscriptions();
+		return true;
+	}
+	else
+	{
+		return false;
+	}
 }
 
 bool SceneNode::IsComponentAutoRelease(g2d::Component * component) const
@@ -319,17 +600,27 @@ void SceneNode::SetVisibleMask(uint32_t mask, bool recursive)
 
 gml::vec2 SceneNode::GetWorldPosition()
 {
-	return m_worldTransform.GetPosition();
+	if (ParentIsScene())
+	{
+		return GetPosition();
+	}
+	else
+	{
+		return gml::transform_point(m_parent->GetWorldMatrix(), GetPosition());
+	}
 }
 
 const gml::vec2 & SceneNode::GetRight()
 {
-	return m_worldTransform.GetRight();
+	m_right = gml::transform_vector(GetWorldMatrix(), gml::vec2::right());
+	m_right.normalize();
+	return m_right;
 }
 
 const gml::vec2 & SceneNode::GetUp()
 {
-	return m_worldTransform.GetUp();
+	m_up = gml::transform_vector(GetWorldMatrix(), gml::vec2::up());
+	return m_up;
 }
 
 gml::vec2 SceneNode::WorldToLocal(const gml::vec2& pos)
@@ -353,28 +644,18 @@ gml::vec2 SceneNode::WorldToParent(const gml::vec2& pos)
 	}
 }
 
-void SceneNode::SetRenderingOrder(uint32_t & order)
+void SceneNode::SetRenderingOrder(uint64_t order)
 {
-	m_renderingOrder = order++;
+	m_renderingOrder = order;
 	m_components.Traversal([&](g2d::Component* component)
 	{
 		component->SetRenderingOrder(order);
 	});
-	m_children.Traversal([&](::SceneNode* child)
-	{
-		child->SetRenderingOrder(order);
-	});
-}
-
-void SceneNode::SetRenderingOrderOnly(uint32_t order)
-{
-	m_renderingOrder = order;
 }
 
 void SceneNode::OnMessage(const g2d::Message& message)
 {
 	m_components.OnMessage(message);
-	m_children.OnMessage(message);
 }
 
 void SceneNode::OnCursorEnterFrom(::SceneNode* adjacency)
@@ -508,23 +789,19 @@ void SceneNode::OnDropTo(::SceneNode* dropped, g2d::MouseButton button)
 void SceneNode::OnKeyPress(g2d::KeyCode key)
 {
 	m_components.OnKeyPress(key);
-	m_children.OnKeyPress(key);
 }
 
 void SceneNode::OnKeyPressingBegin(g2d::KeyCode key)
 {
 	m_components.OnKeyPressingBegin(key);
-	m_children.OnKeyPressingBegin(key);
 }
 
 void SceneNode::OnKeyPressing(g2d::KeyCode key)
 {
 	m_components.OnKeyPressing(key);
-	m_children.OnKeyPressing(key);
 }
 
 void SceneNode::OnKeyPressingEnd(g2d::KeyCode key)
 {
 	m_components.OnKeyPressingEnd(key);
-	m_children.OnKeyPressingEnd(key);
 }
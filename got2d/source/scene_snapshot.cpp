@@ -0,0 +1,245 @@
+#include <cstring>
+#include <string>
+#include <vector>
+#include "scene.h"
+#include "engine.h"
+#include "scene_snapshot.h"
+
+// Serializers of components, registered at startup, by class id and by
+// name, since class ids may differ in the next run.
+class SnapshotClasses
+{
+public:
+	struct Entry
+	{
+		uint32_t classID;
+		std::string name;
+		g2d::SaveComponentFunc save;
+		g2d::LoadComponentFunc load;
+	};
+
+	static SnapshotClasses& GetInstance();
+
+	// registering a class again replaces its serializers.
+	void Register(uint32_t classID, const std::string& name, g2d::SaveComponentFunc save, g2d::LoadComponentFunc load);
+
+	// nullptr if the class is not registered.
+	const Entry* Find(uint32_t classID) const;
+
+	const Entry* Find(const std::string& name) const;
+
+private:
+	SnapshotClasses();
+
+	std::vector<Entry> m_entries;
+};
+
+uint32_t SaveQuad(const g2d::Component& component, void* data, uint32_t capacity)
+{
+	const gml::vec2& size = static_cast<const ::Quad&>(component).GetSize();
+	if (capacity >= sizeof(float) * 2)
+	{
+		float values[2] = { size.x, size.y };
+		memcpy(data, values, sizeof(values));
+	}
+	return sizeof(float) * 2;
+}
+
+g2d::Component* LoadQuad(const void* data, uint32_t size)
+{
+	if (size < sizeof(float) * 2)
+		return nullptr;
+
+	float values[2];
+	memcpy(values, data, sizeof(values));
+	auto quad = g2d::Quad::Create();
+	quad->SetSize(gml::vec2(values[0], values[1]));
+	return quad;
+}
+
+SnapshotClasses& SnapshotClasses::GetInstance()
+{
+	static SnapshotClasses* s_instance = new SnapshotClasses();
+	return *s_instance;
+}
+
+SnapshotClasses::SnapshotClasses()
+{
+	Register(::Quad::GetStaticClassID(), "g2d.Quad", SaveQuad, LoadQuad);
+}
+
+void SnapshotClasses::Register(uint32_t classID, const std::string& name, g2d::SaveComponentFunc save, g2d::LoadComponentFunc load)
+{
+	for (auto& entry : m_entries)
+	{
+		if (entry.classID == classID || entry.name == name)
+		{
+			entry = { classID, name, save, load };
+			return;
+		}
+	}
+	m_entries.push_back({ classID, name, save, load });
+}
+
+const SnapshotClasses::Entry* SnapshotClasses::Find(uint32_t classID) const
+{
+	for (auto& entry : m_entries)
+	{
+		if (entry.classID == classID)
+			return &entry;
+	}
+	return nullptr;
+}
+
+const SnapshotClasses::Entry* SnapshotClasses::Find(const std::string& name) const
+{
+	for (auto& entry : m_entries)
+	{
+		if (entry.name == name)
+			return &entry;
+	}
+	return nullptr;
+}
+
+void g2d::RegisterSnapshotClass(uint32_t classID, const char* name, SaveComponentFunc save, LoadComponentFunc load)
+{
+	ENSURE(name != nullptr && save != nullptr && load != nullptr);
+	SnapshotClasses::GetInstance().Register(classID, name, save, load);
+}
+
+// the node and its subtree, in rendering order.
+void WriteSnapshotNode(SnapshotWriter& writer, ::Scene& scene, ::SceneNode& node, uint32_t parent)
+{
+	// cameras belong to the scene they are created by.
+	if (scene.FindComponent(&node, ::Camera::GetStaticClassID()) != nullptr)
+		return;
+
+	TransformStore& transforms = node.GetTransforms();
+	TransformStore::Handle handle = node.GetTransformHandle();
+	SnapshotNode info;
+	info.parent = parent;
+	info.visibleMask = node.GetVisibleMask();
+	info.position[0] = transforms.GetPosition(handle).x;
+	info.position[1] = transforms.GetPosition(handle).y;
+	info.scale[0] = transforms.GetScale(handle).x;
+	info.scale[1] = transforms.GetScale(handle).y;
+	info.pivot[0] = transforms.GetPivot(handle).x;
+	info.pivot[1] = transforms.GetPivot(handle).y;
+	info.rotation = transforms.GetRotation(handle);
+	info.flags = (node.IsVisible() ? SnapshotNode::VISIBLE : 0) | (node.IsStatic() ? SnapshotNode::STATIC : 0);
+	uint32_t index = writer.AddNode(info);
+
+	auto& snapshotClasses = SnapshotClasses::GetInstance();
+	for (uint32_t i = 0; i < node.GetComponentCount(); i++)
+	{
+		g2d::Component* component = node.GetComponentByIndex(i);
+		auto entry = snapshotClasses.Find(component->GetClassID());
+		if (entry == nullptr)
+			continue;
+
+		uint32_t classIndex = writer.AddClass(entry->name);
+		// most components need a few bytes, others are saved again.
+		const uint32_t capacity = 64;
+		uint32_t size = entry->save(*component, writer.AddComponent(classIndex, 0, capacity), capacity);
+		uint8_t* data = writer.ResizeLastComponent(size);
+		if (size > capacity)
+		{
+			entry->save(*component, data, size);
+		}
+	}
+
+	for (::SceneNode* child = static_cast<::SceneNode*>(node.FirstChild()); child != nullptr; child = child->GetNextSibling())
+	{
+		WriteSnapshotNode(writer, scene, *child, index);
+	}
+}
+
+bool Scene::SaveSnapshot(const char* path)
+{
+	ENSURE(path != nullptr && SceneCommandBuffer::GetCurrent() == nullptr);
+	SnapshotWriter writer;
+	for (::SceneNode* child = m_children.First(); child != nullptr; child = child->GetNextSibling())
+	{
+		WriteSnapshotNode(writer, *this, *child, SNAPSHOT_NO_PARENT);
+	}
+
+	std::vector<uint8_t> snapshot;
+	writer.Finish(snapshot);
+	return GetEngineImpl()->GetFileSystem().WriteFile(FileSystem::NormalizePath(path), snapshot.data(), snapshot.size());
+}
+
+bool Scene::LoadSnapshot(const char* path)
+{
+	ENSURE(path != nullptr && SceneCommandBuffer::GetCurrent() == nullptr);
+	FileView view;
+	MappedFile mapping;
+	SnapshotReader reader;
+	if (!GetEngineImpl()->GetFileSystem().MapFile(FileSystem::NormalizePath(path), view, mapping) ||
+		!reader.Open(view.GetData(), view.GetSize()))
+	{
+		return false;
+	}
+
+	// components of classes not registered in this run are skipped.
+	auto& snapshotClasses = SnapshotClasses::GetInstance();
+	std::vector<const SnapshotClasses::Entry*> classes(reader.GetClassCount());
+	for (uint32_t i = 0; i < reader.GetClassCount(); i++)
+	{
+		classes[i] = snapshotClasses.Find(reader.GetClassName(i));
+	}
+
+	// parents come first, nodes are linked without being ordered one by one.
+	uint32_t nodeCount = reader.GetNodeCount();
+	m_transforms.Reserve(m_transforms.GetCount() + nodeCount);
+	m_orderingNodes.resize(nodeCount);
+	std::vector<g2d::Component*> components;
+	components.reserve(reader.GetComponentCount());
+	for (uint32_t i = 0; i < nodeCount; i++)
+	{
+		const SnapshotNode& info = reader.GetNode(i);
+		::SceneNode* node = (info.parent == SNAPSHOT_NO_PARENT)
+			? m_children.CreateChild(*this, m_children)
+			: m_orderingNodes[info.parent]->CreateChildUnordered();
+		m_orderingNodes[i] = node;
+
+		m_transforms.SetTransform(node->GetTransformHandle(),
+			{ info.position[0], info.position[1] }, info.rotation,
+			{ info.scale[0], info.scale[1] }, { info.pivot[0], info.pivot[1] });
+		node->SetVisible((info.flags & SnapshotNode::VISIBLE) != 0);
+		node->SetVisibleMask(info.visibleMask, false);
+		if ((info.flags & SnapshotNode::STATIC) != 0)
+		{
+			// no component to adjust yet.
+			node->SetStatic(true);
+		}
+
+		for (uint32_t c = info.firstComponent; c < info.firstComponent + info.componentCount; c++)
+		{
+			const SnapshotComponent& entry = reader.GetComponent(c);
+			auto snapshotClass = classes[entry.classIndex];
+			if (snapshotClass == nullptr)
+				continue;
+
+			// created here, nobody else owns them.
+			g2d::Component* component = snapshotClass->load(reader.GetComponentData(c), entry.dataSize);
+			if (component == nullptr)
+				continue;
+
+			if (node->AddComponentWithoutSpatial(component, true))
+				components.push_back(component);
+			else
+				component->Release();
+		}
+	}
+
+	if (nodeCount > 0)
+	{
+		// loaded nodes follow all others, keys are given in one pass.
+		m_renderingOrder.Insert(m_orderingNodes[0]->GetPrevInRenderingOrder(), nullptr, m_orderingNodes);
+	}
+
+	// world matrices in one linear pass, before static ones are placed.
+	m_transforms.Update(&m_movedTransforms);
+	m_spatial.AddRange(components.data(), static_cast<uint32_t>(components.size()));
+	return true;
+}
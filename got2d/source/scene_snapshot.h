@@ -0,0 +1,270 @@
+#pragma once
+#include <cinttypes>
+#include <cstring>
+#include <string>
+#include <vector>
+
+// Binary snapshot of a scene tree.
+// Nodes are stored in rendering order: every node comes after its parent
+// and previous siblings, and its subtree follows it contiguously, so that
+// loading creates parents first and orders all nodes in one pass.
+// Components of a node are stored next to each other in execution order,
+// their data is written by serializers of their class, found by name.
+//
+// Snapshot layout, all fields are little-endian:
+//   SnapshotHeader
+//   SnapshotNode[nodeCount]
+//   SnapshotComponent[componentCount]
+//   SnapshotClass[classCount]
+//   class names, not null-terminated
+//   component data, each one aligned to SNAPSHOT_DATA_ALIGNMENT
+constexpr uint32_t SNAPSHOT_MAGIC = 0x53443247; // "G2DS"
+constexpr uint32_t SNAPSHOT_VERSION = 1;
+constexpr uint32_t SNAPSHOT_DATA_ALIGNMENT = 8;
+constexpr uint32_t SNAPSHOT_NO_PARENT = 0xFFFFFFFF;
+
+struct SnapshotHeader
+{
+	uint32_t magic;
+	uint32_t version;
+	uint32_t nodeCount;
+	uint32_t componentCount;
+	uint32_t classCount;
+	uint32_t namesSize;
+	uint64_t nodesOffset;
+	uint64_t componentsOffset;
+	uint64_t classesOffset;
+	uint64_t namesOffset;
+	uint64_t dataOffset;
+	uint64_t dataSize;
+};
+
+struct SnapshotNode
+{
+	// SNAPSHOT_NO_PARENT for top-level nodes.
+	uint32_t parent;
+	uint32_t firstComponent;
+	uint32_t componentCount;
+	uint32_t visibleMask;
+	float position[2];
+	float scale[2];
+	float pivot[2];
+	float rotation;
+	uint32_t flags;
+
+	constexpr static uint32_t VISIBLE = 0x1;
+	constexpr static uint32_t STATIC = 0x2;
+};
+
+struct SnapshotComponent
+{
+	uint32_t classIndex;
+	uint32_t flags;	// reserved, 0.
+	uint32_t dataOffset;	// relative to data of the snapshot.
+	uint32_t dataSize;
+};
+
+struct SnapshotClass
+{
+	uint32_t nameOffset;
+	uint32_t nameLength;
+};
+
+static_assert(sizeof(SnapshotHeader) == 72 && sizeof(SnapshotNode) == 48 &&
+	sizeof(SnapshotComponent) == 16 && sizeof(SnapshotClass) == 8, "snapshot layout must be packed.");
+
+// Validate a snapshot in memory once, so that reading needs no bounds
+// checking. Memory is referenced, it must outlive the reader.
+class SnapshotReader
+{
+public:
+	bool Open(const uint8_t* data, uint64_t size)
+	{
+		m_header = nullptr;
+		auto header = reinterpret_cast<const SnapshotHeader*>(data);
+		if (size < sizeof(SnapshotHeader) ||
+			header->magic != SNAPSHOT_MAGIC ||
+			header->version != SNAPSHOT_VERSION ||
+			!InRange(header->nodesOffset, static_cast<uint64_t>(header->nodeCount) * sizeof(SnapshotNode), size) ||
+			!InRange(header->componentsOffset, static_cast<uint64_t>(header->componentCount) * sizeof(SnapshotComponent), size) ||
+			!InRange(header->classesOffset, static_cast<uint64_t>(header->classCount) * sizeof(SnapshotClass), size) ||
+			!InRange(header->namesOffset, header->namesSize, size) ||
+			!InRange(header->dataOffset, header->dataSize, size) ||
+			header->nodesOffset % alignof(SnapshotNode) != 0 ||
+			header->componentsOffset % alignof(SnapshotComponent) != 0 ||
+			header->classesOffset % alignof(SnapshotClass) != 0)
+		{
+			return false;
+		}
+
+		auto nodes = reinterpret_cast<const SnapshotNode*>(data + header->nodesOffset);
+		auto components = reinterpret_cast<const SnapshotComponent*>(data + header->componentsOffset);
+		auto classes = reinterpret_cast<const SnapshotClass*>(data + header->classesOffset);
+		for (uint32_t i = 0; i < header->classCount; i++)
+		{
+			if (static_cast<uint64_t>(classes[i].nameOffset) + classes[i].nameLength > header->namesSize)
+				return false;
+		}
+
+		for (uint32_t i = 0; i < header->componentCount; i++)
+		{
+			const SnapshotComponent& component = components[i];
+			if (component.classIndex >= header->classCount ||
+				static_cast<uint64_t>(component.dataOffset) + component.dataSize > header->dataSize)
+			{
+				return false;
+			}
+		}
+
+		// ancestors of the previous node, parent of a node must be one of
+		// them, otherwise subtrees are not contiguous.
+		m_path.clear();
+		for (uint32_t i = 0; i < header->nodeCount; i++)
+		{
+			const SnapshotNode& node = nodes[i];
+			while (!m_path.empty() && m_path.back() != node.parent)
+			{
+				m_path.pop_back();
+			}
+
+			if ((m_path.empty() && node.parent != SNAPSHOT_NO_PARENT) ||
+				static_cast<uint64_t>(node.firstComponent) + node.componentCount > header->componentCount)
+			{
+				return false;
+			}
+			m_path.push_back(i);
+		}
+
+		m_header = header;
+		m_nodes = nodes;
+		m_components = components;
+		m_classes = classes;
+		m_names = reinterpret_cast<const char*>(data + header->namesOffset);
+		m_data = data + header->dataOffset;
+		return true;
+	}
+
+	uint32_t GetNodeCount() const { return m_header == nullptr ? 0 : m_header->nodeCount; }
+
+	uint32_t GetComponentCount() const { return m_header == nullptr ? 0 : m_header->componentCount; }
+
+	uint32_t GetClassCount() const { return m_header == nullptr ? 0 : m_header->classCount; }
+
+	const SnapshotNode& GetNode(uint32_t index) const { return m_nodes[index]; }
+
+	const SnapshotComponent& GetComponent(uint32_t index) const { return m_components[index]; }
+
+	std::string GetClassName(uint32_t index) const
+	{
+		return std::string(m_names + m_classes[index].nameOffset, m_classes[index].nameLength);
+	}
+
+	const uint8_t* GetComponentData(uint32_t index) const { return m_data + m_components[index].dataOffset; }
+
+private:
+	static bool InRange(uint64_t offset, uint64_t length, uint64_t size)
+	{
+		return offset <= size && length <= size - offset;
+	}
+
+	const SnapshotHeader* m_header = nullptr;
+	const SnapshotNode* m_nodes = nullptr;
+	const SnapshotComponent* m_components = nullptr;
+	const SnapshotClass* m_classes = nullptr;
+	const char* m_names = nullptr;
+	const uint8_t* m_data = nullptr;
+	std::vector<uint32_t> m_path;
+};
+
+// Build a snapshot in memory, nodes must be added in rendering order,
+// components of a node right after the node.
+class SnapshotWriter
+{
+public:
+	// index of the class, names are added once.
+	uint32_t AddClass(const std::string& name)
+	{
+		for (uint32_t i = 0; i < m_classes.size(); i++)
+		{
+			if (m_names.compare(m_classes[i].nameOffset, m_classes[i].nameLength, name) == 0)
+				return i;
+		}
+
+		m_classes.push_back({ static_cast<uint32_t>(m_names.size()), static_cast<uint32_t>(name.size()) });
+		m_names += name;
+		return static_cast<uint32_t>(m_classes.size()) - 1;
+	}
+
+	// index of the node, components are not counted yet.
+	uint32_t AddNode(const SnapshotNode& node)
+	{
+		m_nodes.push_back(node);
+		m_nodes.back().firstComponent = static_cast<uint32_t>(m_components.size());
+		m_nodes.back().componentCount = 0;
+		return static_cast<uint32_t>(m_nodes.size()) - 1;
+	}
+
+	// add a component to the last node, data of size bytes is written
+	// into the returned buffer, it's valid until next adding.
+	uint8_t* AddComponent(uint32_t classIndex, uint32_t flags, uint32_t size)
+	{
+		uint32_t offset = static_cast<uint32_t>(m_data.size());
+		m_components.push_back({ classIndex, flags, offset, size });
+		m_nodes.back().componentCount++;
+		m_data.resize(offset + Align(size));
+		return m_data.data() + offset;
+	}
+
+	// change data size of the last component, bytes written are kept.
+	uint8_t* ResizeLastComponent(uint32_t size)
+	{
+		SnapshotComponent& component = m_components.back();
+		component.dataSize = size;
+		m_data.resize(component.dataOffset + Align(size));
+		return m_data.data() + component.dataOffset;
+	}
+
+	uint32_t GetNodeCount() const { return static_cast<uint32_t>(m_nodes.size()); }
+
+	void Finish(std::vector<uint8_t>& snapshot) const
+	{
+		SnapshotHeader header;
+		header.magic = SNAPSHOT_MAGIC;
+		header.version = SNAPSHOT_VERSION;
+		header.nodeCount = static_cast<uint32_t>(m_nodes.size());
+		header.componentCount = static_cast<uint32_t>(m_components.size());
+		header.classCount = static_cast<uint32_t>(m_classes.size());
+		header.namesSize = static_cast<uint32_t>(m_names.size());
+		header.nodesOffset = sizeof(SnapshotHeader);
+		header.componentsOffset = header.nodesOffset + m_nodes.size() * sizeof(SnapshotNode);
+		header.classesOffset = header.componentsOffset + m_components.size() * sizeof(SnapshotComponent);
+		header.namesOffset = header.classesOffset + m_classes.size() * sizeof(SnapshotClass);
+		header.dataOffset = Align(header.namesOffset + m_names.size());
+		header.dataSize = m_data.size();
+
+		snapshot.assign(static_cast<size_t>(header.dataOffset + header.dataSize), 0);
+		memcpy(snapshot.data(), &header, sizeof(header));
+		Copy(snapshot, header.nodesOffset, m_nodes.data(), m_nodes.size() * sizeof(SnapshotNode));
+		Copy(snapshot, header.componentsOffset, m_components.data(), m_components.size() * sizeof(SnapshotComponent));
+		Copy(snapshot, header.classesOffset, m_classes.data(), m_classes.size() * sizeof(SnapshotClass));
+		Copy(snapshot, header.namesOffset, m_names.data(), m_names.size());
+		Copy(snapshot, header.dataOffset, m_data.data(), m_data.size());
+	}
+
+private:
+	template<typename T> static T Align(T size)
+	{
+		return (size + SNAPSHOT_DATA_ALIGNMENT - 1) / SNAPSHOT_DATA_ALIGNMENT * SNAPSHOT_DATA_ALIGNMENT;
+	}
+
+	static void Copy(std::vector<uint8_t>& snapshot, uint64_t offset, const void* data, size_t size)
+	{
+		if (size > 0) memcpy(snapshot.data() + offset, data, size);
+	}
+
+	std::vector<SnapshotNode> m_nodes;
+	std::vector<SnapshotComponent> m_components;
+	std::vector<SnapshotClass> m_classes;
+	std::string m_names;
+	std::vector<uint8_t> m_data;
+};
@@ -87,7 +87,7 @@ bool Shader::Create(const std::string& vsCode, uint32_t vcbLength, const std::st
 	if (S_OK != ret)
 		return false;
 
-	D3D11_INPUT_ELEMENT_DESC layoutDesc[3];
+	D3D11_INPUT_ELEMENT_DESC layoutDesc[3 + g2d::DrawParam::Count];
 	::ZeroMemory(layoutDesc, sizeof(layoutDesc));
 
 	layoutDesc[0].SemanticName = "POSITION";
@@ -105,6 +105,18 @@ bool Shader::Create(const std::string& vsCode, uint32_t vcbLength, const std::st
 	layoutDesc[2].AlignedByteOffset = D3D11_APPEND_ALIGNED_ELEMENT;
 	layoutDesc[2].InputSlotClass = D3D11_INPUT_PER_VERTEX_DATA;
 
+	// per-draw parameters come from the second stream.
+	for (uint32_t i = 0; i < g2d::DrawParam::Count; i++)
+	{
+		auto& paramDesc = layoutDesc[3 + i];
+		paramDesc.SemanticName = "DRAWPARAM";
+		paramDesc.SemanticIndex = i;
+		paramDesc.Format = DXGI_FORMAT_R32G32B32A32_FLOAT;
+		paramDesc.InputSlot = 1;
+		paramDesc.AlignedByteOffset = D3D11_APPEND_ALIGNED_ELEMENT;
+		paramDesc.InputSlotClass = D3D11_INPUT_PER_VERTEX_DATA;
+	}
+
 	ret = GetRenderSystem()->GetDevice()->CreateInputLayout(
 		layoutDesc, sizeof(layoutDesc) / sizeof(layoutDesc[0]),
 		vsBlob->GetBufferPointer(), vsBlob->GetBufferSize(),
@@ -174,12 +186,15 @@ public:
 				float2 position : POSITION;
 				float2 texcoord : TEXCOORD0;
 				float4 vtxcolor : COLOR;
+				float4 tint : DRAWPARAM0;
+				float4 texcoordTransform : DRAWPARAM1;
 			};
 			struct VertexOutput
 			{
 				float4 position : SV_POSITION;
 				float2 texcoord : TEXCOORD0;
-				float4 vtxcolor : COLOR;
+				float4 vtxcolor : COLOR0;
+				float4 tint : COLOR1;
 			};
 			VertexOutput VSMain(GeometryVertex input)
 			{
@@ -189,8 +204,9 @@ public:
 					dot(position, float3(matrixView[0][0],matrixView[1][0],matrixView[2][0])),
 					dot(position, float3(matrixView[0][1],matrixView[1][1],matrixView[2][1])));
 				output.position = mul(float4(viewPos, 0, 1), matrixProj);
-				output.texcoord = input.texcoord;
+				output.texcoord = input.texcoord * input.texcoordTransform.zw + input.texcoordTransform.xy;
 				output.vtxcolor = input.vtxcolor;
+				output.tint = input.tint;
 				return output;
 			}
 		)";
@@ -208,11 +224,12 @@ class SimpleColorPSData : public PSData
 			{
 				float4 position : SV_POSITION;
 				float2 texcoord : TEXCOORD0;
-				float4 vtxcolor : COLOR;
+				float4 vtxcolor : COLOR0;
+				float4 tint : COLOR1;
 			};
 			float4 PSMain(VertexInput input):SV_TARGET
 			{
-				return input.vtxcolor;
+				return input.vtxcolor * input.tint;
 			}
 		)";
 	}
@@ -231,11 +248,12 @@ class SimpleTexturePSData : public PSData
 			{
 				float4 position : SV_POSITION;
 				float2 texcoord : TEXCOORD0;
-				float4 vtxcolor : COLOR;
+				float4 vtxcolor : COLOR0;
+				float4 tint : COLOR1;
 			};
 			float4 PSMain(VertexInput input):SV_TARGET
 			{
-				return Tex.Sample(State, input.texcoord);
+				return Tex.Sample(State, input.texcoord) * input.tint;
 			}
 		)";
 	}
@@ -254,11 +272,12 @@ class ColorTexturePSData : public PSData
 			{
 				float4 position : SV_POSITION;
 				float2 texcoord : TEXCOORD0;
-				float4 vtxcolor : COLOR;
+				float4 vtxcolor : COLOR0;
+				float4 tint : COLOR1;
 			};
 			float4 PSMain(VertexInput input):SV_TARGET
 			{
-				return input.vtxcolor * Tex.Sample(State, input.texcoord);
+				return input.vtxcolor * Tex.Sample(State, input.texcoord) * input.tint;
 			}
 		)";
 	}
@@ -268,17 +287,17 @@ class ColorTexturePSData : public PSData
 ShaderLib::ShaderLib()
 {
 	VSData* vsd = new DefaultVSData();
-	m_vsSources[vsd->GetName()] = vsd;
+	m_vsSources[Atom(vsd->GetName())] = vsd;
 
 	PSData* psd;
 	psd = new SimpleColorPSData();
-	m_psSources[psd->GetName()] = psd;
+	m_psSources[Atom(psd->GetName())] = psd;
 
 	psd = new SimpleTexturePSData();
-	m_psSources[psd->GetName()] = psd;
+	m_psSources[Atom(psd->GetName())] = psd;
 
 	psd = new ColorTexturePSData();
-	m_psSources[psd->GetName()] = psd;
+	m_psSources[Atom(psd->GetName())] = psd;
 }
 
 ShaderLib::~ShaderLib()
@@ -296,49 +315,62 @@ ShaderLib::~ShaderLib()
 	m_vsSources.clear();
 }
 
-std::string ShaderLib::GetEffectName(const std::string& vsName, const std::string& psName)
+uint64_t ShaderLib::GetEffect(Atom vsName, Atom psName)
 {
-	return std::move(vsName + psName);
+	return (static_cast<uint64_t>(vsName.GetID()) << 32) | psName.GetID();
 }
 
-Shader* ShaderLib::GetShaderByName(const std::string& vsName, const std::string& psName)
+Shader* ShaderLib::GetShaderByName(Atom vsName, Atom psName)
 {
-	std::string effectName = GetEffectName(vsName, psName);
-	if (!m_shaders.count(effectName))
-	{
-		if (!BuildShader(effectName, vsName, psName))
-		{
-			return false;
-		}
-	}
-	return m_shaders[effectName];
+	uint64_t effect = GetEffect(vsName, psName);
+	auto itFound = m_shaders.find(effect);
+	if (itFound != m_shaders.end())
+		return itFound->second;
+
+	if (!BuildShader(effect, vsName, psName))
+		return nullptr;
+
+	return m_shaders[effect];
 }
 
-bool ShaderLib::BuildShader(const std::string& effectName, const std::string& vsName, const std::string& psName)
+bool ShaderLib::BuildShader(uint64_t effect, Atom vsName, Atom psName)
 {
-	auto vsData = m_vsSources[vsName];
-	auto psData = m_psSources[psName];
-	if (vsData == nullptr || psData == nullptr)
+	auto itVS = m_vsSources.find(vsName);
+	auto itPS = m_psSources.find(psName);
+	if (itVS == m_vsSources.end() || itPS == m_psSources.end())
 		return false;
 
+	auto vsData = itVS->second;
+	auto psData = itPS->second;
+
 	Shader* shader = new Shader();
 	if (shader->Create(
 		vsData->GetCode(), vsData->GetConstBufferLength(),
 		psData->GetCode(), psData->GetConstBufferLength()))
 	{
-		m_shaders[effectName] = shader;
+		m_shaders[effect] = shader;
 		return true;
 	}
 	delete shader;
 	return false;
 }
 
+Pass::Pass(const char* vsName, const char* psName)
+	: m_vsName(vsName)
+	, m_psName(psName)
+	, m_blendMode(g2d::BlendMode::None)
+{
+	m_drawParams.params[g2d::DrawParam::Tint] = gml::vec4(1.0f, 1.0f, 1.0f, 1.0f);
+	m_drawParams.params[g2d::DrawParam::TexcoordTransform] = gml::vec4(0.0f, 0.0f, 1.0f, 1.0f);
+}
+
 Pass::Pass(const Pass& other)
 	: m_vsName(other.m_vsName)
 	, m_psName(other.m_psName)
 	, m_textures(other.m_textures.size())
 	, m_vsConstants(other.m_vsConstants.size())
 	, m_psConstants(other.m_psConstants.size())
+	, m_drawParams(other.m_drawParams)
 	, m_blendMode(other.m_blendMode)
 {
 	for (size_t i = 0, n = m_textures.size(); i < n; i++)
@@ -378,7 +410,7 @@ bool Pass::IsSame(g2d::Pass* other) const
 	if (!IsSameType(other))
 		return false;
 
-	Pass* p = reinterpret_cast<Pass*>(&other);
+	Pass* p = reinterpret_cast<Pass*>(other);
 
 	if (this == p)
 		return true;
@@ -405,13 +437,13 @@ bool Pass::IsSame(g2d::Pass* other) const
 
 	//we have no idea how to deal with floats.
 	if (m_vsConstants.size() > 0 &&
-		0 != memcmp(&(m_vsConstants[0]), &(p->m_vsConstants[0]), m_vsConstants.size() * sizeof(float)))
+		0 != memcmp(&(m_vsConstants[0]), &(p->m_vsConstants[0]), m_vsConstants.size() * sizeof(gml::vec4)))
 	{
 		return  false;
 	}
 
 	if (m_psConstants.size() > 0 &&
-		0 != memcmp(&(m_psConstants[0]), &(p->m_psConstants[0]), m_psConstants.size() * sizeof(float)))
+		0 != memcmp(&(m_psConstants[0]), &(p->m_psConstants[0]), m_psConstants.size() * sizeof(gml::vec4)))
 	{
 		return false;
 	}
@@ -473,6 +505,18 @@ void Pass::SetPSConstant(uint32_t index, float* data, uint32_t size, uint32_t co
 	}
 }
 
+void Pass::SetDrawParam(uint32_t index, const gml::vec4& param)
+{
+	ENSURE(index < g2d::DrawParam::Count);
+	m_drawParams.params[index] = param;
+}
+
+const gml::vec4& Pass::GetDrawParam(uint32_t index) const
+{
+	ENSURE(index < g2d::DrawParam::Count);
+	return m_drawParams.params[index];
+}
+
 Material::Material(uint32_t passCount)
 	: m_passes(passCount)
 {
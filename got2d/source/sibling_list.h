@@ -0,0 +1,144 @@
+#pragma once
+#include <cinttypes>
+#include "inner_utility.h"
+#include "small_vector.h"
+
+// Items linked by their sibling pointers, so that removing and moving
+// cost constant time. Indices are found again when they are queried
+// after changes, every index is written then.
+// ACCESS provides these for ITEM* item, nullptr is the end of list:
+//   ITEM* Prev(item), ITEM* Next(item), void SetPrev(item, prev),
+//   void SetNext(item, next), uint32_t GetIndex(const ITEM* item),
+//   void SetIndex(item, index)
+template<typename ITEM, typename ACCESS> class SiblingList
+{
+public:
+	explicit SiblingList(ACCESS access = ACCESS()) : m_access(access) { }
+
+	ITEM* First() const { return m_first; }
+
+	ITEM* Last() const { return m_last; }
+
+	uint32_t GetCount() const { return m_count; }
+
+	void Append(ITEM* item)
+	{
+		m_access.SetPrev(item, m_last);
+		m_access.SetNext(item, nullptr);
+		if (m_last == nullptr)
+			m_first = item;
+		else
+			m_access.SetNext(m_last, item);
+		m_last = item;
+		m_count++;
+		m_indicesChanged = true;
+	}
+
+	// false if it's not in the list, or removed already.
+	bool Remove(ITEM* item)
+	{
+		ITEM* prev = m_access.Prev(item);
+		if (prev != nullptr ? m_access.Next(prev) != item : m_first != item)
+			return false;
+
+		Unlink(item);
+		m_count--;
+		return true;
+	}
+
+	// place the item before another one, or at the end if it's
+	// nullptr, false if it's not moved.
+	bool Move(ITEM* item, ITEM* before)
+	{
+		if (before == item || before == m_access.Next(item))
+			return false;
+
+		Unlink(item);
+		if (before == nullptr)
+		{
+			m_access.SetPrev(item, m_last);
+			m_access.SetNext(m_last, item);
+			m_last = item;
+		}
+		else
+		{
+			ITEM* prev = m_access.Prev(before);
+			m_access.SetPrev(item, prev);
+			m_access.SetNext(item, before);
+			m_access.SetPrev(before, item);
+			if (prev == nullptr)
+				m_first = item;
+			else
+				m_access.SetNext(prev, item);
+		}
+		return true;
+	}
+
+	ITEM* At(uint32_t index) const
+	{
+		ENSURE(index < m_count);
+		UpdateIndices();
+		return m_indices[index];
+	}
+
+	uint32_t IndexOf(const ITEM* item) const
+	{
+		UpdateIndices();
+		return m_access.GetIndex(item);
+	}
+
+	// forget all items, they are not changed.
+	void Clear()
+	{
+		m_first = m_last = nullptr;
+		m_count = 0;
+		m_indices.clear();
+		m_indicesChanged = false;
+	}
+
+	// At may be called concurrently after it.
+	void UpdateIndices() const
+	{
+		if (!m_indicesChanged)
+			return;
+
+		m_indices.clear();
+		m_indices.reserve(m_count);
+		uint32_t index = 0;
+		for (ITEM* item = m_first; item != nullptr; item = m_access.Next(item))
+		{
+			m_access.SetIndex(item, index++);
+			m_indices.push_back(item);
+		}
+		m_indicesChanged = false;
+	}
+
+private:
+	void Unlink(ITEM* item)
+	{
+		ITEM* prev = m_access.Prev(item);
+		ITEM* next = m_access.Next(item);
+		if (prev == nullptr)
+			m_first = next;
+		else
+			m_access.SetNext(prev, next);
+
+		if (next == nullptr)
+			m_last = prev;
+		else
+			m_access.SetPrev(next, prev);
+
+		m_access.SetPrev(item, nullptr);
+		m_access.SetNext(item, nullptr);
+		m_indicesChanged = true;
+	}
+
+	ACCESS m_access;
+	ITEM* m_first = nullptr;
+	ITEM* m_last = nullptr;
+	uint32_t m_count = 0;
+	mutable bool m_indicesChanged = false;
+
+	// items by index, most nodes have no child or only one.
+	mutable small_vector<ITEM*, 1> m_indices;
+};
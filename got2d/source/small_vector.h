@@ -0,0 +1,146 @@
+#pragma once
+#include <cinttypes>
+#include <cstddef>
+#include <cstring>
+#include <iterator>
+#include <new>
+#include <type_traits>
+#include <algorithm>
+
+// Replacement of std::vector for lists which are usually short. Up to N
+// elements are stored inline, sharing the room of the heap pointer, so
+// that short lists need no heap block. Interfaces follow std::vector,
+// except that elements must be trivially copyable, they are moved by
+// memcpy, and that inserting or erasing invalidates iterators.
+template<typename T, uint32_t N>
+class small_vector
+{
+	static_assert(N > 0, "inline capacity must not be zero.");
+	static_assert(std::is_trivially_copyable<T>::value, "elements are moved by memcpy.");
+
+public:
+	typedef T value_type;
+	typedef T* iterator;
+	typedef const T* const_iterator;
+	typedef std::reverse_iterator<iterator> reverse_iterator;
+	typedef std::reverse_iterator<const_iterator> const_reverse_iterator;
+
+	small_vector() { }
+
+	small_vector(const small_vector& other) { *this = other; }
+
+	small_vector& operator=(const small_vector& other)
+	{
+		if (this != &other)
+		{
+			clear();
+			reserve(other.m_size);
+			memcpy(data(), other.data(), other.m_size * sizeof(T));
+			m_size = other.m_size;
+		}
+		return *this;
+	}
+
+	~small_vector()
+	{
+		if (!is_inline())
+			::operator delete(m_storage.heap);
+	}
+
+	T* data() { return is_inline() ? reinterpret_cast<T*>(&m_storage.inline_data) : m_storage.heap; }
+
+	const T* data() const { return const_cast<small_vector*>(this)->data(); }
+
+	iterator begin() { return data(); }
+
+	iterator end() { return data() + m_size; }
+
+	const_iterator begin() const { return data(); }
+
+	const_iterator end() const { return data() + m_size; }
+
+	reverse_iterator rbegin() { return reverse_iterator(end()); }
+
+	reverse_iterator rend() { return reverse_iterator(begin()); }
+
+	const_reverse_iterator rbegin() const { return const_reverse_iterator(end()); }
+
+	const_reverse_iterator rend() const { return const_reverse_iterator(begin()); }
+
+	size_t size() const { return m_size; }
+
+	size_t capacity() const { return m_capacity; }
+
+	bool empty() const { return m_size == 0; }
+
+	// it's still on the heap once grown, like std::vector.
+	void clear() { m_size = 0; }
+
+	T& operator[](size_t index) { return data()[index]; }
+
+	const T& operator[](size_t index) const { return data()[index]; }
+
+	T& front() { return data()[0]; }
+
+	const T& front() const { return data()[0]; }
+
+	T& back() { return data()[m_size - 1]; }
+
+	const T& back() const { return data()[m_size - 1]; }
+
+	void reserve(size_t count)
+	{
+		if (count <= m_capacity)
+			return;
+
+		T* elements = static_cast<T*>(::operator new(count * sizeof(T)));
+		memcpy(elements, data(), m_size * sizeof(T));
+		if (!is_inline())
+			::operator delete(m_storage.heap);
+
+		m_storage.heap = elements;
+		m_capacity = static_cast<uint32_t>(count);
+	}
+
+	void push_back(const T& element)
+	{
+		if (m_size == m_capacity)
+		{
+			// element may be in the list.
+			T copied = element;
+			reserve(m_capacity * 2);
+			new (data() + m_size) T(copied);
+		}
+		else
+		{
+			new (data() + m_size) T(element);
+		}
+		m_size++;
+	}
+
+	void pop_back() { m_size--; }
+
+	iterator erase(const_iterator position) { return erase(position, position + 1); }
+
+	iterator erase(const_iterator first, const_iterator last)
+	{
+		T* elements = data();
+		size_t index = first - elements;
+		size_t count = last - first;
+		memmove(elements + index, elements + index + count, (m_size - index - count) * sizeof(T));
+		m_size -= static_cast<uint32_t>(count);
+		return elements + index;
+	}
+
+private:
+	// heap capacity is always greater than N.
+	bool is_inline() const { return m_capacity == N; }
+
+	union storage
+	{
+		T* heap;
+		typename std::aligned_storage<sizeof(T) * N, alignof(T)>::type inline_data;
+	} m_storage;
+	uint32_t m_size = 0;
+	uint32_t m_capacity = N;
+};
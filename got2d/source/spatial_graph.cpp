@@ -178,7 +178,22 @@ void SpatialGraph::Add(g2d::Component& component)
 	if (Is<::Camera>(component)) return;
 
 	Remove(component);
+	Link(component);
+}
 
+void SpatialGraph::AddRange(g2d::Component* const* components, uint32_t count)
+{
+	// nothing to remove, and links are rehashed once.
+	m_linkRef.reserve(m_linkRef.size() + count);
+	for (uint32_t i = 0; i < count; i++)
+	{
+		if (!Is<::Camera>(*components[i]))
+			Link(*components[i]);
+	}
+}
+
+void SpatialGraph::Link(g2d::Component& component)
+{
 	QuadTreeNode* node = nullptr;
 	if (component.GetSceneNode()->IsStatic())
 	{
@@ -197,11 +212,11 @@ void SpatialGraph::Remove(g2d::Component& component)
 {
 	if (Is<::Camera>(component)) return;
 
-	if (m_linkRef.count(&component))
+	auto itFound = m_linkRef.find(&component);
+	if (itFound != m_linkRef.end())
 	{
-		auto& node = m_linkRef[&component];
-		node->Remove(component);
-		m_linkRef.erase(&component);
+		itFound->second->Remove(component);
+		m_linkRef.erase(itFound);
 	}
 }
 
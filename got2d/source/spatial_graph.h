@@ -4,6 +4,7 @@
 #include <gml/gmlaabb.h>
 #include "inner_utility.h"
 #include "scope_utility.h"
+#include "flat_map.h"
 
 class Camera;
 
@@ -56,11 +57,17 @@ public:
 
 	void Add(g2d::Component& component);
 
+	// components must not be in the graph yet, e.g. of loaded nodes.
+	void AddRange(g2d::Component* const* components, uint32_t count);
+
 	void Remove(g2d::Component& component);
 
 	void FindVisible(Camera& camera);
 
 private:
+	// place the component, it must not be in the graph.
+	void Link(g2d::Component& component);
+
 	autod<QuadTreeNode> m_root;
-	std::map<g2d::Component*, QuadTreeNode*> m_linkRef;
+	flat_hash_map<g2d::Component*, QuadTreeNode*> m_linkRef;
 };
@@ -1,15 +1,41 @@
+#include <algorithm>
 #include "engine.h"
 #include "render_system.h"
+#include "pixel_format.h"
+#include "hash.h"
 
 g2d::Texture* g2d::Texture::LoadFromFile(const char* path)
 {
-	std::string resourcePath = ::GetEngineImpl()->GetResourceRoot() + path;
+	// textures are identified by resource names, files are located by FileSystem.
+	std::string resourcePath = FileSystem::NormalizePath(path);
 	return ::GetRenderSystem()->CreateTextureFromFile(resourcePath.c_str());
 }
 
-Texture::Texture(std::string resPath) : m_resPath(std::move(resPath))
+void g2d::Texture::Preload(const char** paths, uint32_t count, PreloadCallback callback, void* userData)
 {
+	std::vector<Atom> resources;
+	for (uint32_t i = 0; i < count; i++)
+	{
+		resources.push_back(Atom(FileSystem::NormalizePath(paths[i])));
+	}
+	::GetRenderSystem()->GetTexturePool().Preload(std::move(resources), callback, userData);
+}
+
+Texture::Texture(Atom resource) : m_resource(resource)
+{
+	// default texture is never evicted.
+	if (!m_resource.IsEmpty() && ::GetRenderSystem() != nullptr)
+	{
+		::GetRenderSystem()->GetTexturePool().AddReference(m_resource);
+	}
+}
 
+Texture::~Texture()
+{
+	if (!m_resource.IsEmpty() && ::GetRenderSystem() != nullptr)
+	{
+		::GetRenderSystem()->GetTexturePool().RemoveReference(m_resource);
+	}
 }
 
 bool Texture::IsSame(g2d::Texture* other) const
@@ -21,8 +47,10 @@ bool Texture::IsSame(g2d::Texture* other) const
 	if (!same_type(other, this))
 		return false;
 
+	// textures of identical content share GPU resource, and can be batched.
 	Texture* timpl = reinterpret_cast<Texture*>(other);
-	return timpl->m_resPath == m_resPath;
+	return timpl->m_resource == m_resource ||
+		::GetRenderSystem()->GetTexturePool().IsSameTexture(timpl->m_resource, m_resource);
 }
 
 void Texture::AddRef()
@@ -81,6 +109,73 @@ bool Texture2D::Create(uint32_t width, uint32_t height)
 	m_shaderView = std::move(shaderResourceViewPtr);
 	m_width = width;
 	m_height = height;
+	m_memoryBytes = static_cast<uint64_t>(width) * height * 4;
+	return true;
+}
+
+DXGI_FORMAT ToDXGIFormat(TextureFormat format)
+{
+	switch (format)
+	{
+	case TextureFormat::BC1: return DXGI_FORMAT_BC1_UNORM;
+	case TextureFormat::BC3: return DXGI_FORMAT_BC3_UNORM;
+	case TextureFormat::BC7: return DXGI_FORMAT_BC7_UNORM;
+	default: return DXGI_FORMAT_R8G8B8A8_UNORM;
+	}
+}
+
+bool Texture2D::Create(const TextureContainer& container)
+{
+	if (container.mips.empty())
+		return false;
+
+	std::vector<D3D11_SUBRESOURCE_DATA> initData(container.mips.size());
+	for (size_t i = 0; i < container.mips.size(); i++)
+	{
+		initData[i].pSysMem = container.mips[i].data;
+		initData[i].SysMemPitch = container.mips[i].rowPitch;
+		initData[i].SysMemSlicePitch = container.mips[i].dataSize;
+	}
+
+	autor<ID3D11Texture2D> texturePtr = nullptr;
+	autor<ID3D11ShaderResourceView> shaderResourceViewPtr = nullptr;
+
+	D3D11_TEXTURE2D_DESC texDesc;
+
+	texDesc.Width = container.width;
+	texDesc.Height = container.height;
+	texDesc.MipLevels = static_cast<UINT>(container.mips.size());
+	texDesc.ArraySize = 1;
+	texDesc.Format = ToDXGIFormat(container.format);
+	texDesc.SampleDesc.Count = 1;
+	texDesc.SampleDesc.Quality = 0;
+	texDesc.Usage = D3D11_USAGE_IMMUTABLE;
+	texDesc.BindFlags = D3D11_BIND_SHADER_RESOURCE;
+	texDesc.CPUAccessFlags = 0;
+	texDesc.MiscFlags = 0;
+
+	if (S_OK != GetRenderSystem()->GetDevice()->CreateTexture2D(&texDesc, initData.data(), &(texturePtr.pointer)))
+	{
+		return false;
+	}
+
+	D3D11_SHADER_RESOURCE_VIEW_DESC viewDesc;
+	::ZeroMemory(&viewDesc, sizeof(viewDesc));
+	viewDesc.Format = texDesc.Format;
+	viewDesc.ViewDimension = D3D_SRV_DIMENSION_TEXTURE2D;
+	viewDesc.Texture2D.MipLevels = -1;
+	viewDesc.Texture2D.MostDetailedMip = 0;
+
+	if (S_OK != GetRenderSystem()->GetDevice()->CreateShaderResourceView(texturePtr.pointer, &viewDesc, &(shaderResourceViewPtr.pointer)))
+	{
+		return false;
+	}
+
+	m_texture = std::move(texturePtr);
+	m_shaderView = std::move(shaderResourceViewPtr);
+	m_width = container.width;
+	m_height = container.height;
+	m_memoryBytes = container.GetDataBytes();
 	return true;
 }
 
@@ -90,33 +185,30 @@ void Texture2D::UploadImage(uint8_t* data, bool hasAlpha)
 	if (S_OK == GetRenderSystem()->GetContext()->Map(m_texture, 0, D3D11_MAP_WRITE_DISCARD, 0, &mappedRes))
 	{
 		uint8_t* colorBuffer = static_cast<uint8_t*>(mappedRes.pData);
-		if (hasAlpha)
-		{
-			int srcPitch = m_width * 4;
-			for (uint32_t i = 0; i < m_height; i++)
-			{
-				auto dstPtr = colorBuffer + i * mappedRes.RowPitch;
-				auto srcPtr = data + i * srcPitch;
-				memcpy(dstPtr, srcPtr, srcPitch);
-			}
-		}
-		else
+		uint32_t srcPitch = m_width * (hasAlpha ? 4 : 3);
+		uint32_t dstPitch = mappedRes.RowPitch;
+		uint32_t width = m_width;
+
+		// large images are converted in row blocks on multiple threads.
+		ParallelRows(m_height, srcPitch, [=](uint32_t rowBegin, uint32_t rowEnd)
 		{
-			int srcPitch = m_width * 3;
-			for (uint32_t i = 0; i < m_height; i++)
+			for (uint32_t i = rowBegin; i < rowEnd; i++)
 			{
-				auto dstPtr = colorBuffer + i * mappedRes.RowPitch;
+				auto dstPtr = colorBuffer + i * dstPitch;
 				auto srcPtr = data + i * srcPitch;
-				for (uint32_t j = 0; j < m_width; j++)
+				if (hasAlpha)
+				{
+					memcpy(dstPtr, srcPtr, srcPitch);
+				}
+				else
 				{
-					memcpy(dstPtr + j * 4, srcPtr + j * 3, 3);
-					dstPtr[3 + j * 4] = 255;
+					ExpandRGBToRGBA(srcPtr, dstPtr, width);
 				}
 			}
-		}
+		});
 
+		// texture has only one mip level, GenerateMips is not needed.
 		GetRenderSystem()->GetContext()->Unmap(m_texture, 0);
-		GetRenderSystem()->GetContext()->GenerateMips(m_shaderView);
 	}
 }
 
@@ -126,10 +218,10 @@ void Texture2D::Destroy()
 	m_shaderView.release();
 	m_width = 0;
 	m_height = 0;
+	m_memoryBytes = 0;
 }
 
 #include "engine.h"
-#include "file_data.h"
 #include "img_data.h"
 
 bool TexturePool::CreateDefaultTexture()
@@ -142,61 +234,484 @@ bool TexturePool::CreateDefaultTexture()
 			255,255,255,0,0,0
 		};
 		m_defaultTexture.UploadImage(boardData, false);
-		m_textures.insert(std::make_pair<>("", &m_defaultTexture));
+		m_textures.insert(std::make_pair(Atom(), &m_defaultTexture));
 		return true;
 	}
 	m_defaultTexture.Destroy();
 	return false;
 }
 
-bool TexturePool::LoadTextureFromFile(std::string resourcePath)
+void TexturePool::StartStreaming(uint32_t workerCount, uint32_t uploadBudget)
 {
-	file_data f;
-	if (!load_file(resourcePath.c_str(), f))
-		return false;
+	StopStreaming();
+	m_uploadBudget = uploadBudget;
+	m_quit = false;
+	for (uint32_t i = 0; i < workerCount; i++)
+	{
+		m_workers.push_back(std::thread([this] { DecodeLoop(); }));
+	}
+}
+
+void TexturePool::StopStreaming()
+{
+	// unsubmitted reads are dropped, submitted ones must finish
+	// before workers quit, since their callbacks enqueue decoding.
+	for (auto& request : m_readBatch)
+	{
+		delete static_cast<ReadingJob*>(request.userData);
+	}
+	m_readBatch.clear();
+	::GetEngineImpl()->GetAsyncIO().WaitIdle();
+
+	{
+		std::lock_guard<std::mutex> lock(m_jobMutex);
+		m_quit = true;
+		m_jobs.clear();
+	}
+	m_jobCondition.notify_all();
+	for (auto& worker : m_workers)
+	{
+		worker.join();
+	}
+	m_workers.clear();
+
+	for (auto& decoded : m_decoded)
+	{
+		if (decoded.succeeded)
+		{
+			DestroyTextureData(decoded.data);
+		}
+	}
+	m_decoded.clear();
+	m_pending.clear();
+	m_preloads.clear();
+}
+
+uint64_t TextureData::GetUploadBytes() const
+{
+	if (isContainer)
+		return container.GetDataBytes();
+	else
+		return static_cast<uint64_t>(image.width) * image.height * 4;
+}
+
+bool DecodeTextureFromFile(const std::string& resourcePath, TextureData& data)
+{
+	// file view points into mapped pack when the resource is packed.
+	return ::GetEngineImpl()->GetFileSystem().ReadFile(resourcePath, data.file) &&
+		DecodeTextureData(resourcePath, data);
+}
+
+TextureContent HashTextureData(const TextureData& data)
+{
+	// size and format are part of content, so that the same
+	// bytes in different layouts never share a texture.
+	TextureContent content;
+	uint32_t* layout = content.layout;
+	if (data.isContainer)
+	{
+		const TextureContainer& container = data.container;
+		layout[0] = 1;
+		layout[1] = static_cast<uint32_t>(container.format);
+		layout[2] = container.width;
+		layout[3] = container.height;
+		layout[4] = static_cast<uint32_t>(container.mips.size());
+	}
+	else
+	{
+		const img_data& image = data.image;
+		layout[1] = image.has_alpha ? 4u : 3u;
+		layout[2] = image.width;
+		layout[3] = image.height;
+		layout[4] = 1;
+	}
 
-	img_data img;
-	auto result = true;
+	content.hash = HashBytes(layout, sizeof(content.layout));
+	content.check = CheckHashBytes(layout, sizeof(content.layout));
+	if (data.isContainer)
+	{
+		for (auto& mip : data.container.mips)
+		{
+			content.hash = HashBytes(mip.data, mip.dataSize, content.hash);
+			content.check = CheckHashBytes(mip.data, mip.dataSize, content.check);
+		}
+	}
+	else
+	{
+		size_t size = static_cast<size_t>(layout[2]) * layout[3] * layout[1];
+		content.hash = HashBytes(data.image.raw_data, size, content.hash);
+		content.check = CheckHashBytes(data.image.raw_data, size, content.check);
+	}
+	return content;
+}
 
-	result = read_image(f.buffer, img);
-	destroy_file_data(f);
+bool DecodeTextureData(const std::string& resourcePath, TextureData& data)
+{
+	bool result = false;
+	if (IsTextureContainerFile(resourcePath.c_str()))
+	{
+		data.isContainer = true;
+		result = ParseTextureContainer(resourcePath.c_str(), data.file.GetData(), data.file.GetSize(), data.container);
+	}
+	else
+	{
+		result = read_image(const_cast<uint8_t*>(data.file.GetData()), data.image);
+		data.file.Release();
+	}
 
 	if (result)
 	{
-		auto tex = new ::Texture2D();
-		result = tex->Create(img.width, img.height);
-		if (result)
+		data.content = HashTextureData(data);
+	}
+	return result;
+}
+
+void DestroyTextureData(TextureData& data)
+{
+	if (data.isContainer)
+	{
+		data.file.Release();
+		data.container.mips.clear();
+	}
+	else
+	{
+		destroy_img_data(data.image);
+	}
+}
+
+void TexturePool::DecodeLoop()
+{
+	while (true)
+	{
+		DecodedImage decoded;
+		{
+			std::unique_lock<std::mutex> lock(m_jobMutex);
+			m_jobCondition.wait(lock, [this] { return m_quit || !m_jobs.empty(); });
+			if (m_quit)
+				return;
+
+			decoded = std::move(m_jobs.front());
+			m_jobs.pop_front();
+		}
+
+		decoded.succeeded = decoded.fileLoaded && DecodeTextureData(decoded.resource.GetString(), decoded.data);
+
+		std::lock_guard<std::mutex> lock(m_decodedMutex);
+		m_decoded.push_back(std::move(decoded));
+	}
+}
+
+void TexturePool::RequestLoading(Atom resource)
+{
+	if (!m_pending.insert(resource).second)
+		return;
+
+	auto job = new ReadingJob();
+	job->pool = this;
+	job->image.resource = resource;
+
+	IORequest request;
+	auto location = ::GetEngineImpl()->GetFileSystem().PrepareRead(resource.GetString(), job->image.data.file, request);
+	if (location == FileLocation::Loose)
+	{
+		request.callback = OnFileRead;
+		request.userData = job;
+		m_readBatch.push_back(std::move(request));
+		return;
+	}
+
+	// packed resources are mapped already, missing ones fail in decoding.
+	job->image.fileLoaded = (location == FileLocation::Packed);
+	EnqueueDecoding(std::move(job->image));
+	delete job;
+}
+
+void TexturePool::FlushReads()
+{
+	::GetEngineImpl()->GetAsyncIO().Submit(m_readBatch);
+}
+
+void TexturePool::OnFileRead(void* userData, bool succeeded)
+{
+	auto job = static_cast<ReadingJob*>(userData);
+	job->image.fileLoaded = succeeded;
+	job->pool->EnqueueDecoding(std::move(job->image));
+	delete job;
+}
+
+void TexturePool::EnqueueDecoding(DecodedImage&& image)
+{
+	{
+		std::lock_guard<std::mutex> lock(m_jobMutex);
+		m_jobs.push_back(std::move(image));
+	}
+	m_jobCondition.notify_one();
+}
+
+bool TexturePool::CreateTexture(Atom resource, TextureData& data)
+{
+	// equal layout and both hashes, not the bucket key alone.
+	auto itContent = m_contents.find(data.content);
+	if (itContent != m_contents.end())
+	{
+		itContent->second->m_lastUsedFrame = m_frame;
+		m_textures[resource] = itContent->second;
+		m_statistics.dedupCount++;
+		if (m_evicted.erase(resource) > 0)
 		{
-			tex->UploadImage(img.raw_data, img.has_alpha);
-			m_textures[resourcePath] = tex;
+			m_statistics.reloadCount++;
 		}
-		destroy_img_data(img);
-		return result;
+		return true;
 	}
+
+	auto tex = new ::Texture2D();
+	bool created = false;
+	if (data.isContainer)
+	{
+		created = tex->Create(data.container);
+	}
+	else if (tex->Create(data.image.width, data.image.height))
+	{
+		tex->UploadImage(data.image.raw_data, data.image.has_alpha);
+		created = true;
+	}
+
+	if (created)
+	{
+		tex->m_lastUsedFrame = m_frame;
+		tex->m_content = data.content;
+		m_textures[resource] = tex;
+		m_contents[data.content] = tex;
+		m_statistics.residentBytes += tex->GetMemoryBytes();
+		m_statistics.residentCount++;
+		if (m_evicted.erase(resource) > 0)
+		{
+			m_statistics.reloadCount++;
+		}
+		return true;
+	}
+	delete tex;
 	return false;
 }
 
+bool TexturePool::LoadTextureFromFile(Atom resource)
+{
+	TextureData data;
+	if (!DecodeTextureFromFile(resource.GetString(), data))
+		return false;
+
+	auto result = CreateTexture(resource, data);
+	DestroyTextureData(data);
+	return result;
+}
+
+void TexturePool::Update()
+{
+	m_frame++;
+	FlushReads();
+	uint32_t uploadedBytes = 0;
+	while (true)
+	{
+		DecodedImage decoded;
+		{
+			std::lock_guard<std::mutex> lock(m_decodedMutex);
+			// at least one image each frame, so that 
+			// images larger than budget can be uploaded.
+			if (m_decoded.empty() || (uploadedBytes > 0 && uploadedBytes >= m_uploadBudget))
+				break;
+
+			decoded = std::move(m_decoded.front());
+			m_decoded.pop_front();
+		}
+
+		m_pending.erase(decoded.resource);
+		if (decoded.succeeded)
+		{
+			uploadedBytes += static_cast<uint32_t>(decoded.data.GetUploadBytes());
+			if (!CreateTexture(decoded.resource, decoded.data))
+			{
+				m_failed.insert(decoded.resource);
+			}
+			DestroyTextureData(decoded.data);
+		}
+		else
+		{
+			m_failed.insert(decoded.resource);
+		}
+	}
+
+	CheckPreloads();
+	EvictTextures();
+}
+
+void TexturePool::AddReference(Atom resource)
+{
+	m_references[resource]++;
+}
+
+void TexturePool::RemoveReference(Atom resource)
+{
+	auto itFound = m_references.find(resource);
+	if (itFound != m_references.end() && --(itFound->second) == 0)
+	{
+		m_references.erase(itFound);
+	}
+}
+
+void TexturePool::EvictTextures()
+{
+	if (m_memoryBudget == 0 || m_statistics.residentBytes <= m_memoryBudget)
+		return;
+
+	// names sharing a texture are evicted together.
+	std::map<Texture2D*, std::vector<Atom>> aliases;
+	for (auto& t : m_textures)
+	{
+		if (t.second != &m_defaultTexture)
+		{
+			aliases[t.second].push_back(t.first);
+		}
+	}
+
+	// textures used in this frame or still referenced by any name can not be evicted.
+	std::vector<std::pair<uint32_t, Texture2D*>> candidates;
+	for (auto& a : aliases)
+	{
+		if (a.first->m_lastUsedFrame < m_frame &&
+			std::none_of(a.second.begin(), a.second.end(),
+				[this](Atom r) { return m_references.count(r) > 0; }))
+		{
+			candidates.push_back({ a.first->m_lastUsedFrame, a.first });
+		}
+	}
+	std::sort(candidates.begin(), candidates.end());
+
+	for (auto& candidate : candidates)
+	{
+		if (m_statistics.residentBytes <= m_memoryBudget)
+			break;
+
+		auto tex = candidate.second;
+		m_statistics.residentBytes -= tex->GetMemoryBytes();
+		m_statistics.residentCount--;
+		m_statistics.evictionCount++;
+		for (auto& resource : aliases[tex])
+		{
+			m_textures.erase(resource);
+			m_evicted.insert(resource);
+		}
+		m_contents.erase(tex->m_content);
+		tex->Destroy();
+		delete tex;
+	}
+}
+
+void TexturePool::Preload(std::vector<Atom> resources, g2d::Texture::PreloadCallback callback, void* userData)
+{
+	for (auto& resource : resources)
+	{
+		if (m_textures.count(resource) == 0 && m_failed.count(resource) == 0)
+		{
+			if (m_workers.empty())
+			{
+				if (!LoadTextureFromFile(resource))
+				{
+					m_failed.insert(resource);
+				}
+			}
+			else
+			{
+				RequestLoading(resource);
+			}
+		}
+	}
+	m_preloads.push_back({ std::move(resources), callback, userData });
+	FlushReads();
+}
+
+void TexturePool::CheckPreloads()
+{
+	// callbacks may issue new preloading requests,
+	// so pick finished ones out before invoking.
+	std::vector<PreloadRequest> finished;
+	auto itCur = m_preloads.begin();
+	while (itCur != m_preloads.end())
+	{
+		bool allDone = std::all_of(itCur->resources.begin(), itCur->resources.end(),
+			[this](Atom r) { return m_textures.count(r) > 0 || m_failed.count(r) > 0; });
+		if (allDone)
+		{
+			finished.push_back(std::move(*itCur));
+			itCur = m_preloads.erase(itCur);
+		}
+		else
+		{
+			itCur++;
+		}
+	}
+
+	for (auto& request : finished)
+	{
+		if (request.callback)
+		{
+			request.callback(request.userData);
+		}
+	}
+}
+
 void TexturePool::Destroy()
 {
-	m_textures.erase("");
+	StopStreaming();
 	m_defaultTexture.Destroy();
-	for (auto& t : m_textures)
+	for (auto& t : m_contents)
 	{
 		t.second->Destroy();
 		delete t.second;
 	}
+	m_contents.clear();
 	m_textures.clear();
+	m_failed.clear();
+	m_references.clear();
+	m_evicted.clear();
+	m_statistics = g2d::TextureStatistics();
 }
 
-Texture2D* TexturePool::GetTexture(const std::string& resource)
+bool TexturePool::IsSameTexture(Atom resource, Atom otherResource) const
 {
-	if (m_textures.count(resource) == 0)
+	if (resource == otherResource)
+		return true;
+
+	auto itFound = m_textures.find(resource);
+	auto itOther = m_textures.find(otherResource);
+	return itFound != m_textures.end() && itOther != m_textures.end() &&
+		itFound->second == itOther->second;
+}
+
+Texture2D* TexturePool::GetTexture(Atom resource)
+{
+	auto itFound = m_textures.find(resource);
+	if (itFound != m_textures.end())
+	{
+		itFound->second->m_lastUsedFrame = m_frame;
+		return itFound->second;
+	}
+
+	if (m_failed.count(resource) > 0)
+	{
+		return nullptr;
+	}
+
+	if (m_workers.empty())
 	{
 		if (!LoadTextureFromFile(resource))
 		{
+			m_failed.insert(resource);
 			return nullptr;
 		}
+		return m_textures[resource];
 	}
 
-	return m_textures[resource];
+	// use default texture until decoding finished.
+	RequestLoading(resource);
+	return &m_defaultTexture;
 }
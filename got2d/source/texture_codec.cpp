@@ -0,0 +1,952 @@
+#include <algorithm>
+#include <cstring>
+#include <cmath>
+#include <cctype>
+#include "texture_codec.h"
+#include "pixel_format.h"
+
+namespace
+{
+	constexpr uint32_t BLOCK_PIXELS = 16;
+
+	inline int ClampByte(int v) { return std::min(255, std::max(0, v)); }
+
+	// gather 4x4 pixels of block(bx,by), edges are clamped.
+	void FetchBlock(const uint8_t* rgba, uint32_t width, uint32_t height, uint32_t bx, uint32_t by, uint8_t block[BLOCK_PIXELS * 4])
+	{
+		for (uint32_t y = 0; y < 4; y++)
+		{
+			uint32_t sy = std::min(by * 4 + y, height - 1);
+			for (uint32_t x = 0; x < 4; x++)
+			{
+				uint32_t sx = std::min(bx * 4 + x, width - 1);
+				memcpy(block + (y * 4 + x) * 4, rgba + (sy * width + sx) * 4, 4);
+			}
+		}
+	}
+
+	// principal axis of block colors, found by power iteration.
+	// channelCount is 3 for RGB and 4 for RGBA.
+	void FindPrincipalAxis(const uint8_t* block, uint32_t channelCount, float mean[4], float axis[4])
+	{
+		for (uint32_t c = 0; c < 4; c++)
+		{
+			mean[c] = 0.0f;
+			axis[c] = 0.0f;
+		}
+		for (uint32_t i = 0; i < BLOCK_PIXELS; i++)
+		{
+			for (uint32_t c = 0; c < channelCount; c++)
+				mean[c] += block[i * 4 + c];
+		}
+		for (uint32_t c = 0; c < channelCount; c++)
+			mean[c] /= BLOCK_PIXELS;
+
+		float cov[4][4] = {};
+		for (uint32_t i = 0; i < BLOCK_PIXELS; i++)
+		{
+			float d[4];
+			for (uint32_t c = 0; c < channelCount; c++)
+				d[c] = block[i * 4 + c] - mean[c];
+			for (uint32_t r = 0; r < channelCount; r++)
+			{
+				for (uint32_t c = 0; c < channelCount; c++)
+					cov[r][c] += d[r] * d[c];
+			}
+		}
+
+		float v[4] = { 1.0f, 1.0f, 1.0f, 1.0f };
+		for (int iteration = 0; iteration < 8; iteration++)
+		{
+			float w[4] = {};
+			float length = 0.0f;
+			for (uint32_t r = 0; r < channelCount; r++)
+			{
+				for (uint32_t c = 0; c < channelCount; c++)
+					w[r] += cov[r][c] * v[c];
+				length = std::max(length, std::fabs(w[r]));
+			}
+			if (length < 1e-6f)
+				return;
+			for (uint32_t c = 0; c < channelCount; c++)
+				v[c] = w[c] / length;
+		}
+		for (uint32_t c = 0; c < channelCount; c++)
+			axis[c] = v[c];
+	}
+
+	// project block onto principal axis, and return extreme points.
+	void FindEndpoints(const uint8_t* block, uint32_t channelCount, float minPoint[4], float maxPoint[4])
+	{
+		float mean[4], axis[4];
+		FindPrincipalAxis(block, channelCount, mean, axis);
+
+		float minT = 0.0f, maxT = 0.0f;
+		for (uint32_t i = 0; i < BLOCK_PIXELS; i++)
+		{
+			float t = 0.0f;
+			for (uint32_t c = 0; c < channelCount; c++)
+				t += (block[i * 4 + c] - mean[c]) * axis[c];
+			minT = std::min(minT, t);
+			maxT = std::max(maxT, t);
+		}
+
+		float axisLength = 0.0f;
+		for (uint32_t c = 0; c < channelCount; c++)
+			axisLength += axis[c] * axis[c];
+		if (axisLength > 0.0f)
+		{
+			minT /= axisLength;
+			maxT /= axisLength;
+		}
+		for (uint32_t c = 0; c < channelCount; c++)
+		{
+			minPoint[c] = std::min(255.0f, std::max(0.0f, mean[c] + axis[c] * minT));
+			maxPoint[c] = std::min(255.0f, std::max(0.0f, mean[c] + axis[c] * maxT));
+		}
+	}
+
+	uint16_t PackRGB565(const float color[3])
+	{
+		uint32_t r = static_cast<uint32_t>(color[0] * 31.0f / 255.0f + 0.5f);
+		uint32_t g = static_cast<uint32_t>(color[1] * 63.0f / 255.0f + 0.5f);
+		uint32_t b = static_cast<uint32_t>(color[2] * 31.0f / 255.0f + 0.5f);
+		return static_cast<uint16_t>((std::min(r, 31u) << 11) | (std::min(g, 63u) << 5) | std::min(b, 31u));
+	}
+
+	void UnpackRGB565(uint16_t packed, int color[3])
+	{
+		int r = (packed >> 11) & 31;
+		int g = (packed >> 5) & 63;
+		int b = packed & 31;
+		color[0] = (r << 3) | (r >> 2);
+		color[1] = (g << 2) | (g >> 4);
+		color[2] = (b << 3) | (b >> 2);
+	}
+
+	int ColorDistance(const uint8_t* pixel, const int* color, uint32_t channelCount)
+	{
+		int distance = 0;
+		for (uint32_t c = 0; c < channelCount; c++)
+		{
+			int d = pixel[c] - color[c];
+			distance += d * d;
+		}
+		return distance;
+	}
+
+	void WriteUint16(uint8_t* out, uint16_t v)
+	{
+		out[0] = static_cast<uint8_t>(v);
+		out[1] = static_cast<uint8_t>(v >> 8);
+	}
+
+	// pick indices of 4-color palette, return total error.
+	int SelectBC1Indices(const uint8_t* block, uint16_t color0, uint16_t color1, uint8_t indices[BLOCK_PIXELS])
+	{
+		int palette[4][3];
+		UnpackRGB565(color0, palette[0]);
+		UnpackRGB565(color1, palette[1]);
+		for (int c = 0; c < 3; c++)
+		{
+			palette[2][c] = (2 * palette[0][c] + palette[1][c]) / 3;
+			palette[3][c] = (palette[0][c] + 2 * palette[1][c]) / 3;
+		}
+
+		int totalError = 0;
+		for (uint32_t i = 0; i < BLOCK_PIXELS; i++)
+		{
+			int bestIndex = 0;
+			int bestDistance = ColorDistance(block + i * 4, palette[0], 3);
+			for (int p = 1; p < 4; p++)
+			{
+				int distance = ColorDistance(block + i * 4, palette[p], 3);
+				if (distance < bestDistance)
+				{
+					bestDistance = distance;
+					bestIndex = p;
+				}
+			}
+			indices[i] = static_cast<uint8_t>(bestIndex);
+			totalError += bestDistance;
+		}
+		return totalError;
+	}
+
+	// least squares endpoints for fixed indices, return false if singular.
+	bool RefineBC1Endpoints(const uint8_t* block, const uint8_t indices[BLOCK_PIXELS], float color0[3], float color1[3])
+	{
+		const float weights[4] = { 1.0f, 0.0f, 2.0f / 3.0f, 1.0f / 3.0f };
+		float aa = 0.0f, bb = 0.0f, ab = 0.0f;
+		float ax[3] = {}, bx[3] = {};
+		for (uint32_t i = 0; i < BLOCK_PIXELS; i++)
+		{
+			float a = weights[indices[i]];
+			float b = 1.0f - a;
+			aa += a * a;
+			bb += b * b;
+			ab += a * b;
+			for (int c = 0; c < 3; c++)
+			{
+				ax[c] += a * block[i * 4 + c];
+				bx[c] += b * block[i * 4 + c];
+			}
+		}
+
+		float det = aa * bb - ab * ab;
+		if (std::fabs(det) < 1e-6f)
+			return false;
+
+		for (int c = 0; c < 3; c++)
+		{
+			color0[c] = std::min(255.0f, std::max(0.0f, (ax[c] * bb - bx[c] * ab) / det));
+			color1[c] = std::min(255.0f, std::max(0.0f, (bx[c] * aa - ax[c] * ab) / det));
+		}
+		return true;
+	}
+
+	void EncodeBC1Block(const uint8_t* block, uint8_t* out)
+	{
+		float minPoint[4], maxPoint[4];
+		FindEndpoints(block, 3, minPoint, maxPoint);
+
+		uint16_t color0 = PackRGB565(maxPoint);
+		uint16_t color1 = PackRGB565(minPoint);
+		uint8_t indices[BLOCK_PIXELS] = {};
+		int error = 0;
+		if (color0 != color1)
+		{
+			// color0 > color1 selects 4-color mode, which is
+			// also the only mode allowed in BC3 color block.
+			if (color0 < color1)
+				std::swap(color0, color1);
+			error = SelectBC1Indices(block, color0, color1, indices);
+
+			float refined0[3], refined1[3];
+			if (error > 0 && RefineBC1Endpoints(block, indices, refined0, refined1))
+			{
+				uint16_t newColor0 = PackRGB565(refined0);
+				uint16_t newColor1 = PackRGB565(refined1);
+				if (newColor0 < newColor1)
+					std::swap(newColor0, newColor1);
+				uint8_t newIndices[BLOCK_PIXELS];
+				if (newColor0 != newColor1 && SelectBC1Indices(block, newColor0, newColor1, newIndices) < error)
+				{
+					color0 = newColor0;
+					color1 = newColor1;
+					memcpy(indices, newIndices, BLOCK_PIXELS);
+				}
+			}
+		}
+
+		uint32_t packedIndices = 0;
+		for (uint32_t i = 0; i < BLOCK_PIXELS; i++)
+			packedIndices |= static_cast<uint32_t>(indices[i]) << (i * 2);
+
+		WriteUint16(out, color0);
+		WriteUint16(out + 2, color1);
+		WriteUint16(out + 4, static_cast<uint16_t>(packedIndices));
+		WriteUint16(out + 6, static_cast<uint16_t>(packedIndices >> 16));
+	}
+
+	void EncodeAlphaBlock(const uint8_t* block, uint8_t* out)
+	{
+		int alpha0 = 0, alpha1 = 255;
+		for (uint32_t i = 0; i < BLOCK_PIXELS; i++)
+		{
+			alpha0 = std::max<int>(alpha0, block[i * 4 + 3]);
+			alpha1 = std::min<int>(alpha1, block[i * 4 + 3]);
+		}
+
+		// alpha0 > alpha1 selects 8-alpha mode.
+		int palette[8] = { alpha0, alpha1 };
+		for (int p = 1; p < 7; p++)
+			palette[p + 1] = ((7 - p) * alpha0 + p * alpha1) / 7;
+
+		uint64_t packedIndices = 0;
+		if (alpha0 != alpha1)
+		{
+			for (uint32_t i = 0; i < BLOCK_PIXELS; i++)
+			{
+				int alpha = block[i * 4 + 3];
+				uint64_t bestIndex = 0;
+				int bestDistance = 256;
+				for (int p = 0; p < 8; p++)
+				{
+					int distance = std::abs(alpha - palette[p]);
+					if (distance < bestDistance)
+					{
+						bestDistance = distance;
+						bestIndex = p;
+					}
+				}
+				packedIndices |= bestIndex << (i * 3);
+			}
+		}
+
+		out[0] = static_cast<uint8_t>(alpha0);
+		out[1] = static_cast<uint8_t>(alpha1);
+		for (int b = 0; b < 6; b++)
+			out[2 + b] = static_cast<uint8_t>(packedIndices >> (b * 8));
+	}
+
+	void EncodeBC3Block(const uint8_t* block, uint8_t* out)
+	{
+		EncodeAlphaBlock(block, out);
+		EncodeBC1Block(block, out + 8);
+	}
+
+	class BitWriter
+	{
+	public:
+		BitWriter(uint8_t* out) : m_out(out) { memset(m_out, 0, 16); }
+
+		void Write(uint32_t value, uint32_t bitCount)
+		{
+			for (uint32_t i = 0; i < bitCount; i++, m_position++)
+			{
+				if (value & (1u << i))
+					m_out[m_position >> 3] |= static_cast<uint8_t>(1u << (m_position & 7));
+			}
+		}
+
+	private:
+		uint8_t* m_out;
+		uint32_t m_position = 0;
+	};
+
+	// quantize endpoint to 7 bits per channel and a shared p-bit.
+	void QuantizeBC7Endpoint(const float point[4], int quantized[4], int& pbit)
+	{
+		int bestError = -1;
+		for (int p = 0; p < 2; p++)
+		{
+			int candidate[4];
+			int error = 0;
+			for (int c = 0; c < 4; c++)
+			{
+				int v = static_cast<int>(point[c] + 0.5f);
+				candidate[c] = std::min(127, std::max(0, (v - p + 1) >> 1));
+				int d = (candidate[c] << 1 | p) - v;
+				error += d * d;
+			}
+			if (bestError < 0 || error < bestError)
+			{
+				bestError = error;
+				pbit = p;
+				memcpy(quantized, candidate, sizeof(candidate));
+			}
+		}
+	}
+
+	// BC7 mode 6 only: single subset, RGBA 7.7.7.7 endpoints with
+	// p-bits and 4-bit indices. It's the best single mode for
+	// smooth art, and keeps the encoder fast enough for big images.
+	void EncodeBC7Block(const uint8_t* block, uint8_t* out)
+	{
+		static const int WEIGHTS[16] = { 0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64 };
+
+		float minPoint[4], maxPoint[4];
+		FindEndpoints(block, 4, minPoint, maxPoint);
+
+		int endpoints[2][4];
+		int pbits[2];
+		QuantizeBC7Endpoint(minPoint, endpoints[0], pbits[0]);
+		QuantizeBC7Endpoint(maxPoint, endpoints[1], pbits[1]);
+
+		int palette[16][4];
+		for (int c = 0; c < 4; c++)
+		{
+			int e0 = endpoints[0][c] << 1 | pbits[0];
+			int e1 = endpoints[1][c] << 1 | pbits[1];
+			for (int p = 0; p < 16; p++)
+				palette[p][c] = ((64 - WEIGHTS[p]) * e0 + WEIGHTS[p] * e1 + 32) >> 6;
+		}
+
+		uint8_t indices[BLOCK_PIXELS];
+		for (uint32_t i = 0; i < BLOCK_PIXELS; i++)
+		{
+			int bestIndex = 0;
+			int bestDistance = ColorDistance(block + i * 4, palette[0], 4);
+			for (int p = 1; p < 16; p++)
+			{
+				int distance = ColorDistance(block + i * 4, palette[p], 4);
+				if (distance < bestDistance)
+				{
+					bestDistance = distance;
+					bestIndex = p;
+				}
+			}
+			indices[i] = static_cast<uint8_t>(bestIndex);
+		}
+
+		// MSB of anchor index is implied 0, swap endpoints if needed.
+		if (indices[0] & 8)
+		{
+			std::swap(endpoints[0], endpoints[1]);
+			std::swap(pbits[0], pbits[1]);
+			for (uint32_t i = 0; i < BLOCK_PIXELS; i++)
+				indices[i] = 15 - indices[i];
+		}
+
+		BitWriter writer(out);
+		writer.Write(1u << 6, 7);
+		for (int c = 0; c < 4; c++)
+		{
+			writer.Write(endpoints[0][c], 7);
+			writer.Write(endpoints[1][c], 7);
+		}
+		writer.Write(pbits[0], 1);
+		writer.Write(pbits[1], 1);
+		writer.Write(indices[0], 3);
+		for (uint32_t i = 1; i < BLOCK_PIXELS; i++)
+			writer.Write(indices[i], 4);
+	}
+
+	// DDS layout, see DDS_HEADER / DDS_PIXELFORMAT / DDS_HEADER_DXT10.
+	constexpr uint32_t DDS_MAGIC = 0x20534444; // "DDS "
+	constexpr uint32_t DDS_HEADER_SIZE = 124;
+	constexpr uint32_t DDS_DX10_HEADER_SIZE = 20;
+	constexpr uint32_t DDSD_CAPS = 0x1;
+	constexpr uint32_t DDSD_HEIGHT = 0x2;
+	constexpr uint32_t DDSD_WIDTH = 0x4;
+	constexpr uint32_t DDSD_PITCH = 0x8;
+	constexpr uint32_t DDSD_PIXELFORMAT = 0x1000;
+	constexpr uint32_t DDSD_MIPMAPCOUNT = 0x20000;
+	constexpr uint32_t DDSD_LINEARSIZE = 0x80000;
+	constexpr uint32_t DDPF_ALPHAPIXELS = 0x1;
+	constexpr uint32_t DDPF_FOURCC = 0x4;
+	constexpr uint32_t DDPF_RGB = 0x40;
+	constexpr uint32_t DDSCAPS_COMPLEX = 0x8;
+	constexpr uint32_t DDSCAPS_TEXTURE = 0x1000;
+	constexpr uint32_t DDSCAPS_MIPMAP = 0x400000;
+	constexpr uint32_t FOURCC_DXT1 = 0x31545844;
+	constexpr uint32_t FOURCC_DXT5 = 0x35545844;
+	constexpr uint32_t FOURCC_DX10 = 0x30315844;
+	constexpr uint32_t DXGI_RGBA8_UNORM = 28;
+	constexpr uint32_t DXGI_BC1_UNORM = 71;
+	constexpr uint32_t DXGI_BC3_UNORM = 77;
+	constexpr uint32_t DXGI_BC7_UNORM = 98;
+	constexpr uint32_t DDS_DIMENSION_TEXTURE2D = 3;
+
+	inline uint32_t ReadUint32(const uint8_t* p)
+	{
+		return p[0] | (p[1] << 8) | (p[2] << 16) | (static_cast<uint32_t>(p[3]) << 24);
+	}
+
+	inline void AppendUint32(std::vector<uint8_t>& out, uint32_t v)
+	{
+		for (int i = 0; i < 4; i++)
+			out.push_back(static_cast<uint8_t>(v >> (i * 8)));
+	}
+
+	bool FormatFromDXGI(uint32_t dxgiFormat, TextureFormat& format)
+	{
+		switch (dxgiFormat)
+		{
+		case DXGI_RGBA8_UNORM: format = TextureFormat::RGBA8; return true;
+		case DXGI_BC1_UNORM: format = TextureFormat::BC1; return true;
+		case DXGI_BC3_UNORM: format = TextureFormat::BC3; return true;
+		case DXGI_BC7_UNORM: format = TextureFormat::BC7; return true;
+		default: return false;
+		}
+	}
+
+	uint64_t AlignUp(uint64_t value, uint32_t alignment)
+	{
+		return (value + alignment - 1) / alignment * alignment;
+	}
+
+	bool HasExtension(const char* path, const char* ext)
+	{
+		size_t length = strlen(path);
+		size_t extLength = strlen(ext);
+		if (length < extLength)
+			return false;
+
+		for (size_t i = 0; i < extLength; i++)
+		{
+			if (tolower(static_cast<unsigned char>(path[length - extLength + i])) != ext[i])
+				return false;
+		}
+		return true;
+	}
+
+	// zeroth order modified Bessel function of the first kind.
+	double BesselI0(double x)
+	{
+		double sum = 1.0;
+		double term = 1.0;
+		for (int k = 1; k < 32; k++)
+		{
+			term *= (x / (2.0 * k)) * (x / (2.0 * k));
+			sum += term;
+			if (term < sum * 1e-12)
+				break;
+		}
+		return sum;
+	}
+
+	constexpr double KAISER_RADIUS = 3.0;
+	constexpr double KAISER_ALPHA = 4.0;
+
+	// taps of one output pixel along an axis, indices are clamped to edges.
+	struct FilterTaps
+	{
+		std::vector<uint32_t> index;
+		std::vector<float> weight;
+	};
+
+	// sinc low-pass at the destination Nyquist frequency, windowed by
+	// Kaiser window which keeps the ringing of truncated sinc small.
+	std::vector<FilterTaps> BuildKaiserTaps(uint32_t srcSize, uint32_t dstSize)
+	{
+		const double pi = 3.14159265358979323846;
+		double scale = static_cast<double>(srcSize) / dstSize;
+		double support = KAISER_RADIUS * scale;
+		double windowNorm = 1.0 / BesselI0(KAISER_ALPHA);
+		std::vector<FilterTaps> axis(dstSize);
+		for (uint32_t i = 0; i < dstSize; i++)
+		{
+			double center = (i + 0.5) * scale - 0.5;
+			int first = static_cast<int>(std::floor(center - support));
+			int last = static_cast<int>(std::ceil(center + support));
+			double total = 0.0;
+			std::vector<double> weights;
+			for (int s = first; s <= last; s++)
+			{
+				double t = (s - center) / scale;
+				double r = t / KAISER_RADIUS;
+				double w = 0.0;
+				if (r * r < 1.0)
+				{
+					double sinc = (t == 0.0) ? 1.0 : std::sin(pi * t) / (pi * t);
+					w = sinc * BesselI0(KAISER_ALPHA * std::sqrt(1.0 - r * r)) * windowNorm;
+				}
+				weights.push_back(w);
+				total += w;
+			}
+
+			FilterTaps& taps = axis[i];
+			for (int s = first; s <= last; s++)
+			{
+				double w = weights[s - first];
+				if (w == 0.0)
+					continue;
+
+				uint32_t index = static_cast<uint32_t>(std::min(std::max(s, 0), static_cast<int>(srcSize) - 1));
+				if (!taps.index.empty() && taps.index.back() == index)
+				{
+					taps.weight.back() += static_cast<float>(w / total);
+				}
+				else
+				{
+					taps.index.push_back(index);
+					taps.weight.push_back(static_cast<float>(w / total));
+				}
+			}
+		}
+		return axis;
+	}
+
+	// separable filter, horizontal pass is kept in float to avoid double rounding.
+	void DownsampleKaiser(const uint8_t* rgba, uint32_t width, uint32_t height, uint32_t dstWidth, uint32_t dstHeight, uint8_t* out)
+	{
+		std::vector<FilterTaps> columns = BuildKaiserTaps(width, dstWidth);
+		std::vector<FilterTaps> rows = BuildKaiserTaps(height, dstHeight);
+		std::vector<float> horizontal(static_cast<size_t>(dstWidth) * height * 4);
+		float* temp = horizontal.data();
+
+		ParallelRows(height, width * 16, [&](uint32_t rowBegin, uint32_t rowEnd)
+		{
+			for (uint32_t y = rowBegin; y < rowEnd; y++)
+			{
+				const uint8_t* src = rgba + static_cast<size_t>(y) * width * 4;
+				float* dst = temp + static_cast<size_t>(y) * dstWidth * 4;
+				for (uint32_t x = 0; x < dstWidth; x++)
+				{
+					float sum[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
+					const FilterTaps& taps = columns[x];
+					for (size_t t = 0; t < taps.index.size(); t++)
+					{
+						for (uint32_t c = 0; c < 4; c++)
+							sum[c] += src[taps.index[t] * 4 + c] * taps.weight[t];
+					}
+					memcpy(dst + x * 4, sum, sizeof(sum));
+				}
+			}
+		});
+
+		ParallelRows(dstHeight, dstWidth * 16, [&](uint32_t rowBegin, uint32_t rowEnd)
+		{
+			std::vector<float> sum(dstWidth * 4);
+			for (uint32_t y = rowBegin; y < rowEnd; y++)
+			{
+				std::fill(sum.begin(), sum.end(), 0.0f);
+				const FilterTaps& taps = rows[y];
+				for (size_t t = 0; t < taps.index.size(); t++)
+				{
+					const float* src = temp + static_cast<size_t>(taps.index[t]) * dstWidth * 4;
+					for (uint32_t i = 0; i < dstWidth * 4; i++)
+						sum[i] += src[i] * taps.weight[t];
+				}
+
+				uint8_t* dst = out + static_cast<size_t>(y) * dstWidth * 4;
+				for (uint32_t i = 0; i < dstWidth * 4; i++)
+					dst[i] = static_cast<uint8_t>(ClampByte(static_cast<int>(sum[i] + 0.5f)));
+			}
+		});
+	}
+}
+
+uint64_t TextureContainer::GetDataBytes() const
+{
+	uint64_t bytes = 0;
+	for (auto& mip : mips)
+	{
+		bytes += mip.dataSize;
+	}
+	return bytes;
+}
+
+bool IsBlockCompressed(TextureFormat format)
+{
+	return format != TextureFormat::RGBA8;
+}
+
+uint32_t GetFormatUnitBytes(TextureFormat format)
+{
+	switch (format)
+	{
+	case TextureFormat::BC1: return 8;
+	case TextureFormat::BC3: return 16;
+	case TextureFormat::BC7: return 16;
+	default: return 4;
+	}
+}
+
+uint32_t GetMipRowPitch(TextureFormat format, uint32_t width)
+{
+	if (IsBlockCompressed(format))
+		return std::max(1u, (width + 3) / 4) * GetFormatUnitBytes(format);
+	else
+		return width * GetFormatUnitBytes(format);
+}
+
+uint32_t GetMipDataSize(TextureFormat format, uint32_t width, uint32_t height)
+{
+	uint32_t rowCount = IsBlockCompressed(format) ? std::max(1u, (height + 3) / 4) : height;
+	return GetMipRowPitch(format, width) * rowCount;
+}
+
+void CompressImage(TextureFormat format, const uint8_t* rgba, uint32_t width, uint32_t height, std::vector<uint8_t>& out)
+{
+	out.resize(GetMipDataSize(format, width, height));
+	if (!IsBlockCompressed(format))
+	{
+		memcpy(out.data(), rgba, out.size());
+		return;
+	}
+
+	void(*encodeBlock)(const uint8_t*, uint8_t*) = EncodeBC1Block;
+	if (format == TextureFormat::BC3)
+		encodeBlock = EncodeBC3Block;
+	else if (format == TextureFormat::BC7)
+		encodeBlock = EncodeBC7Block;
+
+	uint32_t blockWidth = std::max(1u, (width + 3) / 4);
+	uint32_t blockHeight = std::max(1u, (height + 3) / 4);
+	uint32_t unitBytes = GetFormatUnitBytes(format);
+	uint8_t* dst = out.data();
+	ParallelRows(blockHeight, width * 16, [=](uint32_t rowBegin, uint32_t rowEnd)
+	{
+		uint8_t block[BLOCK_PIXELS * 4];
+		for (uint32_t by = rowBegin; by < rowEnd; by++)
+		{
+			for (uint32_t bx = 0; bx < blockWidth; bx++)
+			{
+				FetchBlock(rgba, width, height, bx, by, block);
+				encodeBlock(block, dst + (by * blockWidth + bx) * unitBytes);
+			}
+		}
+	});
+}
+
+void DownsampleImage(const uint8_t* rgba, uint32_t width, uint32_t height, std::vector<uint8_t>& out, MipFilter filter)
+{
+	uint32_t halfWidth = std::max(1u, width / 2);
+	uint32_t halfHeight = std::max(1u, height / 2);
+	out.resize(halfWidth * halfHeight * 4);
+	if (filter == MipFilter::Kaiser)
+	{
+		DownsampleKaiser(rgba, width, height, halfWidth, halfHeight, out.data());
+		return;
+	}
+
+	for (uint32_t y = 0; y < halfHeight; y++)
+	{
+		uint32_t y0 = std::min(y * 2, height - 1);
+		uint32_t y1 = std::min(y * 2 + 1, height - 1);
+		for (uint32_t x = 0; x < halfWidth; x++)
+		{
+			uint32_t x0 = std::min(x * 2, width - 1);
+			uint32_t x1 = std::min(x * 2 + 1, width - 1);
+			for (uint32_t c = 0; c < 4; c++)
+			{
+				uint32_t sum = rgba[(y0 * width + x0) * 4 + c] + rgba[(y0 * width + x1) * 4 + c]
+					+ rgba[(y1 * width + x0) * 4 + c] + rgba[(y1 * width + x1) * 4 + c];
+				out[(y * halfWidth + x) * 4 + c] = static_cast<uint8_t>((sum + 2) / 4);
+			}
+		}
+	}
+}
+
+bool IsTextureContainerFile(const char* path)
+{
+	return HasExtension(path, ".dds") || HasExtension(path, ".g2dtex");
+}
+
+bool ParseDDS(const uint8_t* buffer, uint64_t size, TextureContainer& container)
+{
+	if (size < 4 + DDS_HEADER_SIZE || ReadUint32(buffer) != DDS_MAGIC)
+		return false;
+
+	const uint8_t* header = buffer + 4;
+	if (ReadUint32(header) != DDS_HEADER_SIZE)
+		return false;
+
+	uint32_t flags = ReadUint32(header + 4);
+	uint32_t height = ReadUint32(header + 8);
+	uint32_t width = ReadUint32(header + 12);
+	uint32_t mipCount = (flags & DDSD_MIPMAPCOUNT) ? ReadUint32(header + 24) : 1;
+	const uint8_t* pixelFormat = header + 72;
+	uint32_t pixelFlags = ReadUint32(pixelFormat + 4);
+	uint32_t fourCC = ReadUint32(pixelFormat + 8);
+	uint64_t offset = 4 + DDS_HEADER_SIZE;
+
+	TextureFormat format;
+	if (pixelFlags & DDPF_FOURCC)
+	{
+		if (fourCC == FOURCC_DXT1)
+		{
+			format = TextureFormat::BC1;
+		}
+		else if (fourCC == FOURCC_DXT5)
+		{
+			format = TextureFormat::BC3;
+		}
+		else if (fourCC == FOURCC_DX10)
+		{
+			if (size < offset + DDS_DX10_HEADER_SIZE)
+				return false;
+
+			const uint8_t* dx10 = buffer + offset;
+			offset += DDS_DX10_HEADER_SIZE;
+			if (ReadUint32(dx10 + 4) != DDS_DIMENSION_TEXTURE2D ||
+				ReadUint32(dx10 + 12) != 1 ||
+				!FormatFromDXGI(ReadUint32(dx10), format))
+			{
+				return false;
+			}
+		}
+		else
+		{
+			return false;
+		}
+	}
+	else if ((pixelFlags & DDPF_RGB) &&
+		ReadUint32(pixelFormat + 12) == 32 &&
+		ReadUint32(pixelFormat + 16) == 0x000000FF &&
+		ReadUint32(pixelFormat + 20) == 0x0000FF00 &&
+		ReadUint32(pixelFormat + 24) == 0x00FF0000)
+	{
+		format = TextureFormat::RGBA8;
+	}
+	else
+	{
+		return false;
+	}
+
+	if (width == 0 || height == 0 || mipCount == 0)
+		return false;
+
+	container.format = format;
+	container.width = width;
+	container.height = height;
+	container.mips.clear();
+	for (uint32_t i = 0; i < mipCount; i++)
+	{
+		TextureMip mip;
+		mip.width = std::max(1u, width >> i);
+		mip.height = std::max(1u, height >> i);
+		mip.rowPitch = GetMipRowPitch(format, mip.width);
+		mip.dataSize = GetMipDataSize(format, mip.width, mip.height);
+		if (offset + mip.dataSize > size)
+			return false;
+
+		mip.data = buffer + offset;
+		offset += mip.dataSize;
+		container.mips.push_back(mip);
+
+		if (mip.width == 1 && mip.height == 1)
+			break;
+	}
+	return true;
+}
+
+void WriteDDS(TextureFormat format, uint32_t width, uint32_t height, const std::vector<std::vector<uint8_t>>& mipData, std::vector<uint8_t>& out)
+{
+	uint32_t mipCount = static_cast<uint32_t>(mipData.size());
+	bool compressed = IsBlockCompressed(format);
+
+	out.clear();
+	AppendUint32(out, DDS_MAGIC);
+	AppendUint32(out, DDS_HEADER_SIZE);
+	AppendUint32(out, DDSD_CAPS | DDSD_HEIGHT | DDSD_WIDTH | DDSD_PIXELFORMAT | DDSD_MIPMAPCOUNT |
+		(compressed ? DDSD_LINEARSIZE : DDSD_PITCH));
+	AppendUint32(out, height);
+	AppendUint32(out, width);
+	AppendUint32(out, compressed ? GetMipDataSize(format, width, height) : GetMipRowPitch(format, width));
+	AppendUint32(out, 0);
+	AppendUint32(out, mipCount);
+	for (int i = 0; i < 11; i++)
+		AppendUint32(out, 0);
+
+	// DDS_PIXELFORMAT
+	AppendUint32(out, 32);
+	if (format == TextureFormat::RGBA8)
+	{
+		AppendUint32(out, DDPF_RGB | DDPF_ALPHAPIXELS);
+		AppendUint32(out, 0);
+		AppendUint32(out, 32);
+		AppendUint32(out, 0x000000FF);
+		AppendUint32(out, 0x0000FF00);
+		AppendUint32(out, 0x00FF0000);
+		AppendUint32(out, 0xFF000000);
+	}
+	else
+	{
+		AppendUint32(out, DDPF_FOURCC);
+		AppendUint32(out, format == TextureFormat::BC1 ? FOURCC_DXT1 :
+			format == TextureFormat::BC3 ? FOURCC_DXT5 : FOURCC_DX10);
+		for (int i = 0; i < 5; i++)
+			AppendUint32(out, 0);
+	}
+
+	uint32_t caps = DDSCAPS_TEXTURE;
+	if (mipCount > 1)
+		caps |= DDSCAPS_COMPLEX | DDSCAPS_MIPMAP;
+	AppendUint32(out, caps);
+	for (int i = 0; i < 4; i++)
+		AppendUint32(out, 0);
+
+	// BC7 has no legacy FourCC.
+	if (format == TextureFormat::BC7)
+	{
+		AppendUint32(out, DXGI_BC7_UNORM);
+		AppendUint32(out, DDS_DIMENSION_TEXTURE2D);
+		AppendUint32(out, 0);
+		AppendUint32(out, 1);
+		AppendUint32(out, 0);
+	}
+
+	for (auto& data : mipData)
+	{
+		out.insert(out.end(), data.begin(), data.end());
+	}
+}
+
+bool ParseBakedTexture(const uint8_t* buffer, uint64_t size, TextureContainer& container)
+{
+	if (size < sizeof(BakedTextureHeader))
+		return false;
+
+	BakedTextureHeader header;
+	memcpy(&header, buffer, sizeof(header));
+	if (header.magic != BAKED_TEXTURE_MAGIC || header.version != BAKED_TEXTURE_VERSION ||
+		header.format > static_cast<uint32_t>(TextureFormat::BC7) ||
+		header.width == 0 || header.height == 0 || header.mipCount == 0 || header.mipCount > 32 ||
+		size < sizeof(BakedTextureHeader) + sizeof(BakedTextureMip) * header.mipCount)
+	{
+		return false;
+	}
+
+	TextureFormat format = static_cast<TextureFormat>(header.format);
+	container.format = format;
+	container.width = header.width;
+	container.height = header.height;
+	container.premultiplied = (header.flags & BAKED_TEXTURE_PREMULTIPLIED) != 0;
+	container.mips.clear();
+	for (uint32_t i = 0; i < header.mipCount; i++)
+	{
+		BakedTextureMip bakedMip;
+		memcpy(&bakedMip, buffer + sizeof(BakedTextureHeader) + sizeof(BakedTextureMip) * i, sizeof(bakedMip));
+
+		TextureMip mip;
+		mip.width = std::max(1u, header.width >> i);
+		mip.height = std::max(1u, header.height >> i);
+		mip.rowPitch = bakedMip.rowPitch;
+		// in 64 bits, pitch and row count of a corrupted file may wrap around.
+		uint64_t dataSize = static_cast<uint64_t>(bakedMip.rowPitch) * bakedMip.rowCount;
+		uint32_t rowCount = IsBlockCompressed(format) ? std::max(1u, (mip.height + 3) / 4) : mip.height;
+		if (bakedMip.rowCount != rowCount || bakedMip.rowPitch < GetMipRowPitch(format, mip.width) ||
+			dataSize > UINT32_MAX || bakedMip.dataOffset > size || size - bakedMip.dataOffset < dataSize)
+		{
+			return false;
+		}
+
+		mip.dataSize = static_cast<uint32_t>(dataSize);
+		mip.data = buffer + bakedMip.dataOffset;
+		container.mips.push_back(mip);
+	}
+	return true;
+}
+
+void WriteBakedTexture(TextureFormat format, uint32_t width, uint32_t height, bool premultiplied, uint32_t pitchAlignment,
+	const std::vector<std::vector<uint8_t>>& mipData, std::vector<uint8_t>& out)
+{
+	BakedTextureHeader header;
+	header.magic = BAKED_TEXTURE_MAGIC;
+	header.version = BAKED_TEXTURE_VERSION;
+	header.format = static_cast<uint32_t>(format);
+	header.flags = premultiplied ? BAKED_TEXTURE_PREMULTIPLIED : 0;
+	header.width = width;
+	header.height = height;
+	header.mipCount = static_cast<uint32_t>(mipData.size());
+	header.pitchAlignment = pitchAlignment;
+
+	std::vector<BakedTextureMip> bakedMips(mipData.size());
+	uint64_t offset = sizeof(BakedTextureHeader) + sizeof(BakedTextureMip) * mipData.size();
+	for (uint32_t i = 0; i < header.mipCount; i++)
+	{
+		uint32_t mipWidth = std::max(1u, width >> i);
+		uint32_t mipHeight = std::max(1u, height >> i);
+		offset = AlignUp(offset, BAKED_TEXTURE_MIP_ALIGNMENT);
+		bakedMips[i].dataOffset = offset;
+		bakedMips[i].rowPitch = static_cast<uint32_t>(AlignUp(GetMipRowPitch(format, mipWidth), pitchAlignment));
+		bakedMips[i].rowCount = IsBlockCompressed(format) ? std::max(1u, (mipHeight + 3) / 4) : mipHeight;
+		offset += static_cast<uint64_t>(bakedMips[i].rowPitch) * bakedMips[i].rowCount;
+	}
+
+	// padding is zero-filled, so that baked files are reproducible.
+	out.assign(static_cast<size_t>(offset), 0);
+	memcpy(out.data(), &header, sizeof(header));
+	memcpy(out.data() + sizeof(header), bakedMips.data(), sizeof(BakedTextureMip) * bakedMips.size());
+	for (uint32_t i = 0; i < header.mipCount; i++)
+	{
+		uint32_t packedPitch = GetMipRowPitch(format, std::max(1u, width >> i));
+		for (uint32_t row = 0; row < bakedMips[i].rowCount; row++)
+		{
+			memcpy(out.data() + bakedMips[i].dataOffset + static_cast<uint64_t>(row) * bakedMips[i].rowPitch,
+				mipData[i].data() + static_cast<uint64_t>(row) * packedPitch, packedPitch);
+		}
+	}
+}
+
+bool ParseTextureContainer(const char* path, const uint8_t* buffer, uint64_t size, TextureContainer& container)
+{
+	if (HasExtension(path, ".g2dtex"))
+		return ParseBakedTexture(buffer, size, container);
+	else
+		return ParseDDS(buffer, size, container);
+}
@@ -0,0 +1,111 @@
+#pragma once
+#include <cinttypes>
+#include <vector>
+
+// Block-compressed texture encoders and DDS container.
+
+enum class TextureFormat : int
+{
+	RGBA8,
+	BC1,	// 4x4 RGB block in 8 bytes, alpha is ignored.
+	BC3,	// 4x4 RGBA block in 16 bytes, BC1 color + interpolated alpha.
+	BC7,	// 4x4 RGBA block in 16 bytes, higher quality than BC3.
+};
+
+// A mip level of a container, data points to the memory
+// passed to ParseDDS, it is NOT copied.
+struct TextureMip
+{
+	const uint8_t* data = nullptr;
+	uint32_t width = 0;
+	uint32_t height = 0;
+	uint32_t rowPitch = 0;
+	uint32_t dataSize = 0;
+};
+
+struct TextureContainer
+{
+	TextureFormat format = TextureFormat::RGBA8;
+	uint32_t width = 0;
+	uint32_t height = 0;
+	bool premultiplied = false;
+	std::vector<TextureMip> mips;
+
+	uint64_t GetDataBytes() const;
+};
+
+bool IsBlockCompressed(TextureFormat format);
+
+// Bytes of a 4x4 block, or a pixel for uncompressed formats.
+uint32_t GetFormatUnitBytes(TextureFormat format);
+
+uint32_t GetMipRowPitch(TextureFormat format, uint32_t width);
+
+uint32_t GetMipDataSize(TextureFormat format, uint32_t width, uint32_t height);
+
+// Encode a tightly packed RGBA8 image, out is resized to GetMipDataSize.
+// Edge blocks of images which size is not multiple of 4 are padded
+// by clamping. Large images are encoded on multiple threads.
+void CompressImage(TextureFormat format, const uint8_t* rgba, uint32_t width, uint32_t height, std::vector<uint8_t>& out);
+
+enum class MipFilter : int
+{
+	Box,	// average of 2x2 pixels, fast.
+	Kaiser,	// Kaiser-windowed sinc of 6 taps per axis, sharper mips without ringing.
+};
+
+// Filter RGBA8 image to half size, odd edges are clamped.
+void DownsampleImage(const uint8_t* rgba, uint32_t width, uint32_t height, std::vector<uint8_t>& out, MipFilter filter = MipFilter::Box);
+
+// Check extension of path (.dds or .g2dtex), containers are uploaded without decoding.
+bool IsTextureContainerFile(const char* path);
+
+// Parse DDS file in memory, mips of container point into buffer.
+bool ParseDDS(const uint8_t* buffer, uint64_t size, TextureContainer& container);
+
+// Serialize mip chain to DDS file, mipData[0] is the top level.
+void WriteDDS(TextureFormat format, uint32_t width, uint32_t height, const std::vector<std::vector<uint8_t>>& mipData, std::vector<uint8_t>& out);
+
+// Baked texture layout (.g2dtex), all fields are little-endian:
+//   BakedTextureHeader
+//   BakedTextureMip[mipCount]
+//   mip data, each one aligned to BAKED_TEXTURE_MIP_ALIGNMENT,
+//   rows are padded to header.pitchAlignment.
+// Data is stored exactly as the GPU takes it, so mips are uploaded
+// straight from the file without any conversion.
+constexpr uint32_t BAKED_TEXTURE_MAGIC = 0x54443247; // "G2DT"
+constexpr uint32_t BAKED_TEXTURE_VERSION = 1;
+constexpr uint32_t BAKED_TEXTURE_MIP_ALIGNMENT = 512;
+constexpr uint32_t BAKED_TEXTURE_DEFAULT_PITCH_ALIGNMENT = 256;
+constexpr uint32_t BAKED_TEXTURE_PREMULTIPLIED = 0x1;
+
+struct BakedTextureHeader
+{
+	uint32_t magic;
+	uint32_t version;
+	uint32_t format;
+	uint32_t flags;
+	uint32_t width;
+	uint32_t height;
+	uint32_t mipCount;
+	uint32_t pitchAlignment;
+};
+
+struct BakedTextureMip
+{
+	uint64_t dataOffset;
+	uint32_t rowPitch;
+	uint32_t rowCount;
+};
+
+static_assert(sizeof(BakedTextureHeader) == 32 && sizeof(BakedTextureMip) == 16, "baked texture layout must be packed.");
+
+// Parse baked texture in memory, mips of container point into buffer.
+bool ParseBakedTexture(const uint8_t* buffer, uint64_t size, TextureContainer& container);
+
+// Serialize tightly packed mip chain to baked texture, pitchAlignment must be power of 2.
+void WriteBakedTexture(TextureFormat format, uint32_t width, uint32_t height, bool premultiplied, uint32_t pitchAlignment,
+	const std::vector<std::vector<uint8_t>>& mipData, std::vector<uint8_t>& out);
+
+// Parse DDS or baked texture according to extension of path.
+bool ParseTextureContainer(const char* path, const uint8_t* buffer, uint64_t size, TextureContainer& container);
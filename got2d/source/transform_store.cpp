@@ -0,0 +1,460 @@
+#include <cmath>
+#include <algorithm>
+#include "transform_store.h"
+
+#if defined(_M_IX86) || defined(_M_X64) || defined(__i386__) || defined(__x86_64__)
+#define G2D_TRANSFORM_SIMD 1
+#include <xmmintrin.h>
+#else
+#define G2D_TRANSFORM_SIMD 0
+#endif
+
+namespace
+{
+	const TransformMatrix IDENTITY_MATRIX = { { { 1.0f, 0.0f, 0.0f },{ 0.0f, 1.0f, 0.0f } } };
+
+	// same as gml::mat32::trsp, translate * rotate * scale * translate(-pivot).
+	void ComposeMatrix(const TransformVector& position, float radian, const TransformVector& scale, const TransformVector& pivot, TransformMatrix& out)
+	{
+		float s = std::sin(radian);
+		float c = std::cos(radian);
+		float m00 = c * scale.x;
+		float m01 = -s * scale.y;
+		float m10 = s * scale.x;
+		float m11 = c * scale.y;
+		out.row[0][0] = m00;
+		out.row[0][1] = m01;
+		out.row[0][2] = position.x - (m00 * pivot.x + m01 * pivot.y);
+		out.row[1][0] = m10;
+		out.row[1][1] = m11;
+		out.row[1][2] = position.y - (m10 * pivot.x + m11 * pivot.y);
+	}
+
+	// out = parent * local, out must not alias the others.
+	inline void MultiplyMatrix(const TransformMatrix& parent, const TransformMatrix& local, TransformMatrix& out)
+	{
+#if G2D_TRANSFORM_SIMD
+		// both rows of local as (m0, m1, translation, x), the 4th lane is
+		// never used, loads stay inside of the matrix.
+		__m128 local0 = _mm_loadu_ps(local.row[0]);
+		__m128 local1 = _mm_loadu_ps(&(local.row[0][2]));
+		local1 = _mm_shuffle_ps(local1, local1, _MM_SHUFFLE(0, 3, 2, 1));
+
+		__m128 out0 = _mm_add_ps(
+			_mm_mul_ps(_mm_set1_ps(parent.row[0][0]), local0),
+			_mm_mul_ps(_mm_set1_ps(parent.row[0][1]), local1));
+		out0 = _mm_add_ps(out0, _mm_set_ps(0.0f, parent.row[0][2], 0.0f, 0.0f));
+
+		__m128 out1 = _mm_add_ps(
+			_mm_mul_ps(_mm_set1_ps(parent.row[1][0]), local0),
+			_mm_mul_ps(_mm_set1_ps(parent.row[1][1]), local1));
+		out1 = _mm_add_ps(out1, _mm_set_ps(0.0f, parent.row[1][2], 0.0f, 0.0f));
+
+		// 4th lane of the first row is overwritten by the second row.
+		_mm_storeu_ps(out.row[0], out0);
+		_mm_storel_pi(reinterpret_cast<__m64*>(out.row[1]), out1);
+		_mm_store_ss(&(out.row[1][2]), _mm_movehl_ps(out1, out1));
+#else
+		for (int r = 0; r < 2; r++)
+		{
+			float p0 = parent.row[r][0];
+			float p1 = parent.row[r][1];
+			out.row[r][0] = p0 * local.row[0][0] + p1 * local.row[1][0];
+			out.row[r][1] = p0 * local.row[0][1] + p1 * local.row[1][1];
+			out.row[r][2] = p0 * local.row[0][2] + p1 * local.row[1][2] + parent.row[r][2];
+		}
+#endif
+	}
+
+	template<typename T>
+	void Reorder(std::vector<T>& elements, const std::vector<uint32_t>& order)
+	{
+		std::vector<T> reordered;
+		reordered.reserve(order.size());
+		for (uint32_t slot : order)
+		{
+			reordered.push_back(elements[slot]);
+		}
+		elements.swap(reordered);
+	}
+}
+
+const TransformStore::Handle TransformStore::INVALID_HANDLE;
+
+const uint32_t TransformStore::INVALID_SLOT;
+
+TransformStore::Handle TransformStore::Create(Handle parent)
+{
+	uint32_t slot = static_cast<uint32_t>(m_handles.size());
+	Handle handle;
+	if (m_freeHandles.empty())
+	{
+		handle = static_cast<Handle>(m_slots.size());
+		m_slots.push_back(slot);
+	}
+	else
+	{
+		handle = m_freeHandles.back();
+		m_freeHandles.pop_back();
+		m_slots[handle] = slot;
+	}
+
+	uint32_t parentSlot = (parent == INVALID_HANDLE) ? INVALID_SLOT : m_slots[parent];
+	m_handles.push_back(handle);
+	m_positions.push_back({ 0.0f, 0.0f });
+	m_pivots.push_back({ 0.0f, 0.0f });
+	m_scales.push_back({ 1.0f, 1.0f });
+	m_rotations.push_back(0.0f);
+	m_localMatrices.push_back(IDENTITY_MATRIX);
+	m_worldMatrices.push_back(IDENTITY_MATRIX);
+	m_parents.push_back(parentSlot);
+	m_depths.push_back(parentSlot == INVALID_SLOT ? 0 : m_depths[parentSlot] + 1);
+	// local matrix of default values is identity already.
+	m_flags.push_back(LOCAL_CHANGED);
+	m_worldVersions.push_back(0);
+	m_parentVersions.push_back(0);
+	m_epochs.push_back(0);
+	SetChanged(slot);
+	return handle;
+}
+
+void TransformStore::Destroy(Handle handle)
+{
+	uint32_t slot = m_slots[handle];
+	m_flags[slot] = SLOT_FREE;
+	m_slots[handle] = INVALID_SLOT;
+	m_freeHandles.push_back(handle);
+	m_holeCount++;
+}
+
+void TransformStore::Reserve(uint32_t count)
+{
+	m_slots.reserve(count);
+	m_handles.reserve(count);
+	m_positions.reserve(count);
+	m_pivots.reserve(count);
+	m_scales.reserve(count);
+	m_rotations.reserve(count);
+	m_localMatrices.reserve(count);
+	m_worldMatrices.reserve(count);
+	m_parents.reserve(count);
+	m_depths.reserve(count);
+	m_flags.reserve(count);
+	m_worldVersions.reserve(count);
+	m_parentVersions.reserve(count);
+	m_epochs.reserve(count);
+}
+
+void TransformStore::Clear()
+{
+	m_slots.clear();
+	m_handles.clear();
+	m_freeHandles.clear();
+	m_positions.clear();
+	m_pivots.clear();
+	m_scales.clear();
+	m_rotations.clear();
+	m_localMatrices.clear();
+	m_worldMatrices.clear();
+	m_parents.clear();
+	m_depths.clear();
+	m_flags.clear();
+	m_worldVersions.clear();
+	m_parentVersions.clear();
+	m_epochs.clear();
+	m_holeCount = 0;
+	m_sortedCount = 0;
+	m_firstChangedSlot = INVALID_SLOT;
+	m_epochExpired = true;
+}
+
+void TransformStore::SetPosition(Handle handle, const TransformVector& position)
+{
+	uint32_t slot = m_slots[handle];
+	m_positions[slot] = position;
+	SetLocalDirty(slot);
+}
+
+void TransformStore::SetPivot(Handle handle, const TransformVector& pivot)
+{
+	uint32_t slot = m_slots[handle];
+	m_pivots[slot] = pivot;
+	SetLocalDirty(slot);
+}
+
+void TransformStore::SetScale(Handle handle, const TransformVector& scale)
+{
+	uint32_t slot = m_slots[handle];
+	m_scales[slot] = scale;
+	SetLocalDirty(slot);
+}
+
+void TransformStore::SetRotation(Handle handle, float radian)
+{
+	uint32_t slot = m_slots[handle];
+	m_rotations[slot] = radian;
+	SetLocalDirty(slot);
+}
+
+void TransformStore::SetTransform(Handle handle, const TransformVector& position, float radian, const TransformVector& scale, const TransformVector& pivot)
+{
+	uint32_t slot = m_slots[handle];
+	m_positions[slot] = position;
+	m_rotations[slot] = radian;
+	m_scales[slot] = scale;
+	m_pivots[slot] = pivot;
+	SetLocalDirty(slot);
+}
+
+const TransformMatrix& TransformStore::GetLocalMatrix(Handle handle)
+{
+	uint32_t slot = m_slots[handle];
+	if (m_flags[slot] & LOCAL_MATRIX_DIRTY)
+	{
+		UpdateLocalMatrix(slot);
+	}
+	return m_localMatrices[slot];
+}
+
+const TransformMatrix& TransformStore::GetWorldMatrix(Handle handle)
+{
+	return m_worldMatrices[Evaluate(handle)];
+}
+
+void TransformStore::Update(std::vector<Handle>* worldChanged)
+{
+	uint32_t size = static_cast<uint32_t>(m_handles.size());
+	if ((m_holeCount + size - m_sortedCount) * 8 > size)
+	{
+		Compact();
+		size = static_cast<uint32_t>(m_handles.size());
+	}
+
+	if (!m_epochExpired && m_updatedEpoch == m_epoch)
+		return;
+
+	// parents come before children, so that they are up to date when
+	// visiting their children, only children of changed parents need
+	// to compare versions. Slots before the first changed one are clean.
+	AdvanceEpoch();
+	uint8_t* flags = m_flags.data();
+	const uint32_t* parents = m_parents.data();
+	for (uint32_t slot = m_firstChangedSlot; slot < size; slot++)
+	{
+		uint8_t flag = flags[slot];
+		if (flag & SLOT_FREE)
+			continue;
+
+		uint32_t parent = parents[slot];
+		if ((flag & LOCAL_CHANGED) || (parent != INVALID_SLOT && (flags[parent] & WORLD_CHANGED)))
+		{
+			EvaluateSlot(slot);
+		}
+	}
+
+	// including those evaluated by querying before Update.
+	for (uint32_t slot = m_firstChangedSlot; slot < size; slot++)
+	{
+		if ((flags[slot] & WORLD_CHANGED) && worldChanged != nullptr)
+			worldChanged->push_back(m_handles[slot]);
+		flags[slot] &= ~WORLD_CHANGED;
+	}
+	m_updatedEpoch = m_epoch;
+	m_firstChangedSlot = INVALID_SLOT;
+}
+
+void TransformStore::Compact()
+{
+	uint32_t size = static_cast<uint32_t>(m_handles.size());
+	uint32_t maxDepth = 0;
+	for (uint32_t slot = 0; slot < size; slot++)
+	{
+		if (!(m_flags[slot] & SLOT_FREE) && m_depths[slot] > maxDepth)
+			maxDepth = m_depths[slot];
+	}
+
+	// stable counting sort of living slots by depth.
+	std::vector<uint32_t> offsets(maxDepth + 2, 0);
+	for (uint32_t slot = 0; slot < size; slot++)
+	{
+		if (!(m_flags[slot] & SLOT_FREE))
+			offsets[m_depths[slot] + 1]++;
+	}
+	for (uint32_t depth = 1; depth < offsets.size(); depth++)
+	{
+		offsets[depth] += offsets[depth - 1];
+	}
+
+	std::vector<uint32_t> order(size - m_holeCount);
+	std::vector<uint32_t> remap(size, INVALID_SLOT);
+	for (uint32_t slot = 0; slot < size; slot++)
+	{
+		if (!(m_flags[slot] & SLOT_FREE))
+		{
+			uint32_t newSlot = offsets[m_depths[slot]]++;
+			order[newSlot] = slot;
+			remap[slot] = newSlot;
+		}
+	}
+
+	Reorder(m_handles, order);
+	Reorder(m_positions, order);
+	Reorder(m_pivots, order);
+	Reorder(m_scales, order);
+	Reorder(m_rotations, order);
+	Reorder(m_localMatrices, order);
+	Reorder(m_worldMatrices, order);
+	Reorder(m_parents, order);
+	Reorder(m_depths, order);
+	Reorder(m_flags, order);
+	Reorder(m_worldVersions, order);
+	Reorder(m_parentVersions, order);
+	Reorder(m_epochs, order);
+
+	uint32_t newSize = static_cast<uint32_t>(order.size());
+	for (uint32_t slot = 0; slot < newSize; slot++)
+	{
+		// children of destroyed nodes are about to be destroyed too.
+		uint32_t parent = m_parents[slot];
+		m_parents[slot] = (parent == INVALID_SLOT) ? INVALID_SLOT : remap[parent];
+		m_slots[m_handles[slot]] = slot;
+	}
+	m_holeCount = 0;
+	m_sortedCount = newSize;
+	// changed slots are moved.
+	if (m_firstChangedSlot != INVALID_SLOT)
+	{
+		m_firstChangedSlot = 0;
+	}
+}
+
+void TransformStore::BeginConcurrent()
+{
+	m_concurrent = true;
+	m_concurrentFirstChangedSlot.store(INVALID_SLOT, std::memory_order_relaxed);
+}
+
+void TransformStore::EndConcurrent()
+{
+	m_concurrent = false;
+	uint32_t slot = m_concurrentFirstChangedSlot.load(std::memory_order_relaxed);
+	if (slot != INVALID_SLOT)
+	{
+		SetChanged(slot);
+	}
+}
+
+void TransformStore::Multiply(const TransformMatrix& parent, const TransformMatrix& local, TransformMatrix& out)
+{
+	TransformMatrix result;
+	MultiplyMatrix(parent, local, result);
+	out = result;
+}
+
+void TransformStore::SetChangedConcurrently(uint32_t slot)
+{
+	uint32_t first = m_concurrentFirstChangedSlot.load(std::memory_order_relaxed);
+	while (slot < first && !m_concurrentFirstChangedSlot.compare_exchange_weak(first, slot, std::memory_order_relaxed))
+	{
+	}
+}
+
+uint32_t TransformStore::Evaluate(Handle handle)
+{
+	uint32_t slot = m_slots[handle];
+	if (m_concurrent)
+		return EvaluateConcurrently(slot);
+
+	AdvanceEpoch();
+	if (m_updatedEpoch == m_epoch || m_epochs[slot] == m_epoch)
+		return slot;
+
+	// walk up to the nearest ancestor known to be up to date, then
+	// evaluate the path down, each node is visited once per epoch.
+	m_chain.clear();
+	for (uint32_t current = slot; current != INVALID_SLOT && m_epochs[current] != m_epoch; current = m_parents[current])
+	{
+		m_chain.push_back(current);
+	}
+
+	for (size_t i = m_chain.size(); i > 0; i--)
+	{
+		uint32_t current = m_chain[i - 1];
+		EvaluateSlot(current);
+		m_epochs[current] = m_epoch;
+	}
+	return slot;
+}
+
+uint32_t TransformStore::EvaluateConcurrently(uint32_t slot)
+{
+	// nothing changed since Update, by any thread.
+	if (m_concurrentFirstChangedSlot.load(std::memory_order_relaxed) == INVALID_SLOT)
+		return slot;
+
+	// epochs are shared, walk the whole path instead, ancestors
+	// belong to the same subtree as the node.
+	static thread_local std::vector<uint32_t> chain;
+	chain.clear();
+	for (uint32_t current = slot; current != INVALID_SLOT; current = m_parents[current])
+	{
+		chain.push_back(current);
+	}
+
+	for (size_t i = chain.size(); i > 0; i--)
+	{
+		EvaluateSlot(chain[i - 1]);
+	}
+	return slot;
+}
+
+void TransformStore::EvaluateSlot(uint32_t slot)
+{
+	uint32_t parent = m_parents[slot];
+	uint32_t parentVersion = (parent == INVALID_SLOT) ? 0 : m_worldVersions[parent];
+	if ((m_flags[slot] & LOCAL_CHANGED) || m_parentVersions[slot] != parentVersion)
+	{
+		if (m_flags[slot] & LOCAL_MATRIX_DIRTY)
+		{
+			UpdateLocalMatrix(slot);
+		}
+		UpdateWorldMatrix(slot);
+		m_flags[slot] = (m_flags[slot] & ~LOCAL_CHANGED) | WORLD_CHANGED;
+		m_parentVersions[slot] = parentVersion;
+		m_worldVersions[slot]++;
+	}
+}
+
+void TransformStore::AdvanceEpoch()
+{
+	if (!m_epochExpired)
+		return;
+
+	m_epochExpired = false;
+	if (++m_epoch == 0)
+	{
+		// stamps of 4 billion epochs ago would look valid again.
+		std::fill(m_epochs.begin(), m_epochs.end(), 0);
+		m_epoch = 1;
+		m_updatedEpoch = 0;
+	}
+}
+
+void TransformStore::UpdateLocalMatrix(uint32_t slot)
+{
+	ComposeMatrix(m_positions[slot], m_rotations[slot], m_scales[slot], m_pivots[slot], m_localMatrices[slot]);
+	m_flags[slot] &= ~LOCAL_MATRIX_DIRTY;
+}
+
+void TransformStore::UpdateWorldMatrix(uint32_t slot)
+{
+	uint32_t parent = m_parents[slot];
+	if (parent == INVALID_SLOT)
+	{
+		m_worldMatrices[slot] = m_localMatrices[slot];
+	}
+	else
+	{
+		MultiplyMatrix(m_worldMatrices[parent], m_localMatrices[slot], m_worldMatrices[slot]);
+	}
+}
@@ -0,0 +1,182 @@
+#pragma once
+#include <cinttypes>
+#include <atomic>
+#include <vector>
+
+// Transforms of all nodes of a scene in structure-of-arrays form.
+// Vector and matrix types are laid out exactly like gml::vec2 and
+// gml::mat32, the engine reinterprets them directly.
+struct TransformVector
+{
+	float x;
+	float y;
+};
+
+// two rows of (m0, m1, translation), same as gml::mat32.
+struct TransformMatrix
+{
+	float row[2][3];
+};
+
+// Every attribute lives in its own contiguous array indexed by slot,
+// slots are sorted by depth in hierarchy so that parents always come
+// before their children, and Update recomputes all dirty world matrices
+// in one linear pass without chasing pointers. Nodes created after the
+// last compaction are appended to the end, which keeps parents first.
+// Handles stay valid until destroyed while slots move on compaction.
+//
+// Setters only mark the node itself, changes reach descendants lazily:
+// every world matrix carries a version, bumped when it is recomputed,
+// and a child is out of date when its parent's version differs from the
+// one it was computed with. Evaluated nodes are stamped with an epoch
+// which advances whenever something changes, so a node is checked
+// against its ancestors at most once between changes.
+//
+// Between BeginConcurrent and EndConcurrent, threads may set and read
+// transforms of disjoint subtrees concurrently, nodes can not be
+// created or destroyed meanwhile.
+class TransformStore
+{
+public:
+	typedef uint32_t Handle;
+
+	static const Handle INVALID_HANDLE = 0xFFFFFFFF;
+
+	// parent must be created before, or INVALID_HANDLE for root nodes.
+	Handle Create(Handle parent);
+
+	// children must be destroyed as well, before next Update.
+	void Destroy(Handle handle);
+
+	void Reserve(uint32_t count);
+
+	// destroy every transform, handles are reused from 0.
+	void Clear();
+
+	// number of living transforms.
+	uint32_t GetCount() const { return static_cast<uint32_t>(m_handles.size()) - m_holeCount; }
+
+	void SetPosition(Handle handle, const TransformVector& position);
+
+	void SetPivot(Handle handle, const TransformVector& pivot);
+
+	void SetScale(Handle handle, const TransformVector& scale);
+
+	void SetRotation(Handle handle, float radian);
+
+	void SetTransform(Handle handle, const TransformVector& position, float radian, const TransformVector& scale, const TransformVector& pivot);
+
+	const TransformVector& GetPosition(Handle handle) const { return m_positions[m_slots[handle]]; }
+
+	const TransformVector& GetPivot(Handle handle) const { return m_pivots[m_slots[handle]]; }
+
+	const TransformVector& GetScale(Handle handle) const { return m_scales[m_slots[handle]]; }
+
+	float GetRotation(Handle handle) const { return m_rotations[m_slots[handle]]; }
+
+	const TransformMatrix& GetLocalMatrix(Handle handle);
+
+	// up to date even if Update is not called yet, by evaluating
+	// the dirty part of its ancestors.
+	const TransformMatrix& GetWorldMatrix(Handle handle);
+
+	// changes whenever the world matrix is recomputed, compare it with
+	// a saved one to know whether the node moved, directly or not.
+	uint32_t GetWorldVersion(Handle handle) { return m_worldVersions[Evaluate(handle)]; }
+
+	// recompute local and world matrices of every changed node and
+	// their descendants, called once per frame. It starts from the first
+	// changed slot, and returns at once if nothing has changed. Handles
+	// whose world matrix is recomputed since last Update are appended to
+	// worldChanged, parents before children.
+	void Update(std::vector<Handle>* worldChanged = nullptr);
+
+	// remove holes left by destroyed nodes and sort appended nodes by
+	// depth, Update does it automatically when they pile up.
+	void Compact();
+
+	// Update must be called just before, so that every node is up to
+	// date when it begins. Shared states are not touched during it,
+	// querying walks up to the root instead of relying on epochs.
+	void BeginConcurrent();
+
+	void EndConcurrent();
+
+	// out = parent * local, for matrices of different stores.
+	static void Multiply(const TransformMatrix& parent, const TransformMatrix& local, TransformMatrix& out);
+
+private:
+	enum : uint8_t
+	{
+		LOCAL_MATRIX_DIRTY = 1,		// local matrix need to be recomputed.
+		LOCAL_CHANGED = 2,			// world matrix need to be recomputed.
+		WORLD_CHANGED = 4,			// world matrix recomputed since last Update.
+		SLOT_FREE = 8,
+	};
+
+	static const uint32_t INVALID_SLOT = 0xFFFFFFFF;
+
+	void SetLocalDirty(uint32_t slot)
+	{
+		m_flags[slot] |= LOCAL_MATRIX_DIRTY | LOCAL_CHANGED;
+		if (m_concurrent)
+			SetChangedConcurrently(slot);
+		else
+			SetChanged(slot);
+	}
+
+	void SetChanged(uint32_t slot)
+	{
+		m_epochExpired = true;
+		if (slot < m_firstChangedSlot)
+			m_firstChangedSlot = slot;
+	}
+
+	void SetChangedConcurrently(uint32_t slot);
+
+	// bring world matrix of the node up to date, returns its slot.
+	uint32_t Evaluate(Handle handle);
+
+	uint32_t EvaluateConcurrently(uint32_t slot);
+
+	// recompute the slot if it or its parent changed, parent
+	// must be up to date.
+	void EvaluateSlot(uint32_t slot);
+
+	void AdvanceEpoch();
+
+	void UpdateLocalMatrix(uint32_t slot);
+
+	void UpdateWorldMatrix(uint32_t slot);
+
+	// handle -> slot, and slot -> handle.
+	std::vector<uint32_t> m_slots;
+	std::vector<Handle> m_handles;
+	std::vector<Handle> m_freeHandles;
+
+	std::vector<TransformVector> m_positions;
+	std::vector<TransformVector> m_pivots;
+	std::vector<TransformVector> m_scales;
+	std::vector<float> m_rotations;
+	std::vector<TransformMatrix> m_localMatrices;
+	std::vector<TransformMatrix> m_worldMatrices;
+	std::vector<uint32_t> m_parents;
+	std::vector<uint32_t> m_depths;
+	std::vector<uint8_t> m_flags;
+	std::vector<uint32_t> m_worldVersions;
+	std::vector<uint32_t> m_parentVersions;	// world version of parent when computed.
+	std::vector<uint32_t> m_epochs;			// epoch when known to be up to date.
+
+	std::vector<uint32_t> m_chain;
+	uint32_t m_holeCount = 0;
+	uint32_t m_sortedCount = 0;
+	uint32_t m_firstChangedSlot = INVALID_SLOT;
+
+	// every node is up to date when m_updatedEpoch equals m_epoch.
+	uint32_t m_epoch = 1;
+	uint32_t m_updatedEpoch = 0;
+	bool m_epochExpired = false;
+
+	bool m_concurrent = false;
+	std::atomic<uint32_t> m_concurrentFirstChangedSlot{ INVALID_SLOT };
+};
@@ -65,10 +65,11 @@ Hexagon::Hexagon()
 {
 	m_aabb.empty();
 	gml::aabb2d HexagonAABB;
-	m_lastColor = m_color = gml::color4::random();
 	gml::mat32 transform = gml::mat32::identity();
 
-	auto HexagonMesh = CreateHexagonMesh(kHexagonSize - kHexagonMargin, m_color, &HexagonAABB);
+	// vertices keep white, color comes from tint draw param,
+	// so that hexagons with different colors still batch together.
+	auto HexagonMesh = CreateHexagonMesh(kHexagonSize - kHexagonMargin, gml::color4::white(), &HexagonAABB);
 	m_mesh = g2d::Mesh::Create(0, 0);
 
 	for (int line = 1; line < 3; line++)
@@ -86,6 +87,8 @@ Hexagon::Hexagon()
 	}
 	HexagonMesh->Release();
 	m_material = g2d::Material::CreateSimpleColor();
+	m_lastColor = gml::color4::random();
+	SetColor(m_lastColor);
 }
 
 Hexagon::~Hexagon()
@@ -102,12 +105,8 @@ const gml::color4& Hexagon::GetColor()
 void Hexagon::SetColor(const gml::color4 & color)
 {
 	m_color = color;
-	uint32_t count = m_mesh->GetVertexCount();
-	g2d::GeometryVertex* vertices = m_mesh->GetRawVertices();
-	for (uint32_t i = 0; i < count; i++)
-	{
-		vertices[i].vtxcolor = color;
-	}
+	gml::vec4 tint(color.r, color.g, color.b, color.a);
+	m_material->GetPassByIndex(0)->SetDrawParam(g2d::DrawParam::Tint, tint);
 }
 
 void HexagonBoard::OnInitial()
@@ -11,7 +11,7 @@ class Hexagon : public g2d::Component
 {
 	RTTI_IMPL;
 public://implement
-	virtual void Release() override { delete this; }
+	virtual void Release() override { g2d::DestroyComponent(this); }
 
 	virtual const gml::aabb2d& GetLocalAABB() const override { return m_aabb; };
 
@@ -50,7 +50,7 @@ class HexagonBoard : public g2d::Component
 {
 	RTTI_IMPL;
 public:
-	virtual void Release() override { delete this; }
+	virtual void Release() override { g2d::DestroyComponent(this); }
 
 	virtual const gml::aabb2d& GetLocalAABB() const override { return m_aabb; };
 
@@ -85,7 +85,7 @@ class EntityDragging : public g2d::Component
 {
 	RTTI_IMPL;
 public: //implement
-	virtual void Release() override { delete this; }
+	virtual void Release() override { g2d::DestroyComponent(this); }
 
 	virtual void OnLDragBegin(const g2d::Mouse& mouse, const g2d::Keyboard& keyboard) override
 	{
@@ -63,7 +63,7 @@ class KeyboardMoving : public g2d::Component
 {
 	RTTI_IMPL;
 public: //implement
-	virtual void Release() override { delete this; }
+	virtual void Release() override { g2d::DestroyComponent(this); }
 
 	virtual void OnKeyPress(g2d::KeyCode key, const g2d::Mouse& mouse, const g2d::Keyboard& keyboard) override
 	{
@@ -120,7 +120,7 @@ g2d::SceneNode* CreateQuadNode(g2d::SceneNode* parent)
 	auto quad = g2d::Quad::Create()->SetSize(gml::vec2(100, 120));
 	auto child = parent->CreateChild()->SetPosition(gml::vec2(50, 20));
 	child->AddComponent(quad, true);
-	child->AddComponent(new KeyboardMoving(), true);
+	child->AddComponent(g2d::CreateComponent<KeyboardMoving>(), true);
 	child->SetStatic(false);
 	return child;
 }
@@ -133,13 +133,13 @@ void Testbed::Start()
 	// board
 	auto boardNode = mainScene->CreateChild();
 	boardNode->SetPosition({ -200.0f, 0.0f });
-	boardNode->AddComponent(new HexagonBoard(), true);
+	boardNode->AddComponent(g2d::CreateComponent<HexagonBoard>(), true);
 
 	//hexgon node
 	HexagonNode = mainScene->CreateChild();
 	HexagonNode->SetPosition({ 0,0 });
-	HexagonNode->AddComponent(new Hexagon(), true);
-	HexagonNode->AddComponent(new EntityDragging(), true);
+	HexagonNode->AddComponent(g2d::CreateComponent<Hexagon>(), true);
+	HexagonNode->AddComponent(g2d::CreateComponent<EntityDragging>(), true);
 
 	auto quad = g2d::Quad::Create()->SetSize(gml::vec2(100, 120));
 	auto node = mainScene->CreateChild()->SetPosition(gml::vec2(300, 0));
@@ -151,7 +151,7 @@ void Testbed::Start()
 		auto quad = g2d::Quad::Create()->SetSize(gml::vec2(100, 120));
 		auto child = node->CreateChild()->SetPosition(gml::vec2(50, 60));
 		child->AddComponent(quad, true);
-		child->AddComponent(new KeyboardMoving(), true);
+		child->AddComponent(g2d::CreateComponent<KeyboardMoving>(), true);
 		child->SetStatic(true);
 		node = child;
 	}
@@ -0,0 +1,167 @@
+#pragma once
+#include <cinttypes>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <chrono>
+#include <new>
+#include <string>
+#include <vector>
+
+// Scaffolding shared by the benches: parsing command line options,
+// timing the best of rounds, and counting heap allocations.
+
+typedef std::chrono::steady_clock Clock;
+
+inline double ElapsedNanoseconds(Clock::time_point startTime)
+{
+	return std::chrono::duration<double, std::nano>(Clock::now() - startTime).count();
+}
+
+inline double ElapsedMicroseconds(Clock::time_point startTime)
+{
+	return std::chrono::duration<double, std::micro>(Clock::now() - startTime).count();
+}
+
+inline double ElapsedMilliseconds(Clock::time_point startTime)
+{
+	return std::chrono::duration<double, std::milli>(Clock::now() - startTime).count();
+}
+
+// best is the sample of the first round, or a smaller one.
+inline void KeepBest(uint32_t round, double sample, double& best)
+{
+	if (round == 0 || sample < best)
+		best = sample;
+}
+
+// Options are "-name value" or "-name" flags, arguments without a name
+// are taken in order and all of them are required. Usage is printed
+// when an option is unknown, or a value or an argument is missing.
+class CommandLine
+{
+public:
+	explicit CommandLine(const char* usage) : m_usage(usage) { }
+
+	// the value is clamped to [minimum, maximum].
+	void Add(const char* name, uint32_t& value, uint32_t minimum = 0, uint32_t maximum = UINT32_MAX)
+	{
+		m_options.push_back({ name, &value, nullptr, nullptr, minimum, maximum });
+	}
+
+	void Add(const char* name, std::string& value)
+	{
+		m_options.push_back({ name, nullptr, &value, nullptr, 0, 0 });
+	}
+
+	void AddFlag(const char* name, bool& value)
+	{
+		m_options.push_back({ name, nullptr, nullptr, &value, 0, 0 });
+	}
+
+	void AddArgument(std::string& value)
+	{
+		m_arguments.push_back(&value);
+	}
+
+	bool Parse(int argc, char* argv[])
+	{
+		size_t argumentCount = 0;
+		for (int i = 1; i < argc; i++)
+		{
+			const Option* option = Find(argv[i]);
+			if (option == nullptr)
+			{
+				if (argv[i][0] == '-' || argumentCount == m_arguments.size())
+					return PrintUsage();
+
+				*m_arguments[argumentCount++] = argv[i];
+			}
+			else if (option->flag != nullptr)
+			{
+				*option->flag = true;
+			}
+			else if (i + 1 == argc)
+			{
+				return PrintUsage();
+			}
+			else if (option->text != nullptr)
+			{
+				*option->text = argv[++i];
+			}
+			else
+			{
+				long long value = strtoll(argv[++i], nullptr, 10);
+				value = value < option->minimum ? option->minimum : value;
+				value = value > option->maximum ? option->maximum : value;
+				*option->number = static_cast<uint32_t>(value);
+			}
+		}
+		return argumentCount == m_arguments.size() || PrintUsage();
+	}
+
+private:
+	struct Option
+	{
+		const char* name;
+		uint32_t* number;
+		std::string* text;
+		bool* flag;
+		uint32_t minimum;
+		uint32_t maximum;
+	};
+
+	const Option* Find(const char* name) const
+	{
+		for (auto& option : m_options)
+		{
+			if (strcmp(option.name, name) == 0)
+				return &option;
+		}
+		return nullptr;
+	}
+
+	bool PrintUsage() const
+	{
+		printf("usage: %s\n", m_usage);
+		return false;
+	}
+
+	const char* m_usage;
+	std::vector<Option> m_options;
+	std::vector<std::string*> m_arguments;
+};
+
+// Define BENCH_COUNT_ALLOCATIONS before including it, in the only source
+// file of a bench, to replace the global operator new and delete with
+// ones counting allocations.
+#ifdef BENCH_COUNT_ALLOCATIONS
+namespace
+{
+	uint64_t g_allocationCount = 0;
+}
+
+inline uint64_t GetAllocationCount()
+{
+	return g_allocationCount;
+}
+
+void* operator new(size_t size)
+{
+	g_allocationCount++;
+	void* memory = malloc(size == 0 ? 1 : size);
+	if (memory == nullptr)
+		throw std::bad_alloc();
+	return memory;
+}
+
+void operator delete(void* memory) noexcept
+{
+	free(memory);
+}
+
+void operator delete(void* memory, size_t) noexcept
+{
+	free(memory);
+}
+#endif
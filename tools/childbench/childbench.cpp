@@ -0,0 +1,240 @@
+// childbench: measure releasing and reordering children of a crowded node.
+//
+//   childbench [-n children] [-o operations] [-seed N]
+//
+// Compares SiblingList, which SceneNodeContainer keeps children in, with
+// the vector it replaced: removing or moving a child shifted all children
+// between, and wrote their child indices again. A node gets n children,
+// then random children are released and replaced by new ones, or moved
+// to the front, back, previous or next of their siblings. Child indices
+// written and time are reported per operation, indices are only found
+// again by the linked list when they are queried, once at the end. The
+// list is the engine's, nodes are small structs instead of ::SceneNode,
+// which needs a renderer to build. Orders of both lists are checked to be
+// the same afterwards. It builds with:
+//
+//   g++ -std=c++11 -O2 -I../../got2d/source childbench.cpp
+
+#include <algorithm>
+#include <memory>
+#include <random>
+#include <vector>
+#include "sibling_list.h"
+#include "../bench.h"
+
+struct Options
+{
+	uint32_t childCount = 50000;
+	uint32_t operations = 100000;
+	uint32_t seed = 1;
+};
+
+struct Node
+{
+	uint32_t id = 0;
+	uint32_t childIndex = 0;
+	Node* prevSibling = nullptr;
+	Node* nextSibling = nullptr;
+};
+
+// the way SceneNodeContainer kept children before.
+class VectorChildren
+{
+public:
+	void Append(Node* child)
+	{
+		child->childIndex = static_cast<uint32_t>(m_children.size());
+		m_children.push_back(child);
+		written++;
+	}
+
+	void Remove(Node* child)
+	{
+		uint32_t index = child->childIndex;
+		m_children.erase(m_children.begin() + index);
+		for (uint32_t i = index; i < m_children.size(); i++)
+		{
+			m_children[i]->childIndex = i;
+			written++;
+		}
+	}
+
+	void MoveToFront(Node* child) { Move(child->childIndex, static_cast<uint32_t>(m_children.size()) - 1); }
+
+	void MoveToBack(Node* child) { Move(child->childIndex, 0); }
+
+	void MovePrev(Node* child) { if (child->childIndex > 0) Move(child->childIndex, child->childIndex - 1); }
+
+	void MoveNext(Node* child) { if (child->childIndex + 1 < m_children.size()) Move(child->childIndex, child->childIndex + 1); }
+
+	void Collect(std::vector<uint32_t>& ids)
+	{
+		for (auto child : m_children)
+			ids.push_back(child->id);
+	}
+
+	uint64_t written = 0;
+
+private:
+	void Move(uint32_t from, uint32_t to)
+	{
+		Node* node = m_children[from];
+		if (from > to)
+		{
+			for (uint32_t i = from; i > to; i--)
+			{
+				m_children[i] = m_children[i - 1];
+				m_children[i]->childIndex = i;
+				written++;
+			}
+		}
+		else
+		{
+			for (uint32_t i = from; i < to; i++)
+			{
+				m_children[i] = m_children[i + 1];
+				m_children[i]->childIndex = i;
+				written++;
+			}
+		}
+		m_children[to] = node;
+		node->childIndex = to;
+		written++;
+	}
+
+	std::vector<Node*> m_children;
+};
+
+// counts child indices written.
+struct NodeSiblingAccess
+{
+	uint64_t* written;
+
+	Node* Prev(Node* node) const { return node->prevSibling; }
+
+	Node* Next(Node* node) const { return node->nextSibling; }
+
+	void SetPrev(Node* node, Node* prev) const { node->prevSibling = prev; }
+
+	void SetNext(Node* node, Node* next) const { node->nextSibling = next; }
+
+	uint32_t GetIndex(const Node* node) const { return node->childIndex; }
+
+	void SetIndex(Node* node, uint32_t index) const
+	{
+		node->childIndex = index;
+		(*written)++;
+	}
+};
+
+// the list of SceneNodeContainer, operations as the scene does them.
+class LinkedChildren
+{
+public:
+	void Append(Node* child) { m_list.Append(child); }
+
+	void Remove(Node* child) { m_list.Remove(child); }
+
+	void MoveToFront(Node* child) { m_list.Move(child, nullptr); }
+
+	void MoveToBack(Node* child) { m_list.Move(child, m_list.First()); }
+
+	void MovePrev(Node* child) { if (child->prevSibling != nullptr) m_list.Move(child, child->prevSibling); }
+
+	void MoveNext(Node* child) { if (child->nextSibling != nullptr) m_list.Move(child, child->nextSibling->nextSibling); }
+
+	void Collect(std::vector<uint32_t>& ids)
+	{
+		m_list.UpdateIndices();
+		for (Node* child = m_list.First(); child != nullptr; child = child->nextSibling)
+			ids.push_back(child->id);
+	}
+
+	uint64_t written = 0;
+
+private:
+	SiblingList<Node, NodeSiblingAccess> m_list{ NodeSiblingAccess{ &written } };
+};
+
+struct Result
+{
+	double operationNs = 0.0;
+	double written = 0.0;		// child indices per operation.
+	std::vector<uint32_t> ids;	// children in order afterwards.
+};
+
+template<typename CHILDREN>
+Result Measure(const Options& options)
+{
+	Result result;
+	CHILDREN children;
+	std::vector<std::unique_ptr<Node>> storage;
+	std::vector<Node*> nodes;	// in no particular order, to pick randomly.
+	std::mt19937 random(options.seed);
+	uint32_t nextID = 0;
+	for (uint32_t i = 0; i < options.childCount; i++)
+	{
+		storage.emplace_back(new Node());
+		storage.back()->id = nextID++;
+		nodes.push_back(storage.back().get());
+		children.Append(nodes.back());
+	}
+	children.written = 0;
+
+	auto startTime = Clock::now();
+	for (uint32_t i = 0; i < options.operations; i++)
+	{
+		uint32_t position = random() % nodes.size();
+		Node* node = nodes[position];
+		switch (random() % 5)
+		{
+		case 0:
+			// released ones are replaced, so that the count holds.
+			children.Remove(node);
+			node->id = nextID++;
+			children.Append(node);
+			break;
+		case 1:
+			children.MoveToFront(node);
+			break;
+		case 2:
+			children.MoveToBack(node);
+			break;
+		case 3:
+			children.MovePrev(node);
+			break;
+		default:
+			children.MoveNext(node);
+			break;
+		}
+	}
+	children.Collect(result.ids);
+	result.operationNs = ElapsedNanoseconds(startTime) / options.operations;
+	result.written = static_cast<double>(children.written) / options.operations;
+	return result;
+}
+
+int main(int argc, char* argv[])
+{
+	Options options;
+	CommandLine commandLine("childbench [-n children] [-o operations] [-seed N]");
+	commandLine.Add("-n", options.childCount, 1);
+	commandLine.Add("-o", options.operations, 1);
+	commandLine.Add("-seed", options.seed);
+	if (!commandLine.Parse(argc, argv))
+		return 1;
+
+	Result vectorResult = Measure<VectorChildren>(options);
+	Result linkedResult = Measure<LinkedChildren>(options);
+	if (vectorResult.ids != linkedResult.ids)
+	{
+		fprintf(stderr, "childbench: children are not in the same order\n");
+		return 1;
+	}
+
+	printf("%u children, %u operations\n", options.childCount, options.operations);
+	printf("%-9s %12s %16s\n", "children", "op ns", "indices/op");
+	printf("%-9s %12.1f %16.1f\n", "vector", vectorResult.operationNs, vectorResult.written);
+	printf("%-9s %12.1f %16.1f\n", "linked", linkedResult.operationNs, linkedResult.written);
+	return 0;
+}
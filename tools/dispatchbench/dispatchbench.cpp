@@ -0,0 +1,294 @@
+// dispatchbench: measure dispatching to components added and removed every frame.
+//
+//   dispatchbench [-r rounds] [-n nodes] [-c components] [-f frames] [-p churn%] [-seed N]
+//
+// Compares OrderedList, which components of a node are kept in, with the
+// list it replaced: components, released ones and a copy for dispatching
+// in three vectors, the copy was made again after every change. Every
+// frame each component is updated once, and churn% of them replace
+// themselves during their update, like effects which expire. Replacing
+// is recorded by a buffer shared by all lists, as the command buffer of
+// the scene, and applied after dispatching, the old list changed at once
+// and released removed ones after dispatching. Stand-in
+// components are used, the engine needs a renderer to build. Memory is
+// the inline size of the list plus its heap blocks per node after the
+// run, and heap allocations are counted in the last round. It builds with:
+//
+//   g++ -std=c++11 -O2 -I../../got2d/source dispatchbench.cpp
+
+#include <algorithm>
+#include <random>
+#include <vector>
+#include "ordered_list.h"
+#define BENCH_COUNT_ALLOCATIONS
+#include "../bench.h"
+
+struct Options
+{
+	uint32_t rounds = 5;
+	uint32_t nodeCount = 10000;
+	uint32_t componentCount = 4;
+	uint32_t frames = 100;
+	uint32_t churnPercent = 10;
+	uint32_t seed = 1;
+};
+
+struct StandInComponent
+{
+	int executeOrder = 0;
+	uint32_t updateCount = 0;
+};
+
+// same layout as NodeComponent of the engine.
+struct Item
+{
+	Item(StandInComponent* c, bool ar) : component(c), autoRelease(ar) { }
+	StandInComponent* component = nullptr;
+	uint32_t eventMask = 1;
+	bool autoRelease = false;
+};
+
+struct ExecuteOrderLess
+{
+	bool operator()(const Item& a, const Item& b) const
+	{
+		return a.component->executeOrder < b.component->executeOrder;
+	}
+};
+
+// the list replaced by OrderedList.
+class CopyOnChangeList
+{
+public:
+	void Add(StandInComponent* component)
+	{
+		auto itCur = std::find_if(m_items.begin(), m_items.end(), [&](const Item& item) { return ExecuteOrderLess()(Item(component, true), item); });
+		m_items.insert(itCur, Item(component, true));
+		m_changed = true;
+	}
+
+	bool Remove(StandInComponent* component)
+	{
+		auto itFound = std::find_if(m_items.begin(), m_items.end(), [&](const Item& item) { return item.component == component; });
+		if (itFound == m_items.end())
+			return false;
+
+		m_released.push_back(*itFound);
+		m_items.erase(itFound);
+		m_changed = true;
+		return true;
+	}
+
+	template<typename FUNC, typename RELEASE> void Dispatch(FUNC func, RELEASE release)
+	{
+		if (m_changed)
+		{
+			DelayRemove(release);
+			m_collection = m_items;
+			m_changed = false;
+		}
+
+		for (auto& item : m_collection)
+			func(item.component);
+		DelayRemove(release);
+	}
+
+	size_t GetMemory() const
+	{
+		return sizeof(*this) + (m_items.capacity() + m_released.capacity() + m_collection.capacity()) * sizeof(Item);
+	}
+
+private:
+	template<typename RELEASE> void DelayRemove(RELEASE release)
+	{
+		for (auto& item : m_released)
+			release(item.component);
+		m_released.clear();
+	}
+
+	std::vector<Item> m_items;
+	std::vector<Item> m_released;
+	std::vector<Item> m_collection;
+	uint32_t m_eventMask = 0;
+	bool m_changed = true;
+};
+
+class OrderedComponentList
+{
+public:
+	void Add(StandInComponent* component)
+	{
+		if (s_dispatching)
+			s_commands.push_back({ this, nullptr, component });
+		else
+			m_items.Add(Item(component, true));
+	}
+
+	bool Remove(StandInComponent* component)
+	{
+		if (s_dispatching)
+		{
+			s_commands.push_back({ this, component, nullptr });
+			return true;
+		}
+
+		Item removed(nullptr, false);
+		return m_items.Remove([&](const Item& item) { return item.component == component; }, removed);
+	}
+
+	template<typename FUNC, typename RELEASE> void Dispatch(FUNC func, RELEASE release)
+	{
+		s_dispatching = true;
+		m_items.Traversal([&](const Item& item) { func(item.component); });
+		s_dispatching = false;
+
+		for (auto& command : s_commands)
+		{
+			if (command.removed != nullptr && command.list->Remove(command.removed))
+				release(command.removed);
+			if (command.added != nullptr)
+				command.list->Add(command.added);
+		}
+		s_commands.clear();
+	}
+
+	size_t GetMemory() const
+	{
+		// inline items are counted by sizeof.
+		uint32_t capacity = m_items.GetCapacity();
+		return sizeof(*this) + (capacity > INLINE_COUNT ? capacity * sizeof(Item) : 0);
+	}
+
+private:
+	struct Command
+	{
+		OrderedComponentList* list;
+		StandInComponent* removed;
+		StandInComponent* added;
+	};
+
+	static const uint32_t INLINE_COUNT = 2;	// as ComponentContainer.
+	static bool s_dispatching;
+	static std::vector<Command> s_commands;
+	OrderedList<Item, ExecuteOrderLess, INLINE_COUNT> m_items;
+	uint32_t m_eventMask = 0;
+};
+
+bool OrderedComponentList::s_dispatching = false;
+std::vector<OrderedComponentList::Command> OrderedComponentList::s_commands;
+
+// components are recycled, so that only allocations of lists are counted.
+class ComponentSource
+{
+public:
+	explicit ComponentSource(uint32_t count) : m_storage(count)
+	{
+		m_free.reserve(count);
+		for (auto& component : m_storage)
+			m_free.push_back(&component);
+	}
+
+	StandInComponent* Create()
+	{
+		StandInComponent* component = m_free.back();
+		m_free.pop_back();
+		component->updateCount = 0;
+		return component;
+	}
+
+	void Release(StandInComponent* component) { m_free.push_back(component); }
+
+private:
+	std::vector<StandInComponent> m_storage;
+	std::vector<StandInComponent*> m_free;
+};
+
+struct Result
+{
+	double frameUs = 0.0;
+	uint64_t updates = 0;		// in the last round, same for both lists.
+	uint64_t allocations = 0;	// in the last round.
+	double bytesPerNode = 0.0;
+};
+
+template<typename LIST>
+Result Measure(const Options& options)
+{
+	Result result;
+	for (uint32_t round = 0; round < options.rounds; round++)
+	{
+		// removed ones wait for releasing, keep twice for them.
+		ComponentSource source(options.nodeCount * options.componentCount * 2);
+		std::vector<LIST> lists(options.nodeCount);
+		for (auto& list : lists)
+		{
+			for (uint32_t i = 0; i < options.componentCount; i++)
+				list.Add(source.Create());
+		}
+
+		std::mt19937 random(options.seed);
+		uint64_t updates = 0;
+		uint64_t allocations = GetAllocationCount();
+		auto release = [&](StandInComponent* component) { source.Release(component); };
+		auto startTime = Clock::now();
+		for (uint32_t frame = 0; frame < options.frames; frame++)
+		{
+			for (auto& list : lists)
+			{
+				list.Dispatch([&](StandInComponent* component)
+				{
+					component->updateCount++;
+					updates++;
+					if (random() % 100 < options.churnPercent)
+					{
+						list.Remove(component);
+						list.Add(source.Create());
+					}
+				}, release);
+			}
+		}
+		double time = ElapsedMicroseconds(startTime);
+		result.allocations = GetAllocationCount() - allocations;
+		result.updates = updates;
+		KeepBest(round, time / options.frames, result.frameUs);
+
+		size_t memory = 0;
+		for (auto& list : lists)
+			memory += list.GetMemory();
+		result.bytesPerNode = static_cast<double>(memory) / options.nodeCount;
+	}
+	return result;
+}
+
+int main(int argc, char* argv[])
+{
+	Options options;
+	CommandLine commandLine("dispatchbench [-r rounds] [-n nodes] [-c components] [-f frames] [-p churn%] [-seed N]");
+	commandLine.Add("-r", options.rounds, 1);
+	commandLine.Add("-n", options.nodeCount, 1);
+	commandLine.Add("-c", options.componentCount, 1);
+	commandLine.Add("-f", options.frames, 1);
+	commandLine.Add("-p", options.churnPercent, 0, 100);
+	commandLine.Add("-seed", options.seed);
+	if (!commandLine.Parse(argc, argv))
+		return 1;
+
+	Result copyResult = Measure<CopyOnChangeList>(options);
+	Result orderedResult = Measure<OrderedComponentList>(options);
+	if (copyResult.updates != orderedResult.updates)
+	{
+		fprintf(stderr, "dispatchbench: lists updated %llu and %llu components\n",
+			static_cast<unsigned long long>(copyResult.updates),
+			static_cast<unsigned long long>(orderedResult.updates));
+		return 1;
+	}
+
+	printf("best of %u rounds, %u nodes of %u components, %u%% replaced every frame, %u frames\n",
+		options.rounds, options.nodeCount, options.componentCount, options.churnPercent, options.frames);
+	printf("%-9s %12s %14s %14s\n", "list", "us/frame", "bytes/node", "allocations");
+	printf("%-9s %12.1f %14.1f %14llu\n", "copy", copyResult.frameUs, copyResult.bytesPerNode,
+		static_cast<unsigned long long>(copyResult.allocations));
+	printf("%-9s %12.1f %14.1f %14llu\n", "ordered", orderedResult.frameUs, orderedResult.bytesPerNode,
+		static_cast<unsigned long long>(orderedResult.allocations));
+	return 0;
+}
@@ -0,0 +1,157 @@
+// g2dpack: build and inspect resource pack archives.
+//
+//   g2dpack build [-a alignment] <output.pack> <resource folder>
+//   g2dpack list <input.pack>
+//
+// Every file under resource folder is packed, names are relative to
+// the folder with '/' separators, the same as names passed to engine.
+// It builds on any platform with only file_system.cpp:
+//
+//   g++ -std=c++11 -O2 -I../../got2d/source g2dpack.cpp ../../got2d/source/file_system.cpp
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <algorithm>
+#include <string>
+#include <vector>
+#include "file_system.h"
+
+uint64_t AlignUp(uint64_t value, uint32_t alignment)
+{
+	return (value + alignment - 1) / alignment * alignment;
+}
+
+int Build(const std::string& output, std::string folder, uint32_t alignment)
+{
+	std::replace(folder.begin(), folder.end(), '\\', '/');
+	if (!folder.empty() && folder.back() != '/')
+		folder.push_back('/');
+
+	// index is sorted by name, so that engine can binary search it.
+	std::vector<std::string> names;
+	ListLooseFiles(folder, names);
+	if (names.empty())
+	{
+		fprintf(stderr, "g2dpack: no file found in %s\n", folder.c_str());
+		return 1;
+	}
+
+	std::vector<FileView> files(names.size());
+	PackHeader header;
+	header.magic = PACK_MAGIC;
+	header.version = PACK_VERSION;
+	header.entryCount = static_cast<uint32_t>(names.size());
+	header.alignment = alignment;
+	header.namesOffset = sizeof(PackHeader) + sizeof(PackEntry) * names.size();
+	header.namesSize = 0;
+
+	std::vector<PackEntry> entries(names.size());
+	std::string nameBlob;
+	for (size_t i = 0; i < names.size(); i++)
+	{
+		if (!ReadLooseFile(folder + names[i], files[i]))
+		{
+			fprintf(stderr, "g2dpack: can not read %s\n", names[i].c_str());
+			return 1;
+		}
+		entries[i].nameOffset = static_cast<uint32_t>(nameBlob.size());
+		entries[i].nameLength = static_cast<uint32_t>(names[i].size());
+		entries[i].dataSize = files[i].GetSize();
+		nameBlob += names[i];
+	}
+	header.namesSize = nameBlob.size();
+
+	uint64_t offset = header.namesOffset + header.namesSize;
+	for (auto& entry : entries)
+	{
+		offset = AlignUp(offset, alignment);
+		entry.dataOffset = offset;
+		offset += entry.dataSize;
+	}
+
+	FILE* file = fopen(output.c_str(), "wb");
+	if (file == nullptr)
+	{
+		fprintf(stderr, "g2dpack: can not write %s\n", output.c_str());
+		return 1;
+	}
+
+	bool result = fwrite(&header, sizeof(header), 1, file) == 1 &&
+		fwrite(entries.data(), sizeof(PackEntry), entries.size(), file) == entries.size() &&
+		fwrite(nameBlob.data(), 1, nameBlob.size(), file) == nameBlob.size();
+
+	uint64_t written = header.namesOffset + header.namesSize;
+	const std::vector<uint8_t> padding(alignment, 0);
+	for (size_t i = 0; result && i < entries.size(); i++)
+	{
+		size_t paddingSize = static_cast<size_t>(entries[i].dataOffset - written);
+		result = fwrite(padding.data(), 1, paddingSize, file) == paddingSize &&
+			fwrite(files[i].GetData(), 1, static_cast<size_t>(entries[i].dataSize), file) == entries[i].dataSize;
+		written = entries[i].dataOffset + entries[i].dataSize;
+	}
+
+	if (fclose(file) != 0 || !result)
+	{
+		fprintf(stderr, "g2dpack: can not write %s\n", output.c_str());
+		return 1;
+	}
+
+	printf("%s: %u files, %llu bytes, alignment %u\n", output.c_str(), header.entryCount,
+		static_cast<unsigned long long>(written), alignment);
+	return 0;
+}
+
+int List(const std::string& input)
+{
+	PackArchive archive;
+	if (!archive.Open(input))
+	{
+		fprintf(stderr, "g2dpack: %s is not a valid pack\n", input.c_str());
+		return 1;
+	}
+
+	for (uint32_t i = 0; i < archive.GetEntryCount(); i++)
+	{
+		const PackEntry& entry = archive.GetEntry(i);
+		printf("%12llu %12llu  %s\n",
+			static_cast<unsigned long long>(entry.dataOffset),
+			static_cast<unsigned long long>(entry.dataSize),
+			archive.GetEntryName(i).c_str());
+	}
+	return 0;
+}
+
+void PrintUsage()
+{
+	printf("usage: g2dpack build [-a alignment] <output.pack> <resource folder>\n");
+	printf("       g2dpack list <input.pack>\n");
+}
+
+int main(int argc, char* argv[])
+{
+	if (argc == 3 && strcmp(argv[1], "list") == 0)
+	{
+		return List(argv[2]);
+	}
+
+	if (argc >= 4 && strcmp(argv[1], "build") == 0)
+	{
+		uint32_t alignment = PACK_DEFAULT_ALIGNMENT;
+		int argIndex = 2;
+		if (strcmp(argv[argIndex], "-a") == 0 && argc == 6)
+		{
+			alignment = static_cast<uint32_t>(atoi(argv[argIndex + 1]));
+			argIndex += 2;
+		}
+
+		// power of 2 keeps data aligned for SIMD and page mapping.
+		if (argIndex + 2 == argc && alignment != 0 && (alignment & (alignment - 1)) == 0)
+		{
+			return Build(argv[argIndex], argv[argIndex + 1], alignment);
+		}
+	}
+
+	PrintUsage();
+	return 1;
+}
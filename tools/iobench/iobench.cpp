@@ -0,0 +1,179 @@
+// iobench: measure loading time of every file in a resource folder.
+//
+//   iobench [-r rounds] [-t threads] [-q depth] [-warm] <resource folder>
+//
+// Compares blocking reads one file at a time, which is how resources
+// were loaded before, with AsyncIO batches on each available backend.
+// On linux page cache of the files is dropped before each round unless
+// -warm is given, so that cold start is measured. It builds with:
+//
+//   g++ -std=c++11 -O2 -pthread -I../../got2d/source iobench.cpp
+//       ../../got2d/source/file_system.cpp ../../got2d/source/async_io.cpp
+
+#include <algorithm>
+#include <atomic>
+#include <string>
+#include <vector>
+#include "file_system.h"
+#include "async_io.h"
+#include "../bench.h"
+
+#ifdef __linux__
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+struct Options
+{
+	std::string folder;
+	uint32_t rounds = 3;
+	uint32_t threadCount = 4;
+	uint32_t queueDepth = 128;
+	bool warm = false;
+};
+
+void DropPageCache(const FileSystem& fileSystem, const std::vector<std::string>& names)
+{
+#ifdef __linux__
+	// dropping clean pages of a file does not require root.
+	for (auto& name : names)
+	{
+		int fd = ::open((fileSystem.GetRoot() + name).c_str(), O_RDONLY);
+		if (fd >= 0)
+		{
+			::posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED);
+			::close(fd);
+		}
+	}
+#else
+	(void)fileSystem;
+	(void)names;
+#endif
+}
+
+uint64_t Checksum(const std::vector<FileView>& views)
+{
+	uint64_t sum = 0;
+	for (auto& view : views)
+	{
+		for (uint64_t i = 0; i < view.GetSize(); i += 4096)
+			sum = sum * 31 + view.GetData()[i];
+		sum += view.GetSize();
+	}
+	return sum;
+}
+
+// the way resources were loaded before: open and read files one by one.
+bool LoadBlocking(const FileSystem& fileSystem, const std::vector<std::string>& names, std::vector<FileView>& views)
+{
+	for (size_t i = 0; i < names.size(); i++)
+	{
+		if (!fileSystem.ReadFile(names[i], views[i]))
+			return false;
+	}
+	return true;
+}
+
+// all requests are prepared and submitted as one batch.
+bool LoadAsync(const FileSystem& fileSystem, AsyncIO& asyncIO, const std::vector<std::string>& names, std::vector<FileView>& views)
+{
+	std::atomic<uint32_t> failedCount(0);
+	std::vector<IORequest> batch;
+	for (size_t i = 0; i < names.size(); i++)
+	{
+		IORequest request;
+		if (fileSystem.PrepareRead(names[i], views[i], request) != FileLocation::Loose)
+			return false;
+
+		request.callback = [](void* userData, bool succeeded)
+		{
+			if (!succeeded)
+				(*static_cast<std::atomic<uint32_t>*>(userData))++;
+		};
+		request.userData = &failedCount;
+		batch.push_back(std::move(request));
+	}
+	asyncIO.Submit(batch);
+	asyncIO.WaitIdle();
+	return failedCount == 0;
+}
+
+int main(int argc, char* argv[])
+{
+	Options options;
+	CommandLine commandLine("iobench [-r rounds] [-t threads] [-q depth] [-warm] <resource folder>");
+	commandLine.Add("-r", options.rounds, 1);
+	commandLine.Add("-t", options.threadCount, 1);
+	commandLine.Add("-q", options.queueDepth, 1);
+	commandLine.AddFlag("-warm", options.warm);
+	commandLine.AddArgument(options.folder);
+	if (!commandLine.Parse(argc, argv))
+		return 1;
+
+	FileSystem fileSystem;
+	fileSystem.SetRoot(options.folder);
+	std::vector<std::string> names;
+	ListLooseFiles(fileSystem.GetRoot(), names);
+	if (names.empty())
+	{
+		fprintf(stderr, "iobench: no file found in %s\n", options.folder.c_str());
+		return 1;
+	}
+
+	uint64_t totalBytes = 0;
+	for (auto& name : names)
+	{
+		uint64_t size = 0;
+		GetLooseFileSize(fileSystem.GetRoot() + name, size);
+		totalBytes += size;
+	}
+	printf("%u files, %.2f MB, %s cache, best of %u rounds\n", static_cast<uint32_t>(names.size()),
+		totalBytes / (1024.0 * 1024.0), options.warm ? "warm" : "cold", options.rounds);
+
+	enum Mode { Blocking, ThreadPool, IoUring, ModeCount };
+	const char* modeNames[ModeCount] = { "blocking", "thread pool", "io_uring" };
+	uint64_t referenceChecksum = 0;
+	for (int mode = Blocking; mode < ModeCount; mode++)
+	{
+		AsyncIO asyncIO;
+		if (mode != Blocking)
+		{
+			asyncIO.Start(options.threadCount, options.queueDepth, mode == IoUring);
+			if (strcmp(asyncIO.GetBackendName(), modeNames[mode]) != 0)
+			{
+				printf("%12s: not available\n", modeNames[mode]);
+				continue;
+			}
+		}
+
+		double bestTime = 0.0;
+		for (uint32_t round = 0; round < options.rounds; round++)
+		{
+			if (!options.warm)
+				DropPageCache(fileSystem, names);
+
+			std::vector<FileView> views(names.size());
+			auto startTime = Clock::now();
+			bool succeeded = (mode == Blocking)
+				? LoadBlocking(fileSystem, names, views)
+				: LoadAsync(fileSystem, asyncIO, names, views);
+			double elapsed = ElapsedMilliseconds(startTime);
+
+			uint64_t checksum = Checksum(views);
+			if (mode == Blocking && round == 0)
+				referenceChecksum = checksum;
+
+			if (!succeeded || checksum != referenceChecksum)
+			{
+				fprintf(stderr, "iobench: %s read wrong data\n", modeNames[mode]);
+				return 1;
+			}
+
+			KeepBest(round, elapsed, bestTime);
+		}
+
+		printf("%12s: %9.2f ms %9.1f MB/s\n", modeNames[mode], bestTime,
+			totalBytes / (1024.0 * 1024.0) / (bestTime / 1000.0));
+	}
+	return 0;
+}
@@ -0,0 +1,174 @@
+// jobbench: measure overhead and scaling of the job system.
+//
+//   jobbench [-r rounds] [-t max threads] [-n jobs]
+//
+// Three cases are measured for 1 to max threads, the calling thread
+// counts as one: spawn overhead, empty jobs are spawned from the main
+// thread and waited, reported in ns per job; steal rate, a few jobs
+// carry most of the work and spawn children, reported as the share of
+// executed jobs taken from other workers; and parallel-for scaling, a
+// range of float arithmetic is split by ParallelFor, reported as speedup
+// over a plain loop. It builds with:
+//
+//   g++ -std=c++11 -O2 -pthread -I../../got2d/source jobbench.cpp
+//       ../../got2d/source/job_system.cpp
+
+#include <cmath>
+#include <algorithm>
+#include <atomic>
+#include <thread>
+#include <vector>
+#include "job_system.h"
+#include "../bench.h"
+
+struct Options
+{
+	uint32_t rounds = 5;
+	uint32_t maxThreads = std::max(1u, std::thread::hardware_concurrency());
+	uint32_t jobCount = 100000;
+};
+
+// keeps the work from being optimized away.
+std::atomic<float> g_sink{ 0.0f };
+
+float Work(uint32_t index, uint32_t amount)
+{
+	float value = static_cast<float>(index);
+	for (uint32_t i = 0; i < amount; i++)
+		value = std::sqrt(value * 1.0001f + 1.0f);
+	return value;
+}
+
+void EmptyJob(void*)
+{
+
+}
+
+double MeasureSpawn(JobSystem& jobs, const Options& options)
+{
+	JobCounter counter;
+	auto startTime = Clock::now();
+	for (uint32_t i = 0; i < options.jobCount; i++)
+		jobs.Run(EmptyJob, nullptr, &counter);
+	jobs.Wait(counter);
+	return ElapsedMilliseconds(startTime) * 1e6 / options.jobCount;
+}
+
+// 1 of 16 jobs is heavy and spawns 16 light children.
+struct ImbalancedWork
+{
+	JobSystem* jobs;
+	JobCounter* counter;
+	uint32_t index;
+};
+
+void LightJob(void* userData)
+{
+	g_sink.store(Work(static_cast<uint32_t>(reinterpret_cast<uintptr_t>(userData)), 200), std::memory_order_relaxed);
+}
+
+void HeavyJob(void* userData)
+{
+	auto work = static_cast<ImbalancedWork*>(userData);
+	for (uint32_t i = 0; i < 16; i++)
+		work->jobs->Run(LightJob, reinterpret_cast<void*>(static_cast<uintptr_t>(work->index + i)), work->counter);
+	g_sink.store(Work(work->index, 2000), std::memory_order_relaxed);
+}
+
+double MeasureSteal(JobSystem& jobs, const Options& options, double& stealRate)
+{
+	uint32_t count = std::max(16u, options.jobCount / 100);
+	std::vector<ImbalancedWork> works(count);
+	JobCounter counter;
+	jobs.ResetStatistics();
+	auto startTime = Clock::now();
+	for (uint32_t i = 0; i < count; i++)
+	{
+		works[i] = { &jobs, &counter, i };
+		if (i % 16 == 0)
+			jobs.Run(HeavyJob, &works[i], &counter);
+		else
+			jobs.Run(LightJob, reinterpret_cast<void*>(static_cast<uintptr_t>(i)), &counter);
+	}
+	jobs.Wait(counter);
+	double time = ElapsedMilliseconds(startTime);
+
+	JobStatistics statistics = jobs.GetStatistics();
+	stealRate = statistics.executedCount == 0 ? 0.0 : 100.0 * statistics.stolenCount / statistics.executedCount;
+	return time;
+}
+
+double MeasureParallelFor(JobSystem& jobs, std::vector<float>& values)
+{
+	auto startTime = Clock::now();
+	jobs.ParallelFor(0, static_cast<uint32_t>(values.size()), 1024, [&](uint32_t begin, uint32_t end)
+	{
+		for (uint32_t i = begin; i < end; i++)
+			values[i] = Work(i, 16);
+	});
+	return ElapsedMilliseconds(startTime);
+}
+
+int main(int argc, char* argv[])
+{
+	Options options;
+	CommandLine commandLine("jobbench [-r rounds] [-t max threads] [-n jobs]");
+	commandLine.Add("-r", options.rounds, 1);
+	commandLine.Add("-t", options.maxThreads, 1);
+	commandLine.Add("-n", options.jobCount, 1);
+	if (!commandLine.Parse(argc, argv))
+		return 1;
+
+	std::vector<float> values(options.jobCount * 40);
+	auto startTime = Clock::now();
+	for (uint32_t i = 0; i < values.size(); i++)
+		values[i] = Work(i, 16);
+	double serialTime = ElapsedMilliseconds(startTime);
+	float checksum = 0.0f;
+	for (float value : values)
+		checksum += value;
+
+	printf("best of %u rounds, parallel-for of %u items takes %.3f ms in a loop\n",
+		options.rounds, static_cast<uint32_t>(values.size()), serialTime);
+	printf("%7s %12s %11s %10s %11s %8s\n", "threads", "spawn ns/job", "imbalanced", "stolen", "parallel", "speedup");
+	for (uint32_t threads = 1; threads <= options.maxThreads; threads++)
+	{
+		JobSystem jobs;
+		jobs.Start(threads - 1);
+
+		double bestSpawn = 0.0;
+		double bestSteal = 0.0;
+		double bestParallel = 0.0;
+		double stealRate = 0.0;
+		for (uint32_t round = 0; round < options.rounds; round++)
+		{
+			double spawn = MeasureSpawn(jobs, options);
+			double roundStealRate = 0.0;
+			double steal = MeasureSteal(jobs, options, roundStealRate);
+			std::fill(values.begin(), values.end(), 0.0f);
+			double parallel = MeasureParallelFor(jobs, values);
+
+			float parallelChecksum = 0.0f;
+			for (float value : values)
+				parallelChecksum += value;
+			if (parallelChecksum != checksum)
+			{
+				fprintf(stderr, "jobbench: parallel-for result differs, %f vs %f\n", parallelChecksum, checksum);
+				return 1;
+			}
+
+			KeepBest(round, spawn, bestSpawn);
+			if (round == 0 || steal < bestSteal)
+			{
+				bestSteal = steal;
+				stealRate = roundStealRate;
+			}
+			KeepBest(round, parallel, bestParallel);
+		}
+		jobs.Stop();
+
+		printf("%7u %12.1f %8.3f ms %9.1f%% %8.3f ms %7.2fx\n", threads, bestSpawn,
+			bestSteal, stealRate, bestParallel, serialTime / bestParallel);
+	}
+	return 0;
+}
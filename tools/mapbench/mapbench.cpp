@@ -0,0 +1,129 @@
+// mapbench: measure lookup and insert costs of engine maps against std::map.
+//
+//   mapbench [-n iterations]
+//
+// Keys are shaped like the ones in engine: a few layers or blend modes,
+// interned name ids of textures and shaders, and component pointers of
+// spatial graph. It builds on any platform with only flat_map.h and bench.h:
+//
+//   g++ -std=c++11 -O2 -I../../got2d/source mapbench.cpp
+
+#include <algorithm>
+#include <map>
+#include <memory>
+#include <unordered_map>
+#include <random>
+#include <string>
+#include <vector>
+#include "flat_map.h"
+#include "../bench.h"
+
+// results are accumulated here, so that compiler can not drop the work.
+volatile uint64_t g_sink = 0;
+
+template<typename FUNC>
+double MeasureNanoseconds(uint32_t rounds, uint64_t operationCount, FUNC func)
+{
+	double best = 0.0;
+	for (uint32_t round = 0; round < rounds; round++)
+	{
+		auto startTime = Clock::now();
+		func();
+		KeepBest(round, ElapsedNanoseconds(startTime) / operationCount, best);
+	}
+	return best;
+}
+
+// insert all keys into an empty map, then look up keys in random order.
+template<typename MAP, typename K>
+void Measure(const char* mapName, const std::vector<K>& keys, uint32_t iterations)
+{
+	std::vector<K> lookups;
+	std::mt19937 rng(5489u);
+	size_t lookupCount = std::max<size_t>(keys.size(), 4096);
+	for (size_t i = 0; i < lookupCount; i++)
+		lookups.push_back(keys[rng() % keys.size()]);
+
+	uint32_t insertRounds = std::max<uint32_t>(1, static_cast<uint32_t>(iterations / keys.size()));
+	double insertTime = MeasureNanoseconds(5, insertRounds * keys.size(), [&]
+	{
+		for (uint32_t r = 0; r < insertRounds; r++)
+		{
+			MAP map;
+			for (size_t i = 0; i < keys.size(); i++)
+				map[keys[i]] = static_cast<uint32_t>(i);
+			g_sink = g_sink + map.size();
+		}
+	});
+
+	MAP map;
+	for (size_t i = 0; i < keys.size(); i++)
+		map[keys[i]] = static_cast<uint32_t>(i);
+
+	uint32_t lookupRounds = std::max<uint32_t>(1, static_cast<uint32_t>(iterations / lookups.size()));
+	double lookupTime = MeasureNanoseconds(5, lookupRounds * lookups.size(), [&]
+	{
+		uint64_t sum = 0;
+		for (uint32_t r = 0; r < lookupRounds; r++)
+		{
+			for (auto& key : lookups)
+			{
+				auto it = map.find(key);
+				if (it != map.end())
+					sum += it->second;
+			}
+		}
+		g_sink = g_sink + sum;
+	});
+
+	printf("  %-20s insert %8.2f ns   lookup %8.2f ns\n", mapName, insertTime, lookupTime);
+}
+
+template<typename K>
+void MeasureAll(const char* caseName, const std::vector<K>& keys, uint32_t iterations, bool smallSet)
+{
+	printf("%s, %u keys\n", caseName, static_cast<uint32_t>(keys.size()));
+	Measure<std::map<K, uint32_t>>("std::map", keys, iterations);
+	Measure<std::unordered_map<K, uint32_t>>("std::unordered_map", keys, iterations);
+	Measure<flat_hash_map<K, uint32_t>>("flat_hash_map", keys, iterations);
+	if (smallSet)
+		Measure<vector_map<K, uint32_t>>("vector_map", keys, iterations);
+}
+
+int main(int argc, char* argv[])
+{
+	uint32_t iterations = 4000000;
+	CommandLine commandLine("mapbench [-n iterations]");
+	commandLine.Add("-n", iterations, 1);
+	if (!commandLine.Parse(argc, argv))
+		return 1;
+
+	// render layers and blend modes.
+	std::vector<uint32_t> layers = { 0, 1, 2, 5, 10, 100 };
+	MeasureAll("render layers", layers, iterations, true);
+
+	// interned names are dense ids.
+	for (uint32_t count : { 64u, 1024u, 16384u })
+	{
+		std::vector<uint32_t> ids;
+		for (uint32_t i = 0; i < count; i++)
+			ids.push_back(i + 1);
+		std::shuffle(ids.begin(), ids.end(), std::mt19937(42u));
+		MeasureAll("texture name ids", ids, iterations, count <= 64);
+	}
+
+	// component pointers are scattered over the heap.
+	for (uint32_t count : { 1024u, 65536u })
+	{
+		std::vector<std::unique_ptr<uint64_t[]>> objects;
+		std::vector<void*> pointers;
+		for (uint32_t i = 0; i < count; i++)
+		{
+			objects.emplace_back(new uint64_t[8]);
+			pointers.push_back(objects.back().get());
+		}
+		std::shuffle(pointers.begin(), pointers.end(), std::mt19937(7u));
+		MeasureAll("component pointers", pointers, iterations, false);
+	}
+	return 0;
+}
@@ -0,0 +1,396 @@
+// orderbench: measure keeping rendering order while nodes are created and moved.
+//
+//   orderbench [-n nodes] [-o operations] [-b batch] [-seed N]
+//
+// Compares OrderLabels, which scene nodes take rendering orders from,
+// with renumbering, which the scene did before: every node following the
+// changed one in rendering order took a new number. A random tree is
+// built, then nodes are created under random parents, or moved to the
+// front, back, previous or next of their siblings, one in each frame.
+// Batched labels take the same operations as commands applied by the
+// scene, batch of them at once, changed nodes are marked, and ordered
+// once for the batch. At last, as many nodes are spawned, batch of them
+// under one random parent at once. Nodes touched, whose orders are set,
+// and time are reported per node built, per operation and per node
+// spawned. Renumbering is done once
+// after building, as the scene deferred it to rendering. Stand-in nodes
+// are used, the engine needs a renderer to build. Orders are checked to
+// increase in rendering order after every batch. It builds with:
+//
+//   g++ -std=c++11 -O2 -I../../got2d/source orderbench.cpp
+
+#include <algorithm>
+#include <memory>
+#include <random>
+#include <vector>
+#include "order_labels.h"
+#include "../bench.h"
+
+struct Options
+{
+	uint32_t nodeCount = 100000;
+	uint32_t operations = 1000;
+	uint32_t batch = 16;
+	uint32_t seed = 1;
+};
+
+// the root stands for the scene, it has no order.
+struct Node
+{
+	Node* parent = nullptr;
+	std::vector<Node*> children;
+	uint32_t childIndex = 0;
+	uint64_t order = 0;
+	bool dirty = false;
+
+	Node* GetPrevSibling() const { return childIndex == 0 ? nullptr : parent->children[childIndex - 1]; }
+
+	Node* GetNextSibling() const { return childIndex + 1 == parent->children.size() ? nullptr : parent->children[childIndex + 1]; }
+
+	// same as ::SceneNode.
+	Node* GetPrevInRenderingOrder() const
+	{
+		Node* prev = GetPrevSibling();
+		if (prev == nullptr)
+			return parent->parent == nullptr ? nullptr : parent;
+
+		while (!prev->children.empty())
+			prev = prev->children.back();
+		return prev;
+	}
+
+	Node* GetNextInRenderingOrder() const
+	{
+		return children.empty() ? GetNextAfterSubtree() : children.front();
+	}
+
+	Node* GetNextAfterSubtree() const
+	{
+		for (const Node* current = this; current->parent != nullptr; current = current->parent)
+		{
+			Node* next = current->GetNextSibling();
+			if (next != nullptr)
+				return next;
+		}
+		return nullptr;
+	}
+
+	void CollectSubtree(std::vector<Node*>& nodes)
+	{
+		nodes.push_back(this);
+		for (auto child : children)
+			child->CollectSubtree(nodes);
+	}
+};
+
+struct NodeAccess
+{
+	uint64_t GetKey(Node* node) const { return node->order; }
+	void SetKey(Node* node, uint64_t key) const { node->order = key; }
+	Node* Prev(Node* node) const { return node->GetPrevInRenderingOrder(); }
+	Node* Next(Node* node) const { return node->GetNextInRenderingOrder(); }
+	bool IsDirty(Node* node) const { return node->dirty; }
+};
+
+class Tree
+{
+public:
+	Tree() : m_root(new Node()) { }
+
+	Node* GetRoot() { return m_root.get(); }
+
+	Node* At(uint32_t index) { return m_nodes[index].get(); }
+
+	uint32_t GetCount() const { return static_cast<uint32_t>(m_nodes.size()); }
+
+	Node* CreateChild(Node* parent)
+	{
+		m_nodes.emplace_back(new Node());
+		Node* node = m_nodes.back().get();
+		node->parent = parent;
+		node->childIndex = static_cast<uint32_t>(parent->children.size());
+		parent->children.push_back(node);
+		return node;
+	}
+
+	// same as SceneNodeContainer::Move.
+	void Move(Node* node, uint32_t to)
+	{
+		auto& siblings = node->parent->children;
+		uint32_t from = node->childIndex;
+		if (from > to)
+		{
+			for (uint32_t i = from; i > to; i--)
+			{
+				siblings[i] = siblings[i - 1];
+				siblings[i]->childIndex = i;
+			}
+		}
+		else
+		{
+			for (uint32_t i = from; i < to; i++)
+			{
+				siblings[i] = siblings[i + 1];
+				siblings[i]->childIndex = i;
+			}
+		}
+		siblings[to] = node;
+		node->childIndex = to;
+	}
+
+	bool CheckOrder()
+	{
+		m_preorder.clear();
+		for (auto child : m_root->children)
+			child->CollectSubtree(m_preorder);
+
+		for (size_t i = 1; i < m_preorder.size(); i++)
+		{
+			if (m_preorder[i - 1]->order >= m_preorder[i]->order)
+				return false;
+		}
+		return m_preorder.size() == m_nodes.size();
+	}
+
+private:
+	std::unique_ptr<Node> m_root;
+	std::vector<std::unique_ptr<Node>> m_nodes;
+	std::vector<Node*> m_preorder;
+};
+
+// the way the scene kept orders before.
+struct Renumbering
+{
+	uint32_t Create(Node*) { return 0; }
+
+	uint32_t Build(Tree& tree) { return tree.GetCount() == 0 ? 0 : Update(tree.GetRoot()->children.front()); }
+
+	uint32_t Flush() { return 0; }
+
+	// renumber the node and all following nodes.
+	uint32_t Update(Node* node)
+	{
+		Node* prev = node->GetPrevInRenderingOrder();
+		uint64_t order = (prev == nullptr) ? 1 : prev->order + 1;
+		uint32_t touched = 0;
+		for (Node* current = node; current != nullptr; current = current->GetNextInRenderingOrder())
+		{
+			current->order = order++;
+			touched++;
+		}
+		return touched;
+	}
+};
+
+struct Labeling
+{
+	uint32_t Create(Node* node) { return Update(node); }
+
+	uint32_t Build(Tree&) { return 0; }
+
+	uint32_t Update(Node* node)
+	{
+		nodes.clear();
+		node->CollectSubtree(nodes);
+		return labels.Insert(node->GetPrevInRenderingOrder(), node->GetNextAfterSubtree(), nodes);
+	}
+
+	uint32_t Flush() { return 0; }
+
+	OrderLabels<Node, NodeAccess> labels;
+	std::vector<Node*> nodes;
+};
+
+// same as Scene::UpdateDirtyRenderingOrder.
+struct BatchedLabeling
+{
+	uint32_t Create(Node* node) { return Update(node) + Flush(); }
+
+	uint32_t Build(Tree&) { return 0; }
+
+	uint32_t Update(Node* node)
+	{
+		if (!node->dirty)
+			dirtyNodes.push_back(node);
+		Mark(node);
+		return 0;
+	}
+
+	// dirty nodes next to each other are ordered at once.
+	uint32_t Flush()
+	{
+		uint32_t touched = 0;
+		for (auto node : dirtyNodes)
+		{
+			if (!node->dirty)
+				continue;
+
+			Node* prev = node->GetPrevInRenderingOrder();
+			Node* first = node;
+			while (prev != nullptr && prev->dirty)
+			{
+				first = prev;
+				prev = prev->GetPrevInRenderingOrder();
+			}
+
+			nodes.clear();
+			Node* next = first;
+			while (next != nullptr && next->dirty)
+			{
+				next->dirty = false;
+				nodes.push_back(next);
+				next = next->GetNextInRenderingOrder();
+			}
+			touched += labels.Insert(prev, next, nodes);
+		}
+		dirtyNodes.clear();
+		return touched;
+	}
+
+	// descendants of a dirty node are dirty already.
+	void Mark(Node* node)
+	{
+		if (node->dirty)
+			return;
+
+		node->dirty = true;
+		for (auto child : node->children)
+			Mark(child);
+	}
+
+	OrderLabels<Node, NodeAccess> labels;
+	std::vector<Node*> nodes;
+	std::vector<Node*> dirtyNodes;
+};
+
+struct Result
+{
+	double buildNs = 0.0;		// per created node.
+	double operationNs = 0.0;
+	double buildTouched = 0.0;
+	double operationTouched = 0.0;
+	double spawnNs = 0.0;		// per spawned node.
+	double spawnTouched = 0.0;
+	uint32_t maxTouched = 0;
+	bool ordered = false;
+};
+
+template<typename ORDER>
+Result Measure(const Options& options)
+{
+	Result result;
+	ORDER order;
+	Tree tree;
+	std::mt19937 random(options.seed);
+	uint64_t touched = 0;
+
+	auto startTime = Clock::now();
+	for (uint32_t i = 0; i < options.nodeCount; i++)
+	{
+		Node* parent = (i < 16) ? tree.GetRoot() : tree.At(random() % tree.GetCount());
+		touched += order.Create(tree.CreateChild(parent));
+	}
+	touched += order.Build(tree);
+	result.buildNs = ElapsedNanoseconds(startTime) / options.nodeCount;
+	result.buildTouched = static_cast<double>(touched) / options.nodeCount;
+
+	// checking after every batch is not counted.
+	double checkTime = 0.0;
+	auto checkOrder = [&]()
+	{
+		auto checkStart = Clock::now();
+		bool ordered = tree.CheckOrder();
+		checkTime += ElapsedNanoseconds(checkStart);
+		return ordered;
+	};
+
+	touched = 0;
+	startTime = Clock::now();
+	for (uint32_t i = 0; i < options.operations; i++)
+	{
+		Node* node = tree.At(random() % tree.GetCount());
+		uint32_t siblingCount = static_cast<uint32_t>(node->parent->children.size());
+		uint32_t count = 0;
+		switch (random() % 5)
+		{
+		case 0:
+			count = order.Update(tree.CreateChild(node));
+			break;
+		case 1:
+			tree.Move(node, siblingCount - 1);
+			count = order.Update(node);
+			break;
+		case 2:
+			tree.Move(node, 0);
+			count = order.Update(node);
+			break;
+		case 3:
+			tree.Move(node, node->childIndex > 0 ? node->childIndex - 1 : 0);
+			count = order.Update(node);
+			break;
+		default:
+			tree.Move(node, std::min(node->childIndex + 1, siblingCount - 1));
+			count = order.Update(node);
+			break;
+		}
+		if ((i + 1) % options.batch == 0 || i + 1 == options.operations)
+		{
+			count += order.Flush();
+			if (!checkOrder())
+				return result;
+		}
+		touched += count;
+		result.maxTouched = std::max(result.maxTouched, count);
+	}
+	result.operationNs = (ElapsedNanoseconds(startTime) - checkTime) / options.operations;
+	result.operationTouched = static_cast<double>(touched) / options.operations;
+
+	touched = 0;
+	checkTime = 0.0;
+	startTime = Clock::now();
+	for (uint32_t spawned = 0; spawned < options.operations;)
+	{
+		Node* parent = tree.At(random() % tree.GetCount());
+		for (uint32_t i = 0; i < options.batch && spawned < options.operations; i++, spawned++)
+			touched += order.Update(tree.CreateChild(parent));
+		touched += order.Flush();
+		if (!checkOrder())
+			return result;
+	}
+	result.spawnNs = (ElapsedNanoseconds(startTime) - checkTime) / options.operations;
+	result.spawnTouched = static_cast<double>(touched) / options.operations;
+	result.ordered = tree.CheckOrder();
+	return result;
+}
+
+int main(int argc, char* argv[])
+{
+	Options options;
+	CommandLine commandLine("orderbench [-n nodes] [-o operations] [-b batch] [-seed N]");
+	commandLine.Add("-n", options.nodeCount, 1);
+	commandLine.Add("-o", options.operations, 1);
+	commandLine.Add("-b", options.batch, 1);
+	commandLine.Add("-seed", options.seed);
+	if (!commandLine.Parse(argc, argv))
+		return 1;
+
+	Result labeling = Measure<Labeling>(options);
+	Result batched = Measure<BatchedLabeling>(options);
+	Result renumbering = Measure<Renumbering>(options);
+	if (!labeling.ordered || !batched.ordered || !renumbering.ordered)
+	{
+		fprintf(stderr, "orderbench: orders do not follow the tree\n");
+		return 1;
+	}
+
+	printf("%u nodes built, then %u operations, %u in a batch\n", options.nodeCount, options.operations, options.batch);
+	printf("%-12s %14s %14s %14s %14s %12s %14s %14s\n", "order", "build ns/node", "build touched",
+		"op ns", "op touched", "max touched", "spawn ns/node", "spawn touched");
+	printf("%-12s %14.1f %14.1f %14.1f %14.1f %12u %14.1f %14.1f\n", "renumbering", renumbering.buildNs, renumbering.buildTouched,
+		renumbering.operationNs, renumbering.operationTouched, renumbering.maxTouched, renumbering.spawnNs, renumbering.spawnTouched);
+	printf("%-12s %14.1f %14.1f %14.1f %14.1f %12u %14.1f %14.1f\n", "labels", labeling.buildNs, labeling.buildTouched,
+		labeling.operationNs, labeling.operationTouched, labeling.maxTouched, labeling.spawnNs, labeling.spawnTouched);
+	printf("%-12s %14.1f %14.1f %14.1f %14.1f %12u %14.1f %14.1f\n", "batched", batched.buildNs, batched.buildTouched,
+		batched.operationNs, batched.operationTouched, batched.maxTouched, batched.spawnNs, batched.spawnTouched);
+	return 0;
+}
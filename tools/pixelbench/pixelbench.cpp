@@ -0,0 +1,266 @@
+// pixelbench: check and measure the pixel format conversion kernels.
+//
+//   pixelbench [-r rounds] [-n pixels] [-t threads] [-seed N]
+//
+// Every kernel set current CPU supports (avx2, ssse3, scalar) is checked
+// against a plain reference written here: ExpandRGBToRGBA with and without
+// swapping, SwizzleRGB, SwizzleRGBA and PremultiplyAlpha, in place where
+// it's allowed. Pixel counts cover 0 to 67 and odd large ones, source and
+// destination start 0 to 3 bytes off alignment, so that every tail of the
+// vector loops runs, and bytes behind the destination must stay untouched.
+// Then each kernel converts n pixels, reported in ns per pixel and speedup
+// over the scalar set, and ParallelRows converts an image of n pixels on
+// a job system of t threads, checked against the reference as well. It
+// builds with:
+//
+//   g++ -std=c++11 -O2 -pthread -I../../got2d/source pixelbench.cpp
+//       ../../got2d/source/pixel_format.cpp ../../got2d/source/job_system.cpp
+
+#include <algorithm>
+#include <random>
+#include <thread>
+#include <vector>
+#include "pixel_format.h"
+#include "../bench.h"
+
+struct Options
+{
+	uint32_t rounds = 5;
+	uint32_t pixelCount = 1024 * 1024;
+	uint32_t threads = std::max(1u, std::thread::hardware_concurrency());
+	uint32_t seed = 1;
+};
+
+enum class Kernel : int
+{
+	Expand,
+	ExpandSwapped,
+	SwizzleRGB,
+	SwizzleRGBA,
+	Premultiply,
+	Count,
+};
+
+const char* KERNEL_NAMES[] = { "expand", "expand-swap", "swizzle-rgb", "swizzle-rgba", "premultiply" };
+
+const char* KERNEL_SETS[] = { "scalar", "ssse3", "avx2" };
+
+uint32_t GetSourceBytes(Kernel kernel)
+{
+	return (kernel == Kernel::Expand || kernel == Kernel::ExpandSwapped || kernel == Kernel::SwizzleRGB) ? 3 : 4;
+}
+
+uint32_t GetDestinationBytes(Kernel kernel)
+{
+	return kernel == Kernel::SwizzleRGB ? 3 : 4;
+}
+
+bool CanRunInPlace(Kernel kernel)
+{
+	return kernel == Kernel::SwizzleRGB || kernel == Kernel::SwizzleRGBA || kernel == Kernel::Premultiply;
+}
+
+void RunKernel(Kernel kernel, const uint8_t* src, uint8_t* dst, uint32_t pixelCount)
+{
+	switch (kernel)
+	{
+	case Kernel::Expand: ExpandRGBToRGBA(src, dst, pixelCount, false); break;
+	case Kernel::ExpandSwapped: ExpandRGBToRGBA(src, dst, pixelCount, true); break;
+	case Kernel::SwizzleRGB: SwizzleRGB(src, dst, pixelCount); break;
+	case Kernel::SwizzleRGBA: SwizzleRGBA(src, dst, pixelCount); break;
+	case Kernel::Premultiply: PremultiplyAlpha(src, dst, pixelCount); break;
+	default: break;
+	}
+}
+
+// written from the definitions, not from the scalar kernels.
+void RunReference(Kernel kernel, const uint8_t* src, uint8_t* dst, uint32_t pixelCount)
+{
+	uint32_t srcBytes = GetSourceBytes(kernel);
+	uint32_t dstBytes = GetDestinationBytes(kernel);
+	for (uint32_t i = 0; i < pixelCount; i++)
+	{
+		const uint8_t* s = src + i * srcBytes;
+		uint8_t* d = dst + i * dstBytes;
+		uint8_t pixel[4] = { s[0], s[1], s[2], srcBytes == 4 ? s[3] : static_cast<uint8_t>(255) };
+		if (kernel != Kernel::Expand && kernel != Kernel::Premultiply)
+			std::swap(pixel[0], pixel[2]);
+		if (kernel == Kernel::Premultiply)
+		{
+			// rounded to nearest, x / 255 is never halfway.
+			for (int c = 0; c < 3; c++)
+				pixel[c] = static_cast<uint8_t>((2u * pixel[c] * pixel[3] + 255u) / 510u);
+		}
+		memcpy(d, pixel, dstBytes);
+	}
+}
+
+// false at the first mismatch, which is printed.
+bool Check(const char* kernelSet, std::mt19937& random)
+{
+	const uint8_t GUARD = 0xA5;
+	std::vector<uint32_t> counts;
+	for (uint32_t count = 0; count < 68; count++)
+		counts.push_back(count);
+	counts.push_back(1001);
+	counts.push_back(4099);
+	counts.push_back(65537);
+
+	std::vector<uint8_t> src, dst, expected;
+	for (int k = 0; k < static_cast<int>(Kernel::Count); k++)
+	{
+		Kernel kernel = static_cast<Kernel>(k);
+		uint32_t srcBytes = GetSourceBytes(kernel);
+		uint32_t dstBytes = GetDestinationBytes(kernel);
+		for (uint32_t count : counts)
+		{
+			for (uint32_t offset = 0; offset < 4; offset++)
+			{
+				for (int inPlace = 0; inPlace < (CanRunInPlace(kernel) ? 2 : 1); inPlace++)
+				{
+					// 32 guard bytes behind, wider than any vector.
+					src.resize(offset + count * srcBytes + 32);
+					for (auto& byte : src)
+						byte = static_cast<uint8_t>(random());
+					dst.assign(offset + count * dstBytes + 32, GUARD);
+					expected = dst;
+					RunReference(kernel, src.data() + offset, expected.data() + offset, count);
+
+					uint8_t* out = dst.data() + offset;
+					if (inPlace == 1)
+					{
+						memcpy(out, src.data() + offset, count * srcBytes);
+						RunKernel(kernel, out, out, count);
+					}
+					else
+					{
+						RunKernel(kernel, src.data() + offset, out, count);
+					}
+
+					if (dst != expected)
+					{
+						size_t at = std::mismatch(dst.begin(), dst.end(), expected.begin()).first - dst.begin();
+						fprintf(stderr, "pixelbench: %s %s of %u pixels, offset %u%s, byte %u is %u, expected %u\n",
+							kernelSet, KERNEL_NAMES[k], count, offset, inPlace ? " in place" : "",
+							static_cast<uint32_t>(at), dst[at], expected[at]);
+						return false;
+					}
+				}
+			}
+		}
+	}
+	return true;
+}
+
+// best ns per pixel of each kernel.
+void Measure(const Options& options, std::mt19937& random, double* nsPerPixel)
+{
+	std::vector<uint8_t> src(options.pixelCount * 4);
+	std::vector<uint8_t> dst(options.pixelCount * 4);
+	for (auto& byte : src)
+		byte = static_cast<uint8_t>(random());
+
+	for (int k = 0; k < static_cast<int>(Kernel::Count); k++)
+	{
+		nsPerPixel[k] = 0.0;
+		for (uint32_t round = 0; round < options.rounds; round++)
+		{
+			auto startTime = Clock::now();
+			RunKernel(static_cast<Kernel>(k), src.data(), dst.data(), options.pixelCount);
+			KeepBest(round, ElapsedNanoseconds(startTime) / std::max(1u, options.pixelCount), nsPerPixel[k]);
+		}
+	}
+}
+
+// ParallelRows over an image of RGB rows expanded to RGBA, false if
+// any row is wrong.
+bool MeasureParallel(const Options& options, std::mt19937& random, double& parallelMs, double& serialMs)
+{
+	const uint32_t width = 1024;
+	const uint32_t height = std::max(1u, options.pixelCount / width);
+	std::vector<uint8_t> src(width * height * 3);
+	std::vector<uint8_t> dst(width * height * 4);
+	std::vector<uint8_t> expected(width * height * 4);
+	for (auto& byte : src)
+		byte = static_cast<uint8_t>(random());
+	RunReference(Kernel::ExpandSwapped, src.data(), expected.data(), width * height);
+
+	JobSystem jobs;
+	jobs.Start(options.threads - 1);
+	for (int parallel = 0; parallel < 2; parallel++)
+	{
+		SetPixelJobSystem(parallel ? &jobs : nullptr);
+		double& best = parallel ? parallelMs : serialMs;
+		for (uint32_t round = 0; round < options.rounds; round++)
+		{
+			std::fill(dst.begin(), dst.end(), 0);
+			auto startTime = Clock::now();
+			ParallelRows(height, width * 3, [&](uint32_t rowBegin, uint32_t rowEnd)
+			{
+				ExpandRGBToRGBA(src.data() + rowBegin * width * 3, dst.data() + rowBegin * width * 4, (rowEnd - rowBegin) * width, true);
+			});
+			KeepBest(round, ElapsedMilliseconds(startTime), best);
+			if (dst != expected)
+			{
+				fprintf(stderr, "pixelbench: ParallelRows on %u threads converted wrong rows\n", parallel ? options.threads : 1);
+				return false;
+			}
+		}
+	}
+	SetPixelJobSystem(nullptr);
+	return true;
+}
+
+int main(int argc, char* argv[])
+{
+	Options options;
+	CommandLine commandLine("pixelbench [-r rounds] [-n pixels] [-t threads] [-seed N]");
+	commandLine.Add("-r", options.rounds, 1);
+	commandLine.Add("-n", options.pixelCount, 1);
+	commandLine.Add("-t", options.threads, 1);
+	commandLine.Add("-seed", options.seed);
+	if (!commandLine.Parse(argc, argv))
+		return 1;
+
+	std::mt19937 random(options.seed);
+	const int kernelCount = static_cast<int>(Kernel::Count);
+	double scalarNs[kernelCount] = {};
+	printf("best of %u rounds, %u pixels\n", options.rounds, options.pixelCount);
+	printf("%-8s", "set");
+	for (int k = 0; k < kernelCount; k++)
+		printf(" %14s", KERNEL_NAMES[k]);
+	printf("   ns/pixel (speedup)\n");
+	for (const char* kernelSet : KERNEL_SETS)
+	{
+		if (!SelectPixelKernels(kernelSet))
+		{
+			printf("%-8s not supported\n", kernelSet);
+			continue;
+		}
+
+		if (!Check(kernelSet, random))
+			return 1;
+
+		double ns[kernelCount];
+		Measure(options, random, ns);
+		printf("%-8s", kernelSet);
+		for (int k = 0; k < kernelCount; k++)
+		{
+			if (strcmp(kernelSet, "scalar") == 0)
+				scalarNs[k] = ns[k];
+			printf(" %6.3f (%4.1fx)", ns[k], scalarNs[k] / ns[k]);
+		}
+		printf("\n");
+	}
+
+	// the fastest set again, as the engine selects.
+	SelectPixelKernels(nullptr);
+	double parallelMs = 0.0;
+	double serialMs = 0.0;
+	if (!MeasureParallel(options, random, parallelMs, serialMs))
+		return 1;
+
+	printf("ParallelRows expand-swap %u threads %.3f ms, calling thread %.3f ms, %.2fx\n",
+		options.threads, parallelMs, serialMs, serialMs / parallelMs);
+	return 0;
+}
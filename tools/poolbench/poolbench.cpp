@@ -0,0 +1,162 @@
+// poolbench: measure create/release throughput of short-lived nodes.
+//
+//   poolbench [-r rounds] [-n live nodes] [-f frames] [-seed N]
+//
+// Compares ObjectPool, which scene nodes are allocated from, with plain
+// new and delete. A stand-in node of a similar size to ::SceneNode is
+// used, the engine needs a renderer to build. Two patterns are measured:
+// churn, a steady number of nodes lives while 10% of them are released
+// and as many are created every frame, like bullets; and burst, all
+// nodes are created and then released at once, like loading a level.
+// Heap allocations are counted during churn, the pool should make none
+// once warmed up. Stale handles are checked to be detected. It builds with:
+//
+//   g++ -std=c++11 -O2 -I../../got2d/source poolbench.cpp
+
+#include <algorithm>
+#include <random>
+#include <vector>
+#include "object_pool.h"
+#define BENCH_COUNT_ALLOCATIONS
+#include "../bench.h"
+
+struct Options
+{
+	uint32_t rounds = 5;
+	uint32_t liveCount = 100000;
+	uint32_t frames = 100;
+	uint32_t seed = 1;
+};
+
+// roughly the members of ::SceneNode, without containers' heap blocks.
+struct StandInNode
+{
+	StandInNode(StandInNode* parent, uint32_t childIndex) : parent(parent), childIndex(childIndex) { }
+	virtual ~StandInNode() { }
+
+	StandInNode* parent;
+	void* containers[12] = { };
+	uint32_t transform = 0;
+	uint32_t worldVersion = 0;
+	uint32_t transformChanges = 0;
+	float right[2] = { 1.0f, 0.0f };
+	float up[2] = { 0.0f, 1.0f };
+	bool flags[4] = { };
+	uint32_t childIndex;
+	uint32_t renderingOrder = 0xFFFFFFFF;
+	uint32_t visibleMask = 1;
+};
+
+struct HeapAllocator
+{
+	StandInNode* Create(uint32_t index) { return new StandInNode(nullptr, index); }
+	void Destroy(StandInNode* node) { delete node; }
+};
+
+struct PoolAllocator
+{
+	StandInNode* Create(uint32_t index) { return pool.Create(nullptr, index); }
+	void Destroy(StandInNode* node) { pool.Destroy(node); }
+	ObjectPool<StandInNode> pool;
+};
+
+struct Result
+{
+	double churnNs = 0.0;		// per created and released node.
+	double burstNs = 0.0;
+	uint64_t churnAllocations = 0;	// in the last round.
+};
+
+template<typename ALLOCATOR>
+Result Measure(ALLOCATOR& allocator, const Options& options)
+{
+	Result result;
+	std::mt19937 random(options.seed);
+	std::vector<StandInNode*> nodes(options.liveCount);
+	for (uint32_t round = 0; round < options.rounds; round++)
+	{
+		for (uint32_t i = 0; i < options.liveCount; i++)
+			nodes[i] = allocator.Create(i);
+
+		uint32_t churnCount = std::max(1u, options.liveCount / 10);
+		uint64_t allocations = GetAllocationCount();
+		auto startTime = Clock::now();
+		for (uint32_t frame = 0; frame < options.frames; frame++)
+		{
+			for (uint32_t i = 0; i < churnCount; i++)
+			{
+				uint32_t index = random() % options.liveCount;
+				allocator.Destroy(nodes[index]);
+				nodes[index] = allocator.Create(index);
+			}
+		}
+		double churnTime = ElapsedNanoseconds(startTime);
+		result.churnAllocations = GetAllocationCount() - allocations;
+
+		startTime = Clock::now();
+		for (uint32_t i = 0; i < options.liveCount; i++)
+			allocator.Destroy(nodes[i]);
+		for (uint32_t i = 0; i < options.liveCount; i++)
+			nodes[i] = allocator.Create(i);
+		double burstTime = ElapsedNanoseconds(startTime);
+
+		for (uint32_t i = 0; i < options.liveCount; i++)
+			allocator.Destroy(nodes[i]);
+
+		KeepBest(round, churnTime / (static_cast<double>(churnCount) * options.frames), result.churnNs);
+		KeepBest(round, burstTime / options.liveCount, result.burstNs);
+	}
+	return result;
+}
+
+// handles of destroyed nodes must not find nodes reusing their slots.
+bool CheckHandles()
+{
+	ObjectPool<StandInNode> pool;
+	StandInNode* first = pool.Create(nullptr, 0);
+	auto handle = pool.GetHandle(first);
+	if (pool.Get(handle) != first)
+		return false;
+
+	pool.Destroy(first);
+	if (pool.Get(handle) != nullptr)
+		return false;
+
+	StandInNode* second = pool.Create(nullptr, 1);
+	bool reused = (second == first);
+	bool detected = (pool.Get(handle) == nullptr) && (pool.Get(pool.GetHandle(second)) == second);
+	pool.Destroy(second);
+	return reused && detected && pool.Get({ 0, 0 }) == nullptr && pool.Get({ 1000000, 1 }) == nullptr;
+}
+
+int main(int argc, char* argv[])
+{
+	Options options;
+	CommandLine commandLine("poolbench [-r rounds] [-n live nodes] [-f frames] [-seed N]");
+	commandLine.Add("-r", options.rounds, 1);
+	commandLine.Add("-n", options.liveCount, 1);
+	commandLine.Add("-f", options.frames, 1);
+	commandLine.Add("-seed", options.seed);
+	if (!commandLine.Parse(argc, argv))
+		return 1;
+
+	if (!CheckHandles())
+	{
+		fprintf(stderr, "poolbench: stale handle is not detected\n");
+		return 1;
+	}
+
+	HeapAllocator heap;
+	PoolAllocator pool;
+	Result heapResult = Measure(heap, options);
+	Result poolResult = Measure(pool, options);
+
+	printf("best of %u rounds, %u live nodes of %u bytes, %u frames\n", options.rounds,
+		options.liveCount, static_cast<uint32_t>(sizeof(StandInNode)), options.frames);
+	printf("%-9s %16s %16s %18s\n", "allocator", "churn ns/node", "burst ns/node", "churn allocations");
+	printf("%-9s %16.1f %16.1f %18llu\n", "new", heapResult.churnNs, heapResult.burstNs,
+		static_cast<unsigned long long>(heapResult.churnAllocations));
+	printf("%-9s %16.1f %16.1f %18llu\n", "pool", poolResult.churnNs, poolResult.burstNs,
+		static_cast<unsigned long long>(poolResult.churnAllocations));
+	return 0;
+}
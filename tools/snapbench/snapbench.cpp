@@ -0,0 +1,417 @@
+// snapbench: measure loading a level from a scene snapshot.
+//
+//   snapbench [-n nodes] [-r rounds] [-seed N] [-o file]
+//
+// A random level is written to a snapshot file, then loaded in two ways.
+// Calls build it as a level was built before, through the node API one
+// call at a time: the file is read into a buffer, each node is created
+// and ordered between its neighbours, and each component is added to the
+// spatial graph at once, with the world matrix of static ones evaluated
+// through their ancestors. Snapshot follows the steps of
+// Scene::LoadSnapshot: the file is mapped, storage is reserved, all nodes
+// are ordered in one pass, world matrices are updated linearly, and
+// components are added to the spatial graph together. Scene::LoadSnapshot
+// itself is not called, the engine needs a renderer to build: the file
+// system, snapshot format, ObjectPool, OrderLabels and TransformStore are
+// the engine's, nodes are stand-ins and a grid stands in for the quad
+// tree. Both scenes are checked to be the same. It builds with:
+//
+//   g++ -std=c++11 -O2 -I../../got2d/source snapbench.cpp
+//       ../../got2d/source/file_system.cpp ../../got2d/source/async_io.cpp
+//       ../../got2d/source/transform_store.cpp
+
+#include <algorithm>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+#include "file_system.h"
+#include "flat_map.h"
+#include "object_pool.h"
+#include "order_labels.h"
+#include "small_vector.h"
+#include "scene_snapshot.h"
+#include "transform_store.h"
+#include "../bench.h"
+
+struct Options
+{
+	uint32_t nodeCount = 100000;
+	uint32_t rounds = 5;
+	uint32_t seed = 1;
+	std::string path = "snapbench.g2ds";
+};
+
+struct Node;
+
+struct Component
+{
+	Node* node = nullptr;
+	float size[2];
+};
+
+// same links as ::SceneNode, the root stands for the scene.
+struct Node
+{
+	Node* parent = nullptr;
+	Node* firstChild = nullptr;
+	Node* lastChild = nullptr;
+	Node* prevSibling = nullptr;
+	Node* nextSibling = nullptr;
+	TransformStore::Handle transform = TransformStore::INVALID_HANDLE;
+	uint64_t order = 0;
+	uint32_t visibleMask = 0xFFFFFFFF;
+	bool visible = true;
+	bool isStatic = false;
+	small_vector<Component*, 2> components;	// inline, as in ::SceneNode.
+
+	void Append(Node* child)
+	{
+		child->parent = this;
+		child->prevSibling = lastChild;
+		if (lastChild == nullptr)
+			firstChild = child;
+		else
+			lastChild->nextSibling = child;
+		lastChild = child;
+	}
+
+	Node* GetPrevInRenderingOrder() const
+	{
+		if (prevSibling == nullptr)
+			return parent->parent == nullptr ? nullptr : parent;
+
+		Node* prev = prevSibling;
+		while (prev->lastChild != nullptr)
+			prev = prev->lastChild;
+		return prev;
+	}
+
+	Node* GetNextInRenderingOrder() const
+	{
+		return firstChild != nullptr ? firstChild : GetNextAfterSubtree();
+	}
+
+	Node* GetNextAfterSubtree() const
+	{
+		for (const Node* current = this; current->parent != nullptr; current = current->parent)
+		{
+			if (current->nextSibling != nullptr)
+				return current->nextSibling;
+		}
+		return nullptr;
+	}
+
+	void CollectSubtree(std::vector<Node*>& nodes)
+	{
+		nodes.push_back(this);
+		for (Node* child = firstChild; child != nullptr; child = child->nextSibling)
+			child->CollectSubtree(nodes);
+	}
+};
+
+struct NodeOrderAccess
+{
+	uint64_t GetKey(Node* node) const { return node->order; }
+
+	void SetKey(Node* node, uint64_t key) const { node->order = key; }
+
+	Node* Prev(Node* node) const { return node->GetPrevInRenderingOrder(); }
+
+	Node* Next(Node* node) const { return node->GetNextInRenderingOrder(); }
+
+	bool IsDirty(Node*) const { return false; }
+};
+
+// static components are placed by world position, like the quad tree,
+// others are kept in one list.
+class Grid
+{
+public:
+	static const int CELLS = 64;
+	static constexpr float BOUND = 4096.0f;
+
+	Grid() : m_cells(CELLS * CELLS) { }
+
+	void Add(Component* component, const TransformMatrix& world)
+	{
+		std::vector<Component*>* list = &m_dynamic;
+		if (component->node->isStatic)
+		{
+			int x = static_cast<int>((world.row[0][2] + BOUND) / (BOUND * 2) * CELLS);
+			int y = static_cast<int>((world.row[1][2] + BOUND) / (BOUND * 2) * CELLS);
+			list = &m_cells[std::min(std::max(y, 0), CELLS - 1) * CELLS + std::min(std::max(x, 0), CELLS - 1)];
+		}
+		list->push_back(component);
+		links[component] = list;
+	}
+
+	flat_hash_map<Component*, std::vector<Component*>*> links;
+
+private:
+	std::vector<std::vector<Component*>> m_cells;
+	std::vector<Component*> m_dynamic;
+};
+
+struct Scene
+{
+	Node root;
+	TransformStore transforms;
+	ObjectPool<Node> nodes;
+	ObjectPool<Component> components;
+	OrderLabels<Node, NodeOrderAccess> labels;
+	Grid grid;
+	std::vector<Node*> ordering;
+
+	~Scene()
+	{
+		Destroy(root);
+	}
+
+	void Destroy(Node& node)
+	{
+		for (Node* child = node.firstChild; child != nullptr;)
+		{
+			Node* next = child->nextSibling;
+			Destroy(*child);
+			for (Component* component : child->components)
+				components.Destroy(component);
+			nodes.Destroy(child);
+			child = next;
+		}
+	}
+
+	Node* CreateNode(Node* parent)
+	{
+		Node* node = nodes.Create();
+		node->transform = transforms.Create(parent == &root ? TransformStore::INVALID_HANDLE : parent->transform);
+		parent->Append(node);
+		return node;
+	}
+
+	Component* CreateComponent(const void* data, uint32_t size)
+	{
+		if (size < sizeof(float) * 2)
+			return nullptr;
+
+		Component* component = components.Create();
+		memcpy(component->size, data, sizeof(component->size));
+		return component;
+	}
+};
+
+void SetNode(Scene& scene, Node* node, const SnapshotNode& info)
+{
+	scene.transforms.SetTransform(node->transform,
+		{ info.position[0], info.position[1] }, info.rotation,
+		{ info.scale[0], info.scale[1] }, { info.pivot[0], info.pivot[1] });
+	node->visible = (info.flags & SnapshotNode::VISIBLE) != 0;
+	node->isStatic = (info.flags & SnapshotNode::STATIC) != 0;
+	node->visibleMask = info.visibleMask;
+}
+
+// node API called by a level loader, one node at a time.
+bool LoadByCalls(Scene& scene, const std::string& path)
+{
+	FileView view;
+	SnapshotReader reader;
+	if (!ReadLooseFile(path, view) || !reader.Open(view.GetData(), view.GetSize()))
+		return false;
+
+	std::vector<Node*> created(reader.GetNodeCount());
+	for (uint32_t i = 0; i < reader.GetNodeCount(); i++)
+	{
+		const SnapshotNode& info = reader.GetNode(i);
+		Node* node = scene.CreateNode(info.parent == SNAPSHOT_NO_PARENT ? &scene.root : created[info.parent]);
+		created[i] = node;
+
+		// ::Scene::UpdateRenderingOrder
+		scene.ordering.clear();
+		node->CollectSubtree(scene.ordering);
+		scene.labels.Insert(node->GetPrevInRenderingOrder(), node->GetNextAfterSubtree(), scene.ordering);
+
+		SetNode(scene, node, info);
+		for (uint32_t c = info.firstComponent; c < info.firstComponent + info.componentCount; c++)
+		{
+			Component* component = scene.CreateComponent(reader.GetComponentData(c), reader.GetComponent(c).dataSize);
+			if (component == nullptr)
+				continue;
+
+			// ::SpatialGraph::Add removes it first.
+			component->node = node;
+			node->components.push_back(component);
+			auto itFound = scene.grid.links.find(component);
+			if (itFound != scene.grid.links.end())
+				scene.grid.links.erase(itFound);
+			scene.grid.Add(component, scene.transforms.GetWorldMatrix(node->transform));
+		}
+	}
+	return true;
+}
+
+// same as ::Scene::LoadSnapshot.
+bool LoadSnapshot(Scene& scene, const std::string& path)
+{
+	MappedFile mapping;
+	SnapshotReader reader;
+	if (!mapping.Open(path) || !reader.Open(mapping.GetData(), mapping.GetSize()))
+		return false;
+
+	uint32_t nodeCount = reader.GetNodeCount();
+	scene.transforms.Reserve(scene.transforms.GetCount() + nodeCount);
+	scene.ordering.resize(nodeCount);
+	std::vector<Component*> components;
+	components.reserve(reader.GetComponentCount());
+	for (uint32_t i = 0; i < nodeCount; i++)
+	{
+		const SnapshotNode& info = reader.GetNode(i);
+		Node* node = scene.CreateNode(info.parent == SNAPSHOT_NO_PARENT ? &scene.root : scene.ordering[info.parent]);
+		scene.ordering[i] = node;
+
+		SetNode(scene, node, info);
+		for (uint32_t c = info.firstComponent; c < info.firstComponent + info.componentCount; c++)
+		{
+			Component* component = scene.CreateComponent(reader.GetComponentData(c), reader.GetComponent(c).dataSize);
+			if (component == nullptr)
+				continue;
+
+			component->node = node;
+			node->components.push_back(component);
+			components.push_back(component);
+		}
+	}
+
+	if (nodeCount > 0)
+		scene.labels.Insert(scene.ordering[0]->GetPrevInRenderingOrder(), nullptr, scene.ordering);
+
+	scene.transforms.Update();
+	scene.grid.links.reserve(scene.grid.links.size() + components.size());
+	for (Component* component : components)
+		scene.grid.Add(component, scene.transforms.GetWorldMatrix(component->node->transform));
+	return true;
+}
+
+// random level, a few layers of rooms holding objects, in rendering order.
+void WriteLevel(const Options& options, std::vector<uint8_t>& snapshot)
+{
+	std::mt19937 random(options.seed);
+	std::uniform_real_distribution<float> position(-2000.0f, 2000.0f);
+	std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+	SnapshotWriter writer;
+	uint32_t quadClass = writer.AddClass("g2d.Quad");
+
+	// ancestors of the next node, it's placed under one of them.
+	std::vector<uint32_t> path;
+	while (writer.GetNodeCount() < options.nodeCount)
+	{
+		uint32_t depth = static_cast<uint32_t>(random() % (std::min<size_t>(path.size(), 6) + 1));
+		path.resize(depth);
+
+		SnapshotNode info;
+		info.parent = path.empty() ? SNAPSHOT_NO_PARENT : path.back();
+		info.visibleMask = 0xFFFFFFFF;
+		info.position[0] = depth == 0 ? position(random) : position(random) * 0.05f;
+		info.position[1] = depth == 0 ? position(random) : position(random) * 0.05f;
+		info.scale[0] = info.scale[1] = 1.0f;
+		info.pivot[0] = info.pivot[1] = 0.0f;
+		info.rotation = unit(random) * 6.28f;
+		info.flags = SnapshotNode::VISIBLE | (unit(random) < 0.7f ? SnapshotNode::STATIC : 0);
+		path.push_back(writer.AddNode(info));
+
+		uint32_t componentCount = random() % 3;
+		for (uint32_t c = 0; c < componentCount; c++)
+		{
+			float size[2] = { 8.0f + unit(random) * 64.0f, 8.0f + unit(random) * 64.0f };
+			memcpy(writer.AddComponent(quadClass, 0, sizeof(size)), size, sizeof(size));
+		}
+	}
+	writer.Finish(snapshot);
+}
+
+bool IsSameNode(TransformStore& aTransforms, const Node* a, TransformStore& bTransforms, const Node* b)
+{
+	const TransformMatrix& aWorld = aTransforms.GetWorldMatrix(a->transform);
+	const TransformMatrix& bWorld = bTransforms.GetWorldMatrix(b->transform);
+	if (memcmp(&aWorld, &bWorld, sizeof(aWorld)) != 0 || a->isStatic != b->isStatic ||
+		a->components.size() != b->components.size())
+	{
+		return false;
+	}
+
+	for (size_t i = 0; i < a->components.size(); i++)
+	{
+		if (memcmp(a->components[i]->size, b->components[i]->size, sizeof(a->components[i]->size)) != 0)
+			return false;
+	}
+	return true;
+}
+
+// same nodes in the same rendering order, with increasing orders.
+bool IsSameScene(Scene& a, Scene& b)
+{
+	Node* aNode = a.root.firstChild;
+	Node* bNode = b.root.firstChild;
+	uint64_t aOrder = 0;
+	uint64_t bOrder = 0;
+	while (aNode != nullptr && bNode != nullptr)
+	{
+		if (!IsSameNode(a.transforms, aNode, b.transforms, bNode) || aNode->order <= aOrder || bNode->order <= bOrder)
+			return false;
+
+		aOrder = aNode->order;
+		bOrder = bNode->order;
+		aNode = aNode->GetNextInRenderingOrder();
+		bNode = bNode->GetNextInRenderingOrder();
+	}
+	return aNode == nullptr && bNode == nullptr;
+}
+
+int main(int argc, char* argv[])
+{
+	Options options;
+	CommandLine commandLine("snapbench [-n nodes] [-r rounds] [-seed N] [-o file]");
+	commandLine.Add("-n", options.nodeCount, 1);
+	commandLine.Add("-r", options.rounds, 1);
+	commandLine.Add("-seed", options.seed);
+	commandLine.Add("-o", options.path);
+	if (!commandLine.Parse(argc, argv))
+		return 1;
+
+	std::vector<uint8_t> snapshot;
+	WriteLevel(options, snapshot);
+	if (!WriteLooseFile(options.path, snapshot.data(), snapshot.size()))
+	{
+		fprintf(stderr, "snapbench: can not write %s\n", options.path.c_str());
+		return 1;
+	}
+
+	double callsMs = 0.0;
+	double snapshotMs = 0.0;
+	for (uint32_t round = 0; round < options.rounds; round++)
+	{
+		std::unique_ptr<Scene> callsScene(new Scene());
+		std::unique_ptr<Scene> snapshotScene(new Scene());
+
+		auto startTime = Clock::now();
+		bool loaded = LoadByCalls(*callsScene, options.path);
+		callsMs += ElapsedMilliseconds(startTime);
+
+		startTime = Clock::now();
+		loaded = LoadSnapshot(*snapshotScene, options.path) && loaded;
+		snapshotMs += ElapsedMilliseconds(startTime);
+
+		if (!loaded || !IsSameScene(*callsScene, *snapshotScene))
+		{
+			fprintf(stderr, "snapbench: scenes are not the same\n");
+			remove(options.path.c_str());
+			return 1;
+		}
+	}
+	remove(options.path.c_str());
+
+	printf("%u nodes, %.1f KB snapshot, %u rounds\n", options.nodeCount, snapshot.size() / 1024.0, options.rounds);
+	printf("%-9s %12s %12s\n", "load", "ms", "ns/node");
+	printf("%-9s %12.2f %12.1f\n", "calls", callsMs / options.rounds, callsMs * 1e6 / options.rounds / options.nodeCount);
+	printf("%-9s %12.2f %12.1f\n", "snapshot", snapshotMs / options.rounds, snapshotMs * 1e6 / options.rounds / options.nodeCount);
+	return 0;
+}
@@ -0,0 +1,450 @@
+// texconv: convert images to DDS or baked textures with full mip chain.
+//
+//   texconv [-f auto|bc1|bc3|bc7|rgba8] [-nomips] [-premultiply]
+//           [-filter box|kaiser] [-pitch alignment] <input> <output.dds|output.g2dtex>
+//
+// Baked textures (.g2dtex) keep rows padded to the pitch alignment,
+// so that engine uploads every mip straight from the file.
+//
+// TGA and PAM/PPM images are read natively, so that the tool can be
+// built on any platform with only texture_codec.cpp, pixel_format.cpp and
+// job_system.cpp:
+//
+//   g++ -std=c++11 -O2 -pthread -I../../got2d/source texconv.cpp
+//       ../../got2d/source/texture_codec.cpp ../../got2d/source/pixel_format.cpp
+//       ../../got2d/source/job_system.cpp
+//
+// Other formats (png, jpg, bmp ...) are read with res/img when
+// G2D_TEXCONV_USE_RES is defined, as in texconv.vcxproj.
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <cctype>
+#include <algorithm>
+#include <string>
+#include <vector>
+#include <chrono>
+#include <thread>
+#include "texture_codec.h"
+#include "pixel_format.h"
+
+#ifdef G2D_TEXCONV_USE_RES
+#include "file_data.h"
+#include "img_data.h"
+#endif
+
+struct Image
+{
+	uint32_t width = 0;
+	uint32_t height = 0;
+	std::vector<uint8_t> rgba;
+};
+
+bool ReadFile(const char* path, std::vector<uint8_t>& buffer)
+{
+	FILE* file = fopen(path, "rb");
+	if (file == nullptr)
+		return false;
+
+	bool result = false;
+	if (fseek(file, 0, SEEK_END) == 0)
+	{
+		long size = ftell(file);
+		if (size > 0 && fseek(file, 0, SEEK_SET) == 0)
+		{
+			buffer.resize(size);
+			result = fread(buffer.data(), 1, size, file) == static_cast<size_t>(size);
+		}
+	}
+	fclose(file);
+	return result;
+}
+
+bool WriteFile(const char* path, const std::vector<uint8_t>& buffer)
+{
+	FILE* file = fopen(path, "wb");
+	if (file == nullptr)
+		return false;
+
+	bool result = fwrite(buffer.data(), 1, buffer.size(), file) == buffer.size();
+	return fclose(file) == 0 && result;
+}
+
+bool HasExtension(const std::string& path, const char* ext)
+{
+	size_t length = strlen(ext);
+	if (path.size() < length)
+		return false;
+
+	for (size_t i = 0; i < length; i++)
+	{
+		if (tolower(path[path.size() - length + i]) != ext[i])
+			return false;
+	}
+	return true;
+}
+
+// uncompressed (2) and RLE (10) true-color TGA, 24 or 32 bits.
+bool ReadTGA(const std::vector<uint8_t>& file, Image& image)
+{
+	if (file.size() < 18)
+		return false;
+
+	uint32_t idLength = file[0];
+	uint32_t imageType = file[2];
+	uint32_t width = file[12] | (file[13] << 8);
+	uint32_t height = file[14] | (file[15] << 8);
+	uint32_t pixelBytes = file[16] / 8;
+	bool topDown = (file[17] & 0x20) != 0;
+	if ((imageType != 2 && imageType != 10) || file[1] != 0 ||
+		(pixelBytes != 3 && pixelBytes != 4) || width == 0 || height == 0)
+	{
+		return false;
+	}
+
+	std::vector<uint8_t> bgra(width * height * pixelBytes);
+	size_t pos = 18 + idLength;
+	if (imageType == 2)
+	{
+		if (file.size() < pos + bgra.size())
+			return false;
+		memcpy(bgra.data(), file.data() + pos, bgra.size());
+	}
+	else
+	{
+		size_t out = 0;
+		while (out < bgra.size())
+		{
+			if (pos >= file.size())
+				return false;
+
+			uint32_t header = file[pos++];
+			uint32_t count = (header & 0x7F) + 1;
+			bool packed = (header & 0x80) != 0;
+			size_t needed = packed ? pixelBytes : pixelBytes * count;
+			if (pos + needed > file.size() || out + pixelBytes * count > bgra.size())
+				return false;
+
+			for (uint32_t i = 0; i < count; i++)
+			{
+				memcpy(bgra.data() + out, file.data() + pos + (packed ? 0 : i * pixelBytes), pixelBytes);
+				out += pixelBytes;
+			}
+			pos += needed;
+		}
+	}
+
+	image.width = width;
+	image.height = height;
+	image.rgba.resize(width * height * 4);
+	for (uint32_t y = 0; y < height; y++)
+	{
+		const uint8_t* src = bgra.data() + (topDown ? y : height - 1 - y) * width * pixelBytes;
+		uint8_t* dst = image.rgba.data() + y * width * 4;
+		if (pixelBytes == 4)
+			SwizzleRGBA(src, dst, width);
+		else
+			ExpandRGBToRGBA(src, dst, width, true);
+	}
+	return true;
+}
+
+// binary PPM (P6) and PAM (P7) with 8-bit RGB or RGB_ALPHA tuples.
+bool ReadPNM(const std::vector<uint8_t>& file, Image& image)
+{
+	if (file.size() < 2 || file[0] != 'P' || (file[1] != '6' && file[1] != '7'))
+		return false;
+
+	size_t pos = 2;
+	auto nextToken = [&]() -> std::string
+	{
+		std::string token;
+		while (pos < file.size())
+		{
+			char c = static_cast<char>(file[pos]);
+			if (c == '#')
+			{
+				while (pos < file.size() && file[pos] != '\n')
+					pos++;
+			}
+			else if (isspace(static_cast<unsigned char>(c)))
+			{
+				pos++;
+				if (!token.empty())
+					return token;
+			}
+			else
+			{
+				token += c;
+				pos++;
+			}
+		}
+		return token;
+	};
+
+	uint32_t width = 0, height = 0, channels = 3, maxValue = 0;
+	if (file[1] == '6')
+	{
+		width = atoi(nextToken().c_str());
+		height = atoi(nextToken().c_str());
+		maxValue = atoi(nextToken().c_str());
+	}
+	else
+	{
+		while (true)
+		{
+			std::string token = nextToken();
+			if (token.empty())
+				return false;
+			if (token == "ENDHDR")
+				break;
+			else if (token == "WIDTH")
+				width = atoi(nextToken().c_str());
+			else if (token == "HEIGHT")
+				height = atoi(nextToken().c_str());
+			else if (token == "DEPTH")
+				channels = atoi(nextToken().c_str());
+			else if (token == "MAXVAL")
+				maxValue = atoi(nextToken().c_str());
+			else if (token == "TUPLTYPE")
+				nextToken();
+		}
+	}
+
+	if (width == 0 || height == 0 || maxValue != 255 || (channels != 3 && channels != 4) ||
+		file.size() < pos + static_cast<size_t>(width) * height * channels)
+	{
+		return false;
+	}
+
+	image.width = width;
+	image.height = height;
+	image.rgba.resize(width * height * 4);
+	if (channels == 4)
+		memcpy(image.rgba.data(), file.data() + pos, image.rgba.size());
+	else
+		ExpandRGBToRGBA(file.data() + pos, image.rgba.data(), width * height);
+	return true;
+}
+
+bool ReadImage(const std::string& path, Image& image)
+{
+	std::vector<uint8_t> file;
+	if (HasExtension(path, ".tga") || HasExtension(path, ".ppm") || HasExtension(path, ".pam"))
+	{
+		if (!ReadFile(path.c_str(), file))
+			return false;
+
+		return HasExtension(path, ".tga") ? ReadTGA(file, image) : ReadPNM(file, image);
+	}
+
+#ifdef G2D_TEXCONV_USE_RES
+	file_data f;
+	if (!load_file(path.c_str(), f))
+		return false;
+
+	img_data img;
+	bool result = read_image(f.buffer, img);
+	destroy_file_data(f);
+	if (result)
+	{
+		image.width = img.width;
+		image.height = img.height;
+		image.rgba.resize(img.width * img.height * 4);
+		if (img.has_alpha)
+			memcpy(image.rgba.data(), img.raw_data, image.rgba.size());
+		else
+			ExpandRGBToRGBA(img.raw_data, image.rgba.data(), img.width * img.height);
+		destroy_img_data(img);
+	}
+	return result;
+#else
+	return false;
+#endif
+}
+
+bool ParseFormat(const char* name, TextureFormat& format, bool& autoFormat)
+{
+	autoFormat = false;
+	if (strcmp(name, "auto") == 0)
+		autoFormat = true;
+	else if (strcmp(name, "bc1") == 0)
+		format = TextureFormat::BC1;
+	else if (strcmp(name, "bc3") == 0)
+		format = TextureFormat::BC3;
+	else if (strcmp(name, "bc7") == 0)
+		format = TextureFormat::BC7;
+	else if (strcmp(name, "rgba8") == 0)
+		format = TextureFormat::RGBA8;
+	else
+		return false;
+	return true;
+}
+
+const char* GetFormatName(TextureFormat format)
+{
+	switch (format)
+	{
+	case TextureFormat::BC1: return "bc1";
+	case TextureFormat::BC3: return "bc3";
+	case TextureFormat::BC7: return "bc7";
+	default: return "rgba8";
+	}
+}
+
+void PrintUsage()
+{
+	printf("usage: texconv [-f auto|bc1|bc3|bc7|rgba8] [-nomips] [-premultiply]\n");
+	printf("               [-filter box|kaiser] [-pitch alignment] <input> <output.dds|output.g2dtex>\n");
+	printf("  auto picks bc1 for opaque images and bc3 for others.\n");
+	printf("  filter is box for dds and kaiser for g2dtex by default.\n");
+}
+
+int main(int argc, char* argv[])
+{
+	TextureFormat format = TextureFormat::BC1;
+	bool autoFormat = true;
+	bool generateMips = true;
+	bool premultiply = false;
+	bool filterGiven = false;
+	MipFilter filter = MipFilter::Box;
+	uint32_t pitchAlignment = BAKED_TEXTURE_DEFAULT_PITCH_ALIGNMENT;
+	std::vector<std::string> files;
+	for (int i = 1; i < argc; i++)
+	{
+		if (strcmp(argv[i], "-f") == 0 && i + 1 < argc)
+		{
+			if (!ParseFormat(argv[++i], format, autoFormat))
+			{
+				PrintUsage();
+				return 1;
+			}
+		}
+		else if (strcmp(argv[i], "-nomips") == 0)
+		{
+			generateMips = false;
+		}
+		else if (strcmp(argv[i], "-premultiply") == 0)
+		{
+			premultiply = true;
+		}
+		else if (strcmp(argv[i], "-filter") == 0 && i + 1 < argc)
+		{
+			filterGiven = true;
+			const char* name = argv[++i];
+			if (strcmp(name, "box") == 0)
+				filter = MipFilter::Box;
+			else if (strcmp(name, "kaiser") == 0)
+				filter = MipFilter::Kaiser;
+			else
+			{
+				PrintUsage();
+				return 1;
+			}
+		}
+		else if (strcmp(argv[i], "-pitch") == 0 && i + 1 < argc)
+		{
+			pitchAlignment = static_cast<uint32_t>(atoi(argv[++i]));
+			if (pitchAlignment == 0 || (pitchAlignment & (pitchAlignment - 1)) != 0)
+			{
+				PrintUsage();
+				return 1;
+			}
+		}
+		else
+		{
+			files.push_back(argv[i]);
+		}
+	}
+
+	if (files.size() != 2)
+	{
+		PrintUsage();
+		return 1;
+	}
+
+	bool baked = HasExtension(files[1], ".g2dtex");
+	if (!filterGiven)
+		filter = baked ? MipFilter::Kaiser : MipFilter::Box;
+
+	Image image;
+	if (!ReadImage(files[0], image))
+	{
+		fprintf(stderr, "texconv: can not read image %s\n", files[0].c_str());
+		return 1;
+	}
+
+	if (autoFormat)
+	{
+		format = TextureFormat::BC1;
+		for (size_t i = 3; i < image.rgba.size(); i += 4)
+		{
+			if (image.rgba[i] != 255)
+			{
+				format = TextureFormat::BC3;
+				break;
+			}
+		}
+	}
+
+	// D3D requires the top level of block-compressed
+	// textures to be multiple of 4 in both dimensions.
+	if (IsBlockCompressed(format) && (image.width % 4 != 0 || image.height % 4 != 0))
+	{
+		fprintf(stderr, "texconv: %ux%u is not multiple of 4, fallback to rgba8.\n", image.width, image.height);
+		format = TextureFormat::RGBA8;
+	}
+
+	// large images are converted by jobs on every core.
+	JobSystem jobs;
+	jobs.Start(std::max(1u, std::thread::hardware_concurrency()) - 1);
+	SetPixelJobSystem(&jobs);
+
+	auto startTime = std::chrono::steady_clock::now();
+
+	// filtering premultiplied colors keeps transparent texels
+	// from bleeding their colors into lower mips.
+	if (premultiply)
+		PremultiplyAlpha(image.rgba.data(), image.rgba.data(), image.width * image.height);
+
+	std::vector<std::vector<uint8_t>> mipData;
+	std::vector<uint8_t> level = std::move(image.rgba);
+	uint32_t width = image.width;
+	uint32_t height = image.height;
+	while (true)
+	{
+		mipData.emplace_back();
+		CompressImage(format, level.data(), width, height, mipData.back());
+		if (!generateMips || (width == 1 && height == 1))
+			break;
+
+		std::vector<uint8_t> nextLevel;
+		DownsampleImage(level.data(), width, height, nextLevel, filter);
+		level.swap(nextLevel);
+		width = std::max(1u, width / 2);
+		height = std::max(1u, height / 2);
+	}
+
+	std::vector<uint8_t> output;
+	if (baked)
+		WriteBakedTexture(format, image.width, image.height, premultiply, pitchAlignment, mipData, output);
+	else
+		WriteDDS(format, image.width, image.height, mipData, output);
+	if (!WriteFile(files[1].c_str(), output))
+	{
+		fprintf(stderr, "texconv: can not write %s\n", files[1].c_str());
+		return 1;
+	}
+
+	auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - startTime);
+	uint64_t rawBytes = static_cast<uint64_t>(image.width) * image.height * 4;
+	printf("%s: %ux%u %s, %u mips, %llu bytes (top level rgba8 %llu bytes), %lld ms, kernels %s\n",
+		files[1].c_str(), image.width, image.height, GetFormatName(format),
+		static_cast<uint32_t>(mipData.size()),
+		static_cast<unsigned long long>(output.size()),
+		static_cast<unsigned long long>(rawBytes),
+		static_cast<long long>(elapsed.count()),
+		GetPixelKernelName());
+	return 0;
+}
@@ -0,0 +1,229 @@
+// transformbench: measure time of updating world matrices by node count.
+//
+//   transformbench [-r rounds] [-n max node count] [-seed N]
+//
+// Compares TransformStore with the way transforms were stored before:
+// every node is a separate object holding its local and world matrices,
+// setters mark the subtree dirty recursively and world matrices are
+// evaluated lazily through parent pointers. Random hierarchies are
+// built for 1K to 1M nodes, four kinds of frames are measured: every
+// node moves, 1% of nodes move, the first root which has the largest
+// subtree moves 3 times, and nothing moves. It builds with:
+//
+//   g++ -std=c++11 -O2 -I../../got2d/source transformbench.cpp
+//       ../../got2d/source/transform_store.cpp
+
+#include <cmath>
+#include <algorithm>
+#include <memory>
+#include <random>
+#include <vector>
+#include "transform_store.h"
+#include "../bench.h"
+
+struct Options
+{
+	uint32_t rounds = 5;
+	uint32_t maxCount = 1000000;
+	uint32_t seed = 1;
+};
+
+// the previous implementation, scalar matrices and a node per allocation.
+class PointerNode
+{
+public:
+	PointerNode(PointerNode* parent) : m_parent(parent)
+	{
+		if (parent != nullptr)
+			parent->m_children.push_back(this);
+	}
+
+	void SetPosition(const TransformVector& position)
+	{
+		m_position = position;
+		m_localDirty = true;
+		SetWorldDirty();
+	}
+
+	void SetRotation(float radian)
+	{
+		m_rotation = radian;
+		m_localDirty = true;
+		SetWorldDirty();
+	}
+
+	const TransformMatrix& GetWorldMatrix()
+	{
+		if (m_worldDirty)
+		{
+			const TransformMatrix& local = GetLocalMatrix();
+			if (m_parent == nullptr)
+			{
+				m_world = local;
+			}
+			else
+			{
+				const TransformMatrix& parent = m_parent->GetWorldMatrix();
+				for (int r = 0; r < 2; r++)
+				{
+					m_world.row[r][0] = parent.row[r][0] * local.row[0][0] + parent.row[r][1] * local.row[1][0];
+					m_world.row[r][1] = parent.row[r][0] * local.row[0][1] + parent.row[r][1] * local.row[1][1];
+					m_world.row[r][2] = parent.row[r][0] * local.row[0][2] + parent.row[r][1] * local.row[1][2] + parent.row[r][2];
+				}
+			}
+			m_worldDirty = false;
+		}
+		return m_world;
+	}
+
+private:
+	const TransformMatrix& GetLocalMatrix()
+	{
+		if (m_localDirty)
+		{
+			float s = std::sin(m_rotation);
+			float c = std::cos(m_rotation);
+			m_local = { { { c, -s, m_position.x },{ s, c, m_position.y } } };
+			m_localDirty = false;
+		}
+		return m_local;
+	}
+
+	void SetWorldDirty()
+	{
+		m_worldDirty = true;
+		for (auto child : m_children)
+			child->SetWorldDirty();
+	}
+
+	PointerNode* m_parent;
+	std::vector<PointerNode*> m_children;
+	TransformVector m_position = { 0.0f, 0.0f };
+	float m_rotation = 0.0f;
+	TransformMatrix m_local = { { { 1.0f, 0.0f, 0.0f },{ 0.0f, 1.0f, 0.0f } } };
+	TransformMatrix m_world = m_local;
+	bool m_localDirty = false;
+	bool m_worldDirty = true;
+};
+
+// parent index of every node, -1 for roots, parents are created first.
+std::vector<int32_t> BuildHierarchy(uint32_t count, std::mt19937& random)
+{
+	std::vector<int32_t> parents(count);
+	for (uint32_t i = 0; i < count; i++)
+	{
+		if (i == 0 || random() % 16 == 0)
+			parents[i] = -1;
+		else
+			parents[i] = static_cast<int32_t>(random() % i);
+	}
+	return parents;
+}
+
+enum Frame { AllMoving, FewMoving, RootMoving, Static, FrameCount };
+
+// nodes moved in a frame, 1% of all for FewMoving.
+std::vector<uint32_t> PickMovingNodes(Frame frame, uint32_t count, std::mt19937& random)
+{
+	std::vector<uint32_t> moving;
+	if (frame == AllMoving)
+	{
+		for (uint32_t i = 0; i < count; i++)
+			moving.push_back(i);
+	}
+	else if (frame == FewMoving)
+	{
+		for (uint32_t i = 0; i < std::max(1u, count / 100); i++)
+			moving.push_back(random() % count);
+	}
+	else if (frame == RootMoving)
+	{
+		moving.assign(3, 0);
+	}
+	return moving;
+}
+
+TransformVector MovedPosition(uint32_t node, uint32_t round)
+{
+	return{ static_cast<float>(node % 97) * 0.01f + round, static_cast<float>(node % 89) * 0.01f - round };
+}
+
+int main(int argc, char* argv[])
+{
+	Options options;
+	CommandLine commandLine("transformbench [-r rounds] [-n max node count] [-seed N]");
+	commandLine.Add("-r", options.rounds, 1);
+	commandLine.Add("-n", options.maxCount, 1);
+	commandLine.Add("-seed", options.seed);
+	if (!commandLine.Parse(argc, argv))
+		return 1;
+
+	const char* frameNames[FrameCount] = { "all moving", "1% moving", "root x3", "static" };
+	printf("best of %u rounds, ms per frame\n", options.rounds);
+	printf("%9s %-11s %10s %10s %8s\n", "nodes", "frame", "pointer", "store", "speedup");
+	for (uint32_t count = 1000; count <= options.maxCount; count *= 10)
+	{
+		std::mt19937 random(options.seed);
+		std::vector<int32_t> parents = BuildHierarchy(count, random);
+
+		std::vector<std::unique_ptr<PointerNode>> nodes;
+		nodes.reserve(count);
+		TransformStore store;
+		store.Reserve(count);
+		std::vector<TransformStore::Handle> handles(count);
+		for (uint32_t i = 0; i < count; i++)
+		{
+			PointerNode* parentNode = parents[i] < 0 ? nullptr : nodes[parents[i]].get();
+			nodes.emplace_back(new PointerNode(parentNode));
+			handles[i] = store.Create(parents[i] < 0 ? TransformStore::INVALID_HANDLE : handles[parents[i]]);
+		}
+
+		for (int frame = AllMoving; frame < FrameCount; frame++)
+		{
+			double bestPointer = 0.0;
+			double bestStore = 0.0;
+			for (uint32_t round = 0; round < options.rounds; round++)
+			{
+				std::vector<uint32_t> moving = PickMovingNodes(static_cast<Frame>(frame), count, random);
+
+				// every world matrix is read, as rendering does.
+				float checksumPointer = 0.0f;
+				auto startTime = Clock::now();
+				for (uint32_t node : moving)
+				{
+					nodes[node]->SetPosition(MovedPosition(node, round));
+					nodes[node]->SetRotation(node * 0.001f + round);
+				}
+				for (auto& node : nodes)
+					checksumPointer += node->GetWorldMatrix().row[0][2];
+				double pointerTime = ElapsedMilliseconds(startTime);
+
+				float checksumStore = 0.0f;
+				startTime = Clock::now();
+				for (uint32_t node : moving)
+				{
+					store.SetPosition(handles[node], MovedPosition(node, round));
+					store.SetRotation(handles[node], node * 0.001f + round);
+				}
+				store.Update();
+				for (uint32_t i = 0; i < count; i++)
+					checksumStore += store.GetWorldMatrix(handles[i]).row[0][2];
+				double storeTime = ElapsedMilliseconds(startTime);
+
+				float tolerance = 1e-3f * std::max(1.0f, std::fabs(checksumPointer));
+				if (std::fabs(checksumPointer - checksumStore) > tolerance)
+				{
+					fprintf(stderr, "transformbench: world matrices differ, %f vs %f\n", checksumPointer, checksumStore);
+					return 1;
+				}
+
+				KeepBest(round, pointerTime, bestPointer);
+				KeepBest(round, storeTime, bestStore);
+			}
+
+			printf("%9u %-11s %10.3f %10.3f %7.2fx\n", count, frameNames[frame],
+				bestPointer, bestStore, bestPointer / bestStore);
+		}
+	}
+	return 0;
+}